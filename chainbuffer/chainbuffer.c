@@ -1,8 +1,64 @@
 #include "chainbuffer.h"
+#include "../memsearch/memsearch.h"
 #include <string.h>
 #include <stdbool.h>
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
+#include <limits.h> //IOV_MAX
+#include <sys/uio.h> //readv writev
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024 //Linux 的 UIO_MAXIOV
+#endif
+
+static _Atomic uint64_t g_buffer_mem; //所有 chain 向 malloc 申请的字节数
+
+uint64_t buffer_mem_total(void)
+{
+	return g_buffer_mem;
+}
+
+static inline void buffer_mem_add(uint64_t n)
+{
+	__atomic_fetch_add(&g_buffer_mem, n, __ATOMIC_RELAXED);
+}
+
+static inline void buffer_mem_sub(uint64_t n)
+{
+	__atomic_fetch_sub(&g_buffer_mem, n, __ATOMIC_RELAXED);
+}
+
+// 每次修改 total_len 之后调用
+static inline void buffer_check_wm(buffer_t* buf)
+{
+	if (buf->wm_fn == NULL) {
+		return;
+	}
+	if (!buf->wm_above && buf->total_len >= buf->wm_high) {
+		buf->wm_above = 1;
+		buf->wm_fn(buf, 1, buf->wm_arg);
+	}
+	else if (buf->wm_above && buf->total_len <= buf->wm_low) {
+		buf->wm_above = 0;
+		buf->wm_fn(buf, 0, buf->wm_arg);
+	}
+}
+
+void buffer_set_watermark(buffer_t* buf, uint32_t high, uint32_t low, buffer_wm_fn fn, void* arg)
+{
+	if (high == 0 || fn == NULL) {
+		buf->wm_fn = NULL;
+		buf->wm_above = 0;
+		return;
+	}
+	buf->wm_high = high;
+	buf->wm_low = low < high ? low : high - 1;
+	buf->wm_fn = fn;
+	buf->wm_arg = arg;
+	buf->wm_above = 0;
+	buffer_check_wm(buf);
+}
 
 uint32_t buffer_len(buffer_t* buf)
 {
@@ -12,18 +68,87 @@ uint32_t buffer_len(buffer_t* buf)
 	return 0;
 }
 
-buffer_t* buffer_new(uint32_t sz)
+buf_pool_t* buf_pool_new(uint64_t max_cached)
 {
-	buffer_t* buf = (buffer_t*)malloc(sizeof(buffer_t));
-	if (!buf) {
+	buf_pool_t* pool = (buf_pool_t*)malloc(sizeof(buf_pool_t));
+	if (!pool) {
 		return NULL;
 	}
+	memset(pool, 0, sizeof(buf_pool_t));
+	pool->max_cached = max_cached;
+	return pool;
+}
+
+void buf_pool_free(buf_pool_t* pool)
+{
+	if (!pool) {
+		return;
+	}
+	for (int i = 0; i < BUF_POOL_CLASSES; i++) {
+		buf_chain_t *chain, *next;
+		for (chain = pool->chains[i]; chain; chain = next) {
+			next = chain->next;
+			buffer_mem_sub(chain->buffer_len + BUFFER_CHAIN_SIZE);
+			free(chain);
+		}
+	}
+	buf_chain_t *ref, *rnext;
+	for (ref = pool->refs; ref; ref = rnext) {
+		rnext = ref->next;
+		buffer_mem_sub(BUFFER_CHAIN_SIZE);
+		free(ref);
+	}
+	buffer_t *buf, *next;
+	for (buf = pool->buffers; buf; buf = next) {
+		next = (buffer_t*)buf->first;
+		free(buf);
+	}
+	free(pool);
+}
+
+// 只有按 2 的幂取整分配出来的 chain 才能放回池中
+static inline int buf_pool_class(uint32_t to_alloc)
+{
+	if (to_alloc < MIN_BUFFER_SIZE || (to_alloc & (to_alloc - 1))) {
+		return -1;
+	}
+	int cls = __builtin_ctz(to_alloc) - __builtin_ctz(MIN_BUFFER_SIZE);
+	return cls < BUF_POOL_CLASSES ? cls : -1;
+}
+
+buffer_t* buffer_new_with_pool(buf_pool_t* pool)
+{
+	buffer_t* buf;
+	if (pool && pool->buffers) {
+		buf = pool->buffers;
+		pool->buffers = (buffer_t*)buf->first;
+		pool->nbuffers--;
+	}
+	else {
+		buf = (buffer_t*)malloc(sizeof(buffer_t));
+		if (!buf) {
+			return NULL;
+		}
+	}
 	memset(buf, 0, sizeof(buffer_t));
 	buf->last_with_datap = &buf->first;
+	buf->pool = pool;
 	return buf;
 }
 
-static buf_chain_t* buf_chain_new(uint32_t size)
+static inline buf_chain_t* buf_chain_insert_new(buffer_t* buf, uint32_t datalen);
+
+buffer_t* buffer_new(uint32_t sz)
+{
+	buffer_t* buf = buffer_new_with_pool(NULL);
+	if (buf && sz > 0 && buf_chain_insert_new(buf, sz) == NULL) {
+		free(buf);
+		return NULL;
+	}
+	return buf;
+}
+
+static buf_chain_t* buf_chain_new(buf_pool_t* pool, uint32_t size)
 {
 	buf_chain_t* chain;
 	uint32_t to_alloc;
@@ -41,29 +166,120 @@ static buf_chain_t* buf_chain_new(uint32_t size)
 	else {
 		to_alloc = size;
 	}
-	chain = malloc(to_alloc);
-	if (chain == NULL) {
-		return NULL;
+	int cls = pool ? buf_pool_class(to_alloc) : -1;
+	if (cls >= 0 && pool->chains[cls]) {
+		chain = pool->chains[cls];
+		pool->chains[cls] = chain->next;
+		pool->cached -= to_alloc;
+		pool->chain_reuses++;
+	}
+	else {
+		chain = malloc(to_alloc);
+		if (chain == NULL) {
+			return NULL;
+		}
+		buffer_mem_add(to_alloc);
+		if (pool) {
+			pool->chain_mallocs++;
+		}
+	}
+	if (pool) {
+		pool->used += to_alloc;
 	}
 	memset(chain, 0, BUFFER_CHAIN_SIZE);
 	chain->buffer_len = to_alloc - BUFFER_CHAIN_SIZE;
 	chain->buffer = BUFFER_CHAIN_EXTRA(uint8_t, chain);
+	chain->refcnt = 1;
+	return chain;
+}
+
+// 引用 chain：数据区就是 parent 中 [data, data + len)，buffer_len == off 保证 CHAIN_SPACE_LEN 永远为 0
+static buf_chain_t* buf_chain_new_ref(buf_pool_t* pool, buf_chain_t* parent, uint8_t* data, uint32_t len)
+{
+	buf_chain_t* chain;
+	if (pool && pool->refs) {
+		chain = pool->refs;
+		pool->refs = chain->next;
+		pool->nrefs--;
+	}
+	else {
+		chain = malloc(BUFFER_CHAIN_SIZE);
+		if (chain == NULL) {
+			return NULL;
+		}
+		buffer_mem_add(BUFFER_CHAIN_SIZE);
+	}
+	if (pool) {
+		pool->used += BUFFER_CHAIN_SIZE;
+	}
+	memset(chain, 0, BUFFER_CHAIN_SIZE);
+	chain->flags = BUF_CHAIN_REFERENCE;
+	chain->parent = parent;
+	chain->buffer = data;
+	chain->buffer_len = len;
+	chain->off = len;
+	parent->refcnt++;
 	return chain;
 }
 
-static void buf_chain_free_all(buf_chain_t* chain)
+static void buf_chain_free(buf_pool_t* pool, buf_chain_t* chain)
+{
+	if (chain->flags & BUF_CHAIN_REFERENCE) {
+		buf_chain_t* parent = chain->parent;
+		if (pool) {
+			pool->used -= BUFFER_CHAIN_SIZE;
+		}
+		if (pool && pool->nrefs < BUF_POOL_MAX_REFS) {
+			chain->next = pool->refs;
+			pool->refs = chain;
+			pool->nrefs++;
+		}
+		else {
+			buffer_mem_sub(BUFFER_CHAIN_SIZE);
+			free(chain);
+		}
+		chain = parent;
+	}
+	if (--chain->refcnt > 0) {
+		return;
+	}
+	uint32_t size = chain->buffer_len + BUFFER_CHAIN_SIZE;
+	if (pool) {
+		pool->used -= size;
+	}
+	int cls = pool ? buf_pool_class(size) : -1;
+	if (cls >= 0 && pool->cached + size <= pool->max_cached) {
+		chain->next = pool->chains[cls];
+		pool->chains[cls] = chain;
+		pool->cached += size;
+		return;
+	}
+	buffer_mem_sub(size);
+	free(chain);
+}
+
+static void buf_chain_free_all(buf_pool_t* pool, buf_chain_t* chain)
 {
 	buf_chain_t* next;
 	for (;chain; chain = next) {
 		next = chain->next;
-		free(chain);
+		buf_chain_free(pool, chain);
 	}
 }
 
 void buffer_free(buffer_t* buf)
 {
-	if (buf) {
-		buf_chain_free_all(buf->first);
+	if (!buf) {
+		return;
+	}
+	buf_pool_t* pool = buf->pool;
+	buf_chain_free_all(pool, buf->first);
+	if (pool && pool->nbuffers < BUF_POOL_MAX_BUFFERS) {
+		// 空闲的 buffer_t 借用 first 字段串成链表
+		buf->first = (buf_chain_t*)pool->buffers;
+		pool->buffers = buf;
+		pool->nbuffers++;
+		return;
 	}
 	free(buf);
 }
@@ -75,7 +291,7 @@ static buf_chain_t** free_empty_chains(buffer_t* buf)
 		ch = &(*ch)->next;
 	}
 	if (*ch) {
-		buf_chain_free_all(*ch);
+		buf_chain_free_all(buf->pool, *ch);
 		*ch = NULL;
 	}
 	return ch;
@@ -101,7 +317,7 @@ static void buf_chain_insert(buffer_t* buf, buf_chain_t* chain)
 static inline buf_chain_t* buf_chain_insert_new(buffer_t* buf, uint32_t datalen)
 {
 	buf_chain_t* chain;
-	chain = buf_chain_new(datalen);
+	chain = buf_chain_new(buf->pool, datalen);
 	if (chain == NULL) {
 		return NULL;
 	}
@@ -109,9 +325,15 @@ static inline buf_chain_t* buf_chain_insert_new(buffer_t* buf, uint32_t datalen)
 	return chain;
 }
 
+// 数据被引用时不能 memmove（引用 chain 指向的是绝对地址），引用 chain 本身更不能写
+static inline int buf_chain_shared(buf_chain_t* chain)
+{
+	return (chain->flags & BUF_CHAIN_REFERENCE) || chain->refcnt > 1;
+}
+
 static int buf_chain_should_realign(buf_chain_t* chain, uint32_t datalen)
 {
-	return chain->buffer_len - chain->off >= datalen && chain->off < chain->buffer_len / 2 && chain->off <= MAX_TO_REALIGN_IN_EXPAND;
+	return !buf_chain_shared(chain) && chain->buffer_len - chain->off >= datalen && chain->off < chain->buffer_len / 2 && chain->off <= MAX_TO_REALIGN_IN_EXPAND;
 }
 
 static void buf_chain_align(buf_chain_t* chain)
@@ -165,7 +387,7 @@ int buffer_add(buffer_t* buf, const void* data_in, uint32_t data_len)
 	if (data_len > to_alloc) {
 		to_alloc = data_len;
 	}
-	tmp = buf_chain_new(to_alloc);
+	tmp = buf_chain_new(buf->pool, to_alloc);
 	if (tmp == NULL) {
 		goto done;
 	}
@@ -183,6 +405,7 @@ int buffer_add(buffer_t* buf, const void* data_in, uint32_t data_len)
 	buf_chain_insert(buf, tmp);
 out:
 	result = 0;
+	buffer_check_wm(buf);
 done:
 	return result;
 }
@@ -237,7 +460,7 @@ int buffer_drain(buffer_t* buf, uint32_t len)
 		len = buf->total_len;
 		for (chain = buf->first; chain != NULL; chain = next) {
 			next = chain->next;
-			free(chain);
+			buf_chain_free(buf->pool, chain);
 		}
 		ZERO_CHAIN(buf);
 	}
@@ -253,13 +476,14 @@ int buffer_drain(buffer_t* buf, uint32_t len)
 			if (&chain->next == buf->last_with_datap) {
 				buf->last_with_datap = &buf->first;
 			}
-			free(chain);
+			buf_chain_free(buf->pool, chain);
 		}
 
 		buf->first = chain;
 		chain->misalign += remaining;
 		chain->off -= remaining;
 	}
+	buffer_check_wm(buf);
 	return len;
 }
 
@@ -274,6 +498,135 @@ int buffer_remove(buffer_t* buf, void* data_out, uint32_t data_len)
 	return (int)n;
 }
 
+buf_chain_t* buffer_chain_new(buf_pool_t* pool, uint32_t size)
+{
+	return buf_chain_new(pool, size);
+}
+
+void buffer_chain_free(buf_pool_t* pool, buf_chain_t* chain)
+{
+	buf_chain_free(pool, chain);
+}
+
+int buffer_add_chain(buffer_t* buf, buf_chain_t* chain)
+{
+	if (chain->off > BUFFER_CHAIN_MAX - buf->total_len) {
+		return -1;
+	}
+	if (chain->off == 0) {
+		buf_chain_free(buf->pool, chain);
+		return 0;
+	}
+	chain->next = NULL;
+	buf_chain_insert(buf, chain);
+	buffer_check_wm(buf);
+	return chain->off;
+}
+
+int buffer_add_buffer(buffer_t* dst, buffer_t* src)
+{
+	if (src->total_len == 0) {
+		return 0;
+	}
+	if (src->total_len > BUFFER_CHAIN_MAX - dst->total_len) {
+		return -1;
+	}
+	buf_chain_t** chp;
+	if (*dst->last_with_datap == NULL) {
+		// dst 里只有空 chain（或者什么都没有），直接换成 src 的链表
+		buf_chain_free_all(dst->pool, dst->first);
+		chp = &dst->first;
+	}
+	else {
+		chp = free_empty_chains(dst);
+	}
+	*chp = src->first;
+	dst->last = src->last;
+	dst->last_with_datap = src->last_with_datap == &src->first ? chp : src->last_with_datap;
+	dst->total_len += src->total_len;
+	ZERO_CHAIN(src);
+	buffer_check_wm(dst);
+	buffer_check_wm(src);
+	return 0;
+}
+
+int buffer_remove_buffer(buffer_t* src, buffer_t* dst, uint32_t datlen)
+{
+	if (datlen >= src->total_len) {
+		datlen = src->total_len;
+		return buffer_add_buffer(dst, src) == 0 ? (int)datlen : -1;
+	}
+	if (datlen == 0) {
+		return 0;
+	}
+	if (datlen > BUFFER_CHAIN_MAX - dst->total_len) {
+		return -1;
+	}
+
+	// 找出能整块移动的 chain：[src->first, prev]
+	buf_chain_t *chain = src->first, *prev = NULL, *pprev = NULL;
+	uint32_t moved = 0;
+	while (moved + chain->off <= datlen) {
+		moved += chain->off;
+		pprev = prev;
+		prev = chain;
+		chain = chain->next;
+	}
+	if (prev) {
+		buffer_t tmp;
+		memset(&tmp, 0, sizeof(tmp));
+		tmp.first = src->first;
+		tmp.last = prev;
+		tmp.last_with_datap = pprev ? &pprev->next : &tmp.first;
+		tmp.total_len = moved;
+		tmp.pool = src->pool;
+		// 剩下的数据都在 chain 及之后，last_with_datap 最多指到 prev->next
+		if (src->last_with_datap == &prev->next) {
+			src->last_with_datap = &src->first;
+		}
+		prev->next = NULL;
+		src->first = chain;
+		src->total_len -= moved;
+		buffer_add_buffer(dst, &tmp);
+		buffer_check_wm(src);
+	}
+	if (datlen > moved) {
+		if (buffer_add(dst, chain->buffer + chain->misalign, datlen - moved) < 0) {
+			return moved;
+		}
+		buffer_drain(src, datlen - moved);
+	}
+	return datlen;
+}
+
+int buffer_add_buffer_reference(buffer_t* dst, buffer_t* src)
+{
+	if (src->total_len == 0) {
+		return 0;
+	}
+	if (src->total_len > BUFFER_CHAIN_MAX - dst->total_len) {
+		return -1;
+	}
+	// 先在临时链表上建好所有引用，失败时整体回滚
+	buffer_t tmp;
+	memset(&tmp, 0, sizeof(tmp));
+	ZERO_CHAIN(&tmp);
+	tmp.pool = dst->pool;
+	for (buf_chain_t* chain = src->first; chain; chain = chain->next) {
+		if (chain->off == 0) {
+			continue;
+		}
+		buf_chain_t* parent = (chain->flags & BUF_CHAIN_REFERENCE) ? chain->parent : chain;
+		buf_chain_t* ref = buf_chain_new_ref(dst->pool, parent, chain->buffer + chain->misalign, chain->off);
+		if (ref == NULL) {
+			buf_chain_free_all(dst->pool, tmp.first);
+			return -1;
+		}
+		buf_chain_insert(&tmp, ref);
+	}
+	return buffer_add_buffer(dst, &tmp);
+}
+
 static bool check_sep(buf_chain_t* chain, int from, const char* sep, int seplen)
 {
 	for (;;) {
@@ -295,65 +648,205 @@ static bool check_sep(buf_chain_t* chain, int from, const char* sep, int seplen)
 
 int buffer_search(buffer_t* buf, const char* sep, const int seplen)
 {
-	buf_chain_t* chain;
-	int i;
-	chain = buf->first;
-	if (chain == NULL) {
+	if (seplen <= 0 || buf->total_len < (uint32_t)seplen) {
 		return 0;
 	}
-	int bytes = chain->off;
-	while (bytes <= buf->last_read_pos) {
+	uint32_t last = buf->total_len - seplen + 1; //可能的起点个数
+	uint32_t pos = buf->last_read_pos; //上次没搜完的起点，之前的起点都已经确认不匹配
+	uint32_t base = 0; //当前 chain 第一个字节的偏移
+	buf_chain_t* chain = buf->first;
+	while (chain && base + chain->off <= pos) {
+		base += chain->off;
 		chain = chain->next;
-		if (chain == NULL) {
-			return 0;
-		}
-		bytes += chain->off;
-	}
-	bytes -= buf->last_read_pos;
-	int from = chain->off - bytes;
-	for (i = buf->last_read_pos; i <= buf->total_len - seplen; i++) {
-		if (check_sep(chain, from, sep, seplen)) {
-			buf->last_read_pos = 0;
-			return i + seplen;
-		}
-		++from;
-		--bytes;
-		if (bytes == 0) {
-			chain = chain->next;
-			from = 0;
-			if (chain == NULL) {
-				break;
+	}
+	while (chain && pos < last) {
+		const uint8_t* data = chain->buffer + chain->misalign;
+		uint32_t from = pos - base;
+		// 整个分隔符都落在本 chain 内的起点交给向量化内核
+		if (chain->off - from >= (uint32_t)seplen) {
+			size_t k = memsearch(data + from, chain->off - from, sep, seplen);
+			if (k < chain->off - from) {
+				buf->last_read_pos = 0;
+				return pos + k + seplen;
 			}
-			bytes = chain->off;
+			pos = base + chain->off - seplen + 1;
 		}
+		// 跨到后面 chain 的起点最多 seplen - 1 个，逐个检查；pos < last 保证后面的数据够长
+		for (; pos < base + chain->off && pos < last; pos++) {
+			if (data[pos - base] == (uint8_t)sep[0] && check_sep(chain, pos - base, sep, seplen)) {
+				buf->last_read_pos = 0;
+				return pos + seplen;
+			}
+		}
+		base += chain->off;
+		chain = chain->next;
 	}
-	buf->last_read_pos = i;
+	buf->last_read_pos = pos;
 	return 0;
 }
 
-uint8_t* buffer_write_atmost(buffer_t* p)
+int buffer_peek(buffer_t* buf, uint32_t len, struct iovec* vec, int n_vec)
+{
+	if (len == 0 || len > buf->total_len) {
+		len = buf->total_len;
+	}
+	int n = 0;
+	for (buf_chain_t* chain = buf->first; chain && len > 0; chain = chain->next) {
+		if (chain->off == 0) {
+			continue;
+		}
+		uint32_t take = chain->off < len ? chain->off : len;
+		if (n < n_vec) {
+			vec[n].iov_base = chain->buffer + chain->misalign;
+			vec[n].iov_len = take;
+		}
+		n++;
+		len -= take;
+	}
+	return n;
+}
+
+int buffer_reserve(buffer_t* buf, uint32_t size, struct iovec* vec, int n_vec)
+{
+	buf_chain_t *chain, *fresh;
+	if (n_vec < 1 || size == 0 || size > BUFFER_CHAIN_MAX - buf->total_len) {
+		return -1;
+	}
+
+	chain = *buf->last_with_datap;
+	if (chain == NULL) {
+		// 没有数据：剩下的都是空 chain，只有一个且够大时直接用，否则整体换新
+		chain = buf->first;
+		if (chain == NULL || chain->next || buf_chain_shared(chain) || chain->buffer_len < size) {
+			buf_chain_free_all(buf->pool, buf->first);
+			ZERO_CHAIN(buf);
+			if ((chain = buf_chain_insert_new(buf, size)) == NULL) {
+				return -1;
+			}
+		}
+		chain->misalign = 0;
+		buf->reserved = chain;
+		vec[0].iov_base = chain->buffer;
+		vec[0].iov_len = chain->buffer_len;
+		return 1;
+	}
+
+	if (chain->next) {
+		// chain 本身可能是空的（buffer_new 预分配的、commit(0) 留下的），只释放它后面的
+		buf_chain_free_all(buf->pool, chain->next);
+		chain->next = NULL;
+		buf->last = chain;
+	}
+	uint32_t space = CHAIN_SPACE_LEN(chain);
+	if (space >= size || (n_vec == 1 && buf_chain_should_realign(chain, size))) {
+		if (space < size) {
+			buf_chain_align(chain);
+			space = CHAIN_SPACE_LEN(chain);
+		}
+		buf->reserved = chain;
+		vec[0].iov_base = chain->buffer + chain->misalign + chain->off;
+		vec[0].iov_len = space;
+		return 1;
+	}
+
+	int n = 0;
+	buf->reserved = NULL;
+	if (n_vec > 1 && space) {
+		buf->reserved = chain;
+		vec[n].iov_base = chain->buffer + chain->misalign + chain->off;
+		vec[n].iov_len = space;
+		n++;
+		size -= space;
+	}
+	// 和 buffer_add 一样按最后一个 chain 的两倍增长，连续的小预留不会每次都新开一个小 chain
+	uint32_t to_alloc = chain->buffer_len;
+	if (to_alloc <= BUFFER_CHAIN_MAX_AUTO_SIZE / 2) {
+		to_alloc <<= 1;
+	}
+	if (size > to_alloc) {
+		to_alloc = size;
+	}
+	if ((fresh = buf_chain_new(buf->pool, to_alloc)) == NULL) {
+		return -1;
+	}
+	// 直接接在 chain 后面：chain 可能是空的，buf_chain_insert 会把它当空 chain 释放掉。
+	// fresh 的 off 为 0，total_len 和 last_with_datap 不变，commit 时再往后挪
+	chain->next = fresh;
+	buf->last = fresh;
+	if (buf->reserved == NULL) {
+		buf->reserved = fresh;
+	}
+	vec[n].iov_base = fresh->buffer;
+	vec[n].iov_len = fresh->buffer_len;
+	return n + 1;
+}
+
+int buffer_commit(buffer_t* buf, uint32_t size)
+{
+	// 常见情况：整段都写在最后一个有数据的 chain 里
+	buf_chain_t* tail = *buf->last_with_datap;
+	if (tail && tail == buf->reserved && tail->next == NULL && size <= CHAIN_SPACE_LEN(tail)) {
+		tail->off += size;
+		buf->total_len += size;
+		buf->reserved = NULL;
+		buffer_check_wm(buf);
+		return 0;
+	}
+	// reserved 是 last_with_data 所在的 chain 或者它后面的空 chain
+	buf_chain_t** chp = *buf->last_with_datap ? buf->last_with_datap : &buf->first;
+	while (*chp && *chp != buf->reserved) {
+		chp = &(*chp)->next;
+	}
+	if (size && *chp == NULL) {
+		return -1;
+	}
+	uint32_t space = 0;
+	for (buf_chain_t* chain = *chp; chain; chain = chain->next) {
+		space += CHAIN_SPACE_LEN(chain);
+	}
+	if (size > space || size > BUFFER_CHAIN_MAX - buf->total_len) {
+		return -1;
+	}
+
+	buf->total_len += size;
+	for (buf_chain_t* chain = *chp; chain && size; chp = &chain->next, chain = *chp) {
+		uint32_t k = CHAIN_SPACE_LEN(chain);
+		if (k > size) {
+			k = size;
+		}
+		if (k) {
+			chain->off += k;
+			buf->last_with_datap = chp;
+			size -= k;
+		}
+	}
+	buf->reserved = NULL;
+	free_empty_chains(buf);
+	buf->last = *buf->last_with_datap;
+	buffer_check_wm(buf);
+	return 0;
+}
+
+uint8_t* buffer_pullup(buffer_t* p, uint32_t size)
 {
 	buf_chain_t *chain, *next, *tmp, *last_with_data;
 	uint8_t* buffer;
-	uint32_t remaining;
 	int removed_last_with_data = 0;
 	int removed_last_with_datap = 0;
 
+	if (size == 0 || size > p->total_len) {
+		size = p->total_len;
+	}
+	if (size == 0) {
+		return NULL;
+	}
 	chain = p->first;
-	uint32_t size = p->total_len;
 
 	if (chain->off >= size) {
 		return chain->buffer + chain->misalign;
 	}
 
-	remaining = size - chain->off;
-	for (tmp = chain->next; tmp; tmp = tmp->next) {
-		if (tmp->off >= (size_t)remaining) {
-			break;
-		}
-		remaining -= tmp->off;
-	}
-	if (chain->buffer_len - chain->misalign >= (size_t)size) {
+	if (!(chain->flags & BUF_CHAIN_REFERENCE) && chain->buffer_len - chain->misalign >= (size_t)size) {
 		/* already have enough space in the first chain */
 		size_t old_off = chain->off;
 		buffer = chain->buffer + chain->misalign + chain->off;
@@ -363,7 +856,7 @@ uint8_t* buffer_write_atmost(buffer_t* p)
 		chain = chain->next; // 从第二个块开始合并数据
 	}
 	else {
-		if ((tmp = buf_chain_new(size)) == NULL) {
+		if ((tmp = buf_chain_new(p->pool, size)) == NULL) {
 			return NULL;
 		}
 		buffer = tmp->buffer;
@@ -386,7 +879,7 @@ uint8_t* buffer_write_atmost(buffer_t* p)
 		if (&chain->next == p->last_with_datap) {
 			removed_last_with_datap = 1;
 		}
-		free(chain);
+		buf_chain_free(p->pool, chain);
 	}
 
 	if (chain != NULL) {
@@ -412,4 +905,114 @@ uint8_t* buffer_write_atmost(buffer_t* p)
 	}
 
 	return tmp->buffer + tmp->misalign;
+}
+
+uint8_t* buffer_write_atmost(buffer_t* p)
+{
+	return buffer_pullup(p, 0);
+}
+
+int buffer_read_fd(buffer_t* buf, int fd, uint32_t howmuch)
+{
+	buf_chain_t *tail, *fresh = NULL;
+	struct iovec vec[2];
+	uint32_t space = 0;
+	int nvec = 0;
+	int n;
+
+	if (howmuch == 0) {
+		howmuch = BUFFER_MAX_READ;
+	}
+	if (howmuch > BUFFER_CHAIN_MAX - buf->total_len) {
+		howmuch = BUFFER_CHAIN_MAX - buf->total_len;
+		if (howmuch == 0) {
+			errno = ENOBUFS;
+			return -1;
+		}
+	}
+
+	tail = *buf->last_with_datap;
+	if (tail) {
+		space = CHAIN_SPACE_LEN(tail);
+		if (space > howmuch) {
+			space = howmuch;
+		}
+		if (space) {
+			vec[nvec].iov_base = tail->buffer + tail->misalign + tail->off;
+			vec[nvec].iov_len = space;
+			nvec++;
+		}
+	}
+	if (space < howmuch) {
+		// 申请的大小加上 chain 头正好是 2 的幂，避免 buf_chain_new 向上取整时浪费一半
+		uint32_t want = howmuch - space;
+		fresh = buf_chain_new(buf->pool, want > BUFFER_CHAIN_SIZE ? want - BUFFER_CHAIN_SIZE : want);
+		if (fresh == NULL) {
+			if (nvec == 0) {
+				errno = ENOMEM;
+				return -1;
+			}
+		}
+		else {
+			vec[nvec].iov_base = fresh->buffer;
+			vec[nvec].iov_len = fresh->buffer_len < want ? fresh->buffer_len : want;
+			nvec++;
+		}
+	}
+
+	n = readv(fd, vec, nvec);
+	if (n <= 0) {
+		if (fresh) {
+			buf_chain_free(buf->pool, fresh);
+		}
+		return n;
+	}
+
+	uint32_t left = n;
+	if (space) {
+		uint32_t k = left < space ? left : space;
+		tail->off += k;
+		buf->total_len += k;
+		left -= k;
+	}
+	if (left) {
+		fresh->off = left;
+		buf_chain_insert(buf, fresh);
+	}
+	else if (fresh) {
+		buf_chain_free(buf->pool, fresh);
+	}
+	buffer_check_wm(buf);
+	return n;
+}
+
+int buffer_write_fd(buffer_t* buf, int fd, uint32_t howmuch)
+{
+	struct iovec vec[IOV_MAX];
+	buf_chain_t* chain = buf->first;
+	int nvec = 0;
+	int n;
+
+	if (howmuch == 0 || howmuch > buf->total_len) {
+		howmuch = buf->total_len;
+	}
+	if (howmuch == 0) {
+		return 0;
+	}
+	while (chain && nvec < IOV_MAX && howmuch) {
+		if (chain->off) {
+			uint32_t len = chain->off < howmuch ? chain->off : howmuch;
+			vec[nvec].iov_base = chain->buffer + chain->misalign;
+			vec[nvec].iov_len = len;
+			howmuch -= len;
+			nvec++;
+		}
+		chain = chain->next;
+	}
+
+	n = writev(fd, vec, nvec);
+	if (n > 0) {
+		buffer_drain(buf, n);
+	}
+	return n;
 }
\ No newline at end of file
@@ -2,9 +2,11 @@
 #define __CHAIN_BUFFER_H__
 
 #include <stdint.h>
+#include <sys/uio.h>
 
 typedef struct buf_chain_s buf_chain_t;
 typedef struct buffer_s buffer_t;
+typedef struct buf_pool_s buf_pool_t;
 
 struct buf_chain_s
 {
@@ -12,9 +14,19 @@ struct buf_chain_s
 	uint32_t buffer_len;
 	uint32_t misalign;
 	uint32_t off;
+	uint32_t flags;
+	uint32_t refcnt; //数据 chain 被持有的次数：所在 buffer 算一次，每个引用 chain 再算一次
+	struct buf_chain_s* parent; //引用 chain 指向的数据 chain
 	uint8_t* buffer;
 };
 
+// 引用 chain 只有头部，buffer 指向 parent 的数据，只读、没有剩余空间。
+// 计数不是原子的，共享只能发生在同一个线程（同一个 reactor）的 buffer 之间
+#define BUF_CHAIN_REFERENCE		0x1
+
+// 数据量向上越过 high（above 为 1）或向下回到 low（above 为 0）时调用，回调里不能释放这个 buffer
+typedef void (*buffer_wm_fn)(buffer_t* buf, int above, void* arg);
+
 struct buffer_s
 {
 	buf_chain_t* first;
@@ -22,6 +34,13 @@ struct buffer_s
 	buf_chain_t** last_with_datap; //假设有块A-->B,A的next指针指向B，这个二级指针实际上存储了块A的next指针的地址，便于直接修改块A的next指针
 	uint32_t total_len;
 	uint32_t last_read_pos; //for sep read
+	buf_chain_t* reserved; //buffer_reserve 返回的第一段所在的 chain，commit 从这里开始填
+	uint32_t wm_high; //为 0 时不检查水位
+	uint32_t wm_low;
+	int wm_above;
+	buffer_wm_fn wm_fn;
+	void* wm_arg;
+	buf_pool_t* pool; //为 NULL 时 chain 直接走 malloc/free
 };
 
 #define CHAIN_SPACE_LEN(ch) ((ch)->buffer_len - ((ch)->misalign + (ch)->off))
@@ -32,9 +51,41 @@ struct buffer_s
 #define BUFFER_CHAIN_MAX			16 * 1024 * 1024 //16M
 #define BUFFER_CHAIN_EXTRA(t, c)	(t*)((buf_chain_t*)(c) + 1) //计算数据块中 实际数据区的起始地址。设计逻辑：buf_chain_s 结构体和数据区分配在同一块内存（结构体在前，数据区在后），(buf_chain_t*)(c) + 1 表示 “跳过整个结构体的大小”（指针加 1 按结构体大小偏移），再转成目标类型 t * （比如 uint8_t * ），就是数据区的起始地址。
 #define BUFFER_CHAIN_SIZE			(sizeof(buf_chain_t))
+#define BUFFER_MAX_READ				65536 //buffer_read_fd 单次最多读取的字节数
+#define BUF_POOL_CLASSES			14 //1K ~ 8M，与 buf_chain_new 按 2 的幂取整后的尺寸一一对应
+#define BUF_POOL_MAX_BUFFERS		1024 //池中最多缓存的 buffer_t 个数
+#define BUF_POOL_MAX_REFS			65536 //池中最多缓存的引用 chain 头个数
+
+// chain 内存池：按尺寸分级缓存释放掉的 chain，单线程使用（每个 reactor 一个）
+struct buf_pool_s
+{
+	buf_chain_t* chains[BUF_POOL_CLASSES];
+	buffer_t* buffers;
+	uint32_t nbuffers;
+	buf_chain_t* refs; //空闲的引用 chain 头
+	uint32_t nrefs;
+	uint64_t cached; //空闲链表中缓存的字节数
+	uint64_t max_cached;
+	uint64_t chain_mallocs; //向 malloc 申请 chain 的次数
+	uint64_t chain_reuses; //从池中复用 chain 的次数
+	uint64_t used; //本池分配出去、还被 buffer 持有的 chain 字节数（不含 cached），chain 只在同一个池的 buffer 之间流转时才准确
+};
+
+buf_pool_t* buf_pool_new(uint64_t max_cached);
 
+void buf_pool_free(buf_pool_t* pool);
+
+buffer_t* buffer_new_with_pool(buf_pool_t* pool);
+
+// sz 大于 0 时预先分配一块至少能放 sz 字节的空 chain（和按需分配时一样按 2 的幂取整）
 buffer_t* buffer_new(uint32_t sz);
 
+// 设置高低水位，high 为 0 时关闭；设置时如果已经在 high 之上会立即回调一次
+void buffer_set_watermark(buffer_t* buf, uint32_t high, uint32_t low, buffer_wm_fn fn, void* arg);
+
+// 进程内所有 chain（包括各个池里缓存的）当前占用的字节数，多线程累计
+uint64_t buffer_mem_total(void);
+
 uint32_t buffer_len(buffer_t* buf);
 
 int buffer_add(buffer_t* buf, const void* data, uint32_t datlen);
@@ -45,8 +96,49 @@ int buffer_drain(buffer_t* buf, uint32_t len);
 
 void buffer_free(buffer_t* buf);
 
+// 把 src 的所有 chain 整体挂到 dst 末尾，不拷贝数据，src 变为空
+int buffer_add_buffer(buffer_t* dst, buffer_t* src);
+
+// 从 src 头部移动 datlen 字节到 dst：完整的 chain 直接挂过去，只有最后不完整的一段需要拷贝；返回移动的字节数
+int buffer_remove_buffer(buffer_t* src, buffer_t* dst, uint32_t datlen);
+
+// 以只读引用的方式把 src 的全部数据追加到 dst，src 不变：
+// 每个 chain 只新增一个引用头，同一份回复可以挂到任意多个输出 buffer 上
+int buffer_add_buffer_reference(buffer_t* dst, buffer_t* src);
+
+// 单独分配一个至少能放 size 字节数据的 chain（走池），让外部直接往 chain->buffer 里填数据
+buf_chain_t* buffer_chain_new(buf_pool_t* pool, uint32_t size);
+
+// 释放 buffer_chain_new 分配、还没交给 buffer 的 chain
+void buffer_chain_free(buf_pool_t* pool, buf_chain_t* chain);
+
+// 把填好的 chain 整个挂到 buf 末尾（chain->off 为数据长度），所有权交给 buf，不拷贝；返回挂上的字节数
+int buffer_add_chain(buffer_t* buf, buf_chain_t* chain);
+
 int buffer_search(buffer_t* buf, const char* sep, const int seplen);
 
+// 把全部数据合并成连续内存，等同于 buffer_pullup(p, 0)
 uint8_t* buffer_write_atmost(buffer_t* p);
 
+// 不拷贝地查看前 len 字节（0 表示全部）：最多填 n_vec 个 (ptr, len) 段，返回需要的段数，
+// 返回值大于 n_vec 时说明 vec 不够用；buffer 被修改之前指针一直有效
+int buffer_peek(buffer_t* buf, uint32_t len, struct iovec* vec, int n_vec);
+
+// 只把前 size 字节（0 表示全部）合并成连续内存并返回其指针，后面的 chain 不动；没有数据时返回 NULL
+uint8_t* buffer_pullup(buffer_t* p, uint32_t size);
+
+// 预留至少 size 字节的可写空间，调用方直接往里写，再用 buffer_commit 提交实际写入的长度，省掉一次中转拷贝。
+// n_vec 为 1 时保证空间连续；否则可能返回最后一个 chain 的剩余空间 + 一个新 chain 两段。返回段数，失败返回 -1。
+// reserve 和 commit 之间不能有其他写操作
+int buffer_reserve(buffer_t* buf, uint32_t size, struct iovec* vec, int n_vec);
+
+// 提交最近一次 buffer_reserve 空间里的前 size 字节，按 vec 的顺序填充；没用到的新 chain 会被释放
+int buffer_commit(buffer_t* buf, uint32_t size);
+
+// readv 直接读进最后一个 chain 的剩余空间 + 一个新 chain，howmuch 为 0 时最多读 BUFFER_MAX_READ
+int buffer_read_fd(buffer_t* buf, int fd, uint32_t howmuch);
+
+// writev 一次写出最多 IOV_MAX 个 chain 并 drain 掉已写部分，howmuch 为 0 时尽量全部写出
+int buffer_write_fd(buffer_t* buf, int fd, uint32_t howmuch);
+
 #endif
@@ -0,0 +1,452 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include "chainbuffer.h"
+#include "../memsearch/memsearch.h"
+
+// 编译: gcc -O2 chainbuffer.c ../memsearch/memsearch.c chainbuffer_bench.c -o chainbuffer_bench -lpthread
+// 用法: ./chainbuffer_bench io [总MB]
+//       ./chainbuffer_bench search [每种尺寸扫描的总MB]
+//       ./chainbuffer_bench echo [轮数] [消息 KB]
+//       ./chainbuffer_bench fanout [订阅者数] [消息字节] [轮数]
+//       ./chainbuffer_bench reserve [命令数(万)] [value 字节]
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// -------------------------- socket 读写：拷贝路径 vs readv/writev --------------------------
+#define IO_BATCH (256 * 1024) //写端攒够这么多数据再 flush，模拟 pipeline 的大批量回复
+
+enum { IO_COPY = 0, IO_VEC = 1 };
+
+typedef struct {
+    int fd;
+    int mode;
+    long total;
+} io_reader_t;
+
+static void* io_reader(void* arg)
+{
+    io_reader_t* a = (io_reader_t*)arg;
+    buffer_t* in = buffer_new(0);
+    long got = 0;
+    while (got < a->total) {
+        int n;
+        if (a->mode == IO_COPY) {
+            // 旧的 event_buffer_read：读到栈上再 buffer_add
+            char buf[1024] = { 0 };
+            n = read(a->fd, buf, sizeof(buf));
+            if (n > 0) {
+                buffer_add(in, buf, n);
+            }
+        }
+        else {
+            n = buffer_read_fd(in, a->fd, 0);
+        }
+        if (n <= 0) {
+            break;
+        }
+        got += n;
+        buffer_drain(in, buffer_len(in));
+    }
+    buffer_free(in);
+    return NULL;
+}
+
+static double io_run(int mode, int size, long total)
+{
+    int sv[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+    char* payload = malloc(size);
+    memset(payload, 'v', size);
+    total = total / size * size;
+
+    io_reader_t ra = { sv[1], mode, total };
+    pthread_t tid;
+    double t0 = now_sec();
+    pthread_create(&tid, NULL, io_reader, &ra);
+
+    buffer_t* out = buffer_new(0);
+    long queued = 0;
+    while (queued < total) {
+        while (buffer_len(out) < IO_BATCH && queued < total) {
+            buffer_add(out, payload, size);
+            queued += size;
+        }
+        while (buffer_len(out) > 0) {
+            if (mode == IO_COPY) {
+                // 旧的 EPOLLOUT 路径：先把整条链拷成连续内存再 write
+                int len = buffer_len(out);
+                uint8_t* p = buffer_write_atmost(out);
+                int n = write(sv[0], p, len);
+                if (n <= 0) {
+                    break;
+                }
+                buffer_drain(out, n);
+            }
+            else if (buffer_write_fd(out, sv[0], 0) <= 0) {
+                break;
+            }
+        }
+    }
+    pthread_join(tid, NULL);
+    double elapsed = now_sec() - t0;
+
+    buffer_free(out);
+    free(payload);
+    close(sv[0]);
+    close(sv[1]);
+    return total / elapsed / (1024 * 1024);
+}
+
+static void bench_io(long total_mb)
+{
+    int sizes[] = { 64, 4096, 1024 * 1024 };
+    long total = total_mb * 1024 * 1024;
+    printf("io bench: %ld MB per run over a unix socketpair\n", total_mb);
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        double copy = io_run(IO_COPY, sizes[i], total);
+        double vec = io_run(IO_VEC, sizes[i], total);
+        printf("payload=%-8d copy=%8.1f MB/s  readv/writev=%8.1f MB/s  (x%.2f)\n",
+            sizes[i], copy, vec, vec / copy);
+    }
+}
+
+// -------------------------- search：在大块 bulk 数据里找结尾的 \r\n --------------------------
+// 改造前的实现：每个偏移都调用一次跨 chain 的 memcmp
+static int legacy_check(buf_chain_t* chain, int from, const char* sep, int seplen)
+{
+    for (;;) {
+        int sz = chain->off - from;
+        if (sz >= seplen) {
+            return memcmp(chain->buffer + chain->misalign + from, sep, seplen) == 0;
+        }
+        if (sz > 0 && memcmp(chain->buffer + chain->misalign + from, sep, sz)) {
+            return 0;
+        }
+        chain = chain->next;
+        sep += sz;
+        seplen -= sz;
+        from = 0;
+    }
+}
+
+static int legacy_search(buffer_t* buf, const char* sep, int seplen)
+{
+    buf_chain_t* chain = buf->first;
+    int from = 0, bytes = chain->off;
+    for (uint32_t i = 0; i + seplen <= buf->total_len; i++) {
+        if (legacy_check(chain, from, sep, seplen)) {
+            return i + seplen;
+        }
+        ++from;
+        if (--bytes == 0) {
+            chain = chain->next;
+            if (chain == NULL) {
+                break;
+            }
+            from = 0;
+            bytes = chain->off;
+        }
+    }
+    return 0;
+}
+
+static double search_run(buffer_t* buf, int level, long reps)
+{
+    int expect = buffer_len(buf);
+    double t0 = now_sec();
+    for (long i = 0; i < reps; i++) {
+        buf->last_read_pos = 0;
+        int pos = level < 0 ? legacy_search(buf, "\r\n", 2) : buffer_search(buf, "\r\n", 2);
+        if (pos != expect) {
+            printf("search returned %d, expected %d\n", pos, expect);
+            return 0;
+        }
+    }
+    return (double)expect * reps / (now_sec() - t0) / 1e9;
+}
+
+static void bench_search(long total_mb)
+{
+    uint32_t sizes[] = { 1024, 16 * 1024, 256 * 1024, 1024 * 1024, 16 * 1024 * 1024 };
+    // bulk 数据里偶尔出现 \r，但后面不是 \n
+    uint8_t chunk[16 * 1024];
+    srand(3);
+    for (size_t i = 0; i < sizeof(chunk); i++) {
+        chunk[i] = rand() % 64 == 0 ? '\r' : 'a' + rand() % 26;
+    }
+    int levels[] = { MEMSEARCH_SCALAR, MEMSEARCH_SSE2, MEMSEARCH_AVX2 };
+    int best = memsearch_level();
+
+    printf("search bench: scan %ld MB per size for a trailing \\r\\n, GB/s\n", total_mb);
+    printf("%-10s %8s %8s %8s %8s\n", "size", "legacy", "scalar", "sse2", "avx2");
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        buffer_t* buf = buffer_new(0);
+        uint32_t left = sizes[i] - 2;
+        while (left > 0) {
+            uint32_t n = left < sizeof(chunk) ? left : sizeof(chunk);
+            buffer_add(buf, chunk, n);
+            left -= n;
+        }
+        buffer_add(buf, "\r\n", 2);
+        long reps = (total_mb << 20) / sizes[i];
+        if (reps == 0) {
+            reps = 1;
+        }
+
+        printf("%-10u %8.2f", sizes[i], search_run(buf, -1, reps / 8 + 1));
+        for (size_t l = 0; l < sizeof(levels) / sizeof(levels[0]); l++) {
+            if (memsearch_set_level(levels[l]) != levels[l]) {
+                printf(" %8s", "-");
+                continue;
+            }
+            printf(" %8.2f", search_run(buf, levels[l], reps));
+        }
+        printf("\n");
+        memsearch_set_level(best);
+        buffer_free(buf);
+    }
+}
+
+// -------------------------- echo：输入缓冲区原样转到输出缓冲区 --------------------------
+// 输入按 16KB 一次到达（和 buffer_read_fd 的节奏一样），攒满一条消息后回声：
+// atmost 先把整条消息合并成连续内存再 buffer_add，peek 按 chain 分段 buffer_add
+enum { ECHO_ATMOST = 0, ECHO_PEEK = 1 };
+
+static double echo_run(int mode, long rounds, uint32_t msg_len)
+{
+    buf_pool_t* pool = buf_pool_new(64 * 1024 * 1024);
+    buffer_t* in = buffer_new_with_pool(pool);
+    buffer_t* out = buffer_new_with_pool(pool);
+    uint8_t chunk[16 * 1024];
+    memset(chunk, 'e', sizeof(chunk));
+    struct iovec vec[256];
+
+    double t0 = now_sec();
+    for (long r = 0; r < rounds; r++) {
+        for (uint32_t left = msg_len; left > 0; ) {
+            uint32_t n = left < sizeof(chunk) ? left : sizeof(chunk);
+            buffer_add(in, chunk, n);
+            left -= n;
+        }
+        if (mode == ECHO_ATMOST) {
+            buffer_add(out, buffer_write_atmost(in), msg_len);
+        }
+        else {
+            int n = buffer_peek(in, msg_len, vec, 256);
+            for (int i = 0; i < n; i++) {
+                buffer_add(out, vec[i].iov_base, vec[i].iov_len);
+            }
+        }
+        buffer_drain(in, msg_len);
+        buffer_drain(out, msg_len); //假装已经写到 socket
+    }
+    double elapsed = now_sec() - t0;
+
+    buffer_free(in);
+    buffer_free(out);
+    buf_pool_free(pool);
+    return (double)msg_len * rounds / elapsed / (1024 * 1024);
+}
+
+static void bench_echo(long rounds, uint32_t msg_kb)
+{
+    uint32_t msg_len = msg_kb * 1024;
+    printf("echo bench: %ld rounds of %u KB messages\n", rounds, msg_kb);
+    double atmost = echo_run(ECHO_ATMOST, rounds, msg_len);
+    double peek = echo_run(ECHO_PEEK, rounds, msg_len);
+    printf("write_atmost=%8.1f MB/s  peek=%8.1f MB/s  (x%.2f)\n", atmost, peek, peek / atmost);
+}
+
+// -------------------------- fanout：一条发布消息写给所有订阅者 --------------------------
+// copy 每个订阅者 buffer_add 一份，ref 只挂引用 chain；订阅者随后全部写出（drain）
+enum { FANOUT_COPY = 0, FANOUT_REF = 1 };
+
+// 订阅者输出缓冲区实际占用的内存，被共享的数据 chain 只算一次
+static uint64_t fanout_mem(buffer_t** subs, int nsubs, buffer_t* pub)
+{
+    uint64_t mem = 0;
+    for (buf_chain_t* c = pub->first; c; c = c->next) {
+        mem += BUFFER_CHAIN_SIZE + c->buffer_len;
+    }
+    for (int i = 0; i < nsubs; i++) {
+        for (buf_chain_t* c = subs[i]->first; c; c = c->next) {
+            mem += BUFFER_CHAIN_SIZE + ((c->flags & BUF_CHAIN_REFERENCE) ? 0 : c->buffer_len);
+        }
+    }
+    return mem;
+}
+
+static double fanout_run(int mode, int nsubs, uint32_t msg_len, long rounds, uint64_t* mem)
+{
+    buf_pool_t* pool = buf_pool_new(256 * 1024 * 1024);
+    buffer_t* pub = buffer_new_with_pool(pool);
+    buffer_t** subs = malloc(sizeof(buffer_t*) * nsubs);
+    for (int i = 0; i < nsubs; i++) {
+        subs[i] = buffer_new_with_pool(pool);
+    }
+    uint8_t* msg = malloc(msg_len);
+    memset(msg, 'f', msg_len);
+
+    double t0 = now_sec();
+    for (long r = 0; r < rounds; r++) {
+        buffer_add(pub, msg, msg_len);
+        for (int i = 0; i < nsubs; i++) {
+            if (mode == FANOUT_COPY) {
+                struct iovec vec[64];
+                int n = buffer_peek(pub, 0, vec, 64);
+                for (int k = 0; k < n; k++) {
+                    buffer_add(subs[i], vec[k].iov_base, vec[k].iov_len);
+                }
+            }
+            else {
+                buffer_add_buffer_reference(subs[i], pub);
+            }
+        }
+        if (r == 0) {
+            *mem = fanout_mem(subs, nsubs, pub);
+        }
+        buffer_drain(pub, msg_len);
+        for (int i = 0; i < nsubs; i++) {
+            buffer_drain(subs[i], msg_len); //假装已经写到 socket
+        }
+    }
+    double elapsed = now_sec() - t0;
+
+    for (int i = 0; i < nsubs; i++) {
+        buffer_free(subs[i]);
+    }
+    free(subs);
+    free(msg);
+    buffer_free(pub);
+    buf_pool_free(pool);
+    return (double)rounds / elapsed;
+}
+
+static void bench_fanout(int nsubs, uint32_t msg_len, long rounds)
+{
+    printf("fanout bench: %d subscribers, %u byte messages, %ld rounds\n", nsubs, msg_len, rounds);
+    uint64_t copy_mem, ref_mem;
+    double copy = fanout_run(FANOUT_COPY, nsubs, msg_len, rounds, &copy_mem);
+    double ref = fanout_run(FANOUT_REF, nsubs, msg_len, rounds, &ref_mem);
+    printf("copy=%8.1f msg/s  %8.1f MB\n", copy, copy_mem / (1024.0 * 1024));
+    printf("ref =%8.1f msg/s  %8.1f MB  (x%.2f)\n", ref, ref_mem / (1024.0 * 1024), ref / copy);
+}
+
+// -------------------------- reserve：RESP 命令直接编码进输出缓冲区 --------------------------
+// staging 先编码到栈上的临时缓冲区再 buffer_add，reserve 直接编码进 chain 再 commit；
+// 每 64KB 假装写出一次
+enum { ENC_STAGING = 0, ENC_RESERVE = 1 };
+
+static char* enc_bulk(char* p, const char* s, int len)
+{
+    *p++ = '$';
+    if (len >= 1000) *p++ = '0' + len / 1000 % 10;
+    if (len >= 100) *p++ = '0' + len / 100 % 10;
+    if (len >= 10) *p++ = '0' + len / 10 % 10;
+    *p++ = '0' + len % 10;
+    *p++ = '\r';
+    *p++ = '\n';
+    memcpy(p, s, len);
+    p += len;
+    *p++ = '\r';
+    *p++ = '\n';
+    return p;
+}
+
+static int enc_set(char* p, long i, const char* value, int vlen)
+{
+    char key[16];
+    snprintf(key, sizeof(key), "key:%08ld", i % 100000000);
+    char* start = p;
+    memcpy(p, "*3\r\n", 4);
+    p = enc_bulk(p + 4, "SET", 3);
+    p = enc_bulk(p, key, 12);
+    p = enc_bulk(p, value, vlen);
+    return p - start;
+}
+
+static double reserve_run(int mode, long cmds, const char* value, int vlen)
+{
+    buf_pool_t* pool = buf_pool_new(64 * 1024 * 1024);
+    buffer_t* out = buffer_new_with_pool(pool);
+    char scratch[4096];
+    uint32_t max = vlen + 64;
+
+    double t0 = now_sec();
+    for (long i = 0; i < cmds; i++) {
+        if (mode == ENC_STAGING) {
+            buffer_add(out, scratch, enc_set(scratch, i, value, vlen));
+        }
+        else {
+            struct iovec vec;
+            buffer_reserve(out, max, &vec, 1);
+            buffer_commit(out, enc_set(vec.iov_base, i, value, vlen));
+        }
+        if (buffer_len(out) >= 64 * 1024) {
+            buffer_drain(out, buffer_len(out));
+        }
+    }
+    double elapsed = now_sec() - t0;
+
+    buffer_free(out);
+    buf_pool_free(pool);
+    return cmds / elapsed / 1e6;
+}
+
+static void bench_reserve(long cmds, int vlen)
+{
+    if (vlen > 3000) {
+        vlen = 3000;
+    }
+    char* value = malloc(vlen);
+    memset(value, 'v', vlen);
+    printf("reserve bench: %ld SET commands, %d byte values\n", cmds, vlen);
+    double staging = reserve_run(ENC_STAGING, cmds, value, vlen);
+    double reserve = reserve_run(ENC_RESERVE, cmds, value, vlen);
+    printf("staging=%6.2f Mcmd/s  reserve=%6.2f Mcmd/s  (x%.2f)\n", staging, reserve, reserve / staging);
+    free(value);
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        printf("usage: %s io [total_mb]\n", argv[0]);
+        printf("       %s search [total_mb]\n", argv[0]);
+        printf("       %s echo [rounds] [msg_kb]\n", argv[0]);
+        printf("       %s fanout [subscribers] [msg_bytes] [rounds]\n", argv[0]);
+        printf("       %s reserve [commands_10k] [value_bytes]\n", argv[0]);
+        return 1;
+    }
+    if (strcmp(argv[1], "io") == 0) {
+        bench_io(argc > 2 ? atol(argv[2]) : 512);
+        return 0;
+    }
+    if (strcmp(argv[1], "search") == 0) {
+        bench_search(argc > 2 ? atol(argv[2]) : 1024);
+        return 0;
+    }
+    if (strcmp(argv[1], "echo") == 0) {
+        bench_echo(argc > 2 ? atol(argv[2]) : 2000, argc > 3 ? atoi(argv[3]) : 1024);
+        return 0;
+    }
+    if (strcmp(argv[1], "fanout") == 0) {
+        bench_fanout(argc > 2 ? atoi(argv[2]) : 10000, argc > 3 ? atoi(argv[3]) : 4096, argc > 4 ? atol(argv[4]) : 200);
+        return 0;
+    }
+    if (strcmp(argv[1], "reserve") == 0) {
+        bench_reserve((argc > 2 ? atol(argv[2]) : 500) * 10000, argc > 3 ? atoi(argv[3]) : 64);
+        return 0;
+    }
+    printf("unknown bench: %s\n", argv[1]);
+    return 1;
+}
@@ -3,6 +3,8 @@
 #include <assert.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <unistd.h>
+#include <sys/socket.h>
 #include "chainbuffer.h"  // 引入你的缓冲区头文件
 
 // -------------------------- 辅助工具函数 --------------------------
@@ -37,6 +39,17 @@ void test_buffer_create_free() {
     assert(buffer_len(buf) == 0); // 初始长度为0
     assert(buf->first == NULL);   // 初始无数据块
     buffer_free(buf);             // 释放无崩溃（防内存泄漏，可配合valgrind验证）
+
+    // 指定大小时预先分配一块空 chain，写满它之前不再分配
+    buf = buffer_new(3000);
+    assert(buf != NULL && buffer_len(buf) == 0);
+    assert(buf->first != NULL && buf->first->buffer_len >= 3000);
+    buf_chain_t* first = buf->first;
+    char data[3000];
+    memset(data, 'x', sizeof(data));
+    assert(buffer_add(buf, data, sizeof(data)) == 0);
+    assert(buf->first == first && buf->last == first && buffer_len(buf) == sizeof(data));
+    buffer_free(buf);
     TEST_PASS();
 }
 
@@ -51,7 +64,7 @@ void test_buffer_single_block_add_remove() {
     int data_len = strlen(data);
     int ret = buffer_add(buf, data, data_len);
     assert(ret == 0);                  // 添加成功
-    assert(buffer_len(buf) == data_len);// 长度正确
+    assert(buffer_len(buf) == (uint32_t)data_len);// 长度正确
 
     // 2. 读取数据
     char read_buf[1024] = { 0 };
@@ -81,7 +94,7 @@ void test_buffer_cross_block_merge() {
 
     assert(buffer_add(buf, data1, len1) == 0);
     assert(buffer_add(buf, data2, len2) == 0);
-    assert(buffer_len(buf) == len1 + len2); // 总长度正确
+    assert(buffer_len(buf) == (uint32_t)(len1 + len2)); // 总长度正确
 
     // 2. 合并数据（buffer_write_atmost）
     uint8_t* merged_buf = buffer_write_atmost(buf);
@@ -117,12 +130,12 @@ void test_buffer_drain() {
     const char* data = "abcdefghijklmnopqrst";
     int data_len = strlen(data);
     assert(buffer_add(buf, data, data_len) == 0);
-    assert(buffer_len(buf) == data_len);
+    assert(buffer_len(buf) == (uint32_t)data_len);
 
     // 2. 部分删除（删除前5字节）
     int drain_len1 = 5;
     assert(buffer_drain(buf, drain_len1) == drain_len1);
-    assert(buffer_len(buf) == data_len - drain_len1);
+    assert(buffer_len(buf) == (uint32_t)(data_len - drain_len1));
 
     // 验证剩余数据（从第6字节开始）
     char read_buf1[100] = { 0 };
@@ -211,6 +224,476 @@ void test_buffer_exception() {
     TEST_PASS();
 }
 
+// 测试7：chain 内存池复用
+void test_buffer_pool() {
+    TEST_START("buffer_pool");
+    buf_pool_t* pool = buf_pool_new(1024 * 1024);
+    assert(pool != NULL);
+
+    buffer_t* buf = buffer_new_with_pool(pool);
+    char data[600];
+    memset(data, 'P', sizeof(data));
+    assert(buffer_add(buf, data, sizeof(data)) == 0);
+    assert(pool->chain_mallocs == 1);
+
+    // 清空后 chain 回到池中，再次写入时复用同一尺寸级别的 chain
+    assert(buffer_drain(buf, sizeof(data)) == sizeof(data));
+    assert(pool->cached > 0);
+    assert(buffer_add(buf, data, sizeof(data)) == 0);
+    assert(pool->chain_mallocs == 1);
+    assert(pool->chain_reuses == 1);
+
+    // buffer_t 结构体本身也会被回收复用
+    buffer_free(buf);
+    assert(pool->nbuffers == 1);
+    buffer_t* buf2 = buffer_new_with_pool(pool);
+    assert(buf2 == buf);
+    assert(buffer_len(buf2) == 0 && buf2->first == NULL);
+    buffer_free(buf2);
+
+    // 超过缓存上限的 chain 直接释放
+    pool->max_cached = 0;
+    buf = buffer_new_with_pool(pool);
+    assert(buffer_add(buf, data, sizeof(data)) == 0);
+    assert(pool->chain_reuses == 2 && pool->cached == 0);
+    buffer_drain(buf, sizeof(data));
+    assert(pool->cached == 0);
+    buffer_free(buf);
+
+    buf_pool_free(pool);
+    TEST_PASS();
+}
+
+// 测试8：readv/writev 直接在 chain 上收发
+void test_buffer_fd_io() {
+    TEST_START("buffer_fd_io");
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    buffer_t* out = buffer_new(0);
+    buffer_t* in = buffer_new(0);
+
+    // 构造多个 chain，writev 一次写出
+    char data[3000];
+    for (int i = 0; i < (int)sizeof(data); i++) {
+        data[i] = 'a' + i % 26;
+    }
+    assert(buffer_add(out, data, 1000) == 0);
+    assert(buffer_add(out, data + 1000, 2000) == 0);
+    assert(out->first != out->last);
+    assert(buffer_write_fd(out, sv[0], 0) == 3000);
+    assert(buffer_len(out) == 0);
+
+    // 先放一点数据，readv 先填满尾部 chain 的剩余空间再落到新 chain
+    assert(buffer_add(in, "xy", 2) == 0);
+    int total = 0;
+    while (total < 3000) {
+        int n = buffer_read_fd(in, sv[1], 0);
+        assert(n > 0);
+        total += n;
+    }
+    assert(buffer_len(in) == 3002);
+    char check[3002];
+    assert(buffer_remove(in, check, sizeof(check)) == 3002);
+    assert(memcmp(check, "xy", 2) == 0);
+    assert(memcmp(check + 2, data, 3000) == 0);
+
+    // 限定读取长度
+    assert(write(sv[0], data, 100) == 100);
+    assert(buffer_read_fd(in, sv[1], 10) == 10);
+    assert(buffer_len(in) == 10);
+
+    buffer_free(out);
+    buffer_free(in);
+    close(sv[0]);
+    close(sv[1]);
+    TEST_PASS();
+}
+// 测试9：分隔符跨 chain 边界、断点续搜，随机数据与朴素实现对比
+void test_buffer_search_chains() {
+    TEST_START("buffer_search_chains");
+    buffer_t* buf = buffer_new(0);
+    assert(buf != NULL);
+
+    // 数据比分隔符短，不能越过最后一个 chain
+    assert(buffer_add(buf, "\r", 1) == 0);
+    assert(buffer_search(buf, "\r\n", 2) == 0);
+    buffer_drain(buf, buffer_len(buf));
+    buf->last_read_pos = 0;
+
+    // "\r" 正好是第一个 chain 的最后一个字节，"\n" 晚些才到达
+    assert(buffer_add(buf, "x", 1) == 0);
+    uint32_t cap = CHAIN_SPACE_LEN(buf->first);
+    char* fill = malloc(cap);
+    memset(fill, 'x', cap);
+    fill[cap - 1] = '\r';
+    assert(buffer_add(buf, fill, cap) == 0);
+    assert(buf->first->next == NULL);
+    assert(buffer_search(buf, "\r\n", 2) == 0);
+    assert(buf->last_read_pos == cap); //之前的起点都已确认不匹配
+    assert(buffer_add(buf, "\nyy", 3) == 0);
+    assert(buf->first->next != NULL);
+    assert(buffer_search(buf, "\r\n", 2) == (int)cap + 2);
+    assert(buf->last_read_pos == 0);
+    buffer_drain(buf, buffer_len(buf));
+    free(fill);
+
+    // 随机切成很多小块写入，分两次搜索
+    srand(11);
+    char data[5000];
+    for (int round = 0; round < 200; round++) {
+        int n = rand() % sizeof(data);
+        for (int i = 0; i < n; i++) {
+            data[i] = "xy\r\n"[rand() % 4 == 0 ? 2 + rand() % 2 : rand() % 2];
+        }
+        const char* sep = round % 2 ? "\r\n" : "\r\n\r\n";
+        int seplen = strlen(sep);
+        int expect = 0;
+        for (int i = 0; i + seplen <= n; i++) {
+            if (memcmp(data + i, sep, seplen) == 0) {
+                expect = i + seplen;
+                break;
+            }
+        }
+        int half = n / 2, got = 0;
+        buffer_t* b = buffer_new(0);
+        for (int off = 0; off < n; ) {
+            int len = 1 + rand() % 300;
+            if (len > n - off) {
+                len = n - off;
+            }
+            assert(buffer_add(b, data + off, len) == 0);
+            off += len;
+            if (off >= half && !got) {
+                // 前一半先搜一次，剩下的数据到达后从 last_read_pos 续搜
+                got = buffer_search(b, sep, seplen);
+                if (got) {
+                    break;
+                }
+                got = -1;
+            }
+        }
+        if (got <= 0) {
+            got = buffer_search(b, sep, seplen);
+        }
+        assert(got == expect);
+        buffer_free(b);
+    }
+
+    buffer_free(buf);
+    TEST_PASS();
+}
+// 测试10：peek 不拷贝地查看多个 chain，pullup 只合并前 n 字节
+void test_buffer_peek_pullup() {
+    TEST_START("buffer_peek_pullup");
+    buffer_t* buf = buffer_new(0);
+    struct iovec vec[8];
+    assert(buffer_peek(buf, 0, vec, 8) == 0);
+    assert(buffer_pullup(buf, 10) == NULL);
+
+    // 第一个 chain 填满，剩下的数据落到后面的 chain
+    char data[3000];
+    for (int i = 0; i < (int)sizeof(data); i++) {
+        data[i] = 'a' + i % 26;
+    }
+    assert(buffer_add(buf, data, 100) == 0);
+    uint32_t first = 100 + CHAIN_SPACE_LEN(buf->first);
+    assert(buffer_add(buf, data + 100, sizeof(data) - 100) == 0);
+    assert(buf->first->off == first);
+
+    int n = buffer_peek(buf, 0, vec, 8);
+    assert(n == 2);
+    assert(vec[0].iov_len == first && vec[0].iov_base == buf->first->buffer + buf->first->misalign);
+    assert(vec[1].iov_len == sizeof(data) - first);
+    assert(memcmp(vec[1].iov_base, data + first, vec[1].iov_len) == 0);
+    // 只看前 first + 5 字节，vec 不够时返回需要的段数
+    assert(buffer_peek(buf, first + 5, vec, 8) == 2 && vec[1].iov_len == 5);
+    assert(buffer_peek(buf, 0, vec, 1) == 2);
+    assert(buffer_peek(buf, 10, vec, 8) == 1 && vec[0].iov_len == 10);
+
+    // 已经连续时直接返回第一个 chain
+    assert(buffer_pullup(buf, first) == buf->first->buffer + buf->first->misalign);
+
+    // 合并前 first + 10 字节，剩下的留在原 chain
+    uint8_t* p = buffer_pullup(buf, first + 10);
+    assert(p != NULL);
+    assert(memcmp(p, data, first + 10) == 0);
+    assert(buf->first->off >= first + 10);
+    assert(buffer_len(buf) == sizeof(data));
+    n = buffer_peek(buf, 0, vec, 8);
+    assert(vec[0].iov_len + (n == 2 ? vec[1].iov_len : 0) == sizeof(data));
+
+    // 全部合并后内容不变，后续追加正常
+    p = buffer_pullup(buf, 0);
+    assert(memcmp(p, data, sizeof(data)) == 0);
+    assert(buffer_peek(buf, 0, vec, 8) == 1);
+    assert(buffer_add(buf, "tail", 4) == 0);
+    assert(buffer_len(buf) == sizeof(data) + 4);
+    char out[sizeof(data) + 4];
+    assert(buffer_remove(buf, out, sizeof(out)) == (int)sizeof(out));
+    assert(memcmp(out, data, sizeof(data)) == 0 && memcmp(out + sizeof(data), "tail", 4) == 0);
+
+    buffer_free(buf);
+    TEST_PASS();
+}
+
+// 测试用例：buffer 之间整体移动、部分移动和引用共享
+void test_buffer_move_reference() {
+    TEST_START("buffer_move_reference");
+    buf_pool_t* pool = buf_pool_new(1024 * 1024);
+    buffer_t* src = buffer_new_with_pool(pool);
+    buffer_t* dst = buffer_new_with_pool(pool);
+    char data[5000];
+    for (int i = 0; i < (int)sizeof(data); i++) {
+        data[i] = 'a' + i % 26;
+    }
+    char out[sizeof(data) * 3];
+
+    // 整体移动：chain 直接挂到 dst 后面，dst 原有数据在前
+    assert(buffer_add(dst, "head", 4) == 0);
+    assert(buffer_add(src, data, sizeof(data)) == 0);
+    buf_chain_t* moved = src->first;
+    assert(buffer_add_buffer(dst, src) == 0);
+    assert(buffer_len(src) == 0 && src->first == NULL);
+    assert(buffer_len(dst) == 4 + sizeof(data));
+    assert(dst->first->next == moved);
+    // 移动后两边都能继续正常追加
+    assert(buffer_add(src, "x", 1) == 0);
+    assert(buffer_add(dst, "tail", 4) == 0);
+    assert(buffer_remove(dst, out, sizeof(out)) == (int)(8 + sizeof(data)));
+    assert(memcmp(out, "head", 4) == 0 && memcmp(out + 4, data, sizeof(data)) == 0);
+    assert(memcmp(out + 4 + sizeof(data), "tail", 4) == 0);
+    buffer_drain(src, 1);
+
+    // 部分移动：完整的 chain 直接挂，不完整的那段拷贝
+    assert(buffer_add(src, data, 100) == 0);
+    uint32_t first = 100 + CHAIN_SPACE_LEN(src->first);
+    assert(buffer_add(src, data + 100, sizeof(data) - 100) == 0);
+    moved = src->first;
+    assert(buffer_remove_buffer(src, dst, first + 10) == (int)first + 10);
+    assert(dst->first == moved);
+    assert(buffer_len(dst) == first + 10 && buffer_len(src) == sizeof(data) - first - 10);
+    assert(buffer_add(src, "!", 1) == 0);
+    assert(buffer_remove(src, out, sizeof(out)) == (int)(sizeof(data) - first - 9));
+    assert(memcmp(out, data + first + 10, sizeof(data) - first - 10) == 0 && out[sizeof(data) - first - 10] == '!');
+    assert(buffer_remove(dst, out, sizeof(out)) == (int)first + 10);
+    assert(memcmp(out, data, first + 10) == 0);
+
+    // 引用：多个订阅者共享同一份数据，src 释放后数据仍然有效
+    assert(buffer_add(src, data, sizeof(data)) == 0);
+    buffer_t* subs[4];
+    for (int i = 0; i < 4; i++) {
+        subs[i] = buffer_new_with_pool(pool);
+        assert(buffer_add(subs[i], "sub:", 4) == 0);
+        assert(buffer_add_buffer_reference(subs[i], src) == 0);
+        assert(buffer_len(subs[i]) == 4 + sizeof(data));
+    }
+    buf_chain_t* shared = src->first;
+    assert(shared->refcnt == 5);
+    assert(subs[0]->first->next->buffer == shared->buffer + shared->misalign);
+    // 引用 chain 没有剩余空间，追加会新开 chain；src 追加到被引用的 chain 后面不影响已共享的部分
+    assert(buffer_add(subs[0], "end", 3) == 0);
+    assert(buffer_add(src, "more", 4) == 0);
+    buffer_drain(src, sizeof(data) + 4);
+    // 引用的引用指向同一个数据 chain
+    assert(buffer_add_buffer_reference(subs[3], subs[2]) == 0);
+
+    buffer_drain(subs[1], 10);
+    // pullup 不能往引用 chain 里写，也不能移动被共享的数据
+    uint8_t* p = buffer_pullup(subs[1], 100);
+    assert(memcmp(p, data + 6, 100) == 0);
+    assert(buffer_remove(subs[1], out, sizeof(out)) == (int)sizeof(data) - 6);
+    assert(memcmp(out, data + 6, sizeof(data) - 6) == 0);
+
+    assert(buffer_remove(subs[0], out, sizeof(out)) == (int)sizeof(data) + 7);
+    assert(memcmp(out + 4, data, sizeof(data)) == 0 && memcmp(out + 4 + sizeof(data), "end", 3) == 0);
+    assert(buffer_len(subs[3]) == 2 * (4 + sizeof(data)));
+    buffer_free(subs[2]);
+    buffer_free(subs[1]);
+    assert(buffer_remove(subs[3], out, sizeof(out)) == (int)(2 * (4 + sizeof(data))));
+    assert(memcmp(out + 4, data, sizeof(data)) == 0 && memcmp(out + 8 + sizeof(data), data, sizeof(data)) == 0);
+    buffer_free(subs[0]);
+    buffer_free(subs[3]);
+
+    buffer_free(src);
+    buffer_free(dst);
+    buf_pool_free(pool);
+    TEST_PASS();
+}
+
+// 测试用例：预留空间直接写入再提交
+void test_buffer_reserve_commit() {
+    TEST_START("buffer_reserve_commit");
+    buffer_t* buf = buffer_new(0);
+    struct iovec vec[2];
+    char out[8192];
+
+    // 空 buffer：一段连续空间
+    assert(buffer_reserve(buf, 0, vec, 2) == -1);
+    assert(buffer_reserve(buf, 100, vec, 1) == 1);
+    assert(vec[0].iov_len >= 100);
+    int n = snprintf(vec[0].iov_base, vec[0].iov_len, "*%d\r\n$%d\r\n", 1, 4);
+    assert(buffer_commit(buf, n) == 0);
+    assert(buffer_len(buf) == (uint32_t)n);
+
+    // 剩余空间够用时直接接在已有数据后面
+    assert(buffer_reserve(buf, 6, vec, 2) == 1);
+    assert(vec[0].iov_base == buf->first->buffer + buf->first->misalign + n);
+    memcpy(vec[0].iov_base, "PING\r\n", 6);
+    assert(buffer_commit(buf, 6) == 0);
+    assert(buffer_remove(buf, out, sizeof(out)) == n + 6);
+    assert(memcmp(out, "*1\r\n$4\r\nPING\r\n", n + 6) == 0);
+
+    // 剩余空间不够：n_vec 为 2 时分两段，只提交一部分时没用到的 chain 被释放
+    char data[6000];
+    for (int i = 0; i < (int)sizeof(data); i++) {
+        data[i] = 'a' + i % 26;
+    }
+    assert(buffer_add(buf, data, 10) == 0);
+    uint32_t space = CHAIN_SPACE_LEN(buf->first);
+    assert(buffer_reserve(buf, space + 3000, vec, 2) == 2);
+    assert(vec[0].iov_len == space && vec[1].iov_len >= 3000);
+    memcpy(vec[0].iov_base, data + 10, space);
+    memcpy(vec[1].iov_base, data + 10 + space, 3000);
+    assert(buffer_commit(buf, space + 3000 + vec[1].iov_len) == -1);
+    assert(buffer_commit(buf, space + 100) == 0);
+    assert(buffer_len(buf) == 10 + space + 100);
+    assert(buf->last == buf->first->next && buf->last->off == 100);
+    assert(buffer_remove(buf, out, sizeof(out)) == (int)(10 + space + 100));
+    assert(memcmp(out, data, 10 + space + 100) == 0);
+
+    // n_vec 为 1 时保证连续；commit(0) 放弃预留，原有数据不受影响
+    assert(buffer_add(buf, data, 10) == 0);
+    assert(buffer_reserve(buf, 5000, vec, 1) == 1);
+    assert(vec[0].iov_len >= 5000);
+    assert(buffer_commit(buf, 0) == 0);
+    assert(buffer_len(buf) == 10 && buf->first->next == NULL);
+    assert(buffer_reserve(buf, 5000, vec, 1) == 1);
+    memcpy(vec[0].iov_base, data + 10, 5000);
+    assert(buffer_commit(buf, 5000) == 0);
+    assert(buffer_remove(buf, out, sizeof(out)) == 5010);
+    assert(memcmp(out, data, 5010) == 0);
+    assert(buffer_commit(buf, 0) == 0 && buf->first == NULL);
+
+    // 最后一个 chain 是空的（buffer_new 预分配的、commit(0) 留下的）：n_vec 为 2 时两段都可写
+    for (int k = 0; k < 2; k++) {
+        buffer_t* b = k == 0 ? buffer_new(3000) : buffer_new(0);
+        if (k == 1) {
+            assert(buffer_reserve(b, 100, vec, 1) == 1);
+            assert(buffer_commit(b, 0) == 0);
+        }
+        assert(b->first && b->first->off == 0);
+        uint32_t want = CHAIN_SPACE_LEN(b->first) + 1000;
+        assert(want <= sizeof(out));
+        n = buffer_reserve(b, want, vec, 2);
+        assert(n == 2 && vec[0].iov_len + vec[1].iov_len >= want);
+        memset(vec[0].iov_base, 'x', vec[0].iov_len);
+        memset(vec[1].iov_base, 'y', vec[1].iov_len);
+        assert(buffer_commit(b, want) == 0);
+        assert(buffer_len(b) == want);
+        assert(buffer_remove(b, out, sizeof(out)) == (int)want);
+        assert(out[vec[0].iov_len - 1] == 'x' && out[vec[0].iov_len] == 'y' && out[want - 1] == 'y');
+        buffer_free(b);
+    }
+
+    // read 直接读进 chain
+    int fds[2];
+    assert(pipe(fds) == 0);
+    assert(write(fds[1], data, 3000) == 3000);
+    assert(buffer_reserve(buf, 4096, vec, 2) == 1);
+    n = read(fds[0], vec[0].iov_base, vec[0].iov_len);
+    assert(n == 3000);
+    assert(buffer_commit(buf, n) == 0);
+    assert(buffer_remove(buf, out, sizeof(out)) == 3000);
+    assert(memcmp(out, data, 3000) == 0);
+    close(fds[0]);
+    close(fds[1]);
+
+    buffer_free(buf);
+    TEST_PASS();
+}
+
+static int wm_calls[2];
+
+static void wm_cb(buffer_t* buf, int above, void* arg) {
+    wm_calls[above]++;
+    *(int*)arg = above;
+}
+
+// 测试用例：高低水位回调和内存统计
+void test_buffer_watermark() {
+    TEST_START("buffer_watermark");
+    uint64_t mem0 = buffer_mem_total();
+    buf_pool_t* pool = buf_pool_new(1024 * 1024);
+    buffer_t* buf = buffer_new_with_pool(pool);
+    int above = -1;
+    char data[4096];
+    memset(data, 'w', sizeof(data));
+
+    buffer_set_watermark(buf, 8192, 2048, wm_cb, &above);
+    assert(buffer_add(buf, data, 4096) == 0 && above == -1);
+    assert(buffer_add(buf, data, 4096) == 0 && above == 1);
+    // 已经在高水位之上，不重复回调
+    assert(buffer_add(buf, data, 4096) == 0 && wm_calls[1] == 1);
+    assert(pool->used >= 12288 && buffer_mem_total() - mem0 >= pool->used);
+
+    // 降到低水位之上不回调，到低水位时回调一次
+    buffer_drain(buf, 8192);
+    assert(above == 1);
+    buffer_drain(buf, 2048);
+    assert(above == 0 && wm_calls[0] == 1);
+
+    // 其他写入路径同样触发
+    struct iovec vec[2];
+    assert(buffer_reserve(buf, 8192, vec, 2) > 0);
+    assert(buffer_commit(buf, 8192) == 0 && above == 1);
+    buffer_t* other = buffer_new_with_pool(pool);
+    assert(buffer_add_buffer(other, buf) == 0 && above == 0);
+    assert(buffer_add_buffer(buf, other) == 0 && above == 1 && wm_calls[1] == 3);
+    buffer_set_watermark(buf, 0, 0, NULL, NULL);
+    buffer_drain(buf, buffer_len(buf));
+    assert(above == 1);
+
+    // 全部释放后池中没有在用的 chain，池释放后全局统计回到原值
+    assert(pool->used == 0);
+    buffer_free(buf);
+    buffer_free(other);
+    buf_pool_free(pool);
+    assert(buffer_mem_total() == mem0);
+    TEST_PASS();
+}
+
+void test_buffer_add_chain() {
+    TEST_START("buffer_add_chain");
+    buf_pool_t* pool = buf_pool_new(1024 * 1024);
+    buffer_t* buf = buffer_new_with_pool(pool);
+    assert(buffer_add(buf, "head-", 5) == 0);
+
+    // 外部直接填好的 chain 整块挂到末尾，不拷贝
+    buf_chain_t* ch = buffer_chain_new(pool, 8192);
+    assert(ch != NULL && ch->buffer_len >= 8192);
+    memset(ch->buffer, 'c', 8000);
+    ch->off = 8000;
+    assert(buffer_add_chain(buf, ch) == 8000);
+    assert(buffer_len(buf) == 8005 && buf->last == ch);
+    uint8_t* p = buffer_pullup(buf, 6);
+    assert(memcmp(p, "head-c", 6) == 0);
+
+    // 之后的写入接着用 chain 剩下的空间
+    assert(buffer_add(buf, "tail", 4) == 0);
+    char out[8009];
+    assert(buffer_remove(buf, out, sizeof(out)) == 8009);
+    assert(memcmp(out + 8005, "tail", 4) == 0);
+
+    // 空 chain 直接释放，没挂上的 chain 可以单独还给池
+    buf_chain_t* empty = buffer_chain_new(pool, 100);
+    assert(buffer_add_chain(buf, empty) == 0 && buffer_len(buf) == 0);
+    buffer_chain_free(pool, buffer_chain_new(pool, 100));
+    buffer_free(buf);
+    assert(pool->used == 0);
+    buf_pool_free(pool);
+    TEST_PASS();
+}
+
 
 // -------------------------- 主函数（执行所有测试） --------------------------
 int main() {
@@ -222,6 +705,14 @@ int main() {
     test_buffer_drain();
     test_buffer_search();
     test_buffer_exception();
+    test_buffer_pool();
+    test_buffer_fd_io();
+    test_buffer_search_chains();
+    test_buffer_peek_pullup();
+    test_buffer_move_reference();
+    test_buffer_reserve_commit();
+    test_buffer_watermark();
+    test_buffer_add_chain();
 
     printf("\n=== All Tests Finished ===\n");
     return 0;
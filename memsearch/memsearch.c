@@ -0,0 +1,140 @@
+#include "memsearch.h"
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MEMSEARCH_X86 1
+#endif
+
+typedef size_t (*memsearch_fn)(const uint8_t* s, size_t n, const uint8_t* sep, size_t m);
+
+// 调用方保证 n >= m >= 1，从第 i 个候选起点开始逐个检查
+static inline size_t _memsearch_tail(const uint8_t* s, size_t n, const uint8_t* sep, size_t m, size_t i)
+{
+	size_t end = n - m + 1;
+	while (i < end) {
+		const uint8_t* p = (const uint8_t*)memchr(s + i, sep[0], end - i);
+		if (!p) {
+			break;
+		}
+		i = p - s;
+		if (s[i + m - 1] == sep[m - 1] && memcmp(s + i, sep, m) == 0) {
+			return i;
+		}
+		i++;
+	}
+	return n;
+}
+
+static size_t _memsearch_scalar(const uint8_t* s, size_t n, const uint8_t* sep, size_t m)
+{
+	return _memsearch_tail(s, n, sep, m, 0);
+}
+
+#ifdef MEMSEARCH_X86
+// a 取候选起点 i..i+15 的首字节，b 取对应的尾字节 i+m-1..i+m+14，都不会越过 s[n-1]
+__attribute__((target("sse2")))
+static size_t _memsearch_sse2(const uint8_t* s, size_t n, const uint8_t* sep, size_t m)
+{
+	const __m128i first = _mm_set1_epi8((char)sep[0]);
+	const __m128i last = _mm_set1_epi8((char)sep[m - 1]);
+	size_t end = n - m + 1;
+	size_t i = 0;
+	for (; i + 16 <= end; i += 16) {
+		__m128i a = _mm_loadu_si128((const __m128i*)(s + i));
+		__m128i b = _mm_loadu_si128((const __m128i*)(s + i + m - 1));
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last)));
+		while (mask) {
+			size_t k = i + __builtin_ctz(mask);
+			if (m <= 2 || memcmp(s + k + 1, sep + 1, m - 2) == 0) {
+				return k;
+			}
+			mask &= mask - 1;
+		}
+	}
+	return _memsearch_tail(s, n, sep, m, i);
+}
+
+__attribute__((target("avx2")))
+static size_t _memsearch_avx2(const uint8_t* s, size_t n, const uint8_t* sep, size_t m)
+{
+	const __m256i first = _mm256_set1_epi8((char)sep[0]);
+	const __m256i last = _mm256_set1_epi8((char)sep[m - 1]);
+	size_t end = n - m + 1;
+	size_t i = 0;
+	for (; i + 32 <= end; i += 32) {
+		__m256i a = _mm256_loadu_si256((const __m256i*)(s + i));
+		__m256i b = _mm256_loadu_si256((const __m256i*)(s + i + m - 1));
+		uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last)));
+		while (mask) {
+			size_t k = i + __builtin_ctz(mask);
+			if (m <= 2 || memcmp(s + k + 1, sep + 1, m - 2) == 0) {
+				return k;
+			}
+			mask &= mask - 1;
+		}
+	}
+	return _memsearch_tail(s, n, sep, m, i);
+}
+#endif
+
+static int g_level = -1;
+static memsearch_fn g_fn = _memsearch_scalar;
+
+static int _memsearch_supported(void)
+{
+#ifdef MEMSEARCH_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return MEMSEARCH_AVX2;
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return MEMSEARCH_SSE2;
+	}
+#endif
+	return MEMSEARCH_SCALAR;
+}
+
+int memsearch_set_level(int level)
+{
+	int supported = _memsearch_supported();
+	if (level > supported) {
+		level = supported;
+	}
+	switch (level) {
+#ifdef MEMSEARCH_X86
+	case MEMSEARCH_AVX2:
+		g_fn = _memsearch_avx2;
+		break;
+	case MEMSEARCH_SSE2:
+		g_fn = _memsearch_sse2;
+		break;
+#endif
+	default:
+		level = MEMSEARCH_SCALAR;
+		g_fn = _memsearch_scalar;
+		break;
+	}
+	g_level = level;
+	return level;
+}
+
+// 进程启动时选好实现，之后的调用不再判断 CPU
+__attribute__((constructor))
+static void _memsearch_init(void)
+{
+	memsearch_set_level(MEMSEARCH_AVX2);
+}
+
+int memsearch_level(void)
+{
+	return g_level;
+}
+
+size_t memsearch(const uint8_t* hay, size_t n, const void* sep, size_t seplen)
+{
+	if (seplen == 0 || n < seplen) {
+		return n;
+	}
+	return g_fn(hay, n, (const uint8_t*)sep, seplen);
+}
@@ -0,0 +1,25 @@
+#ifndef __MEMSEARCH_H__
+#define __MEMSEARCH_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+// 分隔符查找内核：每次比较 16/32 个候选起点的首字节和尾字节，两者都命中的候选再用 memcmp 确认。
+// 启动时按 CPU 支持情况选择 AVX2 / SSE2 / 标量实现，也可以手动降级做对比测试。
+
+enum {
+	MEMSEARCH_SCALAR = 0,
+	MEMSEARCH_SSE2 = 1,
+	MEMSEARCH_AVX2 = 2,
+};
+
+// 当前使用的实现
+int memsearch_level(void);
+
+// 切换实现，超过 CPU 支持的级别时取能用的最高级别，返回实际级别
+int memsearch_set_level(int level);
+
+// sep 在 hay[0, n) 中第一次完整出现的起始偏移，找不到返回 n
+size_t memsearch(const uint8_t* hay, size_t n, const void* sep, size_t seplen);
+
+#endif
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "memsearch.h"
+
+// 编译: gcc memsearch.c memsearch_test.c -o memsearch_test
+
+static size_t naive(const uint8_t* s, size_t n, const uint8_t* sep, size_t m)
+{
+    for (size_t i = 0; i + m <= n; i++) {
+        if (memcmp(s + i, sep, m) == 0) {
+            return i;
+        }
+    }
+    return n;
+}
+
+static const char* level_name(int level)
+{
+    return level == MEMSEARCH_AVX2 ? "avx2" : level == MEMSEARCH_SSE2 ? "sse2" : "scalar";
+}
+
+// 测试用例1：固定用例
+void test_basic() {
+    printf("Test 1: Basic search\n");
+    for (int level = MEMSEARCH_SCALAR; level <= MEMSEARCH_AVX2; level++) {
+        if (memsearch_set_level(level) != level) {
+            continue;
+        }
+        const char* s = "$5\r\nhello\r\n";
+        assert(memsearch((const uint8_t*)s, strlen(s), "\r\n", 2) == 2);
+        assert(memsearch((const uint8_t*)s + 4, strlen(s) - 4, "\r\n", 2) == 5);
+        assert(memsearch((const uint8_t*)s, strlen(s), "xyz", 3) == strlen(s));
+        assert(memsearch((const uint8_t*)s, strlen(s), "h", 1) == 4);
+        assert(memsearch((const uint8_t*)s, 1, "\r\n", 2) == 1);
+        assert(memsearch((const uint8_t*)s, strlen(s), "", 0) == strlen(s));
+    }
+    printf("Passed\n\n");
+}
+
+// 测试用例2：随机数据与朴素实现对比，缓冲区按实际长度分配，越界读会被 ASan 抓到
+void test_random() {
+    printf("Test 2: Random haystacks\n");
+    srand(7);
+    for (int level = MEMSEARCH_SCALAR; level <= MEMSEARCH_AVX2; level++) {
+        if (memsearch_set_level(level) != level) {
+            printf("  %s not supported, skipped\n", level_name(level));
+            continue;
+        }
+        for (int round = 0; round < 20000; round++) {
+            size_t n = rand() % 200;
+            size_t m = 1 + rand() % 8;
+            uint8_t* s = malloc(n ? n : 1);
+            uint8_t sep[8];
+            // 字母表很小，部分匹配（首尾字节相同而中间不同）经常出现
+            for (size_t i = 0; i < n; i++) {
+                s[i] = "ab\r\n"[rand() % 4];
+            }
+            for (size_t i = 0; i < m; i++) {
+                sep[i] = "ab\r\n"[rand() % 4];
+            }
+            assert(memsearch(s, n, sep, m) == naive(s, n, sep, m));
+            free(s);
+        }
+        printf("  %s ok\n", level_name(level));
+    }
+    memsearch_set_level(MEMSEARCH_AVX2);
+    printf("Passed\n\n");
+}
+
+int main() {
+    printf("Starting memsearch tests...\n\n");
+
+    test_basic();
+    test_random();
+
+    printf("All tests passed!\n");
+    return 0;
+}
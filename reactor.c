@@ -1,63 +1,252 @@
-#include "reactor.h"
+#define _GNU_SOURCE //pthread_setaffinity_np
+#include "reactor_backend.h"
+#include <sched.h> //cpu_set_t
+#include <sys/eventfd.h>
 
-static int _write_socket(event_t* e, void* buf, int size);
+static int _write_buffer(event_t* e);
+static void _resume_read(event_t* e);
+static void _wake_read_cb(int fd, int events, void* privdata);
+static void _run_mailbox(reactor_t* r);
 
 reactor_t* create_reactor()
+{
+	const char* name = getenv("REACTOR_BACKEND");
+	if (name && strcmp(name, "uring") == 0) {
+		return create_reactor_backend(REACTOR_BACKEND_URING);
+	}
+	return create_reactor_backend(REACTOR_BACKEND_EPOLL);
+}
+
+reactor_t* create_reactor_backend(int backend)
 {
 	reactor_t* r = (reactor_t*)malloc(sizeof(reactor_t));
-	r->epfd = epoll_create(1);
+	if (!r) {
+		return NULL;
+	}
+	r->epfd = -1;
+	r->backend = NULL;
+	r->backend_data = NULL;
+	r->syscalls = 0;
 	r->listenfd = -1;
 	r->stop = 0;
-	r->iter = 0;
-	r->events = (event_t*)malloc(sizeof(event_t) * MAX_CONN);
-	memset(r->events, 0, sizeof(event_t) * MAX_CONN);
+	r->slabs = NULL;
+	r->nslabs = 0;
+	r->nused = 0;
+	r->free_head = -1;
+	r->pool = buf_pool_new(REACTOR_POOL_CACHED);
+	r->timer = timewheel_create(timewheel_now());
+	r->defers = NULL;
+	r->ndefers = 0;
+	r->defer_cap = 0;
+	r->mem_high = 0;
+	r->mem_low = 0;
+	r->mem_above = 0;
+	r->mem_fn = NULL;
+	r->mem_priv = NULL;
+	r->paused = NULL;
+	r->npaused = 0;
+	r->paused_cap = 0;
+	r->read_budget = REACTOR_READ_BUDGET;
+	r->write_budget = REACTOR_WRITE_BUDGET;
+	r->ready = NULL;
+	r->nready = 0;
+	r->ready_cap = 0;
+	r->running = NULL;
+	r->running_cap = 0;
+	r->mailbox = NULL;
+	r->wakefd = -1;
 	memset(r->fire, 0, sizeof(struct epoll_event) * MAX_EVENT_NUM);
+	if (!r->pool || !r->timer) {
+		goto fail;
+	}
+	if (backend == REACTOR_BACKEND_URING) {
+		r->backend = &reactor_uring_backend;
+		if (r->backend->init(r) < 0) {
+			// 内核不支持（或被禁用）io_uring，退回 epoll
+			r->backend = NULL;
+		}
+	}
+	if (!r->backend) {
+		r->backend = &reactor_epoll_backend;
+		if (r->backend->init(r) < 0) {
+			r->backend = NULL;
+			goto fail;
+		}
+	}
+	atomic_init(&r->wake_pending, 0);
+	atomic_init(&r->wakeups, 0);
+	r->mailbox = mpmc_ring_create(REACTOR_MAILBOX_SIZE, sizeof(reactor_task_t));
+	if (!r->mailbox) {
+		goto fail;
+	}
+	r->wakefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (r->wakefd < 0) {
+		goto fail;
+	}
+	event_t* we = new_event(r, r->wakefd, _wake_read_cb, NULL, NULL);
+	if (!we || add_event(r, EPOLLIN, we) < 0) {
+		goto fail;
+	}
+	// 唤醒用的 event 是 reactor 自己的，不算在连接数里
+	r->nused--;
 	return r;
+
+fail:
+	// 还没有连接，event 上也没有 buffer，只拆已经建好的部分
+	if (r->backend) {
+		r->backend->release(r);
+	}
+	if (r->wakefd >= 0) {
+		close(r->wakefd);
+	}
+	mpmc_ring_destroy(r->mailbox);
+	for (uint32_t i = 0; i < r->nslabs; i++) {
+		free(r->slabs[i]);
+	}
+	free(r->slabs);
+	buf_pool_free(r->pool);
+	timewheel_destroy(r->timer);
+	free(r);
+	return NULL;
+}
+
+const char* reactor_backend_name(reactor_t* r)
+{
+	return r->backend->name;
 }
 
 void release_reactor(reactor_t* r)
 {
-	free(r->events);
-	close(r->epfd);
+	// 还没来得及执行的任务在 reactor 拆掉之前执行完，任务参数的释放通常在任务里
+	_run_mailbox(r);
+	// 后端可能还持有池里的 chain，先于池释放
+	r->backend->release(r);
+	close(r->wakefd);
+	mpmc_ring_destroy(r->mailbox);
+	for (uint32_t i = 0; i < r->nslabs; i++) {
+		for (int j = 0; j < EVENT_SLAB_SIZE; j++) {
+			buffer_free(r->slabs[i][j].in);
+			buffer_free(r->slabs[i][j].out);
+		}
+		free(r->slabs[i]);
+	}
+	free(r->slabs);
+	buf_pool_free(r->pool);
+	timewheel_destroy(r->timer);
+	free(r->defers);
+	free(r->paused);
+	free(r->ready);
+	free(r->running);
 	free(r);
 }
 
+static int _grow_events(reactor_t* r)
+{
+	event_t** slabs = (event_t**)realloc(r->slabs, sizeof(event_t*) * (r->nslabs + 1));
+	if (!slabs) {
+		return -1;
+	}
+	r->slabs = slabs;
+	event_t* slab = (event_t*)calloc(EVENT_SLAB_SIZE, sizeof(event_t));
+	if (!slab) {
+		return -1;
+	}
+	uint32_t base = r->nslabs * EVENT_SLAB_SIZE;
+	// 倒序压入空闲链表，分配时从低下标开始
+	for (int i = EVENT_SLAB_SIZE - 1; i >= 0; i--) {
+		slab[i].fd = -1;
+		slab[i].id = base + i;
+		slab[i].next_free = r->free_head;
+		r->free_head = base + i;
+	}
+	r->slabs[r->nslabs++] = slab;
+	return 0;
+}
+
 static event_t* _get_event_t(reactor_t* r)
 {
-	r->iter++;
-	while (r->events[r->iter & MAX_CONN].fd > 0) { 
-		r->iter++;
-		if (r->iter >= MAX_CONN) {
-			break;
-		}
+	if (r->free_head < 0 && _grow_events(r) < 0) {
+		return NULL;
 	}
-	return &r->events[r->iter];
+	event_t* e = _slot_event(r, r->free_head);
+	r->free_head = e->next_free;
+	e->next_free = -1;
+	r->nused++;
+	return e;
 }
 
 event_t* new_event(reactor_t* r, int fd, event_callback_fn rd, event_callback_fn wt, error_callback_fn err)
 {
 	assert(rd || wt || err);
 	event_t* e = _get_event_t(r);
+	if (!e) {
+		return NULL;
+	}
 	e->r = r;
 	e->fd = fd;
-	e->in = buffer_new(16 * 1024);
-	e->out = buffer_new(16 * 1024);
+	e->deferred = 0;
+	e->ready = 0;
+	e->events = 0;
+	e->paused = 0;
+	e->mem_paused = 0;
+	e->in_high = 0;
+	e->out_high = 0;
+	e->out_low = 0;
+	e->upstream = 0;
+	e->upstream_paused = 0;
+	e->recv_direct = 0;
+	e->io_state = 0;
+	e->io_mask = 0;
+	e->io_pending = 0;
+	e->io_eof = 0;
+	e->io_err = 0;
+	e->in = NULL;
+	e->out = NULL;
 	e->read_fn = rd;
 	e->write_fn = wt;
 	e->error_fn = err;
+	e->priv = NULL;
 	return e;
 }
 
+static void _event_in_wm(buffer_t* buf, int above, void* arg);
+static void _event_out_wm(buffer_t* buf, int above, void* arg);
+
 buffer_t* evbuf_in(event_t* e)
 {
+	if (!e->in) {
+		e->in = buffer_new_with_pool(e->r->pool);
+		if (e->in && e->in_high) {
+			buffer_set_watermark(e->in, e->in_high, e->in_high - 1, _event_in_wm, e);
+		}
+	}
 	return e->in;
 }
 
 buffer_t* evbuf_out(event_t* e)
 {
+	if (!e->out) {
+		e->out = buffer_new_with_pool(e->r->pool);
+		if (e->out && e->out_high) {
+			buffer_set_watermark(e->out, e->out_high, e->out_low, _event_out_wm, e);
+		}
+	}
 	return e->out;
 }
 
+// 连接空闲时把输入/输出 buffer 还给池，大量空闲连接不再各自占着 buffer
+static inline void _release_idle_buffers(event_t* e)
+{
+	if (e->in && buffer_len(e->in) == 0 && e->in->last_read_pos == 0) {
+		buffer_free(e->in);
+		e->in = NULL;
+	}
+	if (e->out && buffer_len(e->out) == 0) {
+		buffer_free(e->out);
+		e->out = NULL;
+	}
+}
+
 reactor_t* event_base(event_t* e)
 {
 	return e->r;
@@ -65,9 +254,33 @@ reactor_t* event_base(event_t* e)
 
 void free_event(event_t* e)
 {
-	e->fd = 0;
+	if (e->fd < 0) {
+		return;
+	}
+	reactor_t* r = e->r;
+	if (e->upstream_paused) {
+		// 输出还积压着就关闭了，把暂停的 upstream 还回去
+		event_t* up = _lookup_event(r, e->upstream);
+		e->upstream_paused = 0;
+		if (up && up != e) {
+			_resume_read(up);
+		}
+	}
+	e->fd = -1;
+	e->gen++;
+	e->deferred = 0;
+	e->ready = 0;
 	buffer_free(e->in);
 	buffer_free(e->out);
+	e->in = NULL;
+	e->out = NULL;
+	e->read_fn = NULL;
+	e->write_fn = NULL;
+	e->error_fn = NULL;
+	e->priv = NULL;
+	e->next_free = r->free_head;
+	r->free_head = e->id;
+	r->nused--;
 }
 
 int set_nonblock(int fd)
@@ -76,12 +289,57 @@ int set_nonblock(int fd)
 	return fcntl(fd, F_SETFL, flag | O_NONBLOCK);
 }
 
-int add_event(reactor_t* r, int events, event_t* e)
+// -------------------------- epoll 后端 --------------------------
+static int _epoll_init(reactor_t* r)
+{
+	r->epfd = epoll_create(1);
+	return r->epfd < 0 ? -1 : 0;
+}
+
+static void _epoll_release(reactor_t* r)
+{
+	close(r->epfd);
+}
+
+static int _epoll_ctl(reactor_t* r, int op, event_t* e)
 {
 	struct epoll_event ev;
-	ev.events = events;
-	ev.data.ptr = e;
-	if (epoll_ctl(r->epfd, EPOLL_CTL_ADD, e->fd, &ev) == -1) {
+	ev.events = _event_mask(e);
+	ev.data.u64 = _event_key(e);
+	r->syscalls++;
+	return epoll_ctl(r->epfd, op, e->fd, &ev);
+}
+
+static int _epoll_add(reactor_t* r, event_t* e)
+{
+	return _epoll_ctl(r, EPOLL_CTL_ADD, e);
+}
+
+static int _epoll_mod(reactor_t* r, event_t* e)
+{
+	return _epoll_ctl(r, EPOLL_CTL_MOD, e);
+}
+
+static void _epoll_del(reactor_t* r, event_t* e)
+{
+	r->syscalls++;
+	epoll_ctl(r->epfd, EPOLL_CTL_DEL, e->fd, NULL);
+}
+
+static int _epoll_wait(reactor_t* r, int timeout)
+{
+	r->syscalls++;
+	return epoll_wait(r->epfd, r->fire, MAX_EVENT_NUM, timeout);
+}
+
+const reactor_backend_t reactor_epoll_backend = {
+	"epoll", _epoll_init, _epoll_release, _epoll_add, _epoll_mod, _epoll_del, _epoll_wait, 0
+};
+
+int add_event(reactor_t* r, int events, event_t* e)
+{
+	e->events = events;
+	if (r->backend->add(r, e) == -1) {
 		printf("add event err fd = %d\n", e->fd);
 		return -1;
 	}
@@ -90,61 +348,386 @@ int add_event(reactor_t* r, int events, event_t* e)
 
 int del_event(reactor_t* r, event_t* e)
 {
-	epoll_ctl(r->epfd, EPOLL_CTL_DEL, e->fd, NULL);
+	r->backend->del(r, e);
 	free_event(e);
 	return 0;
 }
 
 int enable_event(reactor_t* r, event_t* e, int readable, int writeable)
 {
-	struct epoll_event ev;
-	ev.events = (readable ? EPOLLIN : 0) | (writeable ? EPOLLOUT : 0);
-	ev.data.ptr = e;
-	if (epoll_ctl(r->epfd, EPOLL_CTL_MOD, e->fd, &ev) == -1) {
+	e->events = (readable ? EPOLLIN : 0) | (writeable ? EPOLLOUT : 0);
+	return r->backend->mod(r, e);
+}
+
+int event_set_recv_direct(event_t* e)
+{
+	if (!e->r->backend->recv_direct) {
 		return -1;
 	}
+	e->recv_direct = 1;
 	return 0;
 }
 
-void eventloop_once(reactor_t* r, int timeout)
+// 暂停/恢复读按次数配对，第一次暂停时去掉 EPOLLIN，全部恢复后再按 e->events 加回来
+static void _pause_read(event_t* e)
 {
-	int n = epoll_wait(r->epfd, r->fire, MAX_EVENT_NUM, timeout);
-	for (int i = 0; i < n; i++) {
-		struct epoll_event* e = &r->fire[i];
-		int mask = e->events;
-		if (e->events & EPOLLERR) mask |= EPOLLIN | EPOLLOUT;
-		if (e->events & EPOLLHUP) mask |= EPOLLIN | EPOLLOUT;
-		event_t* et = (event_t*)e->data.ptr;
-		if (mask & EPOLLIN) {
-			if (et->read_fn) {
-				et->read_fn(et->fd, EPOLLIN, et);
-			}
+	if (e->paused++ == 0) {
+		e->r->backend->mod(e->r, e);
+	}
+}
+
+static void _resume_read(event_t* e)
+{
+	if (--e->paused == 0) {
+		e->r->backend->mod(e->r, e);
+		if (e->io_pending || e->io_eof || e->io_err) {
+			// 暂停期间后端已经收下的数据（或关闭）不会再通知一次
+			event_requeue(e, EPOLLIN);
 		}
-		if (mask & EPOLLOUT) {
-			if (et->write_fn) {
-				et->write_fn(et->fd, EPOLLOUT, et);
+	}
+}
+
+static void _event_in_wm(buffer_t* buf, int above, void* arg)
+{
+	event_t* e = (event_t*)arg;
+	if (above) {
+		_pause_read(e);
+	}
+	else {
+		_resume_read(e);
+	}
+}
+
+void event_set_read_watermark(event_t* e, uint32_t high)
+{
+	if (e->in && e->in->wm_above) {
+		_resume_read(e);
+	}
+	e->in_high = high;
+	if (e->in) {
+		buffer_set_watermark(e->in, high, high ? high - 1 : 0, high ? _event_in_wm : NULL, e);
+	}
+}
+
+static void _event_out_wm(buffer_t* buf, int above, void* arg)
+{
+	event_t* e = (event_t*)arg;
+	event_t* up = _lookup_event(e->r, e->upstream);
+	if (above) {
+		if (up && !e->upstream_paused) {
+			e->upstream_paused = 1;
+			_pause_read(up);
+		}
+	}
+	else if (e->upstream_paused) {
+		e->upstream_paused = 0;
+		if (up) {
+			_resume_read(up);
+		}
+	}
+}
+
+void event_set_write_watermark(event_t* e, uint32_t high, uint32_t low, event_t* upstream)
+{
+	// 先按旧设置恢复，避免换 upstream 后配对错乱
+	_event_out_wm(e->out, 0, e);
+	e->out_high = high;
+	e->out_low = low;
+	e->upstream = _event_key(upstream ? upstream : e);
+	if (e->out) {
+		buffer_set_watermark(e->out, high, low, high ? _event_out_wm : NULL, e);
+	}
+}
+
+void reactor_set_mem_watermark(reactor_t* r, uint64_t high, uint64_t low, mem_callback_fn fn, void* privdata)
+{
+	r->mem_high = high;
+	r->mem_low = low < high ? low : (high ? high - 1 : 0);
+	r->mem_fn = fn;
+	r->mem_priv = privdata;
+}
+
+uint64_t reactor_mem_used(reactor_t* r)
+{
+	return r->pool->used;
+}
+
+void reactor_set_budget(reactor_t* r, uint32_t read_budget, uint32_t write_budget)
+{
+	r->read_budget = read_budget;
+	r->write_budget = write_budget;
+}
+
+int event_requeue(event_t* e, uint32_t events)
+{
+	reactor_t* r = e->r;
+	if (e->ready) {
+		e->ready |= events;
+		return 0;
+	}
+	if (r->nready == r->ready_cap) {
+		uint32_t cap = r->ready_cap ? r->ready_cap * 2 : 64;
+		uint64_t* ready = (uint64_t*)realloc(r->ready, sizeof(uint64_t) * cap);
+		if (!ready) {
+			return -1;
+		}
+		r->ready = ready;
+		r->ready_cap = cap;
+	}
+	r->ready[r->nready++] = _event_key(e);
+	e->ready = events;
+	return 0;
+}
+
+// 内存超限期间收到可读事件的连接挂到 paused 列表，不读
+static int _mem_pause(reactor_t* r, event_t* e)
+{
+	if (r->npaused == r->paused_cap) {
+		uint32_t cap = r->paused_cap ? r->paused_cap * 2 : 64;
+		uint64_t* paused = (uint64_t*)realloc(r->paused, sizeof(uint64_t) * cap);
+		if (!paused) {
+			return -1;
+		}
+		r->paused = paused;
+		r->paused_cap = cap;
+	}
+	r->paused[r->npaused++] = _event_key(e);
+	e->mem_paused = 1;
+	_pause_read(e);
+	return 0;
+}
+
+static void _check_mem(reactor_t* r)
+{
+	if (r->mem_high == 0) {
+		return;
+	}
+	uint64_t used = r->pool->used;
+	if (!r->mem_above && used >= r->mem_high) {
+		r->mem_above = 1;
+		if (r->mem_fn) {
+			r->mem_fn(r, 1, r->mem_priv);
+		}
+	}
+	else if (r->mem_above && used <= r->mem_low) {
+		r->mem_above = 0;
+		for (uint32_t i = 0; i < r->npaused; i++) {
+			event_t* e = _lookup_event(r, r->paused[i]);
+			if (e && e->mem_paused) {
+				e->mem_paused = 0;
+				_resume_read(e);
 			}
-			else {
-				buffer_t* out = evbuf_out(et);
-				if (buffer_len(out) > 0) {
-					uint8_t* buf = buffer_write_atmost(out);
-					int len = buffer_len(out);
-					int n = _write_socket(et, buf, len);
-					if (n > 0) {
-						buffer_drain(out, n);
-						if (buffer_len(out) == 0) {
-							enable_event(et->r, et, 1, 0);
-						}
-					}
+		}
+		r->npaused = 0;
+		if (r->mem_fn) {
+			r->mem_fn(r, 0, r->mem_priv);
+		}
+	}
+}
+
+timer_node_t* add_timer(reactor_t* r, uint32_t timeout_ms, timer_callback_fn cb, void* privdata)
+{
+	return timewheel_add(r->timer, timewheel_now() + timeout_ms, cb, privdata);
+}
+
+void del_timer(reactor_t* r, timer_node_t* t)
+{
+	timewheel_del(r->timer, t);
+}
+
+int event_defer_flush(event_t* e, defer_callback_fn fn)
+{
+	reactor_t* r = e->r;
+	if (e->deferred) {
+		return 0;
+	}
+	if (r->ndefers == r->defer_cap) {
+		uint32_t cap = r->defer_cap ? r->defer_cap * 2 : 64;
+		defer_t* defers = (defer_t*)realloc(r->defers, sizeof(defer_t) * cap);
+		if (!defers) {
+			return -1;
+		}
+		r->defers = defers;
+		r->defer_cap = cap;
+	}
+	r->defers[r->ndefers].key = _event_key(e);
+	r->defers[r->ndefers].fn = fn;
+	r->ndefers++;
+	e->deferred = 1;
+	return 0;
+}
+
+// 一轮中攒下的输出统一在 epoll_wait 之前写出，回调里新登记的也在这一趟处理掉
+static void _run_defers(reactor_t* r)
+{
+	for (uint32_t i = 0; i < r->ndefers; i++) {
+		event_t* e = _lookup_event(r, r->defers[i].key);
+		if (!e) {
+			continue;
+		}
+		e->deferred = 0;
+		r->defers[i].fn(e);
+	}
+	r->ndefers = 0;
+}
+
+// 处理一个 event 上的 revents（epoll 报告的，或者就绪队列里记下的）
+static void _dispatch(reactor_t* r, event_t* et, uint64_t key, uint32_t revents)
+{
+	uint32_t mask = revents;
+	if (revents & EPOLLERR) mask |= EPOLLIN | EPOLLOUT;
+	if (revents & EPOLLHUP) mask |= EPOLLIN | EPOLLOUT;
+	// 读已暂停（下游积压或内存超限）时不读；出错或挂断照常交给读回调处理，否则水平触发会一直报
+	if ((mask & EPOLLIN) && !(revents & (EPOLLERR | EPOLLHUP))) {
+		if (r->mem_above && !et->mem_paused) {
+			_mem_pause(r, et);
+		}
+		// 后端直接收数据时读回调不碰 fd，暂停只停内核里的 recv，已经收下的照常交给读回调，否则没人消费也就不会恢复
+		if (et->paused && !et->recv_direct) {
+			mask &= ~EPOLLIN;
+		}
+	}
+	if (mask & EPOLLIN) {
+		if (et->read_fn) {
+			et->read_fn(et->fd, EPOLLIN, et);
+		}
+	}
+	// 读回调里可能已经关闭了连接，槽位甚至被新连接复用
+	if ((mask & EPOLLOUT) && _lookup_event(r, key)) {
+		if (et->write_fn) {
+			et->write_fn(et->fd, EPOLLOUT, et);
+		}
+		else {
+			if (buffer_len(et->out) > 0) {
+				int n = _write_buffer(et);
+				if (n > 0 && buffer_len(et->out) == 0) {
+					enable_event(et->r, et, 1, 0);
 				}
 			}
 		}
 	}
+	if (_lookup_event(r, key)) {
+		_release_idle_buffers(et);
+	}
+	_check_mem(r);
+}
+
+// 上一轮预算用完的 event：换出队列再处理，处理中重新入队的留到下一轮
+static void _run_ready(reactor_t* r)
+{
+	uint64_t* running = r->ready;
+	uint32_t running_cap = r->ready_cap;
+	uint32_t n = r->nready;
+	r->ready = r->running;
+	r->ready_cap = r->running_cap;
+	r->nready = 0;
+	r->running = running;
+	r->running_cap = running_cap;
+	for (uint32_t i = 0; i < n; i++) {
+		event_t* e = _lookup_event(r, running[i]);
+		if (!e || !e->ready) {
+			continue;
+		}
+		uint32_t revents = e->ready;
+		e->ready = 0;
+		_dispatch(r, e, running[i], revents);
+	}
+}
+
+void eventloop_once(reactor_t* r, int timeout)
+{
+	_run_defers(r);
+	_check_mem(r);
+	int next = timewheel_next_timeout(r->timer, timewheel_now());
+	if (next >= 0 && (timeout < 0 || next < timeout)) {
+		timeout = next;
+	}
+	if (r->nready > 0) {
+		// 就绪队列里还有活，只收一下新事件不等待
+		timeout = 0;
+	}
+	int n = r->backend->wait(r, timeout);
+	_run_ready(r);
+	for (int i = 0; i < n; i++) {
+		uint64_t key = r->fire[i].data.u64;
+		event_t* et = _lookup_event(r, key);
+		if (!et) {
+			continue;
+		}
+		if (et->ready) {
+			// 本轮已经用过预算又重新入队了，水平触发的重复通知合并到下一轮
+			et->ready |= r->fire[i].events;
+			continue;
+		}
+		_dispatch(r, et, key, r->fire[i].events);
+	}
+	_run_mailbox(r);
+	timewheel_expire(r->timer, timewheel_now());
+}
+
+// -------------------------- 跨线程投递 --------------------------
+// wake_pending 为 1 表示 eventfd 已经写过、reactor 还没开始取任务，这期间的投递不再写 eventfd；
+// reactor 取任务前用 exchange 清零，之后的投递会重新写一次
+static void _reactor_wake(reactor_t* r)
+{
+	if (atomic_exchange(&r->wake_pending, 1)) {
+		return;
+	}
+	uint64_t one = 1;
+	atomic_fetch_add_explicit(&r->wakeups, 1, memory_order_relaxed);
+	while (write(r->wakefd, &one, sizeof(one)) < 0 && errno == EINTR) {
+	}
+}
+
+static void _wake_read_cb(int fd, int events, void* privdata)
+{
+	uint64_t v;
+	while (read(fd, &v, sizeof(v)) < 0 && errno == EINTR) {
+	}
+}
+
+int reactor_post(reactor_t* r, task_callback_fn fn, void* arg)
+{
+	reactor_task_t t = { fn, arg };
+	if (mpmc_ring_push(r->mailbox, &t) < 0) {
+		return -1;
+	}
+	_reactor_wake(r);
+	return 0;
+}
+
+int reactor_post_batch(reactor_t* r, const reactor_task_t* tasks, int n)
+{
+	int done = (int)mpmc_ring_push_batch(r->mailbox, tasks, n);
+	if (done > 0) {
+		_reactor_wake(r);
+	}
+	return done;
+}
+
+// 每轮取一次：最多执行队列容量这么多个任务，取不完的再唤醒一次留到下一轮，不让投递方饿死 IO
+static void _run_mailbox(reactor_t* r)
+{
+	atomic_exchange(&r->wake_pending, 0);
+	reactor_task_t tasks[64];
+	uint32_t total = 0;
+	while (total < REACTOR_MAILBOX_SIZE) {
+		uint32_t n = mpmc_ring_pop_batch(r->mailbox, tasks, 64);
+		for (uint32_t i = 0; i < n; i++) {
+			tasks[i].fn(r, tasks[i].arg);
+		}
+		total += n;
+		if (n < 64) {
+			return;
+		}
+	}
+	_reactor_wake(r);
 }
 
 void stop_eventloop(reactor_t* r)
 {
 	r->stop = 1;
+	_reactor_wake(r);
 }
 
 void eventloop(reactor_t* r)
@@ -154,7 +737,7 @@ void eventloop(reactor_t* r)
 	}
 }
 
-int create_server(reactor_t* r, short port, event_callback_fn func)
+static int _create_listenfd(short port, int reuseport)
 {
 	int listenfd = socket(AF_INET, SOCK_STREAM, 0);
 	if (listenfd < 0) {
@@ -171,23 +754,42 @@ int create_server(reactor_t* r, short port, event_callback_fn func)
 	int reuse = 1;
 	if (setsockopt(listenfd, SOL_SOCKET, SO_REUSEADDR, (void*)&reuse, sizeof(int)) == -1) {
 		printf("reuse address error: %s\n", strerror(errno));
+		close(listenfd);
+		return -1;
+	}
+
+	if (reuseport && setsockopt(listenfd, SOL_SOCKET, SO_REUSEPORT, (void*)&reuse, sizeof(int)) == -1) {
+		printf("reuse port error: %s\n", strerror(errno));
+		close(listenfd);
 		return -1;
 	}
 
 	if (bind(listenfd, (struct sockaddr*)&addr, sizeof(struct sockaddr_in)) < 0) {
 		printf("bind error %s\n", strerror(errno));
+		close(listenfd);
 		return -2;
 	}
 
-	if (listen(listenfd, 5) < 0) {
+	if (listen(listenfd, LISTEN_BACKLOG) < 0) {
 		printf("listen error %s\n", strerror(errno));
+		close(listenfd);
 		return -3;
 	}
 
 	if (set_nonblock(listenfd) < 0) {
 		printf("set_nonblock error %s\n", strerror(errno));
+		close(listenfd);
 		return -4;
 	}
+	return listenfd;
+}
+
+int create_server(reactor_t* r, short port, event_callback_fn func)
+{
+	int listenfd = _create_listenfd(port, 0);
+	if (listenfd < 0) {
+		return listenfd;
+	}
 
 	r->listenfd = listenfd;
 
@@ -198,40 +800,202 @@ int create_server(reactor_t* r, short port, event_callback_fn func)
 	return 0;
 }
 
+reactor_group_t* create_reactor_group(int num)
+{
+	if (num <= 0) {
+		return NULL;
+	}
+	reactor_group_t* g = (reactor_group_t*)malloc(sizeof(reactor_group_t));
+	if (!g) {
+		return NULL;
+	}
+	g->num = num;
+	g->started = 0;
+	g->reactors = (reactor_t**)calloc(num, sizeof(reactor_t*));
+	g->threads = (pthread_t*)calloc(num, sizeof(pthread_t));
+	if (!g->reactors || !g->threads) {
+		free(g->reactors);
+		free(g->threads);
+		free(g);
+		return NULL;
+	}
+	for (int i = 0; i < num; i++) {
+		g->reactors[i] = create_reactor();
+		if (!g->reactors[i]) {
+			// 已经建好的 reactor 还没有线程，直接释放
+			while (--i >= 0) {
+				release_reactor(g->reactors[i]);
+			}
+			free(g->reactors);
+			free(g->threads);
+			free(g);
+			return NULL;
+		}
+	}
+	return g;
+}
+
+void release_reactor_group(reactor_group_t* g)
+{
+	if (!g) {
+		return;
+	}
+	reactor_group_stop(g);
+	for (int i = 0; i < g->num; i++) {
+		reactor_t* r = g->reactors[i];
+		if (r->listenfd >= 0) {
+			close(r->listenfd);
+		}
+		release_reactor(r);
+	}
+	free(g->reactors);
+	free(g->threads);
+	free(g);
+}
+
+int reactor_group_create_server(reactor_group_t* g, short port, event_callback_fn func)
+{
+	for (int i = 0; i < g->num; i++) {
+		reactor_t* r = g->reactors[i];
+		int listenfd = _create_listenfd(port, 1);
+		if (listenfd < 0) {
+			return listenfd;
+		}
+		r->listenfd = listenfd;
+		event_t* e = new_event(r, listenfd, func, NULL, NULL);
+		add_event(r, EPOLLIN, e);
+	}
+	printf("listen port : %d (%d reactors)\n", ntohs(port), g->num);
+	return 0;
+}
+
+static void* _reactor_thread(void* arg)
+{
+	reactor_t* r = (reactor_t*)arg;
+	// stop_eventloop 会写 eventfd 唤醒，不需要有限超时
+	eventloop(r);
+	return NULL;
+}
+
+int reactor_group_start(reactor_group_t* g)
+{
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	if (ncpu <= 0) {
+		ncpu = 1;
+	}
+	for (int i = 0; i < g->num; i++) {
+		g->reactors[i]->stop = 0;
+		if (pthread_create(&g->threads[i], NULL, _reactor_thread, g->reactors[i]) != 0) {
+			printf("create reactor thread %d error\n", i);
+			reactor_group_stop(g);
+			return -1;
+		}
+		g->started = i + 1;
+
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(i % ncpu, &set);
+		if (pthread_setaffinity_np(g->threads[i], sizeof(cpu_set_t), &set) != 0) {
+			printf("pin reactor thread %d to cpu %ld error\n", i, i % ncpu);
+		}
+	}
+	return 0;
+}
+
+void reactor_group_stop(reactor_group_t* g)
+{
+	for (int i = 0; i < g->started; i++) {
+		stop_eventloop(g->reactors[i]);
+	}
+	for (int i = 0; i < g->started; i++) {
+		pthread_join(g->threads[i], NULL);
+	}
+	g->started = 0;
+}
+
+// 对端关闭（err 为 0）或读出错：回调 error_fn 后释放连接
+static int _read_close(event_t* e, int err)
+{
+	int fd = e->fd;
+	if (err == 0) {
+		printf("close connection fd = %d\n", fd);
+		if (e->error_fn) {
+			e->error_fn(fd, "close socket");
+		}
+	}
+	else {
+		printf("read error fd = %d err = %s\n", fd, strerror(err));
+		if (e->error_fn) {
+			e->error_fn(fd, strerror(err));
+		}
+	}
+	del_event(e->r, e);
+	close(fd);
+	return 0;
+}
+
+// 后端已经把数据收进了 evbuf_in，这里只报告新收到的字节数，不再读 fd
+static int _read_direct(event_t* e)
+{
+	int num = e->io_pending;
+	e->io_pending = 0;
+	if (num > 0) {
+		if (e->io_eof || e->io_err) {
+			// 和直接读一样，先交数据，关闭下一轮再处理
+			event_requeue(e, EPOLLIN);
+		}
+		return num;
+	}
+	if (e->io_eof || e->io_err) {
+		return _read_close(e, e->io_eof ? 0 : e->io_err);
+	}
+	return 0;
+}
+
 int event_buffer_read(event_t* e)
 {
+	if (e->recv_direct) {
+		return _read_direct(e);
+	}
 	int fd = e->fd;
 	int num = 0;
+	buffer_t* in = evbuf_in(e);
+	uint32_t budget = e->r->read_budget;
 	while (1) {
-		char buf[1024] = { 0 };
-		int n = read(fd, buf, 1024);
-		if (n == 0) {
-			printf("close connection fd = %d\n", fd);
-			if (e->error_fn) {
-				e->error_fn(fd, "close socket");
+		if (budget && (uint32_t)num >= budget) {
+			// 预算用完还没读到 EAGAIN，排到下一轮接着读，别的连接先处理
+			event_requeue(e, EPOLLIN);
+			break;
+		}
+		uint32_t howmuch = budget ? budget - num : 0;
+		// 输入攒到水位就不再读，等调用方消费
+		if (e->in_high) {
+			if (buffer_len(in) >= e->in_high) {
+				break;
 			}
-			del_event(e->r, e);
-			close(fd);
-			return 0;
+			uint32_t room = e->in_high - buffer_len(in);
+			if (howmuch == 0 || room < howmuch) {
+				howmuch = room;
+			}
+		}
+		e->r->syscalls++;
+		int n = buffer_read_fd(in, fd, howmuch);
+		if (n == 0 && num > 0) {
+			// 先把这次读到的数据交给调用方，对端关闭下一轮再处理（边沿触发不会再通知）
+			event_requeue(e, EPOLLIN);
+			break;
+		}
+		if (n == 0) {
+			return _read_close(e, 0);
 		}
 		else if (n < 0) {
 			if (errno == EINTR) {
 				continue;
 			}
-			if (errno == EWOULDBLOCK) {
+			if (errno == EWOULDBLOCK || errno == ENOBUFS) {
 				break;
 			}
-			printf("read error fd = %d err = %s\n", fd, strerror(errno));
-			if (e->error_fn) {
-				e->error_fn(fd, strerror(errno));
-			}
-			del_event(e->r, e);
-			close(fd);
-			return 0;
-		}
-		else {
-			printf("recv data from client:%s", buf);
-			buffer_add(evbuf_in(e), buf, n);
+			return _read_close(e, errno);
 		}
 		num += n;
 	}
@@ -242,6 +1006,7 @@ static int _write_socket(event_t* e, void* buf, int size)
 {
 	int fd = e->fd;
 	while (1) {
+		e->r->syscalls++;
 		int n = write(fd, buf, size);
 		if (n < 0) {
 			if (errno == EINTR) {
@@ -254,27 +1019,57 @@ static int _write_socket(event_t* e, void* buf, int size)
 				e->error_fn(fd, strerror(errno));
 			}
 			del_event(e->r, e);
-			close(e->fd);
+			close(fd);
 		}
 		return n;
 	}
 	return 0;
 }
 
+// 把输出 buffer 中的 chain 直接 writev 出去，出错时释放连接并返回 -1
+static int _write_buffer(event_t* e)
+{
+	int fd = e->fd;
+	uint32_t budget = e->r->write_budget;
+	while (1) {
+		uint32_t want = budget && budget < buffer_len(e->out) ? budget : buffer_len(e->out);
+		e->r->syscalls++;
+		int n = buffer_write_fd(e->out, fd, want);
+		if (n > 0 && (uint32_t)n == want && buffer_len(e->out) > 0) {
+			// 预算内的都写出去了，剩下的下一轮再写
+			event_requeue(e, EPOLLOUT);
+		}
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EWOULDBLOCK) {
+				return 0;
+			}
+			if (e->error_fn) {
+				e->error_fn(fd, strerror(errno));
+			}
+			del_event(e->r, e);
+			close(fd);
+		}
+		return n;
+	}
+}
+
 int event_buffer_write(event_t* e, void* buf, int sz) {
-	buffer_t* out = evbuf_out(e);
-	if (buffer_len(out) == 0) {
+	if (buffer_len(e->out) == 0) {
 		int n = _write_socket(e, buf, sz);
-		if (n == 0 || n < sz) {
-			buffer_add(out, (char*)buf + n, sz - n);
-			enable_event(e->r, e, 1, 1);
-			return 0;
+		if (n < 0) {
+			// 写出错时连接已被 del_event 释放
+			return -1;
 		}
-		else if (n < 0) {
+		if (n < sz) {
+			buffer_add(evbuf_out(e), (char*)buf + n, sz - n);
+			enable_event(e->r, e, 1, 1);
 			return 0;
 		}
 		return 1;
 	}
-	buffer_add(out, (char*)buf, sz);
+	buffer_add(e->out, (char*)buf, sz);
 	return 1;
 }
\ No newline at end of file
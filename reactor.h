@@ -12,23 +12,60 @@
 #include <assert.h> //assert
 #include <stdlib.h> //malloc
 #include <string.h> //memcpy memmove
+#include <pthread.h> //pthread_create
 
 #include "chainbuffer/chainbuffer.h"
+#include "timewheel/timewheel.h"
+#include "ringbuffer/mpmc_ring.h"
 
 #define MAX_EVENT_NUM	1024
-#define MAX_CONN ((1 << 16) - 1) //16位无符号整数能表示的最大值
+#define EVENT_SLAB_BITS	10
+#define EVENT_SLAB_SIZE	(1 << EVENT_SLAB_BITS) //event_t 按块分配，每块 1024 个槽位，地址稳定
+#define LISTEN_BACKLOG	511
+#define REACTOR_POOL_CACHED	(16 * 1024 * 1024) //每个 reactor 的 chain 池最多缓存的字节数
+#define REACTOR_READ_BUDGET	(64 * 1024) //每个 event 每轮最多读的字节数，读不完的放到就绪队列下一轮接着读
+#define REACTOR_WRITE_BUDGET	(256 * 1024) //每个 event 每轮最多写的字节数
+#define REACTOR_MAILBOX_SIZE	4096 //跨线程任务队列的容量，满了 reactor_post 返回 -1
+#define REACTOR_BACKEND_EPOLL	0
+#define REACTOR_BACKEND_URING	1 //io_uring，内核不支持时退回 epoll
 
 typedef struct event_s event_t;
 typedef struct reactor_s reactor_t;
+typedef struct reactor_group_s reactor_group_t;
+typedef struct reactor_backend_s reactor_backend_t;
 
 typedef void (*event_callback_fn)(int fd, int events, void* privdata);
 typedef void (*error_callback_fn)(int fd, char* err);
+typedef void (*defer_callback_fn)(event_t* e);
+typedef void (*mem_callback_fn)(reactor_t* r, int above, void* privdata);
+typedef void (*task_callback_fn)(reactor_t* r, void* arg);
+typedef struct defer_s defer_t;
+typedef struct reactor_task_s reactor_task_t;
 
 struct event_s
 {
 	int fd;
+	uint32_t id; //槽位下标
+	uint32_t gen; //槽位每次释放后加一，epoll 事件携带 id + gen 用于识别已失效的 event
+	int next_free;
+	int deferred; //已经在 reactor 的延迟 flush 列表中
+	uint32_t ready; //在就绪队列里等下一轮处理的事件（EPOLLIN/EPOLLOUT），0 表示不在队列中
+	uint32_t events; //最近一次 add_event/enable_event 要求的 epoll 事件
+	int paused; //暂停读的原因个数（下游积压 + reactor 内存超限），为 0 时才监听 EPOLLIN
+	int mem_paused; //因为 reactor 内存超限被暂停过读
+	uint32_t in_high; //输入 buffer 攒到这么多就不再读，为 0 时不限制
+	uint32_t out_high; //输出 buffer 水位，为 0 时不检查
+	uint32_t out_low;
+	uint64_t upstream; //输出积压时要暂停读的 event（id + gen），可以是自己
+	int upstream_paused; //已经暂停了 upstream 的读，恢复或释放时要还回去
+	int recv_direct; //由后端直接收进 evbuf_in，event_buffer_read 不再读 fd
+	uint32_t io_state; //后端私有：已经提交给内核的操作
+	uint32_t io_mask; //后端私有：内核里 poll 当前监听的事件
+	uint32_t io_pending; //后端收进 evbuf_in、还没被 event_buffer_read 报告的字节数
+	int io_eof; //后端收到了对端关闭
+	int io_err; //后端收数据出错的 errno
 	reactor_t* r;
-	buffer_t* in;
+	buffer_t* in; //首次读写时才从池中分配，空闲时归还，请通过 evbuf_in/evbuf_out 访问
 	buffer_t* out;
 	event_callback_fn read_fn;
 	event_callback_fn write_fn;
@@ -36,20 +73,77 @@ struct event_s
 	void* priv;
 };
 
+// 延迟到本轮 eventloop_once 结束（下一次 epoll_wait 之前）执行的 flush
+struct defer_s
+{
+	uint64_t key; //event 的 id + gen，执行前 event 已释放则跳过
+	defer_callback_fn fn;
+};
+
+// 其他线程投递给 reactor 线程执行的任务
+struct reactor_task_s
+{
+	task_callback_fn fn;
+	void* arg;
+};
+
 struct reactor_s
 {
-	int epfd;
+	int epfd; //epoll 后端使用
+	const reactor_backend_t* backend;
+	void* backend_data;
+	uint64_t syscalls; //本 reactor 发起的系统调用次数（后端注册/等待 + event_buffer_read/write 的读写），压测统计用
+	int wakefd; //eventfd，其他线程投递任务或 stop 时写它唤醒 eventloop
+	mpmc_ring_t* mailbox; //其他线程投递的 reactor_task_t
+	_Atomic int wake_pending; //eventfd 已经写过、reactor 还没开始取任务
+	_Atomic uint64_t wakeups; //写 eventfd 的次数，压测统计用
 	int listenfd;
-	int stop;
-	event_t* events;
-	int iter;
+	_Atomic int stop;
+	event_t** slabs;
+	uint32_t nslabs;
+	uint32_t nused;
+	int free_head; //空闲槽位链表头，-1 表示需要扩容
+	buf_pool_t* pool; //本 reactor 所有连接共享的 chain 池
+	timewheel_t* timer;
+	defer_t* defers;
+	uint32_t ndefers;
+	uint32_t defer_cap;
+	uint64_t mem_high; //本 reactor chain 池在用字节数的水位，为 0 时不检查
+	uint64_t mem_low;
+	int mem_above;
+	mem_callback_fn mem_fn;
+	void* mem_priv;
+	uint64_t* paused; //因为内存超限暂停读的 event
+	uint32_t npaused;
+	uint32_t paused_cap;
+	uint32_t read_budget; //为 0 时不限制
+	uint32_t write_budget;
+	uint64_t* ready; //预算用完还没读写完的 event，下一轮不等 epoll 直接处理
+	uint32_t nready;
+	uint32_t ready_cap;
+	uint64_t* running; //本轮正在处理的就绪队列，和 ready 交替使用
+	uint32_t running_cap;
 	struct epoll_event fire[MAX_EVENT_NUM];
 };
 
+// 多 reactor 模式：每个 reactor 独占一个线程并绑定 CPU，
+// 各自持有一个 SO_REUSEPORT 监听 fd，由内核把新连接分摊到各个 reactor
+struct reactor_group_s
+{
+	int num;
+	int started;
+	reactor_t** reactors;
+	pthread_t* threads;
+};
+
 int event_buffer_read(event_t* e);
 int event_buffer_write(event_t* e, void* buf, int sz);
 
+// 默认使用 epoll，环境变量 REACTOR_BACKEND=uring 时使用 io_uring
 reactor_t* create_reactor(void);
+// 指定后端创建，io_uring 不可用（内核太旧或被禁用）时退回 epoll；失败返回 NULL
+reactor_t* create_reactor_backend(int backend);
+const char* reactor_backend_name(reactor_t* r);
 void release_reactor(reactor_t* r);
 event_t* new_event(reactor_t* r, int fd, event_callback_fn rd, event_callback_fn wt, error_callback_fn err);
 void free_event(event_t* e);
@@ -68,16 +162,69 @@ int del_event(reactor_t* R, event_t* e);
 
 int enable_event(reactor_t* R, event_t* e, int readable, int writeable);
 
+// 在 add_event 之前调用：读数据改由后端直接收进 evbuf_in（io_uring 下是 multishot recv + provided buffer ring，
+// 大块数据所在的 chain 直接挂进 buffer），read_fn 里只能用 event_buffer_read 取数据，不能再自己读 fd。
+// 后端不支持时返回 -1，行为不变
+int event_set_recv_direct(event_t* e);
+
+timer_node_t* add_timer(reactor_t* r, uint32_t timeout_ms, timer_callback_fn cb, void* privdata);
+
+void del_timer(reactor_t* r, timer_node_t* t);
+
+// 登记一次延迟 flush：同一个 event 在执行前重复登记只算一次，fn 在下一次 epoll_wait 之前调用
+int event_defer_flush(event_t* e, defer_callback_fn fn);
+
+// 输入 buffer 攒到 high 字节时暂停读，被消费到 high 以下再恢复，high 为 0 时不限制
+void event_set_read_watermark(event_t* e, uint32_t high);
+
+// 输出 buffer 积压到 high 字节时暂停 upstream 的读事件，写出到 low 以下再恢复；
+// upstream 为 NULL 时暂停自己的读（客户端发得比收得快），high 为 0 时关闭
+void event_set_write_watermark(event_t* e, uint32_t high, uint32_t low, event_t* upstream);
+
+// 本 reactor 所有连接的 buffer 合计超过 high 字节后，收到可读事件的连接都先暂停读，降到 low 以下统一恢复；
+// 越过水位时调用 fn（可以为 NULL），high 为 0 时关闭
+void reactor_set_mem_watermark(reactor_t* r, uint64_t high, uint64_t low, mem_callback_fn fn, void* privdata);
+
+// 本 reactor 所有连接的 buffer 当前占用的字节数
+uint64_t reactor_mem_used(reactor_t* r);
+
+// 设置每个 event 每轮的读写字节预算，0 表示不限制（一直读写到 EAGAIN）
+void reactor_set_budget(reactor_t* r, uint32_t read_budget, uint32_t write_budget);
+
+// 把 event 放进就绪队列，下一轮按 events 直接回调，不等 epoll 报告；
+// 边沿触发时数据没读完必须调用，否则不会再收到通知
+int event_requeue(event_t* e, uint32_t events);
+
 void eventloop_once(reactor_t* r, int timeout);
 
+// 可以在任意线程调用，会唤醒阻塞中的 eventloop
 void stop_eventloop(reactor_t* r);
 
+// 线程安全：把 fn(r, arg) 投递到 reactor 线程，在下一轮 eventloop_once 中执行；
+// 一批投递只写一次 eventfd。队列满返回 -1
+int reactor_post(reactor_t* r, task_callback_fn fn, void* arg);
+
+// 一次投递 n 个任务，返回实际入队个数
+int reactor_post_batch(reactor_t* r, const reactor_task_t* tasks, int n);
+
 void eventloop(reactor_t* r);
 
 int create_server(reactor_t* R, short port, event_callback_fn func);
 
+reactor_group_t* create_reactor_group(int num);
+
+void release_reactor_group(reactor_group_t* g);
+
+int reactor_group_create_server(reactor_group_t* g, short port, event_callback_fn func);
+
+int reactor_group_start(reactor_group_t* g);
+
+void reactor_group_stop(reactor_group_t* g);
+
 int event_buffer_read(event_t* e);
 
+// 全部写出返回 1，剩余部分进了输出 buffer 返回 0；写出错返回 -1，此时 e 已被 del_event 释放（e->fd < 0），
+// e->in / e->out 都不能再访问
 int event_buffer_write(event_t* e, void* buf, int sz);
 
 #endif
@@ -0,0 +1,49 @@
+#ifndef __Z2W_REACTOR_BACKEND_H__
+#define __Z2W_REACTOR_BACKEND_H__
+
+#include "reactor.h"
+
+// 多路复用后端，reactor.c 只通过这组接口注册事件和等待；
+// add/mod 按 _event_mask(e) 注册，del 在 free_event 之前调用，wait 把就绪事件填进 r->fire
+struct reactor_backend_s
+{
+	const char* name;
+	int (*init)(reactor_t* r);
+	void (*release)(reactor_t* r);
+	int (*add)(reactor_t* r, event_t* e);
+	int (*mod)(reactor_t* r, event_t* e);
+	void (*del)(reactor_t* r, event_t* e);
+	int (*wait)(reactor_t* r, int timeout);
+	int recv_direct; //支持由后端直接收数据进 evbuf_in
+};
+
+extern const reactor_backend_t reactor_epoll_backend;
+extern const reactor_backend_t reactor_uring_backend;
+
+static inline event_t* _slot_event(reactor_t* r, uint32_t id)
+{
+	return &r->slabs[id >> EVENT_SLAB_BITS][id & (EVENT_SLAB_SIZE - 1)];
+}
+
+static inline uint64_t _event_key(event_t* e)
+{
+	return ((uint64_t)e->gen << 32) | e->id;
+}
+
+// 根据后端携带的 id + gen 找回 event，槽位已释放或被复用时返回 NULL
+static inline event_t* _lookup_event(reactor_t* r, uint64_t key)
+{
+	event_t* e = _slot_event(r, (uint32_t)key);
+	if (e->fd < 0 || e->gen != (uint32_t)(key >> 32)) {
+		return NULL;
+	}
+	return e;
+}
+
+// 实际要监听的事件：读暂停时去掉 EPOLLIN
+static inline uint32_t _event_mask(event_t* e)
+{
+	return e->paused ? e->events & ~EPOLLIN : e->events;
+}
+
+#endif
@@ -0,0 +1,993 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "reactor.h"
+
+// 编译: gcc -O2 reactor.c reactor_uring.c ringbuffer/ringbuffer.c ringbuffer/mpmc_ring.c chainbuffer/chainbuffer.c memsearch/memsearch.c timewheel/timewheel.c reactor_bench.c -o reactor_bench -lpthread
+// 用法: ./reactor_bench echo ./reactor_test [秒数] [连接数] [消息大小]
+//       ./reactor_bench churn [连接数] [轮数]
+//       ./reactor_bench idle [连接数] [轮数] [活跃百分比] [nopool]
+//       ./reactor_bench slow [下游数] [每个下游 MB] [下游读取速度 MB/s]
+//       ./reactor_bench fair [大流量连接数] [小请求连接数] [秒数]
+//       ./reactor_bench backend [秒数] [连接数] [消息大小]
+//       ./reactor_bench post [投递线程数] [每线程任务数] [延迟采样数]
+
+#define BENCH_PORT 8888
+
+static volatile int g_bench_stop = 0;
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int connect_local(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// -------------------------- echo 吞吐（1/2/4/8 个 reactor） --------------------------
+typedef struct {
+    int size;
+    long ops;
+} echo_client_t;
+
+static void* echo_client(void* arg)
+{
+    echo_client_t* c = (echo_client_t*)arg;
+    char* msg = malloc(c->size);
+    char* buf = malloc(c->size);
+    memset(msg, 'x', c->size);
+    int fd = connect_local(BENCH_PORT);
+    if (fd < 0) {
+        printf("client connect error\n");
+        free(msg);
+        free(buf);
+        return NULL;
+    }
+    while (!g_bench_stop) {
+        if (write(fd, msg, c->size) != c->size) {
+            break;
+        }
+        int got = 0;
+        while (got < c->size) {
+            int n = read(fd, buf + got, c->size - got);
+            if (n <= 0) {
+                goto out;
+            }
+            got += n;
+        }
+        c->ops++;
+    }
+out:
+    close(fd);
+    free(msg);
+    free(buf);
+    return NULL;
+}
+
+static pid_t spawn_server(const char* server, int reactors)
+{
+    pid_t pid = fork();
+    if (pid == 0) {
+        char num[16];
+        snprintf(num, sizeof(num), "%d", reactors);
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        execl(server, server, num, (char*)NULL);
+        _exit(127);
+    }
+    // 等待服务器开始监听
+    for (int i = 0; i < 100; i++) {
+        int fd = connect_local(BENCH_PORT);
+        if (fd >= 0) {
+            close(fd);
+            return pid;
+        }
+        usleep(20 * 1000);
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+    return -1;
+}
+
+static void bench_echo(const char* server, int seconds, int conns, int size)
+{
+    int reactors[] = { 1, 2, 4, 8 };
+    printf("echo bench: %d connections, %d bytes/msg, %ds per run\n", conns, size, seconds);
+    for (size_t k = 0; k < sizeof(reactors) / sizeof(reactors[0]); k++) {
+        pid_t pid = spawn_server(server, reactors[k]);
+        if (pid < 0) {
+            printf("start server %s error\n", server);
+            return;
+        }
+        g_bench_stop = 0;
+        pthread_t* tids = calloc(conns, sizeof(pthread_t));
+        echo_client_t* clients = calloc(conns, sizeof(echo_client_t));
+        double start = now_sec();
+        for (int i = 0; i < conns; i++) {
+            clients[i].size = size;
+            pthread_create(&tids[i], NULL, echo_client, &clients[i]);
+        }
+        sleep(seconds);
+        g_bench_stop = 1;
+        long ops = 0;
+        for (int i = 0; i < conns; i++) {
+            pthread_join(tids[i], NULL);
+            ops += clients[i].ops;
+        }
+        double elapsed = now_sec() - start;
+        printf("reactors=%d  ops/s=%.0f  MB/s=%.2f\n", reactors[k],
+            ops / elapsed, ops * (double)size * 2 / elapsed / (1024 * 1024));
+        free(tids);
+        free(clients);
+        kill(pid, SIGKILL);
+        waitpid(pid, NULL, 0);
+    }
+}
+
+static void raise_nofile(void)
+{
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+}
+
+// -------------------------- 连接建立/断开抖动（event 槽位分配） --------------------------
+static void noop_cb(int fd, int events, void* privdata)
+{
+}
+
+// 真实的连接：socketpair 一端挂到 reactor 上，断开时 del_event 并关闭两端
+typedef struct {
+    event_t* e;
+    int peer;
+} churn_conn_t;
+
+static int churn_open(reactor_t* r, churn_conn_t* c)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+        return -1;
+    }
+    set_nonblock(sv[0]);
+    c->e = new_event(r, sv[0], noop_cb, NULL, NULL);
+    if (!c->e || add_event(r, EPOLLIN, c->e) < 0) {
+        if (c->e) {
+            free_event(c->e);
+        }
+        close(sv[0]);
+        close(sv[1]);
+        return -1;
+    }
+    c->peer = sv[1];
+    return 0;
+}
+
+static void churn_close(reactor_t* r, churn_conn_t* c)
+{
+    int fd = c->e->fd;
+    del_event(r, c->e);
+    close(fd);
+    close(c->peer);
+}
+
+static void bench_churn(int n, int rounds)
+{
+    // 每个连接占两个 fd
+    raise_nofile();
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && (rlim_t)n * 2 + 64 > rl.rlim_cur) {
+        n = (int)((rl.rlim_cur - 64) / 2);
+        printf("fd limit %lu, live connections capped to %d\n", (unsigned long)rl.rlim_cur, n);
+    }
+    reactor_t* r = create_reactor();
+    churn_conn_t* conns = calloc(n, sizeof(churn_conn_t));
+    srand(1);
+
+    double t0 = now_sec();
+    for (int i = 0; i < n; i++) {
+        if (churn_open(r, &conns[i]) < 0) {
+            printf("socketpair failed at %d\n", i);
+            exit(1);
+        }
+    }
+    double t1 = now_sec();
+
+    // 随机断开一个连接再建立一个新连接，保持 n 个在线；新连接复用刚释放的槽位和 fd 号
+    long ops = (long)n * rounds;
+    for (long k = 0; k < ops; k++) {
+        int i = rand() % n;
+        churn_close(r, &conns[i]);
+        if (churn_open(r, &conns[i]) < 0) {
+            printf("socketpair failed\n");
+            exit(1);
+        }
+    }
+    double t2 = now_sec();
+
+    printf("churn bench (%s): %d live connections, %u slabs\n", reactor_backend_name(r), n, r->nslabs);
+    printf("fill  : %.1f ns/connection\n", (t1 - t0) * 1e9 / n);
+    printf("churn : %.1f ns/(close+open), %.2f M/s\n", (t2 - t1) * 1e9 / ops, ops / (t2 - t1) / 1e6);
+
+    for (int i = 0; i < n; i++) {
+        churn_close(r, &conns[i]);
+    }
+    free(conns);
+    release_reactor(r);
+}
+
+// -------------------------- 大量空闲连接下的 RSS 与分配次数 --------------------------
+static int g_saved_stdout = -1;
+
+// event_buffer_read 等路径会打印收发的数据，压测期间先把 stdout 指向 /dev/null
+static void quiet_stdout(int quiet)
+{
+    fflush(stdout);
+    if (quiet) {
+        int devnull = open("/dev/null", O_WRONLY);
+        g_saved_stdout = dup(STDOUT_FILENO);
+        dup2(devnull, STDOUT_FILENO);
+        close(devnull);
+    }
+    else if (g_saved_stdout >= 0) {
+        dup2(g_saved_stdout, STDOUT_FILENO);
+        close(g_saved_stdout);
+        g_saved_stdout = -1;
+    }
+}
+
+static long rss_kb(void)
+{
+    long size = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%ld %ld", &size, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(f);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static void idle_echo_cb(int fd, int events, void* privdata)
+{
+    event_t* e = (event_t*)privdata;
+    if (event_buffer_read(e) <= 0) {
+        return;
+    }
+    buffer_t* in = evbuf_in(e);
+    int len = buffer_len(in);
+    if (event_buffer_write(e, buffer_write_atmost(in), len) < 0) {
+        return;
+    }
+    buffer_drain(in, len);
+}
+
+static void bench_idle(int n, int rounds, int active_pct, int nopool)
+{
+    raise_nofile();
+    reactor_t* r = create_reactor();
+    if (nopool) {
+        r->pool->max_cached = 0; // 不缓存任何 chain，等价于直接 malloc/free
+    }
+    int* peers = calloc(n, sizeof(int));
+    long rss_start = rss_kb();
+    for (int i = 0; i < n; i++) {
+        int sv[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) < 0) {
+            printf("socketpair error at %d: %s\n", i, strerror(errno));
+            n = i;
+            break;
+        }
+        set_nonblock(sv[0]);
+        event_t* e = new_event(r, sv[0], idle_echo_cb, NULL, NULL);
+        add_event(r, EPOLLIN, e);
+        peers[i] = sv[1];
+    }
+    long rss_conn = rss_kb();
+
+    char msg[512], reply[512];
+    memset(msg, 'x', sizeof(msg));
+    int active = n * active_pct / 100;
+    if (active == 0) {
+        active = 1;
+    }
+    long requests = 0;
+    srand(1);
+    quiet_stdout(1);
+    double t0 = now_sec();
+    for (int k = 0; k < rounds; k++) {
+        int first = rand() % n;
+        for (int j = 0; j < active; j++) {
+            if (write(peers[(first + j) % n], msg, sizeof(msg)) != sizeof(msg)) {
+                break;
+            }
+        }
+        for (int j = 0; j < active; j++) {
+            int fd = peers[(first + j) % n];
+            int got = 0;
+            while (got < (int)sizeof(reply)) {
+                int m = recv(fd, reply + got, sizeof(reply) - got, MSG_DONTWAIT);
+                if (m > 0) {
+                    got += m;
+                }
+                else {
+                    eventloop_once(r, 0);
+                }
+            }
+            requests++;
+        }
+    }
+    double t1 = now_sec();
+    quiet_stdout(0);
+
+    printf("idle bench: %d connections, %d%% active per round, pool %s\n", n, active_pct, nopool ? "off" : "on");
+    printf("rss: start %ld KB, connected %ld KB (%.1f B/conn), after load %ld KB\n",
+        rss_start, rss_conn, (rss_conn - rss_start) * 1024.0 / n, rss_kb());
+    printf("requests: %ld, %.0f req/s, chain mallocs %llu (%.3f/req), reuses %llu\n",
+        requests, requests / (t1 - t0), (unsigned long long)r->pool->chain_mallocs,
+        (double)r->pool->chain_mallocs / requests, (unsigned long long)r->pool->chain_reuses);
+
+    for (int i = 0; i < n; i++) {
+        close(peers[i]);
+    }
+    free(peers);
+    release_reactor(r);
+}
+
+// -------------------------- 慢消费者：一个上游的数据转发给多个读得慢的下游 --------------------------
+// 生产线程全速往 upstream 写，reactor 把读到的数据复制给每个 downstream，消费线程各自限速读取。
+// 不设水位时积压全部堆在各个 downstream 的输出 buffer 里；设了水位后上游被暂停，积压和 RSS 都有上限
+#define SLOW_MAX_CLIENTS 256
+#define SLOW_IN_HIGH (256 * 1024)
+#define SLOW_OUT_HIGH (1024 * 1024)
+#define SLOW_OUT_LOW (256 * 1024)
+#define SLOW_MEM_HIGH (32 * 1024 * 1024)
+#define SLOW_MEM_LOW (16 * 1024 * 1024)
+
+typedef struct {
+    int fd;
+    long total;
+    int rate_mb; //消费线程每秒最多读多少 MB
+    volatile int done;
+} slow_peer_t;
+
+static event_t* g_slow_down[SLOW_MAX_CLIENTS];
+static int g_slow_clients;
+static int g_slow_mem_events;
+
+static void* slow_producer(void* arg)
+{
+    slow_peer_t* p = (slow_peer_t*)arg;
+    char block[64 * 1024];
+    memset(block, 's', sizeof(block));
+    for (long sent = 0; sent < p->total; ) {
+        long left = p->total - sent;
+        int n = write(p->fd, block, left < (long)sizeof(block) ? left : (long)sizeof(block));
+        if (n <= 0) {
+            break;
+        }
+        sent += n;
+    }
+    close(p->fd);
+    return NULL;
+}
+
+static void* slow_consumer(void* arg)
+{
+    slow_peer_t* p = (slow_peer_t*)arg;
+    char block[16 * 1024];
+    long got = 0;
+    double t0 = now_sec();
+    while (got < p->total) {
+        int n = read(p->fd, block, sizeof(block));
+        if (n <= 0) {
+            break;
+        }
+        got += n;
+        // 按速率限速：读得比预定进度快就睡一会
+        double ahead = got / (p->rate_mb * 1024.0 * 1024) - (now_sec() - t0);
+        if (ahead > 0) {
+            usleep(ahead * 1e6);
+        }
+    }
+    p->done = got >= p->total;
+    return NULL;
+}
+
+static void slow_forward_cb(int fd, int events, void* privdata)
+{
+    event_t* up = (event_t*)privdata;
+    if (event_buffer_read(up) <= 0) {
+        return;
+    }
+    buffer_t* in = evbuf_in(up);
+    while (buffer_len(in) > 0) {
+        struct iovec vec[64];
+        int n = buffer_peek(in, 0, vec, 64);
+        if (n > 64) {
+            n = 64;
+        }
+        uint32_t moved = 0;
+        for (int i = 0; i < n; i++) {
+            for (int k = 0; k < g_slow_clients; k++) {
+                // 写出错的下游已经释放
+                if (g_slow_down[k]->fd >= 0) {
+                    event_buffer_write(g_slow_down[k], vec[i].iov_base, vec[i].iov_len);
+                }
+            }
+            moved += vec[i].iov_len;
+        }
+        buffer_drain(in, moved);
+    }
+}
+
+static void slow_mem_cb(reactor_t* r, int above, void* privdata)
+{
+    g_slow_mem_events++;
+}
+
+// 在子进程里跑，ru_maxrss 只统计这一种模式；返回下游是否都收全了数据、积压是否在上限内
+static int slow_run(int clients, long per_client, int rate_mb, int watermark)
+{
+    reactor_t* r = create_reactor();
+    int up[2];
+    socketpair(AF_UNIX, SOCK_STREAM, 0, up);
+    set_nonblock(up[0]);
+    event_t* eu = new_event(r, up[0], slow_forward_cb, NULL, NULL);
+    add_event(r, EPOLLIN, eu);
+
+    slow_peer_t prod = { up[1], per_client, rate_mb, 0 };
+    slow_peer_t cons[SLOW_MAX_CLIENTS];
+    pthread_t pt, ct[SLOW_MAX_CLIENTS];
+    g_slow_clients = clients;
+    for (int k = 0; k < clients; k++) {
+        int down[2];
+        socketpair(AF_UNIX, SOCK_STREAM, 0, down);
+        set_nonblock(down[0]);
+        g_slow_down[k] = new_event(r, down[0], noop_cb, NULL, NULL);
+        add_event(r, EPOLLIN, g_slow_down[k]);
+        if (watermark) {
+            event_set_write_watermark(g_slow_down[k], SLOW_OUT_HIGH, SLOW_OUT_LOW, eu);
+        }
+        cons[k].fd = down[1];
+        cons[k].total = per_client;
+        cons[k].rate_mb = rate_mb;
+        cons[k].done = 0;
+        pthread_create(&ct[k], NULL, slow_consumer, &cons[k]);
+    }
+    if (watermark) {
+        event_set_read_watermark(eu, SLOW_IN_HIGH);
+        reactor_set_mem_watermark(r, SLOW_MEM_HIGH, SLOW_MEM_LOW, slow_mem_cb, NULL);
+    }
+    pthread_create(&pt, NULL, slow_producer, &prod);
+
+    uint32_t peak_out = 0;
+    uint64_t peak_used = 0, peak_total = 0;
+    double t0 = now_sec();
+    quiet_stdout(1);
+    for (int done = 0; !done && now_sec() - t0 < 60; ) {
+        eventloop_once(r, 10);
+        done = 1;
+        for (int k = 0; k < clients; k++) {
+            if (buffer_len(g_slow_down[k]->out) > peak_out) {
+                peak_out = buffer_len(g_slow_down[k]->out);
+            }
+            done &= cons[k].done;
+        }
+        if (reactor_mem_used(r) > peak_used) {
+            peak_used = reactor_mem_used(r);
+        }
+        if (buffer_mem_total() > peak_total) {
+            peak_total = buffer_mem_total();
+        }
+    }
+    quiet_stdout(0);
+    double elapsed = now_sec() - t0;
+    pthread_join(pt, NULL);
+    int complete = 1;
+    for (int k = 0; k < clients; k++) {
+        // 超时没收全时关掉读端让消费线程退出
+        shutdown(cons[k].fd, SHUT_RDWR);
+        pthread_join(ct[k], NULL);
+        complete &= cons[k].done;
+        close(cons[k].fd);
+    }
+
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    printf("%-9s: %.1f s, peak out/client %5.1f MB, reactor mem %6.1f MB, all chains %6.1f MB, max rss %6.1f MB, mem watermark events %d%s\n",
+        watermark ? "watermark" : "none", elapsed, peak_out / 1048576.0, peak_used / 1048576.0,
+        peak_total / 1048576.0, ru.ru_maxrss / 1024.0, g_slow_mem_events, complete ? "" : " (incomplete)");
+    release_reactor(r);
+    // 一次读回调最多转发 SLOW_IN_HIGH，单个下游的积压不应超过水位再加这么多
+    return complete && (!watermark || peak_out <= SLOW_OUT_HIGH + SLOW_IN_HIGH);
+}
+
+static void bench_slow(int clients, long mb_per_client, int rate_mb)
+{
+    if (clients > SLOW_MAX_CLIENTS) {
+        clients = SLOW_MAX_CLIENTS;
+    }
+    printf("slow consumer bench: one upstream fanned out to %d clients, %ld MB each, clients read %d MB/s\n",
+        clients, mb_per_client, rate_mb);
+    int ok = 1;
+    for (int watermark = 0; watermark <= 1; watermark++) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid == 0) {
+            exit(slow_run(clients, mb_per_client * 1024 * 1024, rate_mb, watermark) ? 0 : 1);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (watermark && !(WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+            ok = 0;
+        }
+    }
+    printf("watermark run complete and bounded: %s\n", ok ? "yes" : "NO");
+}
+
+// -------------------------- 公平性：大流量连接和小请求连接混跑时小请求的延迟 --------------------------
+// 几个 firehose 连接不停灌大块数据（读回调里做一遍逐字节校验和，模拟解析开销），
+// 同时客户端线程在轻连接上逐个做 ping-pong，统计往返延迟；对比不限预算和默认预算
+#define FAIR_MAX_HEAVY 64
+#define FAIR_MAX_LIGHT 256
+#define FAIR_SOCKBUF (4 * 1024 * 1024)
+
+typedef struct {
+    int heavy[FAIR_MAX_HEAVY];
+    int nheavy;
+    int light[FAIR_MAX_LIGHT];
+    int nlight;
+    double seconds;
+    volatile int stop;
+    double* rtt;
+    long nrtt;
+    long cap;
+} fair_ctx_t;
+
+static volatile uint64_t g_fair_sum;
+static volatile uint64_t g_fair_bytes;
+
+static void fair_heavy_cb(int fd, int events, void* privdata)
+{
+    event_t* e = (event_t*)privdata;
+    if (event_buffer_read(e) <= 0) {
+        return;
+    }
+    buffer_t* in = evbuf_in(e);
+    struct iovec vec[64];
+    int n = buffer_peek(in, 0, vec, 64);
+    if (n > 64) {
+        n = 64;
+    }
+    uint32_t done = 0;
+    uint64_t sum = 0;
+    for (int i = 0; i < n; i++) {
+        const uint8_t* p = (const uint8_t*)vec[i].iov_base;
+        for (size_t k = 0; k < vec[i].iov_len; k++) {
+            sum += p[k];
+        }
+        done += vec[i].iov_len;
+    }
+    g_fair_sum += sum;
+    g_fair_bytes += done;
+    buffer_drain(in, done);
+}
+
+static void* fair_firehose(void* arg)
+{
+    fair_ctx_t* ctx = (fair_ctx_t*)arg;
+    static char block[256 * 1024];
+    memset(block, 'h', sizeof(block));
+    while (!ctx->stop) {
+        for (int i = 0; i < ctx->nheavy && !ctx->stop; i++) {
+            // 非阻塞写，socket 满了就换下一个
+            if (send(ctx->heavy[i], block, sizeof(block), MSG_DONTWAIT) < 0 && errno != EAGAIN) {
+                return NULL;
+            }
+        }
+        usleep(100);
+    }
+    return NULL;
+}
+
+static void* fair_client(void* arg)
+{
+    fair_ctx_t* ctx = (fair_ctx_t*)arg;
+    char msg[32], reply[32];
+    memset(msg, 'p', sizeof(msg));
+    double t_end = now_sec() + ctx->seconds;
+    while (now_sec() < t_end) {
+        for (int i = 0; i < ctx->nlight; i++) {
+            double t0 = now_sec();
+            if (write(ctx->light[i], msg, sizeof(msg)) != sizeof(msg)) {
+                goto out;
+            }
+            int got = 0;
+            while (got < (int)sizeof(reply)) {
+                int m = read(ctx->light[i], reply + got, sizeof(reply) - got);
+                if (m <= 0) {
+                    goto out;
+                }
+                got += m;
+            }
+            if (ctx->nrtt < ctx->cap) {
+                ctx->rtt[ctx->nrtt++] = now_sec() - t0;
+            }
+        }
+    }
+out:
+    ctx->stop = 1;
+    return NULL;
+}
+
+static int cmp_double(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void fair_run(int nheavy, int nlight, double seconds, int budget)
+{
+    reactor_t* r = create_reactor();
+    if (!budget) {
+        reactor_set_budget(r, 0, 0);
+    }
+    fair_ctx_t ctx;
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.nheavy = nheavy;
+    ctx.nlight = nlight;
+    ctx.seconds = seconds;
+    ctx.cap = 10 * 1000 * 1000;
+    ctx.rtt = malloc(sizeof(double) * ctx.cap);
+    for (int i = 0; i < nheavy; i++) {
+        int sv[2];
+        socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+        int sz = FAIR_SOCKBUF;
+        setsockopt(sv[1], SOL_SOCKET, SO_SNDBUF, &sz, sizeof(sz));
+        setsockopt(sv[0], SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+        set_nonblock(sv[0]);
+        event_t* e = new_event(r, sv[0], fair_heavy_cb, NULL, NULL);
+        add_event(r, EPOLLIN, e);
+        ctx.heavy[i] = sv[1];
+    }
+    for (int i = 0; i < nlight; i++) {
+        int sv[2];
+        socketpair(AF_UNIX, SOCK_STREAM, 0, sv);
+        set_nonblock(sv[0]);
+        event_t* e = new_event(r, sv[0], idle_echo_cb, NULL, NULL);
+        add_event(r, EPOLLIN, e);
+        ctx.light[i] = sv[1];
+    }
+    g_fair_bytes = 0;
+
+    pthread_t ht, ct;
+    pthread_create(&ht, NULL, fair_firehose, &ctx);
+    pthread_create(&ct, NULL, fair_client, &ctx);
+    quiet_stdout(1);
+    double t0 = now_sec();
+    while (!ctx.stop) {
+        eventloop_once(r, 10);
+    }
+    double elapsed = now_sec() - t0;
+    quiet_stdout(0);
+    pthread_join(ht, NULL);
+    pthread_join(ct, NULL);
+
+    qsort(ctx.rtt, ctx.nrtt, sizeof(double), cmp_double);
+    double p50 = ctx.nrtt ? ctx.rtt[ctx.nrtt / 2] : 0;
+    double p99 = ctx.nrtt ? ctx.rtt[ctx.nrtt * 99 / 100] : 0;
+    double max = ctx.nrtt ? ctx.rtt[ctx.nrtt - 1] : 0;
+    printf("%-9s: light %7ld req, p50 %7.1f us, p99 %8.1f us, max %8.1f us | heavy %7.1f MB/s\n",
+        budget ? "budget" : "unlimited", ctx.nrtt, p50 * 1e6, p99 * 1e6, max * 1e6,
+        g_fair_bytes / elapsed / (1024 * 1024));
+
+    for (int i = 0; i < nheavy; i++) {
+        close(ctx.heavy[i]);
+    }
+    for (int i = 0; i < nlight; i++) {
+        close(ctx.light[i]);
+    }
+    free(ctx.rtt);
+    release_reactor(r);
+}
+
+static void bench_fair(int nheavy, int nlight, double seconds)
+{
+    if (nheavy > FAIR_MAX_HEAVY) {
+        nheavy = FAIR_MAX_HEAVY;
+    }
+    if (nlight > FAIR_MAX_LIGHT) {
+        nlight = FAIR_MAX_LIGHT;
+    }
+    printf("fairness bench: %d firehose + %d ping-pong connections, %.0f s each, read budget %d KB\n",
+        nheavy, nlight, seconds, REACTOR_READ_BUDGET / 1024);
+    fair_run(nheavy, nlight, seconds, 0);
+    fair_run(nheavy, nlight, seconds, 1);
+}
+
+// -------------------------- 后端对比：epoll / io_uring 上的 echo，吞吐和每次请求的系统调用数 --------------------------
+static void backend_echo_cb(int fd, int events, void* privdata)
+{
+    event_t* e = (event_t*)privdata;
+    if (event_buffer_read(e) <= 0) {
+        return;
+    }
+    buffer_t* in = evbuf_in(e);
+    struct iovec vec[16];
+    uint32_t len = buffer_len(in);
+    int n = buffer_peek(in, len, vec, 16);
+    if (n > 16) {
+        vec[0].iov_base = buffer_pullup(in, len);
+        vec[0].iov_len = len;
+        n = 1;
+    }
+    for (int i = 0; i < n; i++) {
+        if (event_buffer_write(e, vec[i].iov_base, vec[i].iov_len) < 0) {
+            return;
+        }
+    }
+    buffer_drain(in, len);
+}
+
+static void backend_accept_cb(int fd, int events, void* privdata)
+{
+    event_t* le = (event_t*)privdata;
+    int cfd;
+    while ((cfd = accept(fd, NULL, NULL)) >= 0) {
+        int one = 1;
+        setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        set_nonblock(cfd);
+        event_t* e = new_event(le->r, cfd, backend_echo_cb, NULL, NULL);
+        event_set_recv_direct(e);
+        add_event(le->r, EPOLLIN, e);
+    }
+}
+
+static void* backend_server(void* arg)
+{
+    reactor_t* r = (reactor_t*)arg;
+    eventloop(r);
+    return NULL;
+}
+
+static void backend_run(int type, int seconds, int conns, int size)
+{
+    reactor_t* r = create_reactor_backend(type);
+    // 服务器线程里连接关闭的打印不要混进结果
+    quiet_stdout(1);
+    int ret;
+    // 上一个 io_uring reactor 的请求由内核异步回收，监听 socket 可能还要过一会儿才能重新 bind
+    for (int i = 0; (ret = create_server(r, htons(BENCH_PORT), backend_accept_cb)) == -2 && i < 100; i++) {
+        usleep(20 * 1000);
+    }
+    if (ret != 0) {
+        quiet_stdout(0);
+        printf("create server error, code=%d\n", ret);
+        release_reactor(r);
+        return;
+    }
+    pthread_t st;
+    pthread_create(&st, NULL, backend_server, r);
+
+    g_bench_stop = 0;
+    pthread_t* tids = calloc(conns, sizeof(pthread_t));
+    echo_client_t* clients = calloc(conns, sizeof(echo_client_t));
+    for (int i = 0; i < conns; i++) {
+        clients[i].size = size;
+        pthread_create(&tids[i], NULL, echo_client, &clients[i]);
+    }
+    // 连接建立阶段的系统调用不算
+    usleep(200 * 1000);
+    uint64_t sys0 = r->syscalls;
+    long ops0 = 0;
+    for (int i = 0; i < conns; i++) {
+        ops0 += clients[i].ops;
+    }
+    double start = now_sec();
+    sleep(seconds);
+    uint64_t sys1 = r->syscalls;
+    long ops = 0;
+    for (int i = 0; i < conns; i++) {
+        ops += clients[i].ops;
+    }
+    double elapsed = now_sec() - start;
+    g_bench_stop = 1;
+    for (int i = 0; i < conns; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    ops -= ops0;
+    const char* name = reactor_backend_name(r);
+    stop_eventloop(r);
+    pthread_join(st, NULL);
+    close(r->listenfd);
+    release_reactor(r);
+    quiet_stdout(0);
+    printf("%-8s: ops/s=%9.0f  server syscalls/op=%.3f\n", name,
+        ops / elapsed, ops ? (double)(sys1 - sys0) / ops : 0);
+    free(tids);
+    free(clients);
+}
+
+static void bench_backend(int seconds, int conns, int size)
+{
+    printf("backend bench: echo, %d connections, %d bytes/msg, %ds per run\n", conns, size, seconds);
+    backend_run(REACTOR_BACKEND_EPOLL, seconds, conns, size);
+    backend_run(REACTOR_BACKEND_URING, seconds, conns, size);
+}
+
+// -------------------------- 跨线程投递：单线程往返延迟、多线程吞吐和每个任务的唤醒次数 --------------------------
+typedef struct {
+    double posted; //投递时刻
+    double ran; //reactor 线程执行时刻
+    atomic_int done;
+} post_probe_t;
+
+static void post_probe_task(reactor_t* r, void* arg)
+{
+    post_probe_t* p = (post_probe_t*)arg;
+    p->ran = now_sec();
+    atomic_store(&p->done, 1);
+}
+
+static atomic_long g_post_count;
+
+static void post_count_task(reactor_t* r, void* arg)
+{
+    atomic_fetch_add_explicit(&g_post_count, 1, memory_order_relaxed);
+}
+
+typedef struct {
+    reactor_t* r;
+    long n;
+} post_worker_t;
+
+static void* post_worker(void* arg)
+{
+    post_worker_t* w = (post_worker_t*)arg;
+    for (long i = 0; i < w->n; i++) {
+        // 队列满时让出 CPU 给 reactor 线程
+        while (reactor_post(w->r, post_count_task, NULL) < 0) {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+static void bench_post(int nthreads, long per_thread, int samples)
+{
+    reactor_t* r = create_reactor();
+    pthread_t st;
+    pthread_create(&st, NULL, backend_server, r);
+    printf("post bench: %s backend, mailbox %d\n", reactor_backend_name(r), REACTOR_MAILBOX_SIZE);
+
+    // 延迟：每次等上一个任务执行完再投递，每个任务都要唤醒一次阻塞的 reactor
+    double* lat = malloc(sizeof(double) * samples);
+    uint64_t w0 = atomic_load(&r->wakeups);
+    for (int i = 0; i < samples; i++) {
+        post_probe_t p;
+        atomic_init(&p.done, 0);
+        p.posted = now_sec();
+        reactor_post(r, post_probe_task, &p);
+        while (!atomic_load(&p.done)) {
+            sched_yield();
+        }
+        lat[i] = p.ran - p.posted;
+    }
+    uint64_t w1 = atomic_load(&r->wakeups);
+    qsort(lat, samples, sizeof(double), cmp_double);
+    printf("latency   : %d posts, p50 %6.1f us, p99 %7.1f us, max %8.1f us, wakeups/post %.2f\n",
+        samples, lat[samples / 2] * 1e6, lat[samples * 99 / 100] * 1e6, lat[samples - 1] * 1e6,
+        (double)(w1 - w0) / samples);
+    free(lat);
+
+    // 吞吐：多个线程连续投递，reactor 一次取一批，唤醒被合并
+    atomic_store(&g_post_count, 0);
+    long total = per_thread * nthreads;
+    pthread_t* tids = calloc(nthreads, sizeof(pthread_t));
+    post_worker_t w = { r, per_thread };
+    w0 = atomic_load(&r->wakeups);
+    double start = now_sec();
+    for (int i = 0; i < nthreads; i++) {
+        pthread_create(&tids[i], NULL, post_worker, &w);
+    }
+    for (int i = 0; i < nthreads; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    while (atomic_load(&g_post_count) < total) {
+        sched_yield();
+    }
+    double elapsed = now_sec() - start;
+    w1 = atomic_load(&r->wakeups);
+    printf("throughput: %d threads x %ld tasks, %10.0f tasks/s, wakeups/task %.4f\n",
+        nthreads, per_thread, total / elapsed, (double)(w1 - w0) / total);
+    free(tids);
+
+    stop_eventloop(r);
+    pthread_join(st, NULL);
+    release_reactor(r);
+}
+
+int main(int argc, char* argv[])
+{
+    signal(SIGPIPE, SIG_IGN);
+    if (argc < 2) {
+        printf("usage: %s echo <reactor_test> [seconds] [conns] [size]\n", argv[0]);
+        printf("       %s churn [conns] [rounds]\n", argv[0]);
+        printf("       %s idle [conns] [rounds] [active%%] [nopool]\n", argv[0]);
+        printf("       %s slow [clients] [mb_per_client] [client_mb_per_s]\n", argv[0]);
+        printf("       %s fair [heavy_conns] [light_conns] [seconds]\n", argv[0]);
+        printf("       %s backend [seconds] [conns] [size]\n", argv[0]);
+        printf("       %s post [threads] [tasks_per_thread] [latency_samples]\n", argv[0]);
+        return 1;
+    }
+    if (strcmp(argv[1], "echo") == 0 && argc >= 3) {
+        bench_echo(argv[2],
+            argc > 3 ? atoi(argv[3]) : 5,
+            argc > 4 ? atoi(argv[4]) : 32,
+            argc > 5 ? atoi(argv[5]) : 64);
+        return 0;
+    }
+    if (strcmp(argv[1], "churn") == 0) {
+        bench_churn(argc > 2 ? atoi(argv[2]) : 5000, argc > 3 ? atoi(argv[3]) : 20);
+        return 0;
+    }
+    if (strcmp(argv[1], "idle") == 0) {
+        bench_idle(argc > 2 ? atoi(argv[2]) : 50000,
+            argc > 3 ? atoi(argv[3]) : 200,
+            argc > 4 ? atoi(argv[4]) : 1,
+            argc > 5 && strcmp(argv[5], "nopool") == 0);
+        return 0;
+    }
+    if (strcmp(argv[1], "slow") == 0) {
+        bench_slow(argc > 2 ? atoi(argv[2]) : 32, argc > 3 ? atol(argv[3]) : 12, argc > 4 ? atoi(argv[4]) : 8);
+        return 0;
+    }
+    if (strcmp(argv[1], "fair") == 0) {
+        bench_fair(argc > 2 ? atoi(argv[2]) : 8, argc > 3 ? atoi(argv[3]) : 16, argc > 4 ? atof(argv[4]) : 3);
+        return 0;
+    }
+    if (strcmp(argv[1], "backend") == 0) {
+        bench_backend(argc > 2 ? atoi(argv[2]) : 3, argc > 3 ? atoi(argv[3]) : 32, argc > 4 ? atoi(argv[4]) : 64);
+        return 0;
+    }
+    if (strcmp(argv[1], "post") == 0) {
+        bench_post(argc > 2 ? atoi(argv[2]) : 4, argc > 3 ? atol(argv[3]) : 1000000, argc > 4 ? atoi(argv[4]) : 20000);
+        return 0;
+    }
+    printf("unknown bench: %s\n", argv[1]);
+    return 1;
+}
@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include "reactor.h"
+
+// 编译: gcc reactor.c reactor_uring.c ringbuffer/ringbuffer.c ringbuffer/mpmc_ring.c chainbuffer/chainbuffer.c memsearch/memsearch.c timewheel/timewheel.c reactor_event_test.c -o reactor_event_test -lpthread
+// reactor 核心的测试：event 槽位复用（epoll 事件带着 id + gen，槽位被释放并分给新连接后，同一批里旧连接的事件不能交给新连接），
+// 以及创建 reactor 时资源不足的处理
+
+typedef struct {
+    event_t* evs[2]; //同一批里都可读的两个连接
+    int sv[2][2];
+    event_t* reused; //回调里新建、复用了被关闭连接槽位的 event
+    int nsv[2];
+    int reads[2];
+    int reused_reads;
+} ctx_t;
+
+static ctx_t g_ctx;
+
+static void reused_read_cb(int fd, int events, void* privdata)
+{
+    char c;
+    g_ctx.reused_reads++;
+    assert(read(fd, &c, 1) == 1);
+}
+
+// 先被回调的连接关掉另一个，再建一个新连接，新连接拿到的正是刚释放的槽位
+static void read_cb(int fd, int events, void* privdata)
+{
+    event_t* e = (event_t*)privdata;
+    int self = e == g_ctx.evs[0] ? 0 : 1;
+    char c;
+    g_ctx.reads[self]++;
+    assert(read(fd, &c, 1) == 1);
+    if (g_ctx.reused) {
+        return;
+    }
+    event_t* other = g_ctx.evs[!self];
+    uint32_t id = other->id, gen = other->gen;
+    del_event(e->r, other);
+    close(g_ctx.sv[!self][0]);
+    close(g_ctx.sv[!self][1]);
+    g_ctx.evs[!self] = NULL;
+
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, g_ctx.nsv) == 0);
+    set_nonblock(g_ctx.nsv[0]);
+    event_t* ne = new_event(e->r, g_ctx.nsv[0], reused_read_cb, NULL, NULL);
+    assert(ne == other && ne->id == id && ne->gen != gen);
+    assert(add_event(e->r, EPOLLIN, ne) == 0);
+    g_ctx.reused = ne;
+}
+
+// 测试用例1：同一批就绪事件里，前一个回调关闭了后一个连接并让新连接复用它的槽位，旧事件被丢弃
+void test_stale_event() {
+    printf("Test 1: Stale epoll event is dropped after slot reuse\n");
+    reactor_t* r = create_reactor();
+    assert(strcmp(reactor_backend_name(r), "epoll") == 0);
+    memset(&g_ctx, 0, sizeof(g_ctx));
+    for (int i = 0; i < 2; i++) {
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, g_ctx.sv[i]) == 0);
+        set_nonblock(g_ctx.sv[i][0]);
+        g_ctx.evs[i] = new_event(r, g_ctx.sv[i][0], read_cb, NULL, NULL);
+        assert(g_ctx.evs[i]);
+        assert(add_event(r, EPOLLIN, g_ctx.evs[i]) == 0);
+    }
+    // 两个连接都先就绪，一次 epoll_wait 一起返回
+    for (int i = 0; i < 2; i++) {
+        assert(write(g_ctx.sv[i][1], "x", 1) == 1);
+    }
+    eventloop_once(r, 100);
+    assert(g_ctx.reused);
+    assert(g_ctx.reads[0] + g_ctx.reads[1] == 1);
+    // 被关闭连接的事件没有落到新连接头上
+    assert(g_ctx.reused_reads == 0);
+
+    // 新连接自己的事件照常送达
+    assert(write(g_ctx.nsv[1], "y", 1) == 1);
+    for (int i = 0; i < 10 && g_ctx.reused_reads == 0; i++) {
+        eventloop_once(r, 100);
+    }
+    assert(g_ctx.reused_reads == 1);
+
+    for (int i = 0; i < 2; i++) {
+        if (g_ctx.evs[i]) {
+            del_event(r, g_ctx.evs[i]);
+            close(g_ctx.sv[i][0]);
+            close(g_ctx.sv[i][1]);
+        }
+    }
+    del_event(r, g_ctx.reused);
+    close(g_ctx.nsv[0]);
+    close(g_ctx.nsv[1]);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// fd 上限压到只剩 extra 个可用 fd 再创建 reactor
+static reactor_t* create_with_fds(int extra)
+{
+    struct rlimit old, rl;
+    int lowest = dup(0); //之前的 fd 都被占着，下一个分配到的就是它
+    assert(lowest >= 0);
+    close(lowest);
+    assert(getrlimit(RLIMIT_NOFILE, &old) == 0);
+    rl = old;
+    rl.rlim_cur = lowest + extra;
+    assert(setrlimit(RLIMIT_NOFILE, &rl) == 0);
+    reactor_t* r = create_reactor();
+    assert(setrlimit(RLIMIT_NOFILE, &old) == 0);
+    return r;
+}
+
+// 测试用例2：创建过程中分配失败时返回 NULL，已经建好的部分都被释放
+void test_create_fail() {
+    printf("Test 2: create_reactor fails cleanly when out of fds\n");
+    // epoll 拿到了 fd，唤醒用的 eventfd 拿不到
+    assert(create_with_fds(1) == NULL);
+    // fd 够用时正常创建
+    reactor_t* r = create_with_fds(2);
+    assert(r);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    unsetenv("REACTOR_BACKEND");
+    printf("Starting reactor event tests...\n\n");
+
+    test_stale_event();
+    test_create_fail();
+
+    printf("All tests passed!\n");
+    return 0;
+}
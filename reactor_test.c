@@ -76,19 +76,32 @@ void client_read_cb(int client_fd, int events, void* arg) {
         return;
     }
 
-    // 2. 回声逻辑：将输入缓冲区的数据写入输出缓冲区，触发发送
-    char* data = buffer_write_atmost(in_buf);  // 假设 buffer_data 返回缓冲区数据指针
+    // 2. 回声逻辑：不合并 chain，按段查看输入缓冲区的数据
+    struct iovec vec[16];
     int data_len = buffer_len(in_buf);
-
-    printf("recv from client fd=%d: %.*s", client_fd, data_len, data);  // 打印接收数据
+    int n = buffer_peek(in_buf, data_len, vec, 16);
+    if (n > 16) {
+        // 段数太多时退回到合并成一块
+        vec[0].iov_base = buffer_pullup(in_buf, data_len);
+        vec[0].iov_len = data_len;
+        n = 1;
+    }
 
     // 3. 调用 Reactor 发送接口，将数据发回客户端
-    int ret = event_buffer_write(et, data, data_len);
-    if (ret != 1) {
-        printf("client fd=%d send pending, wait EPOLLOUT\n", client_fd);
-    }
-    else {
-        printf("send to client fd=%d: %.*s", client_fd, data_len, data);  // 打印发送数据
+    for (int i = 0; i < n; i++) {
+        printf("recv from client fd=%d: %.*s", client_fd, (int)vec[i].iov_len, (char*)vec[i].iov_base);  // 打印接收数据
+        int ret = event_buffer_write(et, vec[i].iov_base, vec[i].iov_len);
+        if (ret < 0) {
+            // 连接已经释放，in_buf 也跟着释放了，不能再 drain
+            printf("client fd=%d send error, connection closed\n", client_fd);
+            return;
+        }
+        if (ret == 0) {
+            printf("client fd=%d send pending, wait EPOLLOUT\n", client_fd);
+        }
+        else {
+            printf("send to client fd=%d: %.*s", client_fd, (int)vec[i].iov_len, (char*)vec[i].iov_base);  // 打印发送数据
+        }
     }
 
     // 4. 清空输入缓冲区（准备下次接收）
@@ -102,7 +115,28 @@ void client_error_cb(int client_fd, char* err_msg) {
 }
 
 // -------------------------- 主函数（启动服务器） --------------------------
-int main() {
+// 用法: ./reactor_test [reactor 数量]，数量大于 1 时启用多 reactor（SO_REUSEPORT）模式
+int main(int argc, char* argv[]) {
+    int num = argc > 1 ? atoi(argv[1]) : 1;
+    if (num > 1) {
+        reactor_group_t* g = create_reactor_group(num);
+        if (g == NULL) {
+            printf("create reactor group error\n");
+            return -1;
+        }
+        int ret = reactor_group_create_server(g, htons(8888), accept_cb);
+        if (ret != 0) {
+            printf("create server error, code=%d\n", ret);
+            release_reactor_group(g);
+            return -1;
+        }
+        printf("reactor group (%d reactors) start, listening port 8888...\n", num);
+        reactor_group_start(g);
+        pause();  // 各 reactor 在自己的线程中运行，主线程等待信号
+        release_reactor_group(g);
+        return 0;
+    }
+
     // 1. 创建 Reactor 实例
     reactor_t* r = create_reactor();
     if (r == NULL) {
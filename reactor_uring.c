@@ -0,0 +1,536 @@
+#include "reactor_backend.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+// io_uring 后端：不依赖 liburing，直接用系统调用 + mmap 的 SQ/CQ。
+// 普通 event 用 poll 模拟就绪通知（水平触发用单次 poll，每轮处理完再重新提交；EPOLLET 用 multishot poll），
+// event_set_recv_direct 的 event 用 multishot recv 从 provided buffer ring 里取 buffer，
+// ring 里的每个 buffer 就是一个 chain，收满的大块直接挂进 evbuf_in。
+// 一轮里产生的所有提交在下一次等待时和等待一起用一次 io_uring_enter 完成
+
+#define URING_ENTRIES		1024 //SQ 深度，CQ 是它的两倍
+#define URING_BUF_COUNT		64 //provided buffer 个数，必须是 2 的幂；用完时 recv 结束，下一轮重新提交
+#define URING_BUF_SIZE		(64 * 1024) //每个 provided buffer 对应的 chain 大小（含 chain 头）
+#define URING_BUF_GROUP		0
+#define URING_COPY_MAX		(URING_BUF_SIZE / 4) //收到的数据不超过这么多时拷进 buffer，chain 留在 ring 里复用
+
+// user_data：高 32 位是 gen，低 32 位是 id << 2 | 操作类型
+#define UD_NONE		0 //取消、poll 更新本身的完成，不用处理
+#define UD_POLL		1
+#define UD_RECV		2
+#define UD_CANCEL	3 //释放时取消全部请求
+
+// event_t::io_state
+#define IO_POLL			0x1 //有一个 poll 在内核里
+#define IO_POLL_MULTI	0x2 //内核里的 poll 是 multishot
+#define IO_RECV			0x4 //multishot recv 在内核里
+#define IO_RECV_CANCEL	0x8 //已经提交了 recv 的取消
+#define IO_REARM		0x10 //在待重新提交列表里
+
+typedef struct uring_s uring_t;
+
+struct uring_s
+{
+	int fd;
+	uint32_t* sq_head;
+	uint32_t* sq_tail;
+	uint32_t* sq_array;
+	uint32_t sq_mask;
+	uint32_t sq_entries;
+	uint32_t sqe_tail; //本地 SQ 尾，进入内核前才写回 *sq_tail
+	struct io_uring_sqe* sqes;
+	uint32_t* cq_head;
+	uint32_t* cq_tail;
+	uint32_t cq_mask;
+	struct io_uring_cqe* cqes;
+	void* sq_ptr;
+	size_t sq_len;
+	void* cq_ptr;
+	size_t cq_len;
+	size_t sqes_len;
+	struct io_uring_buf_ring* br;
+	size_t br_len;
+	uint16_t br_tail;
+	int br_registered;
+	buf_chain_t* bufs[URING_BUF_COUNT]; //bid -> chain
+	uint64_t* rearm; //poll/recv 结束了、需要按当前状态重新提交的 event
+	uint32_t nrearm;
+	uint32_t rearm_cap;
+};
+
+static inline uint64_t _ud(event_t* e, int op)
+{
+	return ((uint64_t)e->gen << 32) | (e->id << 2) | op;
+}
+
+static int _uring_enter(reactor_t* r, uring_t* u, uint32_t wait_nr, int timeout)
+{
+	__atomic_store_n(u->sq_tail, u->sqe_tail, __ATOMIC_RELEASE);
+	uint32_t submit = u->sqe_tail - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE);
+	struct __kernel_timespec ts;
+	struct io_uring_getevents_arg arg;
+	memset(&arg, 0, sizeof(arg));
+	if (timeout > 0) {
+		ts.tv_sec = timeout / 1000;
+		ts.tv_nsec = (long long)(timeout % 1000) * 1000000;
+		arg.ts = (uint64_t)(uintptr_t)&ts;
+	}
+	r->syscalls++;
+	return syscall(__NR_io_uring_enter, u->fd, submit, wait_nr,
+		IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+static struct io_uring_sqe* _uring_sqe(reactor_t* r, uring_t* u)
+{
+	if (u->sqe_tail - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE) >= u->sq_entries) {
+		// SQ 满了先提交一批，不等完成
+		_uring_enter(r, u, 0, 0);
+		if (u->sqe_tail - __atomic_load_n(u->sq_head, __ATOMIC_ACQUIRE) >= u->sq_entries) {
+			return NULL;
+		}
+	}
+	uint32_t idx = u->sqe_tail & u->sq_mask;
+	struct io_uring_sqe* sqe = &u->sqes[idx];
+	memset(sqe, 0, sizeof(*sqe));
+	u->sq_array[idx] = idx;
+	u->sqe_tail++;
+	return sqe;
+}
+
+// 把 bid 对应的 chain 放回 provided buffer ring，等 _uring_reap 结束时统一发布 tail
+static inline void _uring_buf_put(uring_t* u, uint16_t bid)
+{
+	struct io_uring_buf* b = &u->br->bufs[u->br_tail & (URING_BUF_COUNT - 1)];
+	b->addr = (uint64_t)(uintptr_t)u->bufs[bid]->buffer;
+	b->len = u->bufs[bid]->buffer_len;
+	b->bid = bid;
+	u->br_tail++;
+}
+
+static void _uring_want_rearm(uring_t* u, event_t* e)
+{
+	if (e->io_state & IO_REARM) {
+		return;
+	}
+	if (u->nrearm == u->rearm_cap) {
+		uint32_t cap = u->rearm_cap ? u->rearm_cap * 2 : 64;
+		uint64_t* rearm = (uint64_t*)realloc(u->rearm, sizeof(uint64_t) * cap);
+		if (!rearm) {
+			return;
+		}
+		u->rearm = rearm;
+		u->rearm_cap = cap;
+	}
+	u->rearm[u->nrearm++] = _event_key(e);
+	e->io_state |= IO_REARM;
+}
+
+static void _uring_poll_remove(reactor_t* r, uring_t* u, event_t* e, uint32_t flags, uint32_t mask)
+{
+	struct io_uring_sqe* sqe = _uring_sqe(r, u);
+	if (!sqe) {
+		return;
+	}
+	sqe->opcode = IORING_OP_POLL_REMOVE;
+	sqe->fd = -1;
+	sqe->addr = _ud(e, UD_POLL);
+	sqe->len = flags;
+	sqe->poll32_events = mask;
+	sqe->user_data = UD_NONE;
+}
+
+// 让内核里的 poll/recv 和 event 当前要监听的事件一致
+static int _uring_update(reactor_t* r, event_t* e)
+{
+	uring_t* u = (uring_t*)r->backend_data;
+	uint32_t mask = _event_mask(e);
+	if (e->recv_direct) {
+		if ((mask & EPOLLIN) && !(e->io_state & IO_RECV) && !e->io_eof && !e->io_err) {
+			struct io_uring_sqe* sqe = _uring_sqe(r, u);
+			if (!sqe) {
+				return -1;
+			}
+			sqe->opcode = IORING_OP_RECV;
+			sqe->fd = e->fd;
+			sqe->ioprio = IORING_RECV_MULTISHOT;
+			sqe->flags = IOSQE_BUFFER_SELECT;
+			sqe->buf_group = URING_BUF_GROUP;
+			sqe->user_data = _ud(e, UD_RECV);
+			e->io_state |= IO_RECV;
+		}
+		else if (!(mask & EPOLLIN) && (e->io_state & IO_RECV) && !(e->io_state & IO_RECV_CANCEL)) {
+			// 取消完成前收到的数据照样收下，由读水位控制总量
+			struct io_uring_sqe* sqe = _uring_sqe(r, u);
+			if (!sqe) {
+				return -1;
+			}
+			sqe->opcode = IORING_OP_ASYNC_CANCEL;
+			sqe->fd = -1;
+			sqe->addr = _ud(e, UD_RECV);
+			sqe->user_data = UD_NONE;
+			e->io_state |= IO_RECV_CANCEL;
+		}
+		// 读由 recv 负责，poll 只管写
+		mask &= ~EPOLLIN;
+	}
+	uint32_t multi = (mask & EPOLLET) ? IORING_POLL_ADD_MULTI : 0;
+	mask &= ~EPOLLET;
+	if (e->io_state & IO_POLL) {
+		if (mask == e->io_mask && multi == ((e->io_state & IO_POLL_MULTI) ? IORING_POLL_ADD_MULTI : 0)) {
+			return 0;
+		}
+		if (mask && multi == ((e->io_state & IO_POLL_MULTI) ? IORING_POLL_ADD_MULTI : 0)) {
+			// 原地修改监听的事件；已经完成的 poll 更新会失败，完成事件到来后按新的 mask 重新提交
+			_uring_poll_remove(r, u, e, IORING_POLL_UPDATE_EVENTS | multi, mask);
+			e->io_mask = mask;
+		}
+		else {
+			// 不再监听或者触发方式变了，删掉，结束后按当前状态重新提交
+			_uring_poll_remove(r, u, e, 0, 0);
+		}
+		return 0;
+	}
+	if (!mask) {
+		return 0;
+	}
+	struct io_uring_sqe* sqe = _uring_sqe(r, u);
+	if (!sqe) {
+		return -1;
+	}
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = e->fd;
+	sqe->poll32_events = mask;
+	sqe->len = multi;
+	sqe->user_data = _ud(e, UD_POLL);
+	e->io_state |= IO_POLL | (multi ? IO_POLL_MULTI : 0);
+	e->io_mask = mask;
+	return 0;
+}
+
+static void _uring_del(reactor_t* r, event_t* e)
+{
+	uring_t* u = (uring_t*)r->backend_data;
+	if (e->io_state & IO_POLL) {
+		_uring_poll_remove(r, u, e, 0, 0);
+	}
+	if ((e->io_state & IO_RECV) && !(e->io_state & IO_RECV_CANCEL)) {
+		struct io_uring_sqe* sqe = _uring_sqe(r, u);
+		if (sqe) {
+			sqe->opcode = IORING_OP_ASYNC_CANCEL;
+			sqe->fd = -1;
+			sqe->addr = _ud(e, UD_RECV);
+			sqe->user_data = UD_NONE;
+		}
+	}
+	// event 释放后 gen 改变，之后到达的完成事件都会被忽略（provided buffer 照常回收）
+	e->io_state = 0;
+}
+
+// ring 里空着的 chain 不算连接占用的内存，否则 reactor 的内存水位一开始就被它们占掉一截
+static buf_chain_t* _uring_chain_new(reactor_t* r)
+{
+	buf_chain_t* ch = buffer_chain_new(r->pool, URING_BUF_SIZE - BUFFER_CHAIN_SIZE);
+	if (ch) {
+		r->pool->used -= URING_BUF_SIZE;
+	}
+	return ch;
+}
+
+static void _uring_chain_free(reactor_t* r, buf_chain_t* ch)
+{
+	r->pool->used += URING_BUF_SIZE;
+	buffer_chain_free(r->pool, ch);
+}
+
+// 处理 provided buffer 里收到的 len 字节：小块拷进 buffer，大块把整个 chain 挂过去并给 ring 补一个新 chain
+static void _uring_recv_buf(reactor_t* r, uring_t* u, event_t* e, uint16_t bid, int len)
+{
+	if (bid >= URING_BUF_COUNT) {
+		return;
+	}
+	if (e && len > 0) {
+		buffer_t* in = evbuf_in(e);
+		buf_chain_t* ch = u->bufs[bid];
+		buf_chain_t* fresh = len > URING_COPY_MAX ? _uring_chain_new(r) : NULL;
+		if (fresh) {
+			ch->off = len;
+			r->pool->used += URING_BUF_SIZE;
+			if (buffer_add_chain(in, ch) < 0) {
+				ch->off = 0;
+				r->pool->used -= URING_BUF_SIZE;
+				_uring_chain_free(r, fresh);
+			}
+			else {
+				u->bufs[bid] = fresh;
+			}
+		}
+		else {
+			buffer_add(in, ch->buffer, len);
+		}
+		e->io_pending += len;
+	}
+	_uring_buf_put(u, bid);
+}
+
+static int _uring_reap(reactor_t* r, uring_t* u)
+{
+	int n = 0;
+	uint16_t br_tail = u->br_tail;
+	uint32_t head = *u->cq_head;
+	uint32_t tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+	// fire 放满了就停，剩下的完成事件留给下一轮
+	for (; head != tail && n < MAX_EVENT_NUM; head++) {
+		struct io_uring_cqe* cqe = &u->cqes[head & u->cq_mask];
+		uint64_t ud = cqe->user_data;
+		int op = ud & 3;
+		if (op == UD_NONE || op == UD_CANCEL) {
+			continue;
+		}
+		uint64_t key = (ud & 0xffffffff00000000ULL) | ((uint32_t)ud >> 2);
+		event_t* e = _lookup_event(r, key);
+		int more = cqe->flags & IORING_CQE_F_MORE;
+		int res = cqe->res;
+		uint32_t revents = 0;
+		if (op == UD_RECV) {
+			if (cqe->flags & IORING_CQE_F_BUFFER) {
+				_uring_recv_buf(r, u, e, cqe->flags >> IORING_CQE_BUFFER_SHIFT, res);
+			}
+			if (!e) {
+				continue;
+			}
+			if (!more) {
+				e->io_state &= ~(IO_RECV | IO_RECV_CANCEL);
+				_uring_want_rearm(u, e);
+			}
+			if (res > 0) {
+				revents = EPOLLIN;
+			}
+			else if (res == 0) {
+				e->io_eof = 1;
+				revents = EPOLLIN;
+			}
+			else if (res != -ENOBUFS && res != -ECANCELED) {
+				e->io_err = -res;
+				revents = EPOLLIN;
+			}
+		}
+		else {
+			if (!e) {
+				continue;
+			}
+			if (!more) {
+				e->io_state &= ~(IO_POLL | IO_POLL_MULTI);
+				_uring_want_rearm(u, e);
+			}
+			if (res > 0) {
+				// 更新 mask 之前触发的 poll 可能带着已经不关心的事件
+				revents = res & (e->io_mask | EPOLLERR | EPOLLHUP);
+			}
+		}
+		if (!revents) {
+			continue;
+		}
+		if (n > 0 && r->fire[n - 1].data.u64 == key) {
+			r->fire[n - 1].events |= revents;
+			continue;
+		}
+		r->fire[n].events = revents;
+		r->fire[n].data.u64 = key;
+		n++;
+	}
+	__atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+	if (u->br_tail != br_tail) {
+		__atomic_store_n(&u->br->tail, u->br_tail, __ATOMIC_RELEASE);
+	}
+	return n;
+}
+
+static int _uring_wait(reactor_t* r, int timeout)
+{
+	uring_t* u = (uring_t*)r->backend_data;
+	// 上一轮结束的单次 poll 和 recv 按当前状态重新提交，和等待合并成一次 io_uring_enter
+	uint32_t n = u->nrearm;
+	u->nrearm = 0;
+	for (uint32_t i = 0; i < n; i++) {
+		event_t* e = _lookup_event(r, u->rearm[i]);
+		if (!e) {
+			continue;
+		}
+		e->io_state &= ~IO_REARM;
+		_uring_update(r, e);
+	}
+	int ready = *u->cq_head != __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+	if (ready || timeout == 0) {
+		if (!ready || u->sqe_tail != *u->sq_head) {
+			_uring_enter(r, u, 0, 0);
+		}
+	}
+	else {
+		_uring_enter(r, u, 1, timeout);
+	}
+	return _uring_reap(r, u);
+}
+
+// 同步取消内核里所有还没结束的请求：关闭 ring fd 后内核是异步清理的，
+// 在那之前 poll 仍然持有着 fd（比如监听 socket 迟迟不能重新 bind）。
+// 提交请求的线程已经退出时（reactor 线程结束后在主线程释放），被取消的请求仍由内核稍后回收
+static void _uring_cancel_all(reactor_t* r, uring_t* u)
+{
+	struct io_uring_sqe* sqe = _uring_sqe(r, u);
+	if (!sqe) {
+		return;
+	}
+	sqe->opcode = IORING_OP_ASYNC_CANCEL;
+	sqe->fd = -1;
+	sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+	sqe->user_data = UD_CANCEL;
+	for (int i = 0; i < 100; i++) {
+		if (_uring_enter(r, u, 1, 10) < 0 && errno != EINTR && errno != ETIME) {
+			return;
+		}
+		uint32_t head = *u->cq_head;
+		uint32_t tail = __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE);
+		int done = 0;
+		for (; head != tail; head++) {
+			if (u->cqes[head & u->cq_mask].user_data == UD_CANCEL) {
+				done = 1;
+			}
+		}
+		__atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+		if (done) {
+			return;
+		}
+	}
+}
+
+static void _uring_release(reactor_t* r)
+{
+	uring_t* u = (uring_t*)r->backend_data;
+	if (!u) {
+		return;
+	}
+	if (u->sqes) {
+		_uring_cancel_all(r, u);
+	}
+	if (u->br_registered) {
+		struct io_uring_buf_reg reg;
+		memset(&reg, 0, sizeof(reg));
+		reg.bgid = URING_BUF_GROUP;
+		syscall(__NR_io_uring_register, u->fd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+	}
+	if (u->fd >= 0) {
+		close(u->fd);
+	}
+	if (u->sqes) {
+		munmap(u->sqes, u->sqes_len);
+	}
+	if (u->cq_ptr && u->cq_ptr != u->sq_ptr) {
+		munmap(u->cq_ptr, u->cq_len);
+	}
+	if (u->sq_ptr) {
+		munmap(u->sq_ptr, u->sq_len);
+	}
+	if (u->br) {
+		munmap(u->br, u->br_len);
+	}
+	for (int i = 0; i < URING_BUF_COUNT; i++) {
+		if (u->bufs[i]) {
+			_uring_chain_free(r, u->bufs[i]);
+		}
+	}
+	free(u->rearm);
+	free(u);
+	r->backend_data = NULL;
+}
+
+static int _uring_init(reactor_t* r)
+{
+	uring_t* u = (uring_t*)calloc(1, sizeof(uring_t));
+	if (!u) {
+		return -1;
+	}
+	r->backend_data = u;
+	struct io_uring_params p;
+	memset(&p, 0, sizeof(p));
+	u->fd = syscall(__NR_io_uring_setup, URING_ENTRIES, &p);
+	if (u->fd < 0) {
+		goto err;
+	}
+	// 带超时的等待需要 EXT_ARG（5.11），CQ 溢出不丢事件需要 NODROP
+	if (!(p.features & IORING_FEAT_EXT_ARG) || !(p.features & IORING_FEAT_NODROP)) {
+		goto err;
+	}
+	u->sq_len = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+	u->cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		if (u->cq_len > u->sq_len) {
+			u->sq_len = u->cq_len;
+		}
+		u->cq_len = u->sq_len;
+	}
+	u->sq_ptr = mmap(NULL, u->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQ_RING);
+	if (u->sq_ptr == MAP_FAILED) {
+		u->sq_ptr = NULL;
+		goto err;
+	}
+	if (p.features & IORING_FEAT_SINGLE_MMAP) {
+		u->cq_ptr = u->sq_ptr;
+	}
+	else {
+		u->cq_ptr = mmap(NULL, u->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+		if (u->cq_ptr == MAP_FAILED) {
+			u->cq_ptr = NULL;
+			goto err;
+		}
+	}
+	u->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+	u->sqes = mmap(NULL, u->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_SQES);
+	if (u->sqes == MAP_FAILED) {
+		u->sqes = NULL;
+		goto err;
+	}
+	u->sq_head = (uint32_t*)((char*)u->sq_ptr + p.sq_off.head);
+	u->sq_tail = (uint32_t*)((char*)u->sq_ptr + p.sq_off.tail);
+	u->sq_array = (uint32_t*)((char*)u->sq_ptr + p.sq_off.array);
+	u->sq_mask = *(uint32_t*)((char*)u->sq_ptr + p.sq_off.ring_mask);
+	u->sq_entries = p.sq_entries;
+	u->sqe_tail = *u->sq_tail;
+	u->cq_head = (uint32_t*)((char*)u->cq_ptr + p.cq_off.head);
+	u->cq_tail = (uint32_t*)((char*)u->cq_ptr + p.cq_off.tail);
+	u->cq_mask = *(uint32_t*)((char*)u->cq_ptr + p.cq_off.ring_mask);
+	u->cqes = (struct io_uring_cqe*)((char*)u->cq_ptr + p.cq_off.cqes);
+
+	// provided buffer ring（5.19）：ring 本身要页对齐，每个 buffer 是池里分配的一个 chain
+	u->br_len = URING_BUF_COUNT * sizeof(struct io_uring_buf);
+	u->br = mmap(NULL, u->br_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (u->br == MAP_FAILED) {
+		u->br = NULL;
+		goto err;
+	}
+	struct io_uring_buf_reg reg;
+	memset(&reg, 0, sizeof(reg));
+	reg.ring_addr = (uint64_t)(uintptr_t)u->br;
+	reg.ring_entries = URING_BUF_COUNT;
+	reg.bgid = URING_BUF_GROUP;
+	if (syscall(__NR_io_uring_register, u->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+		goto err;
+	}
+	u->br_registered = 1;
+	for (int i = 0; i < URING_BUF_COUNT; i++) {
+		u->bufs[i] = _uring_chain_new(r);
+		if (!u->bufs[i]) {
+			goto err;
+		}
+		_uring_buf_put(u, i);
+	}
+	__atomic_store_n(&u->br->tail, u->br_tail, __ATOMIC_RELEASE);
+	return 0;
+err:
+	_uring_release(r);
+	return -1;
+}
+
+const reactor_backend_t reactor_uring_backend = {
+	"io_uring", _uring_init, _uring_release, _uring_update, _uring_update, _uring_del, _uring_wait, 1
+};
@@ -0,0 +1,334 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include "reactor.h"
+
+// 编译: gcc reactor.c reactor_uring.c ringbuffer/ringbuffer.c ringbuffer/mpmc_ring.c chainbuffer/chainbuffer.c memsearch/memsearch.c timewheel/timewheel.c reactor_uring_test.c -o reactor_uring_test -lpthread
+// io_uring 后端 recv_direct 的测试：socketpair 一端挂在 reactor 上，另一端由测试直接写。内核不支持 io_uring 时只跑退回 epoll 的用例
+
+#define RING_CHAIN (64 * 1024) //和 reactor_uring.c 的 URING_BUF_SIZE 一致：provided buffer 对应的 chain 大小
+#define COPY_MAX (RING_CHAIN / 4) //和 URING_COPY_MAX 一致：不超过它的数据拷进 buffer
+#define RING_BUFS 64 //和 URING_BUF_COUNT 一致
+
+typedef struct {
+    int reads; //read_cb 调用次数
+    int closed;
+    int hold; //为 1 时只收不消费
+    uint64_t got; //event_buffer_read 报告的总字节数
+    uint64_t consumed; //已经校验并消费掉的字节数
+    uint32_t max_in; //输入 buffer 的最大长度
+    int bad; //内容和写入的不一致
+} ctx_t;
+
+static inline uint8_t pattern(uint64_t off)
+{
+    return (uint8_t)(off % 251);
+}
+
+// 从 sv[1] 写入流上 [off, off + len) 的数据，返回写出的字节数（非阻塞时可能写不完）
+static size_t write_pattern(int fd, uint64_t off, size_t len)
+{
+    char buf[16384];
+    size_t done = 0;
+    while (done < len) {
+        size_t n = len - done < sizeof(buf) ? len - done : sizeof(buf);
+        for (size_t i = 0; i < n; i++) {
+            buf[i] = pattern(off + done + i);
+        }
+        ssize_t w = write(fd, buf, n);
+        if (w <= 0) {
+            break;
+        }
+        done += w;
+    }
+    return done;
+}
+
+static void consume(ctx_t* ctx, buffer_t* in)
+{
+    char buf[16384];
+    uint32_t len;
+    while ((len = buffer_len(in)) > 0) {
+        int n = buffer_remove(in, buf, len < sizeof(buf) ? len : sizeof(buf));
+        for (int i = 0; i < n; i++) {
+            ctx->bad += (uint8_t)buf[i] != pattern(ctx->consumed + i);
+        }
+        ctx->consumed += n;
+    }
+}
+
+static void read_cb(int fd, int events, void* privdata)
+{
+    event_t* e = (event_t*)privdata;
+    ctx_t* ctx = (ctx_t*)e->priv;
+    ctx->reads++;
+    int n = event_buffer_read(e);
+    if (e->fd < 0) {
+        ctx->closed = 1;
+        return;
+    }
+    ctx->got += n;
+    buffer_t* in = evbuf_in(e);
+    if (buffer_len(in) > ctx->max_in) {
+        ctx->max_in = buffer_len(in);
+    }
+    if (!ctx->hold) {
+        consume(ctx, in);
+    }
+}
+
+static void pump_until(reactor_t* r, uint64_t* counter, uint64_t expect)
+{
+    for (int i = 0; i < 1000 && *counter < expect; i++) {
+        eventloop_once(r, 10);
+    }
+    assert(*counter == expect);
+}
+
+static event_t* setup(reactor_t* r, int* sv, ctx_t* ctx)
+{
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    set_nonblock(sv[0]);
+    set_nonblock(sv[1]);
+    memset(ctx, 0, sizeof(*ctx));
+    event_t* e = new_event(r, sv[0], read_cb, NULL, NULL);
+    e->priv = ctx;
+    assert(event_set_recv_direct(e) == 0);
+    return e;
+}
+
+static void teardown(reactor_t* r, event_t* e, int* sv)
+{
+    if (e->fd >= 0) {
+        del_event(r, e);
+        close(sv[0]);
+    }
+    close(sv[1]);
+    for (int i = 0; i < 10; i++) {
+        eventloop_once(r, 0);
+    }
+    assert(r->nused == 0);
+}
+
+// 测试用例1：小块数据拷进普通 chain，provided buffer 留在 ring 里复用
+void test_small_read(reactor_t* r) {
+    printf("Test 1: Small recv is copied\n");
+    int sv[2];
+    ctx_t ctx;
+    event_t* e = setup(r, sv, &ctx);
+    add_event(r, EPOLLIN, e);
+    ctx.hold = 1;
+
+    assert(write_pattern(sv[1], 0, 100) == 100);
+    pump_until(r, &ctx.got, 100);
+    buffer_t* in = evbuf_in(e);
+    assert(buffer_len(in) == 100);
+    for (buf_chain_t* ch = in->first; ch; ch = ch->next) {
+        assert(ch->buffer_len + BUFFER_CHAIN_SIZE < RING_CHAIN);
+    }
+    consume(&ctx, in);
+    assert(ctx.consumed == 100 && ctx.bad == 0);
+
+    // 多次小块读：ring 里的 buffer 一直被放回去，次数超过 ring 的大小也不会用完
+    ctx.hold = 0;
+    for (int i = 0; i < 200; i++) {
+        assert(write_pattern(sv[1], ctx.consumed, 50) == 50);
+        pump_until(r, &ctx.consumed, 100 + (uint64_t)(i + 1) * 50);
+    }
+    assert(ctx.bad == 0 && ctx.got == ctx.consumed);
+
+    teardown(r, e, sv);
+    printf("Passed\n\n");
+}
+
+// 测试用例2：大块数据所在的 chain 整个挂进输入 buffer，不拷贝
+void test_large_read(reactor_t* r) {
+    printf("Test 2: Large recv hands over the chain\n");
+    int sv[2];
+    ctx_t ctx;
+    event_t* e = setup(r, sv, &ctx);
+    ctx.hold = 1;
+    // 注册之前数据已经到了，一次 recv 就能收满
+    size_t len = COPY_MAX * 2 + 123;
+    assert(write_pattern(sv[1], 0, len) == len);
+    add_event(r, EPOLLIN, e);
+
+    pump_until(r, &ctx.got, len);
+    buffer_t* in = evbuf_in(e);
+    int ring_chains = 0;
+    for (buf_chain_t* ch = in->first; ch; ch = ch->next) {
+        ring_chains += ch->buffer_len + BUFFER_CHAIN_SIZE == RING_CHAIN && ch->off > COPY_MAX;
+    }
+    assert(ring_chains >= 1);
+    consume(&ctx, in);
+    assert(ctx.consumed == len && ctx.bad == 0);
+
+    // 换进 ring 的新 chain 照常可用
+    ctx.hold = 0;
+    assert(write_pattern(sv[1], len, len) == len);
+    pump_until(r, &ctx.consumed, len * 2);
+    assert(ctx.bad == 0);
+
+    teardown(r, e, sv);
+    printf("Passed\n\n");
+}
+
+// 测试用例3：输入攒到水位时取消内核里的 recv，消费之后重新提交，数据不丢不乱序
+void test_pause_resume(reactor_t* r) {
+    printf("Test 3: Pause cancels recv, resume re-arms it\n");
+    int sv[2];
+    ctx_t ctx;
+    event_t* e = setup(r, sv, &ctx);
+    event_set_read_watermark(e, 8192);
+    add_event(r, EPOLLIN, e);
+    ctx.hold = 1;
+
+    uint64_t total = 16 * 1024 * 1024, sent = 0;
+    for (int i = 0; i < 50; i++) {
+        sent += write_pattern(sv[1], sent, total - sent);
+        eventloop_once(r, 1);
+    }
+    // multishot recv 在取消生效之前会把 socket 里的数据继续收进 provided buffer，最多收满整个 ring
+    assert(e->paused > 0 && sent > ctx.got);
+    assert(ctx.max_in >= 8192 && ctx.max_in <= 8192 + RING_BUFS * RING_CHAIN);
+    // 取消之后对端再写也收不到了
+    uint64_t held = ctx.got;
+    for (int i = 0; i < 10; i++) {
+        sent += write_pattern(sv[1], sent, total - sent);
+        eventloop_once(r, 1);
+    }
+    assert(ctx.got == held && sent < total);
+
+    // 在回调外面消费，降到水位以下恢复读
+    ctx.hold = 0;
+    consume(&ctx, evbuf_in(e));
+    assert(e->paused == 0);
+    for (int i = 0; i < 100000 && ctx.consumed < total; i++) {
+        sent += write_pattern(sv[1], sent, total - sent);
+        eventloop_once(r, 1);
+    }
+    assert(sent == total && ctx.consumed == total && ctx.bad == 0);
+    assert(ctx.max_in <= 8192 + RING_BUFS * RING_CHAIN);
+
+    teardown(r, e, sv);
+    printf("Passed\n\n");
+}
+
+// 测试用例4：数据后面紧跟着对端关闭，先交数据，下一轮再报告关闭
+void test_eof_after_data(reactor_t* r) {
+    printf("Test 4: EOF after data\n");
+    int sv[2];
+    ctx_t ctx;
+    event_t* e = setup(r, sv, &ctx);
+    add_event(r, EPOLLIN, e);
+
+    size_t len = COPY_MAX + 1000;
+    assert(write_pattern(sv[1], 0, len) == len);
+    shutdown(sv[1], SHUT_WR);
+    for (int i = 0; i < 1000 && !ctx.closed; i++) {
+        eventloop_once(r, 10);
+    }
+    assert(ctx.closed && ctx.consumed == len && ctx.bad == 0);
+    assert(e->fd < 0 && r->nused == 0);
+
+    close(sv[1]);
+    printf("Passed\n\n");
+}
+
+// 子进程里用 seccomp 让 io_uring_setup 返回 ENOSYS，模拟内核不支持；block_epoll 时 epoll_create 也返回 EMFILE
+static void block_io_uring(int block_epoll)
+{
+    struct sock_filter filter[] = {
+        BPF_STMT(BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr)),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, __NR_io_uring_setup, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | ENOSYS),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, block_epoll ? __NR_epoll_create : -1u, 1, 0),
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, block_epoll ? __NR_epoll_create1 : -1u, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ERRNO | EMFILE),
+        BPF_STMT(BPF_RET | BPF_K, SECCOMP_RET_ALLOW),
+    };
+    struct sock_fprog prog = { sizeof(filter) / sizeof(filter[0]), filter };
+    assert(prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) == 0);
+    assert(prctl(PR_SET_SECCOMP, SECCOMP_MODE_FILTER, &prog) == 0);
+}
+
+// 测试用例5：REACTOR_BACKEND=uring 但 io_uring 不可用时退回 epoll，recv_direct 不可用，普通读照常
+void test_fallback() {
+    printf("Test 5: REACTOR_BACKEND=uring falls back to epoll\n");
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        block_io_uring(0);
+        setenv("REACTOR_BACKEND", "uring", 1);
+        reactor_t* r = create_reactor();
+        assert(strcmp(reactor_backend_name(r), "epoll") == 0);
+        int sv[2];
+        ctx_t ctx;
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+        set_nonblock(sv[0]);
+        memset(&ctx, 0, sizeof(ctx));
+        event_t* e = new_event(r, sv[0], read_cb, NULL, NULL);
+        e->priv = &ctx;
+        assert(event_set_recv_direct(e) == -1 && e->recv_direct == 0);
+        add_event(r, EPOLLIN, e);
+        assert(write_pattern(sv[1], 0, 1000) == 1000);
+        pump_until(r, &ctx.consumed, 1000);
+        assert(ctx.bad == 0);
+        teardown(r, e, sv);
+        release_reactor(r);
+        _exit(0);
+    }
+    int status;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // 退回的 epoll 也创建失败时返回 NULL
+    pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+        block_io_uring(1);
+        setenv("REACTOR_BACKEND", "uring", 1);
+        assert(create_reactor() == NULL);
+        _exit(0);
+    }
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+    // 没有设置环境变量时是 epoll
+    unsetenv("REACTOR_BACKEND");
+    reactor_t* r = create_reactor();
+    assert(strcmp(reactor_backend_name(r), "epoll") == 0);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    printf("Starting reactor io_uring tests...\n\n");
+
+    setenv("REACTOR_BACKEND", "uring", 1);
+    reactor_t* r = create_reactor();
+    if (strcmp(reactor_backend_name(r), "io_uring") == 0) {
+        test_small_read(r);
+        test_large_read(r);
+        test_pause_resume(r);
+        test_eof_after_data(r);
+    }
+    else {
+        printf("io_uring not available, skip recv_direct tests\n\n");
+    }
+    release_reactor(r);
+    test_fallback();
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -1,8 +1,5 @@
-#include "reactor.h"
+#include "redis_adapter.h"
 #include <signal.h>
-#include <stdarg.h>
-#include <hiredis/hiredis.h>
-#include <hiredis/async.h>
 
 reactor_t* g_reactor = NULL;
 
@@ -14,112 +11,6 @@ static void sigint_handler(int sig)
 	}
 }
 
-static void redis_async_read_cb(int fd, int events, event_t* e)
-{
-	redisAsyncContext* ac = (redisAsyncContext*)e->priv;
-	if (!ac || ac->c.fd != fd) {
-		printf("redisAysncContext is NULL or incorrect fd\n");
-		del_event(e->r, e);
-		close(fd);
-		return;
-	}
-
-	redisAsyncHandleRead(ac);
-	if (ac->err) {
-		printf("Redis async read error: %s\n", ac->errstr);
-		del_event(e->r, e);
-		redisAsyncFree(ac);
-		close(fd);
-	}
-}
-
-static void redis_async_write_cb(int fd, int events, event_t* e)
-{
-	redisAsyncContext* ac = (redisAsyncContext*)e->priv;
-	if (!ac || ac->c.fd != fd) {
-		printf("redisAysncContext is NULL or incorrect fd\n");
-		del_event(e->r, e);
-		close(fd);
-		return;
-	}
-
-	redisAsyncHandleWrite(ac);
-	if (ac->err) {
-		printf("Redis async write error: %s\n", ac->errstr);
-		del_event(e->r, e);
-		redisAsyncFree(ac);
-		close(fd);
-	}
-}
-
-static void redis_async_error_cb(int fd, char* err)
-{
-	printf("Redis async error : %s (fd=%d)\n", err, fd);
-}
-
-// reactor.c 或 main.c 中，函数外定义普通回调函数
-// 注意：函数签名必须严格匹配 hiredis 的回调类型！
-// hiredis 定义的连接回调类型：typedef void (*redisConnectCallback)(const redisAsyncContext*, int);
-static void redis_async_connect_cb(const redisAsyncContext* ac, int status)
-{
-	if (status != REDIS_OK) {
-		printf("Redis connect failed: %s\n", ac->errstr);
-		return;
-	}
-	printf("Redis async connected successfully (fd = %d)\n", ac->c.fd);
-}
-
-static void redis_async_disconnect_cb(const redisAsyncContext* ac, int status)
-{
-	if (status != REDIS_OK) {
-		printf("Redis disconnect error: %s\n", ac->errstr);
-	}
-	else {
-		printf("Redis async disconnected (fd = %d)\n", ac->c.fd);
-	}
-	redisAsyncContext* ctx = (redisAsyncContext*)ac;
-	redisAsyncFree(ctx);
-}
-
-event_t* reactor_redis_async_connect(reactor_t* r, const char* host, int port)
-{
-	redisAsyncContext* ac = redisAsyncConnect(host, port);
-	if (ac == NULL || ac->err) {
-		const char* err = ac ? ac->errstr : "Failed to allocate async context";
-		printf("Redis async connect error: %s\n", err);
-		if (ac) redisAsyncFree(ac);
-		return NULL;
-	}
-
-	redisAsyncSetConnectCallback(ac, redis_async_connect_cb);
-	redisAsyncSetDisconnectCallback(ac, redis_async_disconnect_cb);
-
-	event_t* e = new_event(r, ac->c.fd, redis_async_read_cb, redis_async_write_cb, redis_async_error_cb);
-	if (!e) {
-		redisAsyncFree(ac);
-		return NULL;
-	}
-
-	e->priv = ac;
-	add_event(r, EPOLLIN | EPOLLOUT | EPOLLET, e);
-
-	return e;
-}
-
-void reactor_redis_async_send_cmd(event_t* e, redisCallbackFn* cb, void* privdata, const char* fmt, ...)
-{
-	redisAsyncContext* ac = (redisAsyncContext*)e->priv;
-	if (!ac || ac->err) {
-		printf("Redis async context invalid\n");
-		return;
-	}
-
-	va_list ap;
-	va_start(ap, fmt);
-	redisvAsyncCommand(ac, cb, privdata, fmt, ap);
-	va_end(ap);
-}
-
 static void redis_string_set_cb(redisAsyncContext* ac, void* reply, void* privdata)
 {
 	redisReply* r = (redisReply*)reply;
@@ -1,15 +1,16 @@
 #include <stdio.h>
 #include <string.h>
 #include <hiredis/hiredis.h>
+#include "redis_batch.h"
 
+// 只检查不释放，回复始终由调用方释放
 static inline int check_reply(redisReply* r, char* command)
 {
 	if (r == NULL || r->type == REDIS_REPLY_ERROR) {
 		printf("Command: %s failed: %s\n", command, (r ? r->str : "unknown error"));
-		if (r) freeReplyObject(r);
 		return -1;
 	}
-	if (r->type == REDIS_REPLY_STRING) {
+	if (r->type == REDIS_REPLY_STRING || r->type == REDIS_REPLY_STATUS) {
 		printf("Command: %s success: %s\n", command, r->str);
 	}
 	else if (r->type == REDIS_REPLY_INTEGER) {
@@ -34,6 +35,7 @@ int string_operation(redisContext* c)
 	snprintf(command, sizeof(command), "SET str:name 'z2w-redis-demo'");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	printf("SET %s: %s\n", command, reply->str);
@@ -43,6 +45,7 @@ int string_operation(redisContext* c)
 	snprintf(command, sizeof(command), "GET str:name");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_STRING) {
@@ -54,6 +57,7 @@ int string_operation(redisContext* c)
 	snprintf(command, sizeof(command), "INCR str:counter");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_INTEGER) {
@@ -72,6 +76,7 @@ int hash_operation(redisContext* c)
 	snprintf(command, sizeof(command), "HMSET hash:user id 100 name 'z2w' age 27");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_STRING) {
@@ -83,6 +88,7 @@ int hash_operation(redisContext* c)
 	snprintf(command, sizeof(command), "HGET hash:user name");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_STRING) {
@@ -94,6 +100,7 @@ int hash_operation(redisContext* c)
 	snprintf(command, sizeof(command), "HGETALL hash:user");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_ARRAY) {
@@ -114,6 +121,7 @@ int list_operation(redisContext* c)
 	snprintf(command, sizeof(command), "LPUSH list:fruits 'apple' 'banana'");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_INTEGER) {
@@ -125,6 +133,7 @@ int list_operation(redisContext* c)
 	snprintf(command, sizeof(command), "RPUSH list:fruits 'mango' 'watermelon'");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_INTEGER) {
@@ -136,6 +145,7 @@ int list_operation(redisContext* c)
 	snprintf(command, sizeof(command), "LRANGE list:fruits 0 -1");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_ARRAY) {
@@ -156,6 +166,7 @@ int set_operation(redisContext* c)
 	snprintf(command, sizeof(command), "SADD set:tags 'c' 'c++' 'python'");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_INTEGER) {
@@ -167,6 +178,7 @@ int set_operation(redisContext* c)
 	snprintf(command, sizeof(command), "SISMEMBER set:tags 'c++'");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_INTEGER) {
@@ -178,6 +190,7 @@ int set_operation(redisContext* c)
 	snprintf(command, sizeof(command), "SREM set:tags 'python'");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_INTEGER) {
@@ -194,6 +207,7 @@ int zset_operation(redisContext* c)
 	snprintf(command, sizeof(command), "ZADD zset:ranks 90 'alice' 85 'bob' 95 'charlie'");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_INTEGER) {
@@ -205,6 +219,7 @@ int zset_operation(redisContext* c)
 	snprintf(command, sizeof(command), "ZRANGE zset:ranks 0 -1 WITHSCORES");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_ARRAY) {
@@ -219,6 +234,7 @@ int zset_operation(redisContext* c)
 	snprintf(command, sizeof(command), "ZRANGE zset:ranks 0 -1");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_ARRAY) {
@@ -233,6 +249,7 @@ int zset_operation(redisContext* c)
 	snprintf(command, sizeof(command), "ZRANK zset:ranks 'bob'");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_INTEGER) {
@@ -244,6 +261,7 @@ int zset_operation(redisContext* c)
 	snprintf(command, sizeof(command), "ZREM zset:ranks 'bob'");
 	reply = redisCommand(c, command);
 	if (check_reply(reply, command)) {
+		cleanup(NULL, reply);
 		return 1;
 	}
 	if (reply->type == REDIS_REPLY_INTEGER) {
@@ -255,54 +273,67 @@ int zset_operation(redisContext* c)
 
 int pipeline_operation(redisContext* c)
 {
-	redisReply* reply = NULL;
-	redisAppendCommand(c, "SET pipe:key 'pipeline-test'");
-	redisAppendCommand(c, "INCR pipe:counter");
-	redisAppendCommand(c, "GET pipe:key");
+	const char* set_argv[] = { "SET", "pipe:key", "pipeline-test" };
+	const char* incr_argv[] = { "INCR", "pipe:counter" };
+	const char* get_argv[] = { "GET", "pipe:key" };
 
-	if (redisGetReply(c, (void**)&reply) != REDIS_OK) {
-		printf("pipeline 1 failed\n");
+	redis_batch_t* b = redis_batch_new(c, 0);
+	if (!b) {
 		return 1;
 	}
-	printf("pipeline 1 success: %s\n", reply->str);
-	freeReplyObject(reply);
-
-	if (redisGetReply(c, (void**)&reply) != REDIS_OK) {
-		printf("pipeline 2 failed\n");
+	redis_batch_add(b, 3, set_argv, NULL);
+	redis_batch_add(b, 2, incr_argv, NULL);
+	redis_batch_add(b, 2, get_argv, NULL);
+	if (redis_batch_exec(b)) {
+		printf("pipeline failed\n");
+		redis_batch_free(b);
 		return 1;
 	}
-	printf("pipeline 2 success: %lld\n", reply->integer);
-	freeReplyObject(reply);
-
-	if (redisGetReply(c, (void**)&reply) != REDIS_OK) {
-		printf("pipeline 3 failed\n");
-		return 1;
+	const char* names[] = { "SET", "INCR", "GET" };
+	for (int i = 0; i < b->nreplies; i++) {
+		if (check_reply(redis_batch_reply(b, i), (char*)names[i])) {
+			redis_batch_free(b);
+			return 1;
+		}
 	}
-	printf("pipeline 3 success: %s\n", reply->str);
-	freeReplyObject(reply);
-
+	redis_batch_free(b);
 	return 0;
 }
 
 int transaction_operation(redisContext* c)
 {
-	redisReply* reply = NULL;
-	reply = redisCommand(c, "MULTI");
-	if (check_reply(reply, "MULTI")) {
+	const char* multi_argv[] = { "MULTI" };
+	const char* set_argv[] = { "SET", "trans:key", "transaction-test" };
+	const char* incr_argv[] = { "INCR", "trans:counter" };
+	const char* exec_argv[] = { "EXEC" };
+
+	// MULTI ... EXEC 一次发出，排队阶段的 QUEUED 回复也由 batch 统一释放
+	redis_batch_t* b = redis_batch_new(c, 0);
+	if (!b) {
 		return 1;
 	}
-	printf("MULTI : %s\n", reply->str);
-	freeReplyObject(reply);
-
-	char command[512] = { 0 };
-	snprintf(command, sizeof(command), "SET trans:key 'transaction-test'");
-	redisCommand(c, command);
-	memset(command, 0, sizeof(command));
-	snprintf(command, sizeof(command), "INCR trans:counter");
-	redisCommand(c, command);
+	redis_batch_add(b, 1, multi_argv, NULL);
+	redis_batch_add(b, 3, set_argv, NULL);
+	redis_batch_add(b, 2, incr_argv, NULL);
+	redis_batch_add(b, 1, exec_argv, NULL);
+	if (redis_batch_exec(b)) {
+		printf("transaction failed\n");
+		redis_batch_free(b);
+		return 1;
+	}
+	for (int i = 0; i < b->nreplies - 1; i++) {
+		redisReply* r = redis_batch_reply(b, i);
+		if (r->type == REDIS_REPLY_ERROR) {
+			printf("transaction command %d failed: %s\n", i, r->str);
+		}
+	}
 
-	reply = redisCommand(c, "EXEC");
-	check_reply(reply, "EXEC");
+	redisReply* reply = redis_batch_reply(b, b->nreplies - 1);
+	if (reply->type == REDIS_REPLY_ERROR) {
+		printf("Command: EXEC failed: %s\n", reply->str);
+		redis_batch_free(b);
+		return 1;
+	}
 	if (reply->type == REDIS_REPLY_ARRAY) {
 		printf("transaction result: %lu\n", reply->elements);
 		for (size_t i = 0; i < reply->elements; i++) {
@@ -315,7 +346,7 @@ int transaction_operation(redisContext* c)
 			}
 		}
 	}
-	freeReplyObject(reply);
+	redis_batch_free(b);
 
 	return 0;
 }
@@ -0,0 +1,191 @@
+#include "redis_adapter.h"
+#include <stdarg.h>
+#include <sys/ioctl.h> //FIONREAD
+
+static void redis_async_read_cb(int fd, int events, void* privdata)
+{
+	event_t* e = (event_t*)privdata;
+	redisAsyncContext* ac = (redisAsyncContext*)e->priv;
+	if (!ac || ac->c.fd != fd) {
+		printf("redisAysncContext is NULL or incorrect fd\n");
+		del_event(e->r, e);
+		close(fd);
+		return;
+	}
+
+	redisAsyncHandleRead(ac);
+	if (ac->err) {
+		printf("Redis async read error: %s\n", ac->errstr);
+		del_event(e->r, e);
+		redisAsyncFree(ac);
+		close(fd);
+		return;
+	}
+	// hiredis 每次只读 16KB，边沿触发下没读完的部分不会再有通知，放进就绪队列下一轮接着读
+	int avail = 0;
+	if (ioctl(fd, FIONREAD, &avail) == 0 && avail > 0) {
+		event_requeue(e, EPOLLIN);
+	}
+}
+
+static void redis_async_write_cb(int fd, int events, void* privdata)
+{
+	event_t* e = (event_t*)privdata;
+	redisAsyncContext* ac = (redisAsyncContext*)e->priv;
+	if (!ac || ac->c.fd != fd) {
+		printf("redisAysncContext is NULL or incorrect fd\n");
+		del_event(e->r, e);
+		close(fd);
+		return;
+	}
+
+	redis_async_t* st = (redis_async_t*)ac->data;
+	if (st && st->unflushed) {
+		st->flushes++;
+		st->flushed_cmds += st->unflushed;
+		st->unflushed = 0;
+	}
+
+	redisAsyncHandleWrite(ac);
+	if (ac->err) {
+		printf("Redis async write error: %s\n", ac->errstr);
+		del_event(e->r, e);
+		redisAsyncFree(ac);
+		close(fd);
+	}
+}
+
+// 自动 pipeline：本轮攒下的命令在 epoll_wait 之前一次写出
+static void redis_async_deferred_cb(event_t* e)
+{
+	redis_async_write_cb(e->fd, EPOLLOUT, e);
+}
+
+static void redis_async_error_cb(int fd, char* err)
+{
+	printf("Redis async error : %s (fd=%d)\n", err, fd);
+}
+
+// reactor.c 或 main.c 中，函数外定义普通回调函数
+// 注意：函数签名必须严格匹配 hiredis 的回调类型！
+// hiredis 定义的连接回调类型：typedef void (*redisConnectCallback)(const redisAsyncContext*, int);
+static void redis_async_connect_cb(const redisAsyncContext* ac, int status)
+{
+	if (status != REDIS_OK) {
+		printf("Redis connect failed: %s\n", ac->errstr);
+		// 连接失败后 hiredis 会释放上下文，不再调用断开回调
+		free(ac->data);
+		return;
+	}
+	printf("Redis async connected successfully (fd = %d)\n", ac->c.fd);
+}
+
+static void redis_async_disconnect_cb(const redisAsyncContext* ac, int status)
+{
+	if (status != REDIS_OK) {
+		printf("Redis disconnect error: %s\n", ac->errstr);
+	}
+	else {
+		printf("Redis async disconnected (fd = %d)\n", ac->c.fd);
+	}
+	free(ac->data);
+	redisAsyncContext* ctx = (redisAsyncContext*)ac;
+	ctx->data = NULL;
+	redisAsyncFree(ctx);
+}
+
+event_t* reactor_redis_async_connect(reactor_t* r, const char* host, int port)
+{
+	redisAsyncContext* ac = redisAsyncConnect(host, port);
+	if (ac == NULL || ac->err) {
+		const char* err = ac ? ac->errstr : "Failed to allocate async context";
+		printf("Redis async connect error: %s\n", err);
+		if (ac) redisAsyncFree(ac);
+		return NULL;
+	}
+
+	redisAsyncSetConnectCallback(ac, redis_async_connect_cb);
+	redisAsyncSetDisconnectCallback(ac, redis_async_disconnect_cb);
+
+	ac->data = calloc(1, sizeof(redis_async_t));
+	event_t* e = new_event(r, ac->c.fd, redis_async_read_cb, redis_async_write_cb, redis_async_error_cb);
+	if (!e || !ac->data) {
+		if (e) {
+			free_event(e);
+		}
+		free(ac->data);
+		ac->data = NULL;
+		redisAsyncFree(ac);
+		return NULL;
+	}
+
+	e->priv = ac;
+	add_event(r, EPOLLIN | EPOLLOUT | EPOLLET, e);
+
+	return e;
+}
+
+// 命令已经进入 hiredis 的输出缓冲
+static void _redis_async_queued(event_t* e, redisAsyncContext* ac)
+{
+	redis_async_t* st = (redis_async_t*)ac->data;
+	st->unflushed++;
+	if (st->pipelining) {
+		event_defer_flush(e, redis_async_deferred_cb);
+	}
+}
+
+void reactor_redis_async_send_cmd(event_t* e, redisCallbackFn* cb, void* privdata, const char* fmt, ...)
+{
+	redisAsyncContext* ac = (redisAsyncContext*)e->priv;
+	if (!ac || ac->err) {
+		printf("Redis async context invalid\n");
+		return;
+	}
+
+	va_list ap;
+	va_start(ap, fmt);
+	int ret = redisvAsyncCommand(ac, cb, privdata, fmt, ap);
+	va_end(ap);
+	if (ret == REDIS_OK) {
+		_redis_async_queued(e, ac);
+	}
+}
+
+void reactor_redis_async_send_argv(event_t* e, redisCallbackFn* cb, void* privdata, int argc, const char** argv, const size_t* argvlen)
+{
+	redisAsyncContext* ac = (redisAsyncContext*)e->priv;
+	if (!ac || ac->err) {
+		printf("Redis async context invalid\n");
+		return;
+	}
+	if (redisAsyncCommandArgv(ac, cb, privdata, argc, argv, argvlen) == REDIS_OK) {
+		_redis_async_queued(e, ac);
+	}
+}
+
+void reactor_redis_async_set_pipelining(event_t* e, int on)
+{
+	redisAsyncContext* ac = (redisAsyncContext*)e->priv;
+	if (ac && ac->data) {
+		((redis_async_t*)ac->data)->pipelining = on;
+	}
+}
+
+redis_async_t* reactor_redis_async_stats(event_t* e)
+{
+	redisAsyncContext* ac = (redisAsyncContext*)e->priv;
+	return ac ? (redis_async_t*)ac->data : NULL;
+}
+
+void reactor_redis_async_free(event_t* e)
+{
+	redisAsyncContext* ac = (redisAsyncContext*)e->priv;
+	del_event(e->r, e);
+	if (ac) {
+		free(ac->data);
+		ac->data = NULL;
+		ac->onDisconnect = NULL; //断开回调里还会再 free 一次上下文
+		redisAsyncFree(ac);
+	}
+}
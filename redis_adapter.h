@@ -0,0 +1,34 @@
+#ifndef __REDIS_ADAPTER_H__
+#define __REDIS_ADAPTER_H__
+
+#include "reactor.h"
+#include <hiredis/hiredis.h>
+#include <hiredis/async.h>
+
+// 把 hiredis 的异步上下文挂到 reactor 上，读写事件直接转给 redisAsyncHandleRead/Write。
+// redisAsyncContext 的 data 字段由适配层占用，存放下面的统计信息。
+
+typedef struct redis_async_s redis_async_t;
+
+struct redis_async_s
+{
+	int pipelining; //自动 pipeline：同一轮 eventloop_once 中的命令在 epoll_wait 之前一次写出
+	uint32_t unflushed;
+	uint64_t flushes;
+	uint64_t flushed_cmds; //flushed_cmds / flushes 即每次 flush 的命令数
+};
+
+event_t* reactor_redis_async_connect(reactor_t* r, const char* host, int port);
+
+void reactor_redis_async_send_cmd(event_t* e, redisCallbackFn* cb, void* privdata, const char* fmt, ...);
+
+void reactor_redis_async_send_argv(event_t* e, redisCallbackFn* cb, void* privdata, int argc, const char** argv, const size_t* argvlen);
+
+void reactor_redis_async_set_pipelining(event_t* e, int on);
+
+redis_async_t* reactor_redis_async_stats(event_t* e);
+
+// 主动关闭连接，未完成的命令回调以 reply == NULL 调用
+void reactor_redis_async_free(event_t* e);
+
+#endif
@@ -0,0 +1,116 @@
+#include "redis_batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+redis_batch_t* redis_batch_new(redisContext* c, int depth)
+{
+	redis_batch_t* b = (redis_batch_t*)calloc(1, sizeof(redis_batch_t));
+	if (!b) {
+		return NULL;
+	}
+	b->c = c;
+	b->depth = depth > 0 ? depth : REDIS_BATCH_DEPTH;
+	return b;
+}
+
+void redis_batch_free(redis_batch_t* b)
+{
+	if (!b) {
+		return;
+	}
+	redis_batch_reset(b);
+	free(b->replies);
+	free(b);
+}
+
+void redis_batch_set_callback(redis_batch_t* b, redis_batch_fn fn, void* privdata)
+{
+	b->fn = fn;
+	b->privdata = privdata;
+}
+
+// 读回当前在途的所有回复：第一次 redisGetReply 会把输出缓冲整个写出去
+static int _redis_batch_drain(redis_batch_t* b)
+{
+	while (b->inflight > 0) {
+		redisReply* reply = NULL;
+		if (redisGetReply(b->c, (void**)&reply) != REDIS_OK) {
+			printf("redis batch read error: %s\n", b->c->errstr);
+			b->err = 1;
+			return -1;
+		}
+		b->inflight--;
+		int index = b->nreplies++;
+		if (b->fn) {
+			int stop = b->fn(b, index, reply, b->privdata);
+			freeReplyObject(reply);
+			if (stop) {
+				b->err = 1;
+				return -1;
+			}
+		}
+		else {
+			b->replies[index] = reply;
+		}
+	}
+	return 0;
+}
+
+int redis_batch_add(redis_batch_t* b, int argc, const char** argv, const size_t* argvlen)
+{
+	if (b->err) {
+		return -1;
+	}
+	if (!b->fn && b->queued == b->cap) {
+		int cap = b->cap ? b->cap * 2 : 64;
+		redisReply** replies = (redisReply**)realloc(b->replies, sizeof(redisReply*) * cap);
+		if (!replies) {
+			return -1;
+		}
+		memset(replies + b->cap, 0, sizeof(redisReply*) * (cap - b->cap));
+		b->replies = replies;
+		b->cap = cap;
+	}
+	if (redisAppendCommandArgv(b->c, argc, argv, argvlen) != REDIS_OK) {
+		printf("redis batch append error: %s\n", b->c->errstr);
+		b->err = 1;
+		return -1;
+	}
+	b->queued++;
+	if (++b->inflight >= b->depth) {
+		return _redis_batch_drain(b);
+	}
+	return 0;
+}
+
+int redis_batch_exec(redis_batch_t* b)
+{
+	if (b->err) {
+		return -1;
+	}
+	return _redis_batch_drain(b);
+}
+
+redisReply* redis_batch_reply(redis_batch_t* b, int i)
+{
+	if (b->fn || i < 0 || i >= b->nreplies) {
+		return NULL;
+	}
+	return b->replies[i];
+}
+
+void redis_batch_reset(redis_batch_t* b)
+{
+	if (!b->fn) {
+		for (int i = 0; i < b->nreplies; i++) {
+			freeReplyObject(b->replies[i]);
+			b->replies[i] = NULL;
+		}
+	}
+	b->queued = 0;
+	b->nreplies = 0;
+	b->err = 0;
+	// 出错后在途命令的回复已经无法对应，连接只能由调用方重建
+	b->inflight = 0;
+}
@@ -0,0 +1,50 @@
+#ifndef __REDIS_BATCH_H__
+#define __REDIS_BATCH_H__
+
+#include <hiredis/hiredis.h>
+
+// 同步批量执行：调用方以 argv 形式排队任意多条命令，exec 时一次写出、一次读回全部回复。
+// 在途命令达到 depth 条时自动先 flush 并读回这一段，避免超大批次把 hiredis 的
+// 输出缓冲和 socket 两端的缓冲撑爆；设置了 fn 时回复逐条交给 fn 后立即释放，不在内存中累积。
+
+#define REDIS_BATCH_DEPTH	1024 //默认每段最多多少条命令
+
+typedef struct redis_batch_s redis_batch_t;
+
+// 返回 0 继续，返回非 0 时 batch 停止读取后续回复
+typedef int (*redis_batch_fn)(redis_batch_t* b, int index, redisReply* reply, void* privdata);
+
+struct redis_batch_s
+{
+	redisContext* c;
+	int depth;
+	int queued; //已排队的命令总数
+	int inflight; //已写入 hiredis 输出缓冲、还没读回复的命令数
+	int nreplies; //已读回的回复数
+	int err;
+	redisReply** replies; //未设置 fn 时按排队顺序保存回复
+	int cap;
+	redis_batch_fn fn;
+	void* privdata;
+};
+
+redis_batch_t* redis_batch_new(redisContext* c, int depth);
+
+void redis_batch_free(redis_batch_t* b);
+
+// 设置后回复不再保存在 replies 中
+void redis_batch_set_callback(redis_batch_t* b, redis_batch_fn fn, void* privdata);
+
+// argvlen 为 NULL 时按 strlen 计算参数长度
+int redis_batch_add(redis_batch_t* b, int argc, const char** argv, const size_t* argvlen);
+
+// 读回所有还没拿到的回复，全部成功返回 0
+int redis_batch_exec(redis_batch_t* b);
+
+// 第 i 条命令的回复，回复由 batch 持有
+redisReply* redis_batch_reply(redis_batch_t* b, int i);
+
+// 释放已保存的回复，batch 可以继续复用
+void redis_batch_reset(redis_batch_t* b);
+
+#endif
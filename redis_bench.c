@@ -0,0 +1,1297 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "redis_client.h"
+#include "redis_adapter.h"
+#include "redis_pool.h"
+#include "redis_batch.h"
+#include "redis_cache.h"
+#include "redis_cluster.h"
+#include "redis_multi.h"
+
+// 编译: gcc -O2 reactor.c reactor_uring.c ringbuffer/ringbuffer.c ringbuffer/mpmc_ring.c chainbuffer/chainbuffer.c memsearch/memsearch.c timewheel/timewheel.c resp/resp_parser.c redis_client.c redis_pool.c redis_adapter.c redis_batch.c redis_cache.c redis_cluster.c redis_multi.c redis_bench.c -o redis_bench -lhiredis -lpthread -lm
+// 用法: ./redis_bench depth [host] [port] [每轮命令数] [value 大小]
+//       ./redis_bench fanout [host] [port] [每 tick 命令数] [tick 数]
+//       ./redis_bench latency [host] [port] [秒数] [列表长度]
+//       ./redis_bench batch [host] [port] [key 数]
+//       ./redis_bench bigvalue [host] [port] [最大 MB]
+//       ./redis_bench cache [host] [port] [秒数] [key 数] [缓存 KB]
+//       ./redis_bench cluster [种子 host] [port] [秒数] [每批 key 数]
+//       ./redis_bench multi [host] [port] [key 数]
+
+#define BENCH_KEYS 10000
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+enum { CLIENT_NATIVE = 0, CLIENT_HIREDIS = 1 };
+
+// 闭环压测：始终保持 depth 条命令在途，每收到一条回复就补发一条
+typedef struct {
+    int client;
+    int get; //0 为 SET，1 为 GET
+    redis_conn_t* c;
+    event_t* e;
+    long total;
+    long issued;
+    long done;
+    long errors;
+    const char* value;
+    size_t vlen;
+} bench_t;
+
+static void bench_issue(bench_t* b);
+
+static void bench_on_reply(bench_t* b, int ok)
+{
+    b->done++;
+    if (!ok) {
+        b->errors++;
+    }
+    if (b->issued < b->total) {
+        bench_issue(b);
+    }
+}
+
+static void native_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    bench_on_reply((bench_t*)privdata, reply && reply->type != RESP_ERROR);
+}
+
+static void hiredis_cb(redisAsyncContext* ac, void* reply, void* privdata)
+{
+    redisReply* r = (redisReply*)reply;
+    bench_on_reply((bench_t*)privdata, r && r->type != REDIS_REPLY_ERROR);
+}
+
+// 连接失败或断开后连接已被释放，清掉指针
+static void native_conn_cb(redis_conn_t* c, int status)
+{
+    if (status != 0) {
+        ((bench_t*)c->data)->c = NULL;
+    }
+}
+
+static void native_disconnect_cb(redis_conn_t* c, int status)
+{
+    ((bench_t*)c->data)->c = NULL;
+}
+
+static void bench_issue(bench_t* b)
+{
+    char key[32];
+    const char* argv[3];
+    size_t lens[3];
+    int argc = b->get ? 2 : 3;
+    lens[1] = snprintf(key, sizeof(key), "bench:%ld", b->issued % BENCH_KEYS);
+    argv[0] = b->get ? "GET" : "SET";
+    lens[0] = 3;
+    argv[1] = key;
+    argv[2] = b->value;
+    lens[2] = b->vlen;
+    b->issued++;
+    if (b->client == CLIENT_NATIVE) {
+        if (b->c) {
+            redis_conn_command_argv(b->c, native_cb, b, argc, argv, lens);
+        }
+    }
+    else {
+        reactor_redis_async_send_argv(b->e, hiredis_cb, b, argc, argv, lens);
+    }
+}
+
+static double bench_run(reactor_t* r, const char* host, int port, int client, int get, int depth, long total, const char* value, size_t vlen)
+{
+    bench_t b;
+    memset(&b, 0, sizeof(b));
+    b.client = client;
+    b.get = get;
+    b.total = total;
+    b.value = value;
+    b.vlen = vlen;
+    if (client == CLIENT_NATIVE) {
+        b.c = redis_connect(r, host, port);
+        if (!b.c) {
+            return -1;
+        }
+        b.c->data = &b;
+        b.c->connect_fn = native_conn_cb;
+        b.c->disconnect_fn = native_disconnect_cb;
+    }
+    else {
+        b.e = reactor_redis_async_connect(r, host, port);
+        if (!b.e) {
+            return -1;
+        }
+    }
+
+    double t0 = now_sec();
+    for (int i = 0; i < depth && b.issued < b.total; i++) {
+        bench_issue(&b);
+    }
+    while (b.done < b.total) {
+        eventloop_once(r, 100);
+        if (client == CLIENT_NATIVE ? b.c == NULL : b.e->fd < 0) {
+            break;
+        }
+    }
+    double elapsed = now_sec() - t0;
+    if (b.done < b.total || b.errors) {
+        printf("bench aborted: %ld/%ld replies, %ld errors\n", b.done, b.total, b.errors);
+    }
+
+    if (client == CLIENT_NATIVE) {
+        if (b.c) {
+            redis_conn_free(b.c);
+        }
+    }
+    else if (b.e->fd >= 0) {
+        reactor_redis_async_free(b.e);
+    }
+    if (b.done < b.total) {
+        return -1;
+    }
+    return b.done / elapsed;
+}
+
+static void bench_depth(const char* host, int port, long total, size_t vlen)
+{
+    char* value = malloc(vlen);
+    memset(value, 'v', vlen);
+    reactor_t* r = create_reactor();
+    int depths[] = { 1, 16, 256 };
+
+    printf("depth bench: %s:%d, %ld commands per run, %zu byte values\n", host, port, total, vlen);
+    for (int get = 0; get <= 1; get++) {
+        for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+            double native = bench_run(r, host, port, CLIENT_NATIVE, get, depths[i], total, value, vlen);
+            double hiredis = bench_run(r, host, port, CLIENT_HIREDIS, get, depths[i], total, value, vlen);
+            if (native < 0 || hiredis < 0) {
+                printf("run against %s:%d failed\n", host, port);
+                goto out;
+            }
+            printf("%s depth=%-4d native=%10.0f ops/s  hiredis=%10.0f ops/s  (x%.2f)\n",
+                get ? "GET" : "SET", depths[i], native, hiredis, native / hiredis);
+        }
+    }
+out:
+    release_reactor(r);
+    free(value);
+}
+
+// -------------------------- fan-out：每个 tick 突发大量小 GET --------------------------
+static void fanout_native_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    (*(long*)privdata)++;
+}
+
+static void fanout_hiredis_cb(redisAsyncContext* ac, void* reply, void* privdata)
+{
+    (*(long*)privdata)++;
+}
+
+static void fanout_run(const char* host, int port, int client, int pipelining, int per_tick, int ticks)
+{
+    reactor_t* r = create_reactor();
+    redis_conn_t* c = NULL;
+    event_t* e = NULL;
+    long done = 0, target = 0;
+    const char* argv[2] = { "GET", NULL };
+    size_t lens[2] = { 3, 0 };
+    char key[32];
+
+    if (client == CLIENT_NATIVE) {
+        c = redis_connect(r, host, port);
+        if (c) {
+            redis_conn_set_pipelining(c, pipelining);
+        }
+    }
+    else {
+        e = reactor_redis_async_connect(r, host, port);
+        if (e) {
+            reactor_redis_async_set_pipelining(e, pipelining);
+        }
+    }
+    if (!c && !e) {
+        printf("connect %s:%d error\n", host, port);
+        release_reactor(r);
+        return;
+    }
+
+    double t0 = now_sec();
+    for (int t = 0; t < ticks; t++) {
+        for (int i = 0; i < per_tick; i++) {
+            lens[1] = snprintf(key, sizeof(key), "fanout:%d", i);
+            argv[1] = key;
+            if (c) {
+                redis_conn_command_argv(c, fanout_native_cb, &done, 2, argv, lens);
+            }
+            else {
+                reactor_redis_async_send_argv(e, fanout_hiredis_cb, &done, 2, argv, lens);
+            }
+        }
+        target += per_tick;
+        for (int k = 0; done < target && k < 1000; k++) {
+            eventloop_once(r, 10);
+        }
+        if (done < target) {
+            printf("fanout aborted at tick %d\n", t);
+            break;
+        }
+    }
+    double elapsed = now_sec() - t0;
+
+    uint64_t flushes, cmds;
+    if (c) {
+        flushes = c->flushes;
+        cmds = c->flushed_cmds;
+        redis_conn_free(c);
+    }
+    else {
+        redis_async_t* st = reactor_redis_async_stats(e);
+        flushes = st->flushes;
+        cmds = st->flushed_cmds;
+        reactor_redis_async_free(e);
+    }
+    printf("%-7s pipelining=%-3s ops/s=%10.0f  flushes=%8llu  cmds/flush=%8.1f\n",
+        client == CLIENT_NATIVE ? "native" : "hiredis", pipelining ? "on" : "off", done / elapsed,
+        (unsigned long long)flushes, flushes ? (double)cmds / flushes : 0.0);
+    release_reactor(r);
+}
+
+static void bench_fanout(const char* host, int port, int per_tick, int ticks)
+{
+    printf("fanout bench: %s:%d, %d GETs per tick, %d ticks\n", host, port, per_tick, ticks);
+    fanout_run(host, port, CLIENT_NATIVE, 0, per_tick, ticks);
+    fanout_run(host, port, CLIENT_NATIVE, 1, per_tick, ticks);
+    // 适配层没有注册 hiredis 的写事件钩子，不开 pipeline 时从事件循环外发出的命令要等下一次可写边沿才会写出
+    fanout_run(host, port, CLIENT_HIREDIS, 1, per_tick, ticks);
+}
+
+// -------------------------- 延迟：大 LRANGE 与小 GET 混跑 --------------------------
+#define LAT_GETS		32 //同时在途的 GET 数
+#define LAT_ELEM_SIZE	100
+#define LAT_PUSH_BATCH	1000
+
+typedef struct lat_s lat_t;
+
+typedef struct {
+    lat_t* l;
+    double start;
+} lat_req_t;
+
+struct lat_s {
+    redis_pool_t* p;
+    double deadline;
+    double* samples;
+    long nsamples;
+    long cap;
+    long lranges;
+    int inflight;
+    lat_req_t reqs[LAT_GETS];
+};
+
+static void lat_issue_get(lat_req_t* q);
+static void lat_issue_lrange(lat_t* l);
+
+static void lat_get_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    lat_req_t* q = (lat_req_t*)privdata;
+    lat_t* l = q->l;
+    double now = now_sec();
+    l->inflight--;
+    if (reply && l->nsamples < l->cap) {
+        l->samples[l->nsamples++] = now - q->start;
+    }
+    if (now < l->deadline) {
+        lat_issue_get(q);
+    }
+}
+
+static void lat_lrange_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    lat_t* l = (lat_t*)privdata;
+    l->inflight--;
+    if (reply) {
+        l->lranges++;
+    }
+    if (now_sec() < l->deadline) {
+        lat_issue_lrange(l);
+    }
+}
+
+static void lat_issue_get(lat_req_t* q)
+{
+    const char* argv[] = { "GET", "bench:small" };
+    q->start = now_sec();
+    if (redis_pool_command_argv(q->l->p, lat_get_cb, q, 2, argv, NULL) == 0) {
+        q->l->inflight++;
+    }
+}
+
+static void lat_issue_lrange(lat_t* l)
+{
+    const char* argv[] = { "LRANGE", "bench:biglist", "0", "-1" };
+    if (redis_pool_command_argv(l->p, lat_lrange_cb, l, 4, argv, NULL) == 0) {
+        l->inflight++;
+    }
+}
+
+static int lat_cmp(const void* a, const void* b)
+{
+    double x = *(const double*)a, y = *(const double*)b;
+    return x < y ? -1 : x > y;
+}
+
+static void lat_done_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    (*(int*)privdata)--;
+}
+
+// 准备数据：一个小 key 和一个 elements 个元素的大列表
+static int lat_setup(reactor_t* r, redis_pool_t* p, int elements)
+{
+    char* elem = malloc(LAT_ELEM_SIZE);
+    memset(elem, 'e', LAT_ELEM_SIZE);
+    const char** argv = malloc(sizeof(char*) * (LAT_PUSH_BATCH + 2));
+    size_t* lens = malloc(sizeof(size_t) * (LAT_PUSH_BATCH + 2));
+    int pending = 0;
+    const char* del[] = { "DEL", "bench:biglist" };
+    const char* set[] = { "SET", "bench:small", "v" };
+    pending += redis_pool_command_pinned(p, "bench", 5, lat_done_cb, &pending, 2, del, NULL) == 0;
+    pending += redis_pool_command_pinned(p, "bench", 5, lat_done_cb, &pending, 3, set, NULL) == 0;
+    argv[0] = "RPUSH";
+    lens[0] = 5;
+    argv[1] = "bench:biglist";
+    lens[1] = strlen(argv[1]);
+    for (int i = 2; i < LAT_PUSH_BATCH + 2; i++) {
+        argv[i] = elem;
+        lens[i] = LAT_ELEM_SIZE;
+    }
+    for (int left = elements; left > 0; left -= LAT_PUSH_BATCH) {
+        int n = left < LAT_PUSH_BATCH ? left : LAT_PUSH_BATCH;
+        pending += redis_pool_command_pinned(p, "bench", 5, lat_done_cb, &pending, n + 2, argv, lens) == 0;
+    }
+    for (int i = 0; i < 1000 && pending > 0; i++) {
+        eventloop_once(r, 10);
+    }
+    free(elem);
+    free(argv);
+    free(lens);
+    return pending == 0 ? 0 : -1;
+}
+
+static void bench_latency(const char* host, int port, int seconds, int elements)
+{
+    int sizes[] = { 1, 2, 4, 8 };
+    printf("latency bench: %s:%d, %d GETs in flight + 1 LRANGE of %d x %dB, %ds per run\n",
+        host, port, LAT_GETS, elements, LAT_ELEM_SIZE, seconds);
+    for (size_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        reactor_t* r = create_reactor();
+        redis_pool_t* p = redis_pool_create(r, host, port, sizes[k]);
+        if (!p) {
+            release_reactor(r);
+            return;
+        }
+        for (int i = 0; i < 500 && !(p->members[sizes[k] - 1].c && (p->members[sizes[k] - 1].c->flags & REDIS_CONN_CONNECTED)); i++) {
+            eventloop_once(r, 10);
+        }
+        if (k == 0 && lat_setup(r, p, elements) < 0) {
+            printf("setup against %s:%d failed\n", host, port);
+            redis_pool_free(p);
+            release_reactor(r);
+            return;
+        }
+
+        lat_t l;
+        memset(&l, 0, sizeof(l));
+        l.p = p;
+        l.cap = 10 * 1000 * 1000;
+        l.samples = malloc(sizeof(double) * l.cap);
+        double t0 = now_sec();
+        l.deadline = t0 + seconds;
+        lat_issue_lrange(&l);
+        for (int i = 0; i < LAT_GETS; i++) {
+            l.reqs[i].l = &l;
+            lat_issue_get(&l.reqs[i]);
+        }
+        while (l.inflight > 0 && now_sec() < l.deadline + 5) {
+            eventloop_once(r, 10);
+        }
+        double elapsed = now_sec() - t0;
+
+        qsort(l.samples, l.nsamples, sizeof(double), lat_cmp);
+        double p50 = l.nsamples ? l.samples[l.nsamples / 2] : 0;
+        double p99 = l.nsamples ? l.samples[(long)(l.nsamples * 0.99)] : 0;
+        printf("conns=%d  GET ops/s=%9.0f  p50=%8.1f us  p99=%8.1f us  LRANGE/s=%6.1f\n",
+            sizes[k], l.nsamples / elapsed, p50 * 1e6, p99 * 1e6, l.lranges / elapsed);
+        free(l.samples);
+        redis_pool_free(p);
+        release_reactor(r);
+    }
+}
+
+// -------------------------- batch：同步逐条往返 vs redis_batch --------------------------
+static int batch_fill_argv(int get, long i, char* key, size_t keysz, const char** argv, size_t* lens)
+{
+    argv[0] = get ? "GET" : "SET";
+    argv[1] = key;
+    argv[2] = "batch-value";
+    lens[0] = 3;
+    lens[1] = snprintf(key, keysz, "batch:%ld", i);
+    lens[2] = 11;
+    return get ? 2 : 3;
+}
+
+static double batch_single(redisContext* c, int get, long keys)
+{
+    char key[32];
+    const char* argv[3];
+    size_t lens[3];
+    double start = now_sec();
+    for (long i = 0; i < keys; i++) {
+        int argc = batch_fill_argv(get, i, key, sizeof(key), argv, lens);
+        redisReply* reply = redisCommandArgv(c, argc, argv, lens);
+        if (!reply) {
+            return -1;
+        }
+        freeReplyObject(reply);
+    }
+    return keys / (now_sec() - start);
+}
+
+static double batch_run(redisContext* c, int get, long keys, int depth)
+{
+    char key[32];
+    const char* argv[3];
+    size_t lens[3];
+    double start = now_sec();
+    redis_batch_t* b = redis_batch_new(c, depth);
+    for (long i = 0; i < keys; i++) {
+        int argc = batch_fill_argv(get, i, key, sizeof(key), argv, lens);
+        if (redis_batch_add(b, argc, argv, lens)) {
+            redis_batch_free(b);
+            return -1;
+        }
+    }
+    int ret = redis_batch_exec(b);
+    redis_batch_free(b);
+    return ret ? -1 : keys / (now_sec() - start);
+}
+
+static void bench_batch(const char* host, int port, long keys)
+{
+    struct timeval timeout = { 1, 500000 };
+    redisContext* c = redisConnectWithTimeout(host, port, timeout);
+    if (!c || c->err) {
+        printf("connect %s:%d failed\n", host, port);
+        if (c) {
+            redisFree(c);
+        }
+        return;
+    }
+    int depths[] = { 64, 1024, 16384 };
+
+    printf("batch bench: %s:%d, %ld keys\n", host, port, keys);
+    for (int get = 0; get <= 1; get++) {
+        double single = batch_single(c, get, keys);
+        if (single < 0) {
+            printf("run against %s:%d failed\n", host, port);
+            break;
+        }
+        printf("%s per-command      %10.0f ops/s\n", get ? "GET" : "SET", single);
+        for (size_t i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+            double batch = batch_run(c, get, keys, depths[i]);
+            if (batch < 0) {
+                printf("run against %s:%d failed\n", host, port);
+                goto out;
+            }
+            printf("%s batch depth=%-5d %10.0f ops/s  (x%.2f)\n", get ? "GET" : "SET", depths[i], batch, batch / single);
+        }
+    }
+out:
+    redisFree(c);
+}
+
+// -------------------------- bigvalue：大 value 的 GET，整条回复 vs 流式回复的峰值 RSS 和首字节时间 --------------------------
+#define BIG_FILL_PIECE (4 * 1024 * 1024)
+
+enum { BIG_NATIVE_WHOLE = 0, BIG_NATIVE_STREAM = 1, BIG_HIREDIS = 2 };
+
+typedef struct {
+    double start;
+    double first; //收到第一个数据的时间
+    double done;
+    uint64_t bytes;
+    int finished;
+    int ok;
+} big_t;
+
+static void big_whole_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    big_t* b = (big_t*)privdata;
+    b->first = b->done = now_sec();
+    b->finished = 1;
+    if (reply && reply->type == RESP_BULK) {
+        b->bytes = reply->str.len;
+        b->ok = 1;
+    }
+}
+
+static void big_stream_cb(redis_conn_t* c, const resp_value_t* v, int last, void* privdata)
+{
+    big_t* b = (big_t*)privdata;
+    if (v && (v->chunk || v->type == RESP_BULK)) {
+        if (b->first == 0) {
+            b->first = now_sec();
+        }
+        b->bytes += v->str.len;
+    }
+    if (last) {
+        b->done = now_sec();
+        b->finished = 1;
+        b->ok = v != NULL;
+    }
+}
+
+// 在子进程里取一次，结果（首字节时间、总时间）写到 fd
+static void big_get_child(const char* host, int port, int mode, const char* key, int fd)
+{
+    big_t b;
+    memset(&b, 0, sizeof(b));
+    const char* argv[] = { "GET", key };
+    if (mode == BIG_HIREDIS) {
+        redisContext* c = redisConnect(host, port);
+        if (c && !c->err) {
+            b.start = now_sec();
+            redisReply* reply = redisCommandArgv(c, 2, argv, NULL);
+            b.first = b.done = now_sec();
+            b.ok = reply && reply->type == REDIS_REPLY_STRING;
+            freeReplyObject(reply);
+        }
+        if (c) {
+            redisFree(c);
+        }
+    }
+    else {
+        reactor_t* r = create_reactor();
+        redis_conn_t* c = redis_connect(r, host, port);
+        b.start = now_sec();
+        int ret = -1;
+        if (c) {
+            ret = mode == BIG_NATIVE_STREAM ? redis_conn_stream_argv(c, big_stream_cb, &b, 2, argv, NULL)
+                : redis_conn_command_argv(c, big_whole_cb, &b, 2, argv, NULL);
+        }
+        while (ret == 0 && !b.finished) {
+            eventloop_once(r, 100);
+        }
+        // 连接出错时已经被释放
+        if (c && b.ok) {
+            redis_conn_free(c);
+        }
+        release_reactor(r);
+    }
+    double res[2] = { -1, -1 };
+    if (b.ok) {
+        res[0] = b.first - b.start;
+        res[1] = b.done - b.start;
+    }
+    if (write(fd, res, sizeof(res)) != sizeof(res)) {
+        _exit(1);
+    }
+}
+
+static void big_run(const char* host, int port, int mode, const char* key, int mb)
+{
+    static const char* names[] = { "native", "stream", "hiredis" };
+    int fds[2];
+    if (pipe(fds) < 0) {
+        return;
+    }
+    // 子进程不要把父进程缓冲区里的输出再打印一遍
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        // 连接断开等提示不要混进结果
+        freopen("/dev/null", "w", stdout);
+        big_get_child(host, port, mode, key, fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+    double res[2] = { -1, -1 };
+    if (read(fds[0], res, sizeof(res)) != sizeof(res)) {
+        res[0] = -1;
+    }
+    close(fds[0]);
+    int status;
+    struct rusage ru;
+    wait4(pid, &status, 0, &ru);
+    if (res[0] < 0) {
+        printf("%4d MB %-8s failed\n", mb, names[mode]);
+        return;
+    }
+    printf("%4d MB %-8s first byte %9.2f ms  total %9.2f ms  peak RSS %8.1f MB\n",
+        mb, names[mode], res[0] * 1e3, res[1] * 1e3, ru.ru_maxrss / 1024.0);
+}
+
+static void big_fill_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    int* pending = (int*)privdata;
+    (*pending)--;
+    if (!reply || reply->type == RESP_ERROR) {
+        *pending = -1000000;
+    }
+}
+
+// 单条命令受输出 buffer 上限限制，按块 APPEND 拼出整个 value
+static int big_fill(reactor_t* r, redis_conn_t* c, const char* key, long len, const char* piece)
+{
+    int pending = 0;
+    const char* del[] = { "DEL", key };
+    if (redis_conn_command_argv(c, big_fill_cb, &pending, 2, del, NULL) < 0) {
+        return -1;
+    }
+    pending++;
+    for (long off = 0; off < len; off += BIG_FILL_PIECE) {
+        const char* argv[] = { "APPEND", key, piece };
+        size_t lens[] = { 6, strlen(key), len - off < BIG_FILL_PIECE ? len - off : BIG_FILL_PIECE };
+        if (redis_conn_command_argv(c, big_fill_cb, &pending, 3, argv, lens) < 0) {
+            return -1;
+        }
+        pending++;
+        // 每块等回复，输出 buffer 里最多一块
+        while (pending > 0) {
+            eventloop_once(r, 100);
+        }
+        if (pending < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void bench_bigvalue(const char* host, int port, int max_mb)
+{
+    reactor_t* r = create_reactor();
+    redis_conn_t* c = redis_connect(r, host, port);
+    char* piece = malloc(BIG_FILL_PIECE);
+    for (int i = 0; i < BIG_FILL_PIECE; i++) {
+        piece[i] = 'a' + i % 26;
+    }
+    int sizes[] = { 1, 10, 50, 100 };
+    printf("bigvalue bench: %s:%d, GET of 1..%d MB values\n", host, port, max_mb);
+    for (size_t i = 0; c && i < sizeof(sizes) / sizeof(sizes[0]) && sizes[i] <= max_mb; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "bench:big:%d", sizes[i]);
+        if (big_fill(r, c, key, (long)sizes[i] * 1024 * 1024, piece) < 0) {
+            printf("fill %s on %s:%d failed\n", key, host, port);
+            c = NULL; //出错的连接已经被释放
+            break;
+        }
+        for (int mode = BIG_NATIVE_WHOLE; mode <= BIG_HIREDIS; mode++) {
+            big_run(host, port, mode, key, sizes[i]);
+        }
+    }
+    if (c) {
+        redis_conn_free(c);
+    }
+    free(piece);
+    release_reactor(r);
+}
+
+// -------------------------- cache：zipf 分布的 GET，直连 vs 近缓存 --------------------------
+#define CACHE_DEPTH		16 //同时在途的命令数
+#define CACHE_ZIPF_S	0.99
+#define CACHE_WRITE_PCT	1 //每 100 条命令里的 SET 数，用来产生失效通知
+
+typedef struct {
+    double* cdf;
+    long n;
+    uint64_t seed;
+} zipf_t;
+
+static int zipf_init(zipf_t* z, long n)
+{
+    z->cdf = malloc(sizeof(double) * n);
+    if (!z->cdf) {
+        return -1;
+    }
+    double sum = 0;
+    for (long i = 0; i < n; i++) {
+        sum += 1.0 / pow(i + 1, CACHE_ZIPF_S);
+        z->cdf[i] = sum;
+    }
+    for (long i = 0; i < n; i++) {
+        z->cdf[i] /= sum;
+    }
+    z->n = n;
+    z->seed = 88172645463325252ull;
+    return 0;
+}
+
+static uint64_t zipf_rand(zipf_t* z)
+{
+    // xorshift64
+    z->seed ^= z->seed << 13;
+    z->seed ^= z->seed >> 7;
+    z->seed ^= z->seed << 17;
+    return z->seed;
+}
+
+static long zipf_next(zipf_t* z)
+{
+    double u = (zipf_rand(z) >> 11) * (1.0 / 9007199254740992.0);
+    long lo = 0, hi = z->n - 1;
+    while (lo < hi) {
+        long mid = (lo + hi) / 2;
+        if (z->cdf[mid] < u) {
+            lo = mid + 1;
+        }
+        else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+typedef struct {
+    double* samples;
+    long nsamples;
+    long cap;
+    long errors;
+    int inflight;
+} cache_bench_t;
+
+typedef struct {
+    cache_bench_t* b;
+    double start;
+} cache_req_t;
+
+static void cache_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    cache_req_t* q = (cache_req_t*)privdata;
+    cache_bench_t* b = q->b;
+    b->inflight--;
+    if (!reply || reply->type == RESP_ERROR) {
+        b->errors++;
+    }
+    else if (b->nsamples < b->cap) {
+        b->samples[b->nsamples++] = now_sec() - q->start;
+    }
+    free(q);
+}
+
+static void cache_conn_cb(redis_conn_t* c, int status)
+{
+    *(int*)c->data = status == 0 ? 1 : -1;
+}
+
+static int cache_fill(reactor_t* r, redis_conn_t* c, long keys)
+{
+    int pending = 0;
+    for (long i = 0; i < keys; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "bench:zipf:%ld", i);
+        const char* argv[] = { "SET", key, "value-0123456789" };
+        if (redis_conn_command_argv(c, lat_done_cb, &pending, 3, argv, NULL) < 0) {
+            return -1;
+        }
+        pending++;
+        if (pending >= 1000) {
+            while (pending > 0) {
+                eventloop_once(r, 100);
+            }
+        }
+    }
+    while (pending > 0) {
+        eventloop_once(r, 100);
+    }
+    return 0;
+}
+
+// 闭环压测 seconds 秒；cc 为 NULL 时直接发给 redis
+static void cache_run(reactor_t* r, redis_conn_t* c, redis_cache_t* cc, zipf_t* z, int seconds)
+{
+    cache_bench_t b;
+    memset(&b, 0, sizeof(b));
+    b.cap = 20 * 1000 * 1000;
+    b.samples = malloc(sizeof(double) * b.cap);
+    double t0 = now_sec();
+    double deadline = t0 + seconds;
+    long n = 0;
+    while (now_sec() < deadline) {
+        // 命中在发送时同步回调，不占在途数；每轮限量，失效通知要及时读
+        for (int k = 0; k < 1000 && b.inflight < CACHE_DEPTH; k++) {
+            char key[32];
+            char value[32];
+            snprintf(key, sizeof(key), "bench:zipf:%ld", zipf_next(z));
+            snprintf(value, sizeof(value), "value-%ld", n);
+            const char* get[] = { "GET", key };
+            const char* set[] = { "SET", key, value };
+            int write = zipf_rand(z) % 100 < CACHE_WRITE_PCT;
+            cache_req_t* q = malloc(sizeof(cache_req_t));
+            q->b = &b;
+            q->start = now_sec();
+            b.inflight++;
+            int ret = cc ? redis_cache_command_argv(cc, cache_cb, q, write ? 3 : 2, write ? set : get, NULL)
+                : redis_conn_command_argv(c, cache_cb, q, write ? 3 : 2, write ? set : get, NULL);
+            if (ret < 0) {
+                b.inflight--;
+                free(q);
+                break;
+            }
+            n++;
+        }
+        eventloop_once(r, 0);
+    }
+    while (b.inflight > 0 && now_sec() < deadline + 5) {
+        eventloop_once(r, 10);
+    }
+    double elapsed = now_sec() - t0;
+    qsort(b.samples, b.nsamples, sizeof(double), lat_cmp);
+    double p50 = b.nsamples ? b.samples[b.nsamples / 2] : 0;
+    double p99 = b.nsamples ? b.samples[(long)(b.nsamples * 0.99)] : 0;
+    printf("%-7s ops/s=%10.0f  p50=%8.2f us  p99=%8.2f us  errors=%ld\n",
+        cc ? "cache" : "direct", b.nsamples / elapsed, p50 * 1e6, p99 * 1e6, b.errors);
+    if (cc) {
+        printf("        hits=%llu misses=%llu invalidations=%llu evictions=%llu hit rate=%.1f%% cached=%u keys/%llu bytes\n",
+            (unsigned long long)cc->hits, (unsigned long long)cc->misses, (unsigned long long)cc->invalidations,
+            (unsigned long long)cc->evictions, 100.0 * cc->hits / (cc->hits + cc->misses + 1),
+            cc->nkeys, (unsigned long long)cc->bytes);
+    }
+    free(b.samples);
+}
+
+static void bench_cache(const char* host, int port, int seconds, long keys, long cache_kb)
+{
+    printf("cache bench: %s:%d, zipf(s=%.2f) over %ld keys, %d%% SET, %d in flight, cache %ld KB, %ds per run\n",
+        host, port, CACHE_ZIPF_S, keys, CACHE_WRITE_PCT, CACHE_DEPTH, cache_kb, seconds);
+    zipf_t z;
+    if (zipf_init(&z, keys) < 0) {
+        return;
+    }
+    for (int mode = 0; mode < 2; mode++) {
+        reactor_t* r = create_reactor();
+        int state = 0;
+        redis_conn_t* c = redis_connect(r, host, port);
+        if (!c) {
+            release_reactor(r);
+            break;
+        }
+        c->data = &state;
+        c->connect_fn = cache_conn_cb;
+        for (int i = 0; i < 500 && state == 0; i++) {
+            eventloop_once(r, 10);
+        }
+        if (state != 1 || (mode == 0 && cache_fill(r, c, keys) < 0)) {
+            printf("setup against %s:%d failed\n", host, port);
+            if (state == 1) {
+                redis_conn_free(c);
+            }
+            release_reactor(r);
+            break;
+        }
+        redis_cache_t* cc = NULL;
+        if (mode == 1) {
+            cc = redis_cache_create(c, (uint64_t)cache_kb * 1024);
+            for (int i = 0; i < 500 && cc && !cc->tracking; i++) {
+                eventloop_once(r, 10);
+            }
+            if (!cc || !cc->tracking) {
+                printf("CLIENT TRACKING not available on %s:%d\n", host, port);
+                if (cc) {
+                    redis_cache_free(cc);
+                }
+                redis_conn_free(c);
+                release_reactor(r);
+                break;
+            }
+        }
+        cache_run(r, c, cc, &z, seconds);
+        if (cc) {
+            redis_cache_free(cc);
+        }
+        redis_conn_free(c);
+        release_reactor(r);
+    }
+    free(z.cdf);
+}
+
+// -------------------------- cluster：多 key 读，逐个 GET vs redis_multi 按槽拆分的 MGET --------------------------
+#define CL_DEPTH		4 //同时在途的批次数
+#define CL_GROUP		16 //带 hash tag 的 key 每 16 个落在同一个槽
+#define CL_MAX_BATCH	1024
+
+enum { CL_GET = 0, CL_MGET = 1, CL_MGET_TAGGED = 2 };
+
+typedef struct {
+    int mode;
+    long done; //完成的批次数
+    long cmds; //发出的命令数
+    long errors;
+    int inflight;
+} cl_bench_t;
+
+typedef struct {
+    cl_bench_t* b;
+    int pending; //这一批还没回来的命令数
+} cl_batch_t;
+
+typedef struct {
+    char key[32];
+} cl_key_t;
+
+static void cl_key(int tagged, long i, char* key, size_t size)
+{
+    if (tagged) {
+        snprintf(key, size, "{bench:g%ld}:%ld", i / CL_GROUP, i % CL_GROUP);
+    }
+    else {
+        snprintf(key, size, "bench:c:%ld", i);
+    }
+}
+
+static void cl_release(cl_batch_t* batch)
+{
+    if (--batch->pending == 0) {
+        batch->b->done++;
+        batch->b->inflight--;
+        free(batch);
+    }
+}
+
+static void cl_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    cl_batch_t* batch = (cl_batch_t*)privdata;
+    if (!reply || reply->type == RESP_ERROR) {
+        batch->b->errors++;
+    }
+    cl_release(batch);
+}
+
+static void cl_multi_cb(redis_multi_t* m, void* privdata)
+{
+    cl_bench_t* b = (cl_bench_t*)privdata;
+    b->cmds += m->nchunks;
+    b->errors += m->failed;
+    b->done++;
+    b->inflight--;
+}
+
+// 随机取 n 个 key 读一批：逐个 GET，或交给 redis_multi 按槽分组后每组一条 MGET
+static void cl_issue(redis_cluster_t* cl, cl_bench_t* b, cl_key_t* keys, const char** argv, int n, long nkeys)
+{
+    int tagged = b->mode == CL_MGET_TAGGED;
+    long base = tagged ? (random() % (nkeys / CL_GROUP)) * CL_GROUP : 0;
+    for (int i = 0; i < n; i++) {
+        // 带 tag 时取相邻的几组，模拟按用户聚合的 key
+        long k = tagged ? (base + i) % nkeys : random() % nkeys;
+        cl_key(tagged, k, keys[i].key, sizeof(keys[i].key));
+        argv[i] = keys[i].key;
+    }
+    b->inflight++;
+    if (b->mode != CL_GET) {
+        if (redis_multi_cluster_get(cl, n, argv, NULL, cl_multi_cb, b) < 0) {
+            b->inflight--;
+        }
+        return;
+    }
+    cl_batch_t* batch = malloc(sizeof(cl_batch_t));
+    batch->b = b;
+    batch->pending = 1; //发完之前占住，避免同步失败时提前释放
+    for (int i = 0; i < n; i++) {
+        const char* get[] = { "GET", keys[i].key };
+        if (redis_cluster_command_argv(cl, cl_cb, batch, 2, get, NULL) == 0) {
+            batch->pending++;
+            b->cmds++;
+        }
+    }
+    cl_release(batch);
+}
+
+static void cl_fill_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    (*(int*)privdata)--;
+}
+
+static int cl_fill(reactor_t* r, redis_cluster_t* cl, long nkeys)
+{
+    int pending = 0;
+    for (int tagged = 0; tagged < 2; tagged++) {
+        for (long i = 0; i < nkeys; i++) {
+            char key[32];
+            cl_key(tagged, i, key, sizeof(key));
+            const char* argv[] = { "SET", key, "value-0123456789" };
+            if (redis_cluster_command_argv(cl, cl_fill_cb, &pending, 3, argv, NULL) < 0) {
+                return -1;
+            }
+            pending++;
+            while (pending >= 1000) {
+                eventloop_once(r, 100);
+            }
+        }
+    }
+    for (int i = 0; i < 1000 && pending > 0; i++) {
+        eventloop_once(r, 10);
+    }
+    return pending == 0 ? 0 : -1;
+}
+
+static void bench_cluster(const char* host, int port, int seconds, int batch)
+{
+    const char* names[] = { "GET x N", "MGET/slot", "MGET/slot tagged" };
+    long nkeys = BENCH_KEYS;
+    if (batch <= 0 || batch > CL_MAX_BATCH) {
+        batch = 100;
+    }
+    reactor_t* r = create_reactor();
+    redis_cluster_t* cl = redis_cluster_create(r, host, port);
+    if (!cl) {
+        release_reactor(r);
+        return;
+    }
+    for (int i = 0; i < 500 && cl->refreshes == 0; i++) {
+        eventloop_once(r, 10);
+    }
+    int owned = 0;
+    for (int s = 0; s < REDIS_CLUSTER_SLOTS; s++) {
+        owned += cl->slots[s] >= 0;
+    }
+    printf("cluster bench: seed %s:%d, %d nodes, %d/%d slots mapped, %d keys per batch, %d batches in flight, %ds per run\n",
+        host, port, cl->nnodes, owned, REDIS_CLUSTER_SLOTS, batch, CL_DEPTH, seconds);
+    if (cl_fill(r, cl, nkeys) < 0) {
+        printf("fill against %s:%d failed\n", host, port);
+        redis_cluster_free(cl);
+        release_reactor(r);
+        return;
+    }
+    cl_key_t* keys = malloc(sizeof(cl_key_t) * batch);
+    const char** argv = malloc(sizeof(char*) * batch);
+    for (int mode = CL_GET; mode <= CL_MGET_TAGGED; mode++) {
+        cl_bench_t b;
+        memset(&b, 0, sizeof(b));
+        b.mode = mode;
+        double t0 = now_sec();
+        double deadline = t0 + seconds;
+        while (now_sec() < deadline) {
+            while (b.inflight < CL_DEPTH) {
+                cl_issue(cl, &b, keys, argv, batch, nkeys);
+            }
+            eventloop_once(r, 10);
+        }
+        while (b.inflight > 0 && now_sec() < deadline + 5) {
+            eventloop_once(r, 10);
+        }
+        double elapsed = now_sec() - t0;
+        printf("%-17s batches/s=%8.0f  keys/s=%10.0f  cmds/batch=%6.1f  errors=%ld\n",
+            names[mode], b.done / elapsed, b.done * batch / elapsed, b.done ? (double)b.cmds / b.done : 0, b.errors);
+    }
+    printf("redirects: moved=%llu ask=%llu refreshes=%llu\n",
+        (unsigned long long)cl->moved, (unsigned long long)cl->asks, (unsigned long long)cl->refreshes);
+    free(keys);
+    free(argv);
+    redis_cluster_free(cl);
+    release_reactor(r);
+}
+
+// -------------------------- multi：大量 key 的读，逐个 GET vs redis_multi 拆分 MGET --------------------------
+#define MULTI_POOL	4
+
+enum { MULTI_HIREDIS_GET = 0, MULTI_NATIVE_GET = 1, MULTI_MGET = 2 };
+
+typedef struct {
+    long pending;
+    long errors;
+    long missing;
+} multi_bench_t;
+
+static void multi_native_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    multi_bench_t* b = (multi_bench_t*)privdata;
+    b->pending--;
+    if (!reply || reply->type == RESP_ERROR) {
+        b->errors++;
+    }
+    else if (reply->type != RESP_BULK) {
+        b->missing++;
+    }
+}
+
+static void multi_hiredis_cb(redisAsyncContext* ac, void* reply, void* privdata)
+{
+    multi_bench_t* b = (multi_bench_t*)privdata;
+    redisReply* rr = (redisReply*)reply;
+    b->pending--;
+    if (!rr || rr->type == REDIS_REPLY_ERROR) {
+        b->errors++;
+    }
+    else if (rr->type != REDIS_REPLY_STRING) {
+        b->missing++;
+    }
+}
+
+static void multi_done_cb(redis_multi_t* m, void* privdata)
+{
+    multi_bench_t* b = (multi_bench_t*)privdata;
+    b->pending = 0;
+    b->errors += m->failed;
+    for (int i = 0; m->values && i < m->nkeys; i++) {
+        b->missing += m->values[i].str == NULL;
+    }
+}
+
+static int multi_wait(reactor_t* r, multi_bench_t* b)
+{
+    double deadline = now_sec() + 60;
+    while (b->pending > 0 && now_sec() < deadline) {
+        eventloop_once(r, 10);
+    }
+    return b->pending == 0 ? 0 : -1;
+}
+
+static void bench_multi(const char* host, int port, int nkeys)
+{
+    const char* names[] = { "hiredis GET loop", "native GET loop", "redis_multi_get" };
+    const char** keys = malloc(sizeof(char*) * nkeys);
+    const char** values = malloc(sizeof(char*) * nkeys);
+    char* store = malloc((size_t)nkeys * 64);
+    for (int i = 0; i < nkeys; i++) {
+        char* k = store + (size_t)i * 64;
+        snprintf(k, 32, "bench:m:%d", i);
+        snprintf(k + 32, 32, "value-%010d", i);
+        keys[i] = k;
+        values[i] = k + 32;
+    }
+    printf("multi bench: %s:%d, %d keys, pool of %d, MGET batches of %d\n", host, port, nkeys, MULTI_POOL, REDIS_MULTI_BATCH);
+
+    reactor_t* r = create_reactor();
+    redis_pool_t* p = redis_pool_create(r, host, port, MULTI_POOL);
+    event_t* e = reactor_redis_async_connect(r, host, port);
+    if (!p) {
+        printf("connect %s:%d failed\n", host, port);
+        goto out;
+    }
+    redis_pool_set_pipelining(p, 1);
+    if (e) {
+        reactor_redis_async_set_pipelining(e, 1);
+    }
+    for (int i = 0; i < 500 && !(p->members[MULTI_POOL - 1].c && (p->members[MULTI_POOL - 1].c->flags & REDIS_CONN_CONNECTED)); i++) {
+        eventloop_once(r, 10);
+    }
+
+    multi_bench_t b;
+    memset(&b, 0, sizeof(b));
+    b.pending = 1;
+    double t0 = now_sec();
+    if (redis_multi_set(p, nkeys, keys, NULL, values, NULL, multi_done_cb, &b) < 0 || multi_wait(r, &b) < 0 || b.errors) {
+        printf("fill against %s:%d failed\n", host, port);
+        goto out;
+    }
+    printf("%-17s %8.1f ms  keys/s=%10.0f\n", "redis_multi_set", (now_sec() - t0) * 1e3, nkeys / (now_sec() - t0));
+
+    for (int mode = MULTI_HIREDIS_GET; mode <= MULTI_MGET; mode++) {
+        if (mode == MULTI_HIREDIS_GET && (!e || e->fd < 0)) {
+            printf("%-17s skipped: hiredis connect failed\n", names[mode]);
+            continue;
+        }
+        memset(&b, 0, sizeof(b));
+        t0 = now_sec();
+        if (mode == MULTI_MGET) {
+            b.pending = 1;
+            if (redis_multi_get(p, nkeys, keys, NULL, multi_done_cb, &b) < 0) {
+                continue;
+            }
+        }
+        else {
+            for (int i = 0; i < nkeys; i++) {
+                const char* argv[] = { "GET", keys[i] };
+                if (mode == MULTI_HIREDIS_GET) {
+                    reactor_redis_async_send_argv(e, multi_hiredis_cb, &b, 2, argv, NULL);
+                    b.pending++;
+                }
+                else if (redis_pool_command_argv(p, multi_native_cb, &b, 2, argv, NULL) == 0) {
+                    b.pending++;
+                }
+            }
+        }
+        int ok = multi_wait(r, &b) == 0;
+        double elapsed = now_sec() - t0;
+        printf("%-17s %8.1f ms  keys/s=%10.0f  errors=%ld missing=%ld%s\n",
+            names[mode], elapsed * 1e3, nkeys / elapsed, b.errors, b.missing, ok ? "" : "  (timeout)");
+    }
+
+out:
+    if (e && e->fd >= 0) {
+        reactor_redis_async_free(e);
+    }
+    if (p) {
+        redis_pool_free(p);
+    }
+    release_reactor(r);
+    free(store);
+    free(keys);
+    free(values);
+}
+
+int main(int argc, char* argv[])
+{
+    signal(SIGPIPE, SIG_IGN);
+    if (argc < 2) {
+        printf("usage: %s depth [host] [port] [ops] [value_size]\n", argv[0]);
+        printf("       %s fanout [host] [port] [per_tick] [ticks]\n", argv[0]);
+        printf("       %s latency [host] [port] [seconds] [list_len]\n", argv[0]);
+        printf("       %s batch [host] [port] [keys]\n", argv[0]);
+        printf("       %s bigvalue [host] [port] [max_mb]\n", argv[0]);
+        printf("       %s cache [host] [port] [seconds] [keys] [cache_kb]\n", argv[0]);
+        printf("       %s cluster [host] [port] [seconds] [keys_per_batch]\n", argv[0]);
+        printf("       %s multi [host] [port] [keys]\n", argv[0]);
+        return 1;
+    }
+    const char* host = argc > 2 ? argv[2] : "127.0.0.1";
+    int port = argc > 3 ? atoi(argv[3]) : 6379;
+    if (strcmp(argv[1], "depth") == 0) {
+        bench_depth(host, port, argc > 4 ? atol(argv[4]) : 200000, argc > 5 ? atoi(argv[5]) : 32);
+        return 0;
+    }
+    if (strcmp(argv[1], "fanout") == 0) {
+        bench_fanout(host, port, argc > 4 ? atoi(argv[4]) : 5000, argc > 5 ? atoi(argv[5]) : 100);
+        return 0;
+    }
+    if (strcmp(argv[1], "latency") == 0) {
+        bench_latency(host, port, argc > 4 ? atoi(argv[4]) : 5, argc > 5 ? atoi(argv[5]) : 10000);
+        return 0;
+    }
+    if (strcmp(argv[1], "batch") == 0) {
+        bench_batch(host, port, argc > 4 ? atol(argv[4]) : BENCH_KEYS);
+        return 0;
+    }
+    if (strcmp(argv[1], "bigvalue") == 0) {
+        bench_bigvalue(host, port, argc > 4 ? atoi(argv[4]) : 100);
+        return 0;
+    }
+    if (strcmp(argv[1], "cache") == 0) {
+        bench_cache(host, port, argc > 4 ? atoi(argv[4]) : 5, argc > 5 ? atol(argv[5]) : 100000, argc > 6 ? atol(argv[6]) : 4096);
+        return 0;
+    }
+    if (strcmp(argv[1], "cluster") == 0) {
+        bench_cluster(host, port, argc > 4 ? atoi(argv[4]) : 5, argc > 5 ? atoi(argv[5]) : 100);
+        return 0;
+    }
+    if (strcmp(argv[1], "multi") == 0) {
+        bench_multi(host, port, argc > 4 ? atoi(argv[4]) : 100000);
+        return 0;
+    }
+    printf("unknown bench: %s\n", argv[1]);
+    return 1;
+}
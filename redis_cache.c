@@ -0,0 +1,489 @@
+#include "redis_cache.h"
+#include <strings.h> //strncasecmp
+
+// 可以缓存的单 key 只读命令，argv[1] 为 key
+static const char* _redis_cache_cmds[] = {
+	"GET", "GETRANGE", "STRLEN", "TYPE",
+	"HGET", "HMGET", "HGETALL", "HEXISTS", "HLEN", "HKEYS", "HVALS",
+	"LRANGE", "LLEN", "LINDEX",
+	"SMEMBERS", "SISMEMBER", "SCARD",
+	"ZRANGE", "ZSCORE", "ZCARD", "ZRANK",
+	NULL,
+};
+
+// 可以带多个 key 的只读命令，只在只有一个 key 时缓存：缓存项只挂在 argv[1] 下，收不到其他 key 的失效通知
+static const char* _redis_cache_one_key_cmds[] = {
+	"EXISTS",
+	NULL,
+};
+
+// 未命中的请求：回复回来后写入缓存再交给调用方
+typedef struct {
+	redis_cache_t* cc;
+	redis_reply_fn fn;
+	void* privdata;
+	int cacheable; //发出时 tracking 已经打开
+	uint64_t writes; //发出时的 cc->writes
+	uint32_t hash;
+	uint32_t klen;
+	uint32_t cmdlen;
+	char data[]; //key，后面紧跟命令
+} redis_cache_req_t;
+
+static uint32_t _redis_cache_hash(const char* key, size_t len)
+{
+	uint32_t h = 2166136261u; //FNV-1a
+	for (size_t i = 0; i < len; i++) {
+		h ^= (uint8_t)key[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+static int _redis_cache_cmd_in(const char** cmds, const char* name, size_t len)
+{
+	for (int i = 0; cmds[i]; i++) {
+		if (strlen(cmds[i]) == len && strncasecmp(cmds[i], name, len) == 0) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static int _redis_cache_cmd_ok(int argc, const char* name, size_t len)
+{
+	if (argc < 2) {
+		return 0;
+	}
+	return _redis_cache_cmd_in(_redis_cache_cmds, name, len)
+		|| (argc == 2 && _redis_cache_cmd_in(_redis_cache_one_key_cmds, name, len));
+}
+
+// 命令的全部参数编码成 长度 + 内容，命令名统一成大写；out 为 NULL 时只计算长度
+static uint32_t _redis_cache_encode(char* out, int argc, const char** argv, const size_t* argvlen)
+{
+	uint32_t n = 0;
+	for (int i = 0; i < argc; i++) {
+		uint32_t len = (uint32_t)(argvlen ? argvlen[i] : strlen(argv[i]));
+		if (out) {
+			memcpy(out + n, &len, sizeof(len));
+			for (uint32_t k = 0; k < len; k++) {
+				char ch = argv[i][k];
+				out[n + sizeof(len) + k] = (i == 0 && ch >= 'a' && ch <= 'z') ? ch - 'a' + 'A' : ch;
+			}
+		}
+		n += sizeof(len) + len;
+	}
+	return n;
+}
+
+static redis_cache_key_t** _redis_cache_find_key(redis_cache_t* cc, uint32_t hash, const char* key, uint32_t klen)
+{
+	redis_cache_key_t** pk = &cc->buckets[hash & (cc->nbuckets - 1)];
+	while (*pk) {
+		redis_cache_key_t* k = *pk;
+		if (k->hash == hash && k->klen == klen && memcmp(k->key, key, klen) == 0) {
+			break;
+		}
+		pk = &k->next;
+	}
+	return pk;
+}
+
+static redis_cache_entry_t* _redis_cache_find(redis_cache_key_t* k, const char* cmd, uint32_t cmdlen)
+{
+	for (redis_cache_entry_t* e = k->entries; e; e = e->next) {
+		if (e->cmdlen == cmdlen && memcmp(e->cmd, cmd, cmdlen) == 0) {
+			return e;
+		}
+	}
+	return NULL;
+}
+
+// 从 key 的链表和 CLOCK 数组中摘掉并释放（CLOCK 数组用最后一项填补空位）
+static void _redis_cache_entry_free(redis_cache_t* cc, redis_cache_entry_t* e)
+{
+	redis_cache_entry_t** pe = &e->owner->entries;
+	while (*pe != e) {
+		pe = &(*pe)->next;
+	}
+	*pe = e->next;
+	redis_cache_entry_t* tail = cc->clock[--cc->nentries];
+	cc->clock[e->slot] = tail;
+	tail->slot = e->slot;
+	cc->bytes -= e->size;
+	buffer_free(e->data);
+	free(e);
+}
+
+static void _redis_cache_key_free(redis_cache_t* cc, redis_cache_key_t** pk)
+{
+	redis_cache_key_t* k = *pk;
+	while (k->entries) {
+		_redis_cache_entry_free(cc, k->entries);
+	}
+	*pk = k->next;
+	cc->bytes -= sizeof(redis_cache_key_t) + k->klen;
+	cc->nkeys--;
+	free(k);
+}
+
+static void _redis_cache_evict(redis_cache_t* cc)
+{
+	while (cc->bytes > cc->max_bytes && cc->nentries > 0) {
+		if (cc->hand >= cc->nentries) {
+			cc->hand = 0;
+		}
+		redis_cache_entry_t* e = cc->clock[cc->hand];
+		if (e->ref) {
+			e->ref = 0;
+			cc->hand++;
+			continue;
+		}
+		redis_cache_key_t* owner = e->owner;
+		_redis_cache_entry_free(cc, e);
+		cc->evictions++;
+		if (!owner->entries) {
+			_redis_cache_key_free(cc, _redis_cache_find_key(cc, owner->hash, owner->key, owner->klen));
+		}
+	}
+}
+
+static int _redis_cache_grow(redis_cache_t* cc)
+{
+	uint32_t n = cc->nbuckets * 2;
+	redis_cache_key_t** buckets = (redis_cache_key_t**)calloc(n, sizeof(redis_cache_key_t*));
+	if (!buckets) {
+		return -1;
+	}
+	for (uint32_t i = 0; i < cc->nbuckets; i++) {
+		redis_cache_key_t* k = cc->buckets[i];
+		while (k) {
+			redis_cache_key_t* next = k->next;
+			k->next = buckets[k->hash & (n - 1)];
+			buckets[k->hash & (n - 1)] = k;
+			k = next;
+		}
+	}
+	free(cc->buckets);
+	cc->buckets = buckets;
+	cc->nbuckets = n;
+	return 0;
+}
+
+// 把当前回复写入缓存，同一条命令已有的旧值被替换
+static void _redis_cache_put(redis_cache_t* cc, redis_cache_req_t* req)
+{
+	const char* key = req->data;
+	const char* cmd = req->data + req->klen;
+	if (cc->nentries == cc->clock_cap) {
+		uint32_t cap = cc->clock_cap ? cc->clock_cap * 2 : REDIS_CACHE_BUCKETS_INIT;
+		redis_cache_entry_t** clock = (redis_cache_entry_t**)realloc(cc->clock, sizeof(redis_cache_entry_t*) * cap);
+		if (!clock) {
+			return;
+		}
+		cc->clock = clock;
+		cc->clock_cap = cap;
+	}
+	if (cc->nkeys >= cc->nbuckets && _redis_cache_grow(cc) < 0) {
+		return;
+	}
+	redis_cache_entry_t* e = (redis_cache_entry_t*)malloc(sizeof(redis_cache_entry_t) + req->cmdlen);
+	if (!e) {
+		return;
+	}
+	e->data = buffer_new(0);
+	if (!e->data || redis_conn_copy_reply(cc->c, e->data) < 0) {
+		buffer_free(e->data);
+		free(e);
+		return;
+	}
+	e->size = sizeof(redis_cache_entry_t) + req->cmdlen + buffer_len(e->data);
+	if (e->size > cc->max_bytes / REDIS_CACHE_MAX_ENTRY_DIV) {
+		buffer_free(e->data);
+		free(e);
+		return;
+	}
+	e->cmdlen = req->cmdlen;
+	memcpy(e->cmd, cmd, req->cmdlen);
+	e->ref = 0; //新项要再被访问一次才能躲过下一轮淘汰，一次性扫描的 key 不会挤掉热点
+
+	redis_cache_key_t** pk = _redis_cache_find_key(cc, req->hash, key, req->klen);
+	redis_cache_key_t* k = *pk;
+	if (!k) {
+		k = (redis_cache_key_t*)malloc(sizeof(redis_cache_key_t) + req->klen);
+		if (!k) {
+			buffer_free(e->data);
+			free(e);
+			return;
+		}
+		k->hash = req->hash;
+		k->klen = req->klen;
+		k->entries = NULL;
+		memcpy(k->key, key, req->klen);
+		k->next = NULL;
+		*pk = k;
+		cc->nkeys++;
+		cc->bytes += sizeof(redis_cache_key_t) + req->klen;
+	}
+	redis_cache_entry_t* old = _redis_cache_find(k, cmd, req->cmdlen);
+	if (old) {
+		_redis_cache_entry_free(cc, old);
+	}
+	e->owner = k;
+	e->next = k->entries;
+	k->entries = e;
+	e->slot = cc->nentries;
+	cc->clock[cc->nentries++] = e;
+	cc->bytes += e->size;
+	_redis_cache_evict(cc);
+}
+
+static void _redis_cache_destroy(redis_cache_t* cc)
+{
+	redis_cache_flush(cc);
+	resp_reader_reset(&cc->reader);
+	buffer_free(cc->scratch);
+	free(cc->buckets);
+	free(cc->clock);
+	free(cc);
+}
+
+// 一个请求回来了，redis_cache_free 之后等的就是最后一个
+static void _redis_cache_done(redis_cache_t* cc)
+{
+	cc->inflight--;
+	if (cc->closing && cc->inflight == 0) {
+		_redis_cache_destroy(cc);
+	}
+}
+
+static void _redis_cache_miss_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+	redis_cache_req_t* req = (redis_cache_req_t*)privdata;
+	redis_cache_t* cc = req->cc;
+	// 同一条连接上回复先于之后的失效通知到达，这里写入的值如果被改过，随后的 invalidate 会删掉它
+	// 请求在途期间经缓存发出过写，回复可能是写之前的旧值，而写已经删过本地缓存，失效通知不一定还会来
+	if (reply && req->cacheable && req->writes == cc->writes && cc->tracking && !cc->closing
+		&& reply->type != RESP_ERROR && reply->type != RESP_BLOB_ERROR) {
+		_redis_cache_put(cc, req);
+	}
+	if (req->fn) {
+		req->fn(c, reply, req->privdata);
+	}
+	free(req);
+	_redis_cache_done(cc);
+}
+
+static void _redis_cache_invalidate_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+	redis_cache_t* cc = (redis_cache_t*)privdata;
+	if (!reply) {
+		redis_cache_flush(cc);
+		cc->c = NULL;
+		cc->tracking = 0;
+		return;
+	}
+	resp_reply_t* keys = &reply->element[1];
+	if (keys->type != RESP_ARRAY) {
+		// FLUSHDB / FLUSHALL 时 key 列表为 null
+		cc->invalidations += cc->nkeys;
+		redis_cache_flush(cc);
+		return;
+	}
+	for (int64_t i = 0; i < keys->elements; i++) {
+		resp_view_t* v = &keys->element[i].str;
+		char stack[256];
+		char* key = v->len <= sizeof(stack) ? stack : (char*)malloc(v->len);
+		if (!key) {
+			continue;
+		}
+		resp_view_copy(v, key, v->len);
+		redis_cache_key_t** pk = _redis_cache_find_key(cc, _redis_cache_hash(key, v->len), key, v->len);
+		if (*pk) {
+			_redis_cache_key_free(cc, pk);
+		}
+		cc->invalidations++;
+		if (key != stack) {
+			free(key);
+		}
+	}
+}
+
+static void _redis_cache_setup_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+	redis_cache_t* cc = (redis_cache_t*)privdata;
+	if (reply && reply->type == RESP_ERROR) {
+		char err[128];
+		uint32_t n = resp_view_copy(&reply->str, err, sizeof(err) - 1);
+		err[n] = '\0';
+		printf("redis cache setup error: %s\n", err);
+	}
+	else if (reply && reply->type == RESP_STRING && !cc->closing) {
+		// CLIENT TRACKING ON 的 +OK，之后发出的读命令都会被跟踪
+		cc->tracking = 1;
+	}
+	_redis_cache_done(cc);
+}
+
+redis_cache_t* redis_cache_create(redis_conn_t* c, uint64_t max_bytes)
+{
+	redis_cache_t* cc = (redis_cache_t*)calloc(1, sizeof(redis_cache_t));
+	if (!cc) {
+		return NULL;
+	}
+	cc->c = c;
+	cc->max_bytes = max_bytes;
+	cc->nbuckets = REDIS_CACHE_BUCKETS_INIT;
+	cc->buckets = (redis_cache_key_t**)calloc(cc->nbuckets, sizeof(redis_cache_key_t*));
+	cc->scratch = buffer_new(0);
+	resp_reader_init(&cc->reader);
+	if (!cc->buckets || !cc->scratch) {
+		free(cc->buckets);
+		buffer_free(cc->scratch);
+		free(cc);
+		return NULL;
+	}
+	// HELLO 失败时 TRACKING 也会报错（RESP2 下不带 REDIRECT 不允许），tracking 保持关闭
+	if (redis_conn_command(c, _redis_cache_setup_cb, cc, "HELLO 3") < 0) {
+		_redis_cache_destroy(cc);
+		return NULL;
+	}
+	cc->inflight++;
+	if (redis_conn_command(c, _redis_cache_setup_cb, cc, "CLIENT TRACKING ON") == 0) {
+		cc->inflight++;
+	}
+	c->invalidate_fn = _redis_cache_invalidate_cb;
+	c->invalidate_data = cc;
+	return cc;
+}
+
+void redis_cache_free(redis_cache_t* cc)
+{
+	if (cc->c) {
+		cc->c->invalidate_fn = NULL;
+		cc->c->invalidate_data = NULL;
+	}
+	cc->closing = 1;
+	cc->tracking = 0;
+	if (cc->inflight == 0) {
+		_redis_cache_destroy(cc);
+		return;
+	}
+	redis_cache_flush(cc);
+}
+
+void redis_cache_flush(redis_cache_t* cc)
+{
+	for (uint32_t i = 0; i < cc->nbuckets; i++) {
+		while (cc->buckets[i]) {
+			_redis_cache_key_free(cc, &cc->buckets[i]);
+		}
+	}
+	cc->hand = 0;
+}
+
+// 不可缓存的命令可能改写它的 key：不知道哪些参数是 key，所有参数上缓存的都删掉，
+// 否则失效通知回来之前随后的读会命中写之前的旧值
+static void _redis_cache_drop_args(redis_cache_t* cc, int argc, const char** argv, const size_t* argvlen)
+{
+	for (int i = 1; i < argc && cc->nkeys > 0; i++) {
+		uint32_t len = (uint32_t)(argvlen ? argvlen[i] : strlen(argv[i]));
+		redis_cache_key_t** pk = _redis_cache_find_key(cc, _redis_cache_hash(argv[i], len), argv[i], len);
+		if (*pk) {
+			_redis_cache_key_free(cc, pk);
+		}
+	}
+	cc->writes++;
+}
+
+// 命中：缓存的编码以只读引用挂到解析 buffer 上，不拷贝数据
+static void _redis_cache_hit(redis_cache_t* cc, redis_cache_entry_t* e, redis_reply_fn fn, void* privdata)
+{
+	resp_reader_t nested;
+	resp_reader_t* rd = &cc->reader;
+	buffer_t* buf = cc->scratch;
+	if (cc->hitting) {
+		// 回调里又命中了一次，外层的回复还在用 scratch
+		rd = &nested;
+		resp_reader_init(rd);
+		buf = buffer_new(0);
+	}
+	resp_reply_t* reply;
+	e->ref = 1;
+	cc->hits++;
+	// 回调里可能调用 redis_cache_free，先占住一个 inflight，用完 reader 再释放
+	cc->inflight++;
+	if (buf && buffer_add_buffer_reference(buf, e->data) == 0 && resp_reader_next(rd, buf, &reply) == RESP_VALUE) {
+		int outer = cc->hitting;
+		cc->hitting = 1;
+		if (fn) {
+			fn(cc->c, reply, privdata);
+		}
+		cc->hitting = outer;
+		resp_reader_consume(rd, buf);
+	}
+	if (rd == &nested) {
+		resp_reader_reset(rd);
+		buffer_free(buf);
+	}
+	_redis_cache_done(cc);
+}
+
+int redis_cache_command_argv(redis_cache_t* cc, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen)
+{
+	if (!cc->c || cc->closing || argc <= 0) {
+		return -1;
+	}
+	size_t namelen = argvlen ? argvlen[0] : strlen(argv[0]);
+	if (!_redis_cache_cmd_ok(argc, argv[0], namelen)) {
+		_redis_cache_drop_args(cc, argc, argv, argvlen);
+		return redis_conn_command_argv(cc->c, fn, privdata, argc, argv, argvlen);
+	}
+	uint32_t klen = (uint32_t)(argvlen ? argvlen[1] : strlen(argv[1]));
+	uint32_t cmdlen = _redis_cache_encode(NULL, argc, argv, argvlen);
+	uint32_t hash = _redis_cache_hash(argv[1], klen);
+	char stack[512];
+	char* cmd = cmdlen <= sizeof(stack) ? stack : (char*)malloc(cmdlen);
+	if (!cmd) {
+		return -1;
+	}
+	_redis_cache_encode(cmd, argc, argv, argvlen);
+	redis_cache_key_t* k = *_redis_cache_find_key(cc, hash, argv[1], klen);
+	redis_cache_entry_t* e = k ? _redis_cache_find(k, cmd, cmdlen) : NULL;
+	if (e) {
+		if (cmd != stack) {
+			free(cmd);
+		}
+		_redis_cache_hit(cc, e, fn, privdata);
+		return 0;
+	}
+
+	cc->misses++;
+	redis_cache_req_t* req = (redis_cache_req_t*)malloc(sizeof(redis_cache_req_t) + klen + cmdlen);
+	if (!req) {
+		if (cmd != stack) {
+			free(cmd);
+		}
+		return -1;
+	}
+	req->cc = cc;
+	req->fn = fn;
+	req->privdata = privdata;
+	req->cacheable = cc->tracking;
+	req->writes = cc->writes;
+	req->hash = hash;
+	req->klen = klen;
+	req->cmdlen = cmdlen;
+	memcpy(req->data, argv[1], klen);
+	memcpy(req->data + klen, cmd, cmdlen);
+	if (cmd != stack) {
+		free(cmd);
+	}
+	if (redis_conn_command_argv(cc->c, _redis_cache_miss_cb, req, argc, argv, argvlen) < 0) {
+		free(req);
+		return -1;
+	}
+	cc->inflight++;
+	return 0;
+}
@@ -0,0 +1,80 @@
+#ifndef __REDIS_CACHE_H__
+#define __REDIS_CACHE_H__
+
+#include "redis_client.h"
+
+// 建在一条 redis_conn_t 上的本地近缓存（client side caching）：
+// 连接切到 RESP3 并打开 CLIENT TRACKING，服务器在缓存过的 key 被修改时推送 invalidate；
+// 只读命令的回复按原始 RESP 编码缓存，命中时在本地重新解析后直接回调，不走网络。
+// 同一条连接上回复和失效通知保持顺序，读到的值不会比随后的失效通知更旧。
+// 内存按字节数限制，超出时按 CLOCK（二次机会）淘汰。
+// 注意：打开后这条连接上的所有回复都是 RESP3 格式（HGETALL 返回 MAP 等）。
+
+#define REDIS_CACHE_BUCKETS_INIT	1024 //哈希桶初始个数，key 数超过桶数时按 2 倍扩容
+#define REDIS_CACHE_MAX_ENTRY_DIV	16 //单条回复超过容量的 1/16 时不缓存，避免一条大 value 冲掉整个缓存
+
+typedef struct redis_cache_s redis_cache_t;
+typedef struct redis_cache_key_s redis_cache_key_t;
+typedef struct redis_cache_entry_s redis_cache_entry_t;
+
+// 一个 redis key，挂着这个 key 上缓存过的所有命令（GET、HGETALL ...）
+struct redis_cache_key_s
+{
+	redis_cache_key_t* next; //哈希桶链
+	uint32_t hash;
+	uint32_t klen;
+	redis_cache_entry_t* entries;
+	char key[];
+};
+
+struct redis_cache_entry_s
+{
+	redis_cache_key_t* owner;
+	redis_cache_entry_t* next; //同一个 key 上的下一条命令
+	buffer_t* data; //回复的原始 RESP 编码，命中时以引用的方式挂到解析 buffer 上
+	uint64_t size; //计入容量的字节数
+	uint32_t slot; //在 CLOCK 数组中的下标
+	int ref; //CLOCK 的访问位
+	uint32_t cmdlen;
+	char cmd[]; //命令的全部参数（长度 + 内容依次拼接），用于区分同一个 key 上的不同命令
+};
+
+struct redis_cache_s
+{
+	redis_conn_t* c; //连接关闭后为 NULL
+	int tracking; //CLIENT TRACKING 已经打开，之前的回复不缓存
+	int closing; //redis_cache_free 已调用，等在途的请求回来后释放
+	uint32_t inflight; //未收到回复的未命中请求
+	uint64_t writes; //经缓存发出的不可缓存命令数，未命中请求在途期间有写发出时回复不缓存
+	uint64_t max_bytes;
+	uint64_t bytes;
+	redis_cache_key_t** buckets;
+	uint32_t nbuckets;
+	uint32_t nkeys;
+	redis_cache_entry_t** clock; //所有缓存项，CLOCK 指针在上面转圈
+	uint32_t nentries;
+	uint32_t clock_cap;
+	uint32_t hand;
+	buffer_t* scratch; //命中时重新解析回复用
+	resp_reader_t reader;
+	int hitting; //正在命中回调中，嵌套命中时改用临时 buffer
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t invalidations; //收到失效通知的 key 数
+	uint64_t evictions;
+};
+
+// 在 c 上打开 tracking，max_bytes 为缓存的容量；c 的 invalidate_fn 由 cache 占用
+redis_cache_t* redis_cache_create(redis_conn_t* c, uint64_t max_bytes);
+
+// 清空缓存；还有未收到回复的请求时延迟到最后一个回复之后释放
+void redis_cache_free(redis_cache_t* cc);
+
+// 可缓存的只读命令（GET、HGET、HGETALL、LRANGE 等，argv[1] 为 key）先查本地，命中时在返回前同步回调；
+// 其他命令以及未命中时照常发给 redis；其他命令按可能是写处理，发出前先删掉参数对应的本地缓存。成功返回 0
+int redis_cache_command_argv(redis_cache_t* cc, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen);
+
+// 清空所有缓存项
+void redis_cache_flush(redis_cache_t* cc);
+
+#endif
@@ -0,0 +1,373 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include "redis_cache.h"
+
+// 编译: gcc reactor.c reactor_uring.c ringbuffer/ringbuffer.c ringbuffer/mpmc_ring.c chainbuffer/chainbuffer.c memsearch/memsearch.c timewheel/timewheel.c resp/resp_parser.c redis_client.c redis_cache.c redis_cache_test.c -o redis_cache_test -lpthread
+// 用 socketpair 的另一端扮演打开了 RESP3 tracking 的 redis 服务器
+
+typedef struct {
+    int calls;
+    int nulls;
+    int type;
+    long long integer;
+    char last_str[64];
+} result_t;
+
+static void record_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    result_t* res = (result_t*)privdata;
+    if (!reply) {
+        res->nulls++;
+        return;
+    }
+    res->calls++;
+    res->type = reply->type;
+    res->integer = reply->integer;
+    res->last_str[0] = '\0';
+    if (reply->type == RESP_BULK || reply->type == RESP_STRING) {
+        uint32_t n = resp_view_copy(&reply->str, res->last_str, sizeof(res->last_str) - 1);
+        res->last_str[n] = '\0';
+    }
+    else if (reply->type == RESP_MAP && reply->elements > 0) {
+        uint32_t n = resp_view_copy(&reply->element[1].str, res->last_str, sizeof(res->last_str) - 1);
+        res->last_str[n] = '\0';
+    }
+}
+
+typedef struct {
+    redis_cache_t* cc;
+    result_t inner;
+    char outer_str[64];
+} nested_t;
+
+// 在命中回调里再发一个会命中的命令，外层回复在内层回调之后仍然有效
+static void nested_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    nested_t* n = (nested_t*)privdata;
+    const char* argv[] = { "HGETALL", "k" };
+    assert(redis_cache_command_argv(n->cc, record_cb, &n->inner, 2, argv, NULL) == 0);
+    assert(n->inner.calls == 1);
+    uint32_t len = resp_view_copy(&reply->str, n->outer_str, sizeof(n->outer_str) - 1);
+    n->outer_str[len] = '\0';
+}
+
+static void loop_until(reactor_t* r, int* counter, int expect)
+{
+    for (int i = 0; i < 1000 && *counter < expect; i++) {
+        eventloop_once(r, 10);
+    }
+}
+
+// 读出客户端发来的所有数据，返回其中命令的个数（以 '*' 开头的行数）
+static int drain_commands(reactor_t* r, int fd, char* out, size_t cap)
+{
+    eventloop_once(r, 0);
+    int flags = fcntl(fd, F_GETFL);
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+    size_t got = 0;
+    int n;
+    while (got < cap - 1 && (n = read(fd, out + got, cap - 1 - got)) > 0) {
+        got += n;
+    }
+    fcntl(fd, F_SETFL, flags);
+    out[got] = '\0';
+    int cmds = 0;
+    for (size_t i = 0; i < got; i++) {
+        if (out[i] == '*' && (i == 0 || out[i - 1] == '\n')) {
+            cmds++;
+        }
+    }
+    return cmds;
+}
+
+static void send_str(int fd, const char* s)
+{
+    assert(write(fd, s, strlen(s)) == (ssize_t)strlen(s));
+}
+
+static redis_cache_t* setup(reactor_t* r, int* sv, uint64_t max_bytes)
+{
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    redis_conn_t* c = redis_conn_attach(r, sv[0]);
+    redis_cache_t* cc = redis_cache_create(c, max_bytes);
+    char buf[256];
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 2);
+    assert(strstr(buf, "HELLO") && strstr(buf, "TRACKING"));
+    send_str(sv[1], "%1\r\n$5\r\nproto\r\n:3\r\n+OK\r\n");
+    for (int i = 0; i < 100 && !cc->tracking; i++) {
+        eventloop_once(r, 10);
+    }
+    assert(cc->tracking && cc->inflight == 0);
+    return cc;
+}
+
+// 测试用例1：未命中走网络，命中本地同步回调，失效通知后重新取
+void test_hit_and_invalidate() {
+    printf("Test 1: Hit, miss and invalidation\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    redis_cache_t* cc = setup(r, sv, 1024 * 1024);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    char buf[512];
+
+    const char* get[] = { "GET", "k" };
+    const char* hgetall[] = { "HGETALL", "k" };
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get, NULL) == 0);
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, hgetall, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 2);
+    send_str(sv[1], "$3\r\nabc\r\n%1\r\n$1\r\nf\r\n$1\r\nv\r\n");
+    loop_until(r, &res.calls, 2);
+    assert(cc->misses == 2 && cc->hits == 0 && cc->nkeys == 1 && cc->nentries == 2);
+
+    // 命令名大小写不影响命中，命中时不发任何数据
+    const char* get_lower[] = { "get", "k" };
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get_lower, NULL) == 0);
+    assert(res.calls == 3 && res.type == RESP_BULK && strcmp(res.last_str, "abc") == 0);
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, hgetall, NULL) == 0);
+    assert(res.calls == 4 && res.type == RESP_MAP && strcmp(res.last_str, "v") == 0);
+    assert(cc->hits == 2 && drain_commands(r, sv[1], buf, sizeof(buf)) == 0);
+    nested_t nested;
+    memset(&nested, 0, sizeof(nested));
+    nested.cc = cc;
+    assert(redis_cache_command_argv(cc, nested_cb, &nested, 2, get, NULL) == 0);
+    assert(strcmp(nested.outer_str, "abc") == 0 && strcmp(nested.inner.last_str, "v") == 0);
+    assert(cc->hits == 4);
+
+    // 不可缓存的命令照常发送
+    const char* set[] = { "SET", "k", "xyz" };
+    assert(redis_cache_command_argv(cc, record_cb, &res, 3, set, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 1);
+    // 服务器先推送失效再回复 SET，key 上的两条缓存都被删掉
+    send_str(sv[1], ">2\r\n$10\r\ninvalidate\r\n*1\r\n$1\r\nk\r\n+OK\r\n");
+    loop_until(r, &res.calls, 5);
+    assert(cc->invalidations == 1 && cc->nkeys == 0 && cc->nentries == 0 && cc->bytes == 0);
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 1);
+    send_str(sv[1], "$3\r\nxyz\r\n");
+    loop_until(r, &res.calls, 6);
+    assert(strcmp(res.last_str, "xyz") == 0 && cc->misses == 3);
+
+    // FLUSHALL 的失效通知 key 列表为 null，清空全部
+    send_str(sv[1], ">2\r\n$10\r\ninvalidate\r\n_\r\n");
+    for (int i = 0; i < 100 && cc->nkeys > 0; i++) {
+        eventloop_once(r, 10);
+    }
+    assert(cc->nkeys == 0 && cc->bytes == 0);
+
+    redis_conn_t* c = cc->c;
+    redis_cache_free(cc);
+    assert(c->invalidate_fn == NULL);
+    redis_conn_free(c);
+    close(sv[1]);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例2：按字节数限制容量，CLOCK 优先淘汰没有被再次访问的项
+void test_eviction() {
+    printf("Test 2: Size bounded CLOCK eviction\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    // 每条缓存约 100 多字节，容量放得下十几条
+    redis_cache_t* cc = setup(r, sv, 2048);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    char buf[4096];
+
+    for (int i = 0; i < 40; i++) {
+        char key[16];
+        snprintf(key, sizeof(key), "key:%d", i);
+        const char* get[] = { "GET", key };
+        assert(redis_cache_command_argv(cc, record_cb, &res, 2, get, NULL) == 0);
+        assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 1);
+        send_str(sv[1], "$8\r\nvalue...\r\n");
+        loop_until(r, &res.calls, i + 1);
+        assert(cc->bytes <= 2048);
+        // key:0 一直被访问，访问位始终为 1
+        const char* hot[] = { "GET", "key:0" };
+        int hits = cc->hits;
+        assert(redis_cache_command_argv(cc, record_cb, &res, 2, hot, NULL) == 0);
+        assert(cc->hits == (uint64_t)hits + 1);
+        res.calls--;
+    }
+    assert(cc->evictions > 0 && cc->nentries < 40 && cc->nentries == cc->nkeys);
+
+    // 超过容量 1/16 的回复不缓存
+    const char* big[] = { "GET", "big" };
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, big, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 1);
+    char reply[300];
+    int hdr = sprintf(reply, "$200\r\n");
+    memset(reply + hdr, 'x', 200);
+    memcpy(reply + hdr + 200, "\r\n", 2);
+    assert(write(sv[1], reply, hdr + 202) == hdr + 202);
+    int before = res.calls;
+    loop_until(r, &res.calls, before + 1);
+    assert(res.calls == before + 1);
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, big, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 1);
+
+    redis_conn_t* c = cc->c;
+    redis_cache_free(cc);
+    redis_conn_free(c);
+    close(sv[1]);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例3：连接断开时缓存清空，未完成的请求以 NULL 回调；释放 cache 时等在途请求
+void test_disconnect() {
+    printf("Test 3: Disconnect and deferred free\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    redis_cache_t* cc = setup(r, sv, 1024 * 1024);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    char buf[512];
+
+    const char* get[] = { "GET", "k" };
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 1);
+    send_str(sv[1], "$1\r\nv\r\n");
+    loop_until(r, &res.calls, 1);
+    assert(cc->nentries == 1);
+
+    const char* get2[] = { "GET", "k2" };
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get2, NULL) == 0);
+    close(sv[1]);
+    loop_until(r, &res.nulls, 1);
+    assert(res.nulls == 1 && cc->c == NULL && !cc->tracking && cc->nentries == 0);
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get, NULL) == -1);
+    redis_cache_free(cc);
+
+    // 在途请求回来之前释放 cache：回调照常，之后才真正释放
+    cc = setup(r, sv, 1024 * 1024);
+    memset(&res, 0, sizeof(res));
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get, NULL) == 0);
+    redis_conn_t* c = cc->c;
+    redis_cache_free(cc);
+    send_str(sv[1], "$1\r\nv\r\n");
+    loop_until(r, &res.calls, 1);
+    assert(res.calls == 1 && strcmp(res.last_str, "v") == 0);
+    redis_conn_free(c);
+    close(sv[1]);
+    assert(r->nused == 0);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例4：多 key 的 EXISTS 不缓存，另一个 key 变化后结果跟着变；只带一个 key 时照常缓存
+void test_multi_key() {
+    printf("Test 4: Multi-key EXISTS\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    redis_cache_t* cc = setup(r, sv, 1024 * 1024);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    char buf[512];
+
+    const char* exists2[] = { "EXISTS", "a", "b" };
+    assert(redis_cache_command_argv(cc, record_cb, &res, 3, exists2, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 1);
+    send_str(sv[1], ":1\r\n");
+    loop_until(r, &res.calls, 1);
+    assert(res.type == RESP_INTEGER && res.integer == 1 && cc->nentries == 0);
+
+    // b 被别的客户端写入，失效通知只带 b
+    send_str(sv[1], ">2\r\n$10\r\ninvalidate\r\n*1\r\n$1\r\nb\r\n");
+    eventloop_once(r, 10);
+    assert(redis_cache_command_argv(cc, record_cb, &res, 3, exists2, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 1);
+    send_str(sv[1], ":2\r\n");
+    loop_until(r, &res.calls, 2);
+    assert(res.calls == 2 && res.integer == 2 && cc->hits == 0);
+
+    const char* exists1[] = { "EXISTS", "a" };
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, exists1, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 1);
+    send_str(sv[1], ":1\r\n");
+    loop_until(r, &res.calls, 3);
+    assert(cc->nentries == 1);
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, exists1, NULL) == 0);
+    assert(res.calls == 4 && cc->hits == 1 && drain_commands(r, sv[1], buf, sizeof(buf)) == 0);
+
+    redis_conn_t* c = cc->c;
+    redis_cache_free(cc);
+    redis_conn_free(c);
+    close(sv[1]);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例5：经缓存发出的写先删掉本地缓存，不等服务器的失效通知
+void test_write_through_cache() {
+    printf("Test 5: Writes drop local entries\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    redis_cache_t* cc = setup(r, sv, 1024 * 1024);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    char buf[512];
+
+    const char* get[] = { "GET", "k" };
+    const char* get_other[] = { "GET", "o" };
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get, NULL) == 0);
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get_other, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 2);
+    send_str(sv[1], "$3\r\nabc\r\n$3\r\nooo\r\n");
+    loop_until(r, &res.calls, 2);
+    assert(cc->nentries == 2);
+
+    // SET 发出后紧接着 GET，中间没有服务器往返：不能命中旧值
+    const char* set[] = { "SET", "k", "xyz" };
+    assert(redis_cache_command_argv(cc, record_cb, &res, 3, set, NULL) == 0);
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get, NULL) == 0);
+    assert(res.calls == 2 && cc->hits == 0 && cc->nentries == 1);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 2);
+    // 别的 key 不受影响
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get_other, NULL) == 0);
+    assert(res.calls == 3 && cc->hits == 1 && strcmp(res.last_str, "ooo") == 0);
+    send_str(sv[1], ">2\r\n$10\r\ninvalidate\r\n*1\r\n$1\r\nk\r\n+OK\r\n$3\r\nxyz\r\n");
+    loop_until(r, &res.calls, 5);
+    assert(strcmp(res.last_str, "xyz") == 0);
+
+    // 读在途时发出写：读的回复可能是写之前的值，不缓存
+    const char* get2[] = { "GET", "k2" };
+    const char* del[] = { "DEL", "k2" };
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get2, NULL) == 0);
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, del, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 2);
+    uint32_t entries = cc->nentries;
+    send_str(sv[1], "$3\r\nold\r\n:1\r\n");
+    loop_until(r, &res.calls, 7);
+    assert(cc->nentries == entries);
+    assert(redis_cache_command_argv(cc, record_cb, &res, 2, get2, NULL) == 0);
+    assert(drain_commands(r, sv[1], buf, sizeof(buf)) == 1);
+
+    redis_conn_t* c = cc->c;
+    redis_cache_free(cc);
+    redis_conn_free(c);
+    close(sv[1]);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    printf("Starting redis cache tests...\n\n");
+
+    test_hit_and_invalidate();
+    test_eviction();
+    test_disconnect();
+    test_multi_key();
+    test_write_through_cache();
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,722 @@
+#include "redis_client.h"
+#include <stdarg.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+static void _redis_conn_close(redis_conn_t* c);
+
+static void _redis_conn_fail(redis_conn_t* c, const char* err)
+{
+	if (!c->err) {
+		c->err = 1;
+		snprintf(c->errstr, sizeof(c->errstr), "%s", err);
+		printf("redis connection fd = %d error: %s\n", c->fd, err);
+	}
+	if (c->flags & (REDIS_CONN_IN_CALLBACK | REDIS_CONN_FREEING)) {
+		c->flags |= REDIS_CONN_FREEING;
+		return;
+	}
+	_redis_conn_close(c);
+}
+
+// 尽量把输出 buffer 写空，并按是否还有剩余数据开关 EPOLLOUT；写出错返回 -1
+static int _redis_conn_flush(redis_conn_t* c)
+{
+	buffer_t* out = c->e->out;
+	if (c->unflushed && buffer_len(out) > 0) {
+		c->flushes++;
+		c->flushed_cmds += c->unflushed;
+		c->unflushed = 0;
+	}
+	while (buffer_len(out) > 0) {
+		int n = buffer_write_fd(out, c->fd, 0);
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EWOULDBLOCK) {
+				break;
+			}
+			return -1;
+		}
+	}
+	int pending = buffer_len(out) > 0;
+	if (pending != c->writing) {
+		enable_event(c->r, c->e, 1, pending);
+		c->writing = pending;
+	}
+	return 0;
+}
+
+// FIFO 头部是流式命令、且下一条回复属于它（不是 RESP3 推送）时返回 1
+static int _redis_conn_stream_next(redis_conn_t* c, buffer_t* in)
+{
+	if (c->streaming) {
+		return 1;
+	}
+	if (c->cb_count == 0 || !c->cbs[c->cb_head].stream) {
+		return 0;
+	}
+	// reader 里有半条回复（推送消息）时先让它收完
+	resp_parser_t* p = &c->reader.parser;
+	if (c->reader.ready || p->depth > 0) {
+		return 0;
+	}
+	int type = resp_parser_peek_type(p, in);
+	if (type < 0 || type == RESP_PUSH) {
+		return 0;
+	}
+	c->streaming = 1;
+	return 1;
+}
+
+// 流式分发：每个值回调之后立刻 drain，大 bulk 收到多少放掉多少
+static int _redis_conn_stream(redis_conn_t* c, buffer_t* in)
+{
+	resp_parser_t* p = &c->reader.parser;
+	redis_cb_t cb = c->cbs[c->cb_head];
+	resp_value_t v;
+	int ret;
+	p->stream_min = REDIS_STREAM_BULK_MIN;
+	while (!(c->flags & REDIS_CONN_FREEING) && (ret = resp_parser_next(p, in, &v)) == RESP_VALUE) {
+		int last = resp_parser_reply_done(p);
+		if (last) {
+			c->cb_head = (c->cb_head + 1) & (c->cb_cap - 1);
+			c->cb_count--;
+			c->streaming = 0;
+			p->stream_min = 0;
+		}
+		cb.stream(c, &v, last, cb.privdata);
+		resp_parser_consume(p, in);
+		if (last) {
+			return RESP_VALUE;
+		}
+	}
+	return (c->flags & REDIS_CONN_FREEING) ? RESP_AGAIN : ret;
+}
+
+// 分发所有完整的回复，连接在此期间被释放时返回 -1
+static int _redis_conn_dispatch(redis_conn_t* c)
+{
+	buffer_t* in = c->e->in;
+	resp_reply_t* reply;
+	int ret = RESP_AGAIN;
+	c->flags |= REDIS_CONN_IN_CALLBACK;
+	while (!(c->flags & REDIS_CONN_FREEING)) {
+		if (_redis_conn_stream_next(c, in)) {
+			if ((ret = _redis_conn_stream(c, in)) != RESP_VALUE) {
+				break;
+			}
+			continue;
+		}
+		if ((ret = resp_reader_next(&c->reader, in, &reply)) != RESP_VALUE) {
+			break;
+		}
+		if (reply->type == RESP_PUSH) {
+			// 推送消息不对应任何命令，不占用 FIFO
+			if (c->invalidate_fn && reply->elements == 2 && resp_view_eq(&reply->element[0].str, "invalidate", 10)) {
+				c->invalidate_fn(c, reply, c->invalidate_data);
+			}
+			else if (c->push_fn) {
+				c->push_fn(c, reply, c->data);
+			}
+		}
+		else if (c->cb_count == 0) {
+			_redis_conn_fail(c, "unexpected reply");
+		}
+		else {
+			redis_cb_t cb = c->cbs[c->cb_head];
+			c->cb_head = (c->cb_head + 1) & (c->cb_cap - 1);
+			c->cb_count--;
+			if (cb.fn) {
+				cb.fn(c, reply, cb.privdata);
+			}
+		}
+		resp_reader_consume(&c->reader, in);
+	}
+	c->flags &= ~REDIS_CONN_IN_CALLBACK;
+	if (ret == RESP_ERR) {
+		_redis_conn_fail(c, "protocol error");
+		return -1;
+	}
+	if (c->flags & REDIS_CONN_FREEING) {
+		_redis_conn_close(c);
+		return -1;
+	}
+	return 0;
+}
+
+static void _redis_conn_read_cb(int fd, int events, void* privdata)
+{
+	event_t* e = (event_t*)privdata;
+	redis_conn_t* c = (redis_conn_t*)e->priv;
+	if (c->flags & REDIS_CONN_CONNECTING) {
+		// 连接结果由写事件处理
+		return;
+	}
+	buffer_t* in = evbuf_in(e);
+	uint32_t budget = c->r->read_budget;
+	uint32_t num = 0;
+	while (1) {
+		if (budget && num >= budget) {
+			// 回复很大时分几轮读，不让一个连接占满整轮
+			event_requeue(e, EPOLLIN);
+			break;
+		}
+		int n = buffer_read_fd(in, fd, budget ? budget - num : 0);
+		if (n == 0) {
+			_redis_conn_fail(c, "connection closed by server");
+			return;
+		}
+		if (n < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if (errno == EWOULDBLOCK || errno == ENOBUFS) {
+				break;
+			}
+			_redis_conn_fail(c, strerror(errno));
+			return;
+		}
+		num += n;
+		if (n < BUFFER_MAX_READ && (!budget || num < budget)) {
+			// 没读满说明内核缓冲区已经读空，省掉一次返回 EAGAIN 的 read
+			break;
+		}
+	}
+	if (_redis_conn_dispatch(c) < 0) {
+		return;
+	}
+	if (buffer_len(e->in) >= BUFFER_CHAIN_MAX) {
+		_redis_conn_fail(c, "reply too large");
+	}
+}
+
+static void _redis_conn_write_cb(int fd, int events, void* privdata)
+{
+	event_t* e = (event_t*)privdata;
+	redis_conn_t* c = (redis_conn_t*)e->priv;
+	if (c->flags & REDIS_CONN_CONNECTING) {
+		int err = 0;
+		socklen_t len = sizeof(err);
+		if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) < 0) {
+			err = errno;
+		}
+		if (err) {
+			_redis_conn_fail(c, strerror(err));
+			return;
+		}
+		c->flags = (c->flags & ~REDIS_CONN_CONNECTING) | REDIS_CONN_CONNECTED;
+		if (c->connect_fn) {
+			c->flags |= REDIS_CONN_IN_CALLBACK;
+			c->connect_fn(c, 0);
+			c->flags &= ~REDIS_CONN_IN_CALLBACK;
+			if (c->flags & REDIS_CONN_FREEING) {
+				_redis_conn_close(c);
+				return;
+			}
+		}
+	}
+	if (_redis_conn_flush(c) < 0) {
+		_redis_conn_fail(c, strerror(errno));
+	}
+}
+
+static redis_conn_t* _redis_conn_new(reactor_t* r, int fd)
+{
+	redis_conn_t* c = (redis_conn_t*)calloc(1, sizeof(redis_conn_t));
+	if (!c) {
+		return NULL;
+	}
+	c->cbs = (redis_cb_t*)malloc(sizeof(redis_cb_t) * REDIS_CONN_CB_INIT);
+	c->e = new_event(r, fd, _redis_conn_read_cb, _redis_conn_write_cb, NULL);
+	if (!c->cbs || !c->e) {
+		if (c->e) {
+			free_event(c->e);
+		}
+		free(c->cbs);
+		free(c);
+		return NULL;
+	}
+	c->r = r;
+	c->fd = fd;
+	c->cb_cap = REDIS_CONN_CB_INIT;
+	c->e->priv = c;
+	atomic_init(&c->refs, 1);
+	resp_reader_init(&c->reader);
+	return c;
+}
+
+redis_conn_t* redis_connect(reactor_t* r, const char* host, int port)
+{
+	struct sockaddr_in addr;
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+		printf("redis connect error: invalid address %s\n", host);
+		return NULL;
+	}
+
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		printf("redis connect error: %s\n", strerror(errno));
+		return NULL;
+	}
+	int one = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+	set_nonblock(fd);
+	if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+		printf("redis connect %s:%d error: %s\n", host, port, strerror(errno));
+		close(fd);
+		return NULL;
+	}
+
+	redis_conn_t* c = _redis_conn_new(r, fd);
+	if (!c) {
+		close(fd);
+		return NULL;
+	}
+	// 连接结果统一在写事件中确认，连接期间发出的命令先攒在输出 buffer 里
+	c->flags = REDIS_CONN_CONNECTING;
+	c->writing = 1;
+	add_event(r, EPOLLIN | EPOLLOUT, c->e);
+	return c;
+}
+
+redis_conn_t* redis_conn_attach(reactor_t* r, int fd)
+{
+	set_nonblock(fd);
+	redis_conn_t* c = _redis_conn_new(r, fd);
+	if (!c) {
+		return NULL;
+	}
+	c->flags = REDIS_CONN_CONNECTED;
+	add_event(r, EPOLLIN, c->e);
+	return c;
+}
+
+static void _redis_conn_close(redis_conn_t* c)
+{
+	int status = c->err ? -1 : 0;
+	int connected = c->flags & REDIS_CONN_CONNECTED;
+	c->flags |= REDIS_CONN_FREEING;
+
+	del_event(c->r, c->e);
+	close(c->fd);
+	c->e = NULL;
+	resp_reader_reset(&c->reader);
+	if (c->invalidate_fn) {
+		// 连接断开后收不到失效通知了
+		c->invalidate_fn(c, NULL, c->invalidate_data);
+	}
+
+	while (c->cb_count > 0) {
+		redis_cb_t cb = c->cbs[c->cb_head];
+		c->cb_head = (c->cb_head + 1) & (c->cb_cap - 1);
+		c->cb_count--;
+		if (cb.stream) {
+			cb.stream(c, NULL, 1, cb.privdata);
+		}
+		else if (cb.fn) {
+			cb.fn(c, NULL, cb.privdata);
+		}
+	}
+	c->streaming = 0;
+	if (connected) {
+		if (c->disconnect_fn) {
+			c->disconnect_fn(c, status);
+		}
+	}
+	else if (c->connect_fn) {
+		c->connect_fn(c, -1);
+	}
+	free(c->cbs);
+	c->cbs = NULL;
+	// 其他线程可能还拿着引用，结构体留给最后一个引用释放
+	redis_conn_release(c);
+}
+
+void redis_conn_retain(redis_conn_t* c)
+{
+	atomic_fetch_add(&c->refs, 1);
+}
+
+void redis_conn_release(redis_conn_t* c)
+{
+	if (atomic_fetch_sub(&c->refs, 1) == 1) {
+		free(c);
+	}
+}
+
+void redis_conn_free(redis_conn_t* c)
+{
+	if (c->flags & (REDIS_CONN_IN_CALLBACK | REDIS_CONN_FREEING)) {
+		c->flags |= REDIS_CONN_FREEING;
+		return;
+	}
+	_redis_conn_close(c);
+}
+
+static int _redis_conn_push_cb(redis_conn_t* c, redis_reply_fn fn, redis_stream_fn stream, void* privdata)
+{
+	if (c->cb_count == c->cb_cap) {
+		// 扩容时把环展开成从 0 开始的连续数组
+		redis_cb_t* cbs = (redis_cb_t*)malloc(sizeof(redis_cb_t) * c->cb_cap * 2);
+		if (!cbs) {
+			return -1;
+		}
+		for (uint32_t i = 0; i < c->cb_count; i++) {
+			cbs[i] = c->cbs[(c->cb_head + i) & (c->cb_cap - 1)];
+		}
+		free(c->cbs);
+		c->cbs = cbs;
+		c->cb_head = 0;
+		c->cb_cap *= 2;
+	}
+	redis_cb_t* cb = &c->cbs[(c->cb_head + c->cb_count) & (c->cb_cap - 1)];
+	cb->fn = fn;
+	cb->stream = stream;
+	cb->privdata = privdata;
+	c->cb_count++;
+	return 0;
+}
+
+static void _redis_conn_deferred_cb(event_t* e)
+{
+	redis_conn_t* c = (redis_conn_t*)e->priv;
+	if (c->writing || !(c->flags & REDIS_CONN_CONNECTED)) {
+		// socket 写满或还在连接中，剩下的交给写事件
+		return;
+	}
+	if (_redis_conn_flush(c) < 0) {
+		_redis_conn_fail(c, strerror(errno));
+	}
+}
+
+void redis_conn_set_pipelining(redis_conn_t* c, int on)
+{
+	c->pipelining = on;
+}
+
+// 命令已经追加到输出 buffer：pipeline 模式登记延迟 flush，否则输出 buffer 原本为空时立即尝试写出
+static void _redis_conn_commit(redis_conn_t* c, uint32_t before)
+{
+	c->unflushed++;
+	if (c->pipelining) {
+		event_defer_flush(c->e, _redis_conn_deferred_cb);
+		return;
+	}
+	if (before > 0 || c->writing || !(c->flags & REDIS_CONN_CONNECTED)) {
+		return;
+	}
+	if (_redis_conn_flush(c) < 0) {
+		// 这里不释放连接，打开 EPOLLOUT 让写事件里再次出错时统一处理
+		enable_event(c->r, c->e, 1, 1);
+		c->writing = 1;
+	}
+}
+
+// 十进制位数
+static inline int _resp_digits(uint64_t v)
+{
+	int n = 1;
+	while (v >= 10) {
+		v /= 10;
+		n++;
+	}
+	return n;
+}
+
+// 写出 "<type><len>\r\n"，返回写完后的位置
+static char* _resp_put_len(char* p, char type, uint64_t v)
+{
+	char tmp[20];
+	int n = 0;
+	do {
+		tmp[n++] = '0' + v % 10;
+		v /= 10;
+	} while (v);
+	*p++ = type;
+	while (n) {
+		*p++ = tmp[--n];
+	}
+	*p++ = '\r';
+	*p++ = '\n';
+	return p;
+}
+
+// 编码后的精确长度
+static uint64_t _resp_command_len(int argc, const char** argv, const size_t* argvlen)
+{
+	uint64_t total = 1 + _resp_digits(argc) + 2;
+	for (int i = 0; i < argc; i++) {
+		size_t len = argvlen ? argvlen[i] : strlen(argv[i]);
+		total += 1 + _resp_digits(len) + 2 + len + 2;
+	}
+	return total;
+}
+
+// 按 RESP 数组编码到 p，空间由调用方按 _resp_command_len 准备好
+static void _resp_encode_command(char* p, int argc, const char** argv, const size_t* argvlen)
+{
+	p = _resp_put_len(p, '*', argc);
+	for (int i = 0; i < argc; i++) {
+		size_t len = argvlen ? argvlen[i] : strlen(argv[i]);
+		p = _resp_put_len(p, '$', len);
+		memcpy(p, argv[i], len);
+		p += len;
+		*p++ = '\r';
+		*p++ = '\n';
+	}
+}
+
+static int _redis_conn_command_argv(redis_conn_t* c, redis_reply_fn fn, redis_stream_fn stream, void* privdata, int argc, const char** argv, const size_t* argvlen)
+{
+	if (c->err || (c->flags & REDIS_CONN_FREEING) || argc <= 0) {
+		return -1;
+	}
+	buffer_t* out = evbuf_out(c->e);
+	uint32_t before = buffer_len(out);
+
+	// 先算出编码后的精确长度，放不下时整条命令都不写，避免输出流里留下半条命令
+	uint64_t total = _resp_command_len(argc, argv, argvlen);
+	// 直接编码进输出 buffer 的连续空间，不经过临时缓冲区
+	struct iovec vec;
+	if (total > BUFFER_CHAIN_MAX - before || buffer_reserve(out, (uint32_t)total, &vec, 1) < 0) {
+		return -1;
+	}
+	if (_redis_conn_push_cb(c, fn, stream, privdata) < 0) {
+		buffer_commit(out, 0);
+		return -1;
+	}
+	_resp_encode_command((char*)vec.iov_base, argc, argv, argvlen);
+	buffer_commit(out, (uint32_t)total);
+	_redis_conn_commit(c, before);
+	return 0;
+}
+
+int redis_conn_command_argv(redis_conn_t* c, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen)
+{
+	return _redis_conn_command_argv(c, fn, NULL, privdata, argc, argv, argvlen);
+}
+
+int redis_conn_stream_argv(redis_conn_t* c, redis_stream_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen)
+{
+	if (!fn) {
+		return -1;
+	}
+	return _redis_conn_command_argv(c, NULL, fn, privdata, argc, argv, argvlen);
+}
+
+int redis_conn_copy_reply(redis_conn_t* c, buffer_t* dst)
+{
+	// 每条回复分发完就 drain，当前回复总是从输入 buffer 的起点开始
+	resp_view_t v = { c->e->in->first, 0, c->reader.parser.pos };
+	struct iovec vec;
+	if (v.len == 0 || buffer_reserve(dst, v.len, &vec, 1) < 0) {
+		return -1;
+	}
+	resp_view_copy(&v, vec.iov_base, v.len);
+	return buffer_commit(dst, v.len);
+}
+
+// -------------------------- 跨线程投递 --------------------------
+// 调用方线程里编码好的命令，到 reactor 线程后只剩一次拷贝
+typedef struct {
+	redis_conn_t* c;
+	redis_reply_fn fn;
+	void* privdata;
+	uint32_t len;
+	char data[];
+} redis_post_t;
+
+static void _redis_conn_post_task(reactor_t* r, void* arg)
+{
+	redis_post_t* t = (redis_post_t*)arg;
+	redis_conn_t* c = t->c;
+	struct iovec vec;
+	if (c->err || (c->flags & REDIS_CONN_FREEING)) {
+		goto fail;
+	}
+	buffer_t* out = evbuf_out(c->e);
+	uint32_t before = buffer_len(out);
+	if (t->len > BUFFER_CHAIN_MAX - before || buffer_reserve(out, t->len, &vec, 1) < 0) {
+		goto fail;
+	}
+	if (_redis_conn_push_cb(c, t->fn, NULL, t->privdata) < 0) {
+		buffer_commit(out, 0);
+		goto fail;
+	}
+	memcpy(vec.iov_base, t->data, t->len);
+	buffer_commit(out, t->len);
+	free(t);
+	_redis_conn_commit(c, before);
+	redis_conn_release(c);
+	return;
+
+fail:
+	if (t->fn) {
+		t->fn(c, NULL, t->privdata);
+	}
+	free(t);
+	redis_conn_release(c);
+}
+
+int redis_conn_post_command_argv(redis_conn_t* c, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen)
+{
+	if (argc <= 0) {
+		return -1;
+	}
+	uint64_t total = _resp_command_len(argc, argv, argvlen);
+	if (total > BUFFER_CHAIN_MAX) {
+		return -1;
+	}
+	redis_post_t* t = (redis_post_t*)malloc(sizeof(redis_post_t) + total);
+	if (!t) {
+		return -1;
+	}
+	t->c = c;
+	t->fn = fn;
+	t->privdata = privdata;
+	t->len = (uint32_t)total;
+	_resp_encode_command(t->data, argc, argv, argvlen);
+	// 任务自己占一个引用，调用方在任务执行之前放掉引用也没关系
+	redis_conn_retain(c);
+	if (reactor_post(c->r, _redis_conn_post_task, t) < 0) {
+		redis_conn_release(c);
+		free(t);
+		return -1;
+	}
+	return 0;
+}
+
+// -------------------------- 格式化命令 --------------------------
+typedef struct {
+	char* data; //所有参数依次拼接
+	size_t len;
+	size_t cap;
+	size_t* lens;
+	int argc;
+	int maxargc;
+} redis_fmt_t;
+
+static int _fmt_append(redis_fmt_t* f, const void* p, size_t len)
+{
+	if (f->len + len > f->cap) {
+		size_t cap = f->cap ? f->cap : 256;
+		while (cap < f->len + len) {
+			cap <<= 1;
+		}
+		char* data = (char*)realloc(f->data, cap);
+		if (!data) {
+			return -1;
+		}
+		f->data = data;
+		f->cap = cap;
+	}
+	memcpy(f->data + f->len, p, len);
+	f->len += len;
+	return 0;
+}
+
+static int _fmt_end_arg(redis_fmt_t* f, size_t start)
+{
+	if (f->argc == f->maxargc) {
+		int maxargc = f->maxargc ? f->maxargc * 2 : 8;
+		size_t* lens = (size_t*)realloc(f->lens, sizeof(size_t) * maxargc);
+		if (!lens) {
+			return -1;
+		}
+		f->lens = lens;
+		f->maxargc = maxargc;
+	}
+	f->lens[f->argc++] = f->len - start;
+	return 0;
+}
+
+static int _redis_format(redis_fmt_t* f, const char* fmt, va_list ap)
+{
+	size_t start = 0;
+	int touched = 0; //当前参数是否已经有内容（%s 展开成空串也算一个参数）
+	char num[32];
+	for (const char* p = fmt; *p; p++) {
+		int ret = 0;
+		if (*p == ' ') {
+			if (touched) {
+				ret = _fmt_end_arg(f, start);
+				touched = 0;
+			}
+			start = f->len;
+		}
+		else if (*p != '%' || p[1] == '\0') {
+			ret = _fmt_append(f, p, 1);
+			touched = 1;
+		}
+		else {
+			p++;
+			touched = 1;
+			if (*p == 's') {
+				const char* s = va_arg(ap, const char*);
+				ret = _fmt_append(f, s, strlen(s));
+			}
+			else if (*p == 'b') {
+				const void* b = va_arg(ap, const void*);
+				size_t len = va_arg(ap, size_t);
+				ret = _fmt_append(f, b, len);
+			}
+			else if (*p == 'd') {
+				int n = snprintf(num, sizeof(num), "%d", va_arg(ap, int));
+				ret = _fmt_append(f, num, n);
+			}
+			else if (strncmp(p, "lld", 3) == 0) {
+				int n = snprintf(num, sizeof(num), "%lld", va_arg(ap, long long));
+				ret = _fmt_append(f, num, n);
+				p += 2;
+			}
+			else if (*p == '%') {
+				ret = _fmt_append(f, "%", 1);
+			}
+			else {
+				printf("redis format error: unsupported %%%c\n", *p);
+				return -1;
+			}
+		}
+		if (ret < 0) {
+			return -1;
+		}
+	}
+	if (touched && _fmt_end_arg(f, start) < 0) {
+		return -1;
+	}
+	return 0;
+}
+
+int redis_conn_command(redis_conn_t* c, redis_reply_fn fn, void* privdata, const char* fmt, ...)
+{
+	redis_fmt_t f;
+	memset(&f, 0, sizeof(f));
+	va_list ap;
+	va_start(ap, fmt);
+	int ret = _redis_format(&f, fmt, ap);
+	va_end(ap);
+
+	if (ret == 0) {
+		const char** argv = (const char**)malloc(sizeof(char*) * (f.argc ? f.argc : 1));
+		if (!argv) {
+			ret = -1;
+		}
+		else {
+			size_t off = 0;
+			for (int i = 0; i < f.argc; i++) {
+				argv[i] = f.data + off;
+				off += f.lens[i];
+			}
+			ret = redis_conn_command_argv(c, fn, privdata, f.argc, argv, f.lens);
+			free(argv);
+		}
+	}
+	free(f.data);
+	free(f.lens);
+	return ret;
+}
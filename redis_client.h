@@ -0,0 +1,103 @@
+#ifndef __REDIS_CLIENT_H__
+#define __REDIS_CLIENT_H__
+
+#include "reactor.h"
+#include "resp/resp_parser.h"
+
+// 直接建在 event_t 上的异步 redis 连接：命令编码后直接追加到 e->out，
+// 回复在 e->in 上增量解析，回调按发送顺序放在 FIFO 中；
+// 只有输出 buffer 中有数据没写完时才打开 EPOLLOUT。
+
+#define REDIS_CONN_CB_INIT	64 //回调 FIFO 的初始容量，满了按 2 倍扩容
+#define REDIS_STREAM_BULK_MIN	(64 * 1024) //流式命令的回复中，达到这个长度的 bulk 分块回调
+
+typedef struct redis_conn_s redis_conn_t;
+typedef struct redis_cb_s redis_cb_t;
+
+// reply 为 NULL 表示连接已经断开，命令没有拿到回复；reply 只在回调期间有效
+typedef void (*redis_reply_fn)(redis_conn_t* c, resp_reply_t* reply, void* privdata);
+// 流式回复：一条回复按解析顺序拆成若干个值逐个回调（聚合类型先回调头部，再回调子元素），
+// 大 bulk 按到达的数据分块回调（v->chunk 非 0），v->str 直接指向输入 buffer，只在回调期间有效；
+// last 为 1 表示这是本条回复的最后一次回调。v 为 NULL 表示连接已经断开，回复不完整
+typedef void (*redis_stream_fn)(redis_conn_t* c, const resp_value_t* v, int last, void* privdata);
+// status 为 0 表示成功，-1 表示出错
+typedef void (*redis_conn_fn)(redis_conn_t* c, int status);
+
+enum {
+	REDIS_CONN_CONNECTING = 1,
+	REDIS_CONN_CONNECTED = 2,
+	REDIS_CONN_IN_CALLBACK = 4, //正在分发回复，期间的释放请求推迟到分发结束
+	REDIS_CONN_FREEING = 8,
+};
+
+struct redis_cb_s
+{
+	redis_reply_fn fn;
+	redis_stream_fn stream; //非 NULL 时为流式命令，fn 不使用
+	void* privdata;
+};
+
+struct redis_conn_s
+{
+	reactor_t* r;
+	event_t* e;
+	int fd;
+	int flags;
+	int writing; //当前是否注册了 EPOLLOUT
+	int streaming; //FIFO 头部的流式命令已经开始收到回复
+	int err;
+	char errstr[128];
+	resp_reader_t reader;
+	redis_cb_t* cbs; //等待回复的回调，环形 FIFO
+	uint32_t cb_head;
+	uint32_t cb_count;
+	uint32_t cb_cap;
+	redis_conn_fn connect_fn; //连接建立（或失败）时调用
+	redis_conn_fn disconnect_fn; //已建立的连接断开时调用
+	redis_reply_fn push_fn; //RESP3 推送消息，privdata 为 data
+	redis_reply_fn invalidate_fn; //client tracking 的 invalidate 推送（不再交给 push_fn），连接关闭时以 reply == NULL 调用一次
+	void* invalidate_data;
+	void* data;
+	int pipelining; //自动 pipeline：命令先攒在输出 buffer，本轮 eventloop 结束前一次写出
+	uint32_t unflushed; //已进入输出 buffer、还没有随 flush 写出的命令数
+	uint64_t flushes; //写出过数据的 flush 次数
+	uint64_t flushed_cmds; //随 flush 写出的命令总数，flushed_cmds / flushes 即每次 flush 的命令数
+	_Atomic uint32_t refs; //连接本身占一个，关闭时放掉；其他线程的 redis_conn_retain 和每个还没执行的投递各占一个
+};
+
+// 非阻塞连接 host（IPv4 地址）:port，连接结果通过 connect_fn 通知
+redis_conn_t* redis_connect(reactor_t* r, const char* host, int port);
+
+// 接管一个已经连接好的 fd
+redis_conn_t* redis_conn_attach(reactor_t* r, int fd);
+
+// 断开连接，未收到回复的回调以 reply == NULL 调用一次
+void redis_conn_free(redis_conn_t* c);
+
+// 打开后同一轮 eventloop_once 中发出的所有命令合并成一次 writev
+void redis_conn_set_pipelining(redis_conn_t* c, int on);
+
+// argvlen 为 NULL 时按 strlen 计算参数长度，成功返回 0
+int redis_conn_command_argv(redis_conn_t* c, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen);
+
+// 和 redis_conn_command_argv 一样发送命令，回复以流式回调交付，值不需要整条驻留在内存里；
+// 适合大 value 的 GET、元素很多的 LRANGE/HGETALL 等
+int redis_conn_stream_argv(redis_conn_t* c, redis_stream_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen);
+
+// 只能在回复回调里调用：把当前回复的原始 RESP 编码追加到 dst，成功返回 0
+int redis_conn_copy_reply(redis_conn_t* c, buffer_t* dst);
+
+// 线程安全：在调用方线程编码好命令，投递到连接所在的 reactor 线程发出，回调也在 reactor 线程执行；
+// 连接已经关闭时回调以 reply == NULL 调用。调用方必须持有一个引用（见 redis_conn_retain）。成功返回 0
+int redis_conn_post_command_argv(redis_conn_t* c, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen);
+
+// 线程安全的引用计数：要从其他线程投递命令时，在连接肯定还活着的时候（比如在 reactor 线程里）先 retain，
+// 不再投递后 release。连接关闭后结构体一直留到最后一个引用放掉，期间的投递都以 NULL 回调
+void redis_conn_retain(redis_conn_t* c);
+
+void redis_conn_release(redis_conn_t* c);
+
+// 以空格分隔参数，支持 %s %b（指针 + size_t 长度）%d %lld %%
+int redis_conn_command(redis_conn_t* c, redis_reply_fn fn, void* privdata, const char* fmt, ...);
+
+#endif
@@ -0,0 +1,587 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <pthread.h>
+#include "redis_client.h"
+
+// 编译: gcc reactor.c reactor_uring.c ringbuffer/ringbuffer.c ringbuffer/mpmc_ring.c chainbuffer/chainbuffer.c memsearch/memsearch.c timewheel/timewheel.c resp/resp_parser.c redis_client.c redis_client_test.c -o redis_client_test -lpthread
+// 用 socketpair 的另一端扮演 redis 服务器，不依赖真实的 redis
+
+typedef struct {
+    int calls;
+    int nulls;
+    long long last_int;
+    char last_str[64];
+    int order[512];
+} result_t;
+
+static void record_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    result_t* res = (result_t*)c->data;
+    if (!reply) {
+        res->nulls++;
+        return;
+    }
+    res->order[res->calls++] = (int)(long)privdata;
+    res->last_int = reply->integer;
+    res->last_str[0] = '\0';
+    if (reply->type == RESP_STRING || reply->type == RESP_BULK) {
+        uint32_t n = resp_view_copy(&reply->str, res->last_str, sizeof(res->last_str) - 1);
+        res->last_str[n] = '\0';
+    }
+}
+
+static int g_disconnects = 0;
+static int g_disconnect_status = 0;
+
+static void disconnect_cb(redis_conn_t* c, int status)
+{
+    g_disconnects++;
+    g_disconnect_status = status;
+}
+
+static void read_exact(int fd, char* buf, size_t len)
+{
+    size_t got = 0;
+    while (got < len) {
+        int n = read(fd, buf + got, len - got);
+        assert(n > 0);
+        got += n;
+    }
+    buf[len] = '\0';
+}
+
+static void loop_until(reactor_t* r, int* counter, int expect)
+{
+    for (int i = 0; i < 1000 && *counter < expect; i++) {
+        eventloop_once(r, 10);
+    }
+}
+
+// 测试用例1：命令编码与回调顺序
+void test_encode_and_fifo() {
+    printf("Test 1: Command encoding and FIFO\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    redis_conn_t* c = redis_conn_attach(r, sv[0]);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    c->data = &res;
+
+    const char* argv[] = { "SET", "k", "hello world" };
+    assert(redis_conn_command_argv(c, record_cb, (void*)1, 3, argv, NULL) == 0);
+    assert(redis_conn_command(c, record_cb, (void*)2, "GET %s", "k") == 0);
+    assert(redis_conn_command(c, record_cb, (void*)3, "INCRBY key:%d %lld", 7, 100LL) == 0);
+    assert(redis_conn_command(c, record_cb, (void*)4, "SET %b %s", "a b", (size_t)3, "") == 0);
+    // 输出 buffer 为空时直接写出，不注册 EPOLLOUT
+    assert(c->writing == 0 && c->cb_count == 4);
+
+    const char* expect =
+        "*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$11\r\nhello world\r\n"
+        "*2\r\n$3\r\nGET\r\n$1\r\nk\r\n"
+        "*3\r\n$6\r\nINCRBY\r\n$5\r\nkey:7\r\n$3\r\n100\r\n"
+        "*3\r\n$3\r\nSET\r\n$3\r\na b\r\n$0\r\n\r\n";
+    char got[512];
+    read_exact(sv[1], got, strlen(expect));
+    assert(strcmp(got, expect) == 0);
+
+    // 回复分两次到达，第二个 bulk 被拆开
+    const char* part1 = "+OK\r\n$11\r\nhello";
+    const char* part2 = " world\r\n:107\r\n+OK\r\n";
+    assert(write(sv[1], part1, strlen(part1)) == (int)strlen(part1));
+    loop_until(r, &res.calls, 1);
+    assert(res.calls == 1 && strcmp(res.last_str, "OK") == 0);
+    assert(write(sv[1], part2, strlen(part2)) == (int)strlen(part2));
+    loop_until(r, &res.calls, 4);
+    assert(res.calls == 4);
+    for (int i = 0; i < 4; i++) {
+        assert(res.order[i] == i + 1);
+    }
+    assert(res.last_int == 0 && strcmp(res.last_str, "OK") == 0);
+    assert(c->cb_count == 0);
+
+    redis_conn_free(c);
+    assert(res.nulls == 0);
+    close(sv[1]);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例2：FIFO 扩容与大量 pipeline
+void test_deep_pipeline() {
+    printf("Test 2: Deep pipeline\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    redis_conn_t* c = redis_conn_attach(r, sv[0]);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    c->data = &res;
+
+    int n = 300;
+    for (int i = 0; i < n; i++) {
+        assert(redis_conn_command(c, record_cb, (void*)(long)i, "INCR n") == 0);
+    }
+    assert(c->cb_cap >= (uint32_t)n);
+    buffer_t* replies = buffer_new(0);
+    for (int i = 0; i < n; i++) {
+        char line[32];
+        int len = snprintf(line, sizeof(line), ":%d\r\n", i);
+        buffer_add(replies, line, len);
+    }
+    int total = buffer_len(replies);
+    assert(write(sv[1], buffer_write_atmost(replies), total) == total);
+    buffer_free(replies);
+
+    loop_until(r, &res.calls, n);
+    assert(res.calls == n && res.last_int == n - 1);
+    for (int i = 0; i < n; i++) {
+        assert(res.order[i] == i);
+    }
+
+    redis_conn_free(c);
+    close(sv[1]);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例3：只有写不完时才打开 EPOLLOUT
+void test_writable_only_when_pending() {
+    printf("Test 3: EPOLLOUT only while output pending\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    redis_conn_t* c = redis_conn_attach(r, sv[0]);
+
+    size_t size = 1024 * 1024;
+    char* big = malloc(size);
+    memset(big, 'x', size);
+    const char* argv[] = { "SET", "big", big };
+    size_t lens[] = { 3, 3, size };
+    assert(redis_conn_command_argv(c, NULL, NULL, 3, argv, lens) == 0);
+    // socket 缓冲区放不下 1MB，剩余部分留在输出 buffer 中并打开 EPOLLOUT
+    assert(c->writing == 1 && buffer_len(c->e->out) > 0);
+
+    char* sink = malloc(size + 64);
+    size_t drained = 0;
+    while (c->writing) {
+        int m = recv(sv[1], sink, size + 64, MSG_DONTWAIT);
+        if (m > 0) {
+            drained += m;
+        }
+        eventloop_once(r, 10);
+    }
+    assert(c->writing == 0 && buffer_len(c->e->out) == 0);
+    while (1) {
+        int m = recv(sv[1], sink, size + 64, MSG_DONTWAIT);
+        if (m <= 0) {
+            break;
+        }
+        drained += m;
+    }
+    assert(drained == size + strlen("*3\r\n$3\r\nSET\r\n$3\r\nbig\r\n$1048576\r\n\r\n"));
+
+    free(big);
+    free(sink);
+    redis_conn_free(c);
+    close(sv[1]);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例4：服务端断开时未完成的回调收到 NULL
+void test_disconnect() {
+    printf("Test 4: Disconnect fails pending callbacks\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    redis_conn_t* c = redis_conn_attach(r, sv[0]);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    c->data = &res;
+    c->disconnect_fn = disconnect_cb;
+    g_disconnects = 0;
+
+    for (int i = 0; i < 3; i++) {
+        assert(redis_conn_command(c, record_cb, (void*)(long)i, "GET k") == 0);
+    }
+    assert(write(sv[1], "$1\r\nv\r\n$2\r\n", 11) == 11);
+    close(sv[1]);
+    loop_until(r, &g_disconnects, 1);
+    assert(res.calls == 1 && res.nulls == 2);
+    assert(g_disconnects == 1 && g_disconnect_status == -1);
+    assert(r->nused == 0);
+
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例5：回调中释放连接
+static void free_in_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    result_t* res = (result_t*)c->data;
+    if (reply) {
+        res->calls++;
+        redis_conn_free(c);
+        // 释放推迟到分发结束，之后的命令直接失败
+        assert(redis_conn_command(c, NULL, NULL, "PING") == -1);
+    }
+    else {
+        res->nulls++;
+    }
+}
+
+void test_free_in_callback() {
+    printf("Test 5: Free inside callback\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    redis_conn_t* c = redis_conn_attach(r, sv[0]);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    c->data = &res;
+    c->disconnect_fn = disconnect_cb;
+    g_disconnects = 0;
+
+    assert(redis_conn_command(c, free_in_cb, NULL, "PING") == 0);
+    assert(redis_conn_command(c, free_in_cb, NULL, "PING") == 0);
+    assert(write(sv[1], "+PONG\r\n+PONG\r\n", 14) == 14);
+    loop_until(r, &g_disconnects, 1);
+    assert(res.calls == 1 && res.nulls == 1);
+    assert(g_disconnects == 1 && g_disconnect_status == 0);
+
+    close(sv[1]);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例6：协议错误关闭连接
+void test_protocol_error() {
+    printf("Test 6: Protocol error\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    redis_conn_t* c = redis_conn_attach(r, sv[0]);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    c->data = &res;
+    c->disconnect_fn = disconnect_cb;
+    g_disconnects = 0;
+
+    assert(redis_conn_command(c, record_cb, NULL, "GET k") == 0);
+    assert(write(sv[1], "?oops\r\n", 7) == 7);
+    loop_until(r, &g_disconnects, 1);
+    assert(g_disconnects == 1 && res.nulls == 1);
+
+    close(sv[1]);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例7：自动 pipeline，一轮中的命令合并成一次 flush
+void test_pipelining() {
+    printf("Test 7: Automatic pipelining\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    redis_conn_t* c = redis_conn_attach(r, sv[0]);
+
+    // 关闭时每条命令都单独写一次
+    for (int i = 0; i < 10; i++) {
+        assert(redis_conn_command(c, NULL, NULL, "GET k") == 0);
+    }
+    assert(c->flushes == 10 && c->flushed_cmds == 10);
+
+    redis_conn_set_pipelining(c, 1);
+    for (int i = 0; i < 100; i++) {
+        assert(redis_conn_command(c, NULL, NULL, "GET k") == 0);
+    }
+    // 命令留在输出 buffer 中，直到下一次 epoll_wait 之前
+    assert(c->flushes == 10 && buffer_len(c->e->out) == 100 * strlen("*2\r\n$3\r\nGET\r\n$1\r\nk\r\n"));
+    assert(r->ndefers == 1);
+    eventloop_once(r, 0);
+    assert(c->flushes == 11 && c->flushed_cmds == 110 && c->unflushed == 0);
+    assert(buffer_len(c->e->out) == 0 && r->ndefers == 0);
+
+    // 连接在 flush 之前被释放，延迟 flush 直接跳过
+    assert(redis_conn_command(c, NULL, NULL, "GET k") == 0);
+    redis_conn_free(c);
+    eventloop_once(r, 0);
+    assert(r->ndefers == 0 && r->nused == 0);
+
+    close(sv[1]);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例8：其他线程投递命令，回调在 reactor 线程按投递顺序执行
+#define POST_THREADS 4
+#define POST_PER_THREAD 100
+
+static void* post_thread(void* arg)
+{
+    redis_conn_t* c = (redis_conn_t*)arg;
+    const char* argv[] = { "GET", "k" };
+    for (int i = 0; i < POST_PER_THREAD; i++) {
+        while (redis_conn_post_command_argv(c, record_cb, NULL, 2, argv, NULL) < 0) {
+        }
+    }
+    return NULL;
+}
+
+void test_post_command() {
+    printf("Test 8: Post commands from other threads\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    redis_conn_t* c = redis_conn_attach(r, sv[0]);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    c->data = &res;
+    // 一批投递的命令在同一轮里合并写出，避免小包把 socketpair 的缓冲占满
+    redis_conn_set_pipelining(c, 1);
+
+    pthread_t tids[POST_THREADS];
+    for (int i = 0; i < POST_THREADS; i++) {
+        pthread_create(&tids[i], NULL, post_thread, c);
+    }
+    for (int i = 0; i < POST_THREADS; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    // 投递的命令还在队列里，每个占一个引用，一轮之后全部写出
+    assert(c->cb_count == 0 && atomic_load(&c->refs) == 1 + POST_THREADS * POST_PER_THREAD);
+    eventloop_once(r, 0);
+    assert(c->cb_count == POST_THREADS * POST_PER_THREAD && atomic_load(&c->refs) == 1);
+    // 和本线程发的命令一样，在下一次等待事件之前一次写出
+    assert(c->flushes == 0 && r->ndefers == 1);
+    eventloop_once(r, 0);
+    assert(c->flushes == 1 && c->flushed_cmds == POST_THREADS * POST_PER_THREAD);
+    const char* cmd = "*2\r\n$3\r\nGET\r\n$1\r\nk\r\n";
+    size_t total = strlen(cmd) * POST_THREADS * POST_PER_THREAD;
+    char* buf = malloc(total + 1);
+    read_exact(sv[1], buf, total);
+    for (size_t off = 0; off < total; off += strlen(cmd)) {
+        assert(memcmp(buf + off, cmd, strlen(cmd)) == 0);
+    }
+    free(buf);
+
+    // 连接关闭后才执行到的投递：回调拿到 NULL，最后一个任务放掉引用时释放连接
+    const char* argv[] = { "GET", "k" };
+    assert(redis_conn_post_command_argv(c, record_cb, NULL, 2, argv, NULL) == 0);
+    assert(redis_conn_post_command_argv(c, record_cb, NULL, 2, argv, NULL) == 0);
+    close(sv[1]);
+    loop_until(r, &res.nulls, POST_THREADS * POST_PER_THREAD + 2);
+    assert(res.nulls == POST_THREADS * POST_PER_THREAD + 2);
+    assert(r->nused == 0);
+
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例9：流式回复，大 value 分块回调，输入 buffer 不会堆积整条回复
+#define STREAM_VALUE (20 * 1024 * 1024)
+
+typedef struct {
+    int values;
+    int lasts;
+    int nulls;
+    uint64_t bytes;
+    uint32_t max_in; //回调时输入 buffer 的最大长度
+    int ok; //分块内容和偏移都对
+    int types[8];
+} stream_result_t;
+
+static void stream_cb(redis_conn_t* c, const resp_value_t* v, int last, void* privdata)
+{
+    stream_result_t* res = (stream_result_t*)privdata;
+    if (!v) {
+        res->nulls++;
+        return;
+    }
+    if (res->values < 8) {
+        res->types[res->values] = v->type;
+    }
+    res->values++;
+    res->lasts += last;
+    if (v->chunk) {
+        const uint8_t* ptr = resp_view_ptr(&v->str);
+        if (!ptr || v->offset != res->bytes || v->total != STREAM_VALUE) {
+            res->ok = 0;
+        }
+        for (uint32_t i = 0; ptr && i < v->str.len; i++) {
+            if (ptr[i] != (uint8_t)('a' + (v->offset + i) % 26)) {
+                res->ok = 0;
+                break;
+            }
+        }
+        res->bytes += v->str.len;
+    }
+    if (buffer_len(c->e->in) > res->max_in) {
+        res->max_in = buffer_len(c->e->in);
+    }
+}
+
+static void* stream_server(void* arg)
+{
+    int fd = *(int*)arg;
+    char hdr[64];
+    int n = snprintf(hdr, sizeof(hdr), "$%d\r\n", STREAM_VALUE);
+    assert(write(fd, hdr, n) == n);
+    char block[65536];
+    for (int off = 0; off < STREAM_VALUE; off += sizeof(block)) {
+        for (int i = 0; i < (int)sizeof(block); i++) {
+            block[i] = 'a' + (off + i) % 26;
+        }
+        size_t len = STREAM_VALUE - off < (int)sizeof(block) ? STREAM_VALUE - off : sizeof(block);
+        for (size_t w = 0; w < len;) {
+            ssize_t k = write(fd, block + w, len - w);
+            assert(k > 0);
+            w += k;
+        }
+    }
+    // 大 value 后面跟一条推送、一个数组和一条普通回复
+    const char* rest = "\r\n>2\r\n$7\r\nmessage\r\n$2\r\nhi\r\n*2\r\n$1\r\na\r\n:5\r\n+OK\r\n";
+    assert(write(fd, rest, strlen(rest)) == (ssize_t)strlen(rest));
+    return NULL;
+}
+
+static int g_pushes = 0;
+
+static void push_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    g_pushes++;
+}
+
+void test_stream_reply() {
+    printf("Test 9: Streamed replies\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    redis_conn_t* c = redis_conn_attach(r, sv[0]);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    c->data = &res;
+    c->push_fn = push_cb;
+    stream_result_t big, arr;
+    memset(&big, 0, sizeof(big));
+    memset(&arr, 0, sizeof(arr));
+    big.ok = arr.ok = 1;
+
+    const char* get[] = { "GET", "big" };
+    const char* lrange[] = { "LRANGE", "l", "0", "-1" };
+    assert(redis_conn_stream_argv(c, stream_cb, &big, 2, get, NULL) == 0);
+    assert(redis_conn_stream_argv(c, stream_cb, &arr, 4, lrange, NULL) == 0);
+    assert(redis_conn_command(c, record_cb, (void*)1, "PING") == 0);
+
+    pthread_t st;
+    pthread_create(&st, NULL, stream_server, &sv[1]);
+    loop_until(r, &res.calls, 1);
+    pthread_join(st, NULL);
+
+    // 20MB 的 value 超过了 BUFFER_CHAIN_MAX，整条缓存的方式收不下
+    assert(big.ok && big.bytes == STREAM_VALUE && big.lasts == 1 && big.nulls == 0);
+    assert(big.values > 1 && big.max_in < 1024 * 1024);
+    assert(g_pushes == 1);
+    assert(arr.values == 3 && arr.lasts == 1);
+    assert(arr.types[0] == RESP_ARRAY && arr.types[1] == RESP_BULK && arr.types[2] == RESP_INTEGER);
+    assert(res.calls == 1 && strcmp(res.last_str, "OK") == 0);
+    assert(c->cb_count == 0 && !c->streaming);
+
+    // 流式回复收到一半时连接断开
+    memset(&big, 0, sizeof(big));
+    big.ok = 1;
+    assert(redis_conn_stream_argv(c, stream_cb, &big, 2, get, NULL) == 0);
+    char hdr[64];
+    int n = snprintf(hdr, sizeof(hdr), "$%d\r\nabcdefgh", STREAM_VALUE);
+    assert(write(sv[1], hdr, n) == n);
+    eventloop_once(r, 100);
+    close(sv[1]);
+    loop_until(r, &big.nulls, 1);
+    assert(big.nulls == 1 && big.lasts == 0 && big.bytes == 8);
+    assert(r->nused == 0);
+
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例10：服务端断开的同时另一个线程一直在投递：投递线程持有引用，连接关闭后结构体留到它放掉为止
+#define DROP_POSTS 20000
+
+static _Atomic int g_posted;
+
+static void* post_loop_thread(void* arg)
+{
+    redis_conn_t* c = (redis_conn_t*)arg;
+    const char* argv[] = { "GET", "k" };
+    for (int i = 0; i < DROP_POSTS; i++) {
+        while (redis_conn_post_command_argv(c, record_cb, NULL, 2, argv, NULL) < 0) {
+        }
+        atomic_fetch_add(&g_posted, 1);
+    }
+    redis_conn_release(c);
+    return NULL;
+}
+
+void test_post_while_dropped() {
+    printf("Test 10: Server drops while another thread posts\n");
+    reactor_t* r = create_reactor();
+    int sv[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    set_nonblock(sv[1]);
+    redis_conn_t* c = redis_conn_attach(r, sv[0]);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    c->data = &res;
+    redis_conn_set_pipelining(c, 1);
+    atomic_store(&g_posted, 0);
+
+    redis_conn_retain(c);
+    pthread_t tid;
+    pthread_create(&tid, NULL, post_loop_thread, c);
+    // 收到一部分命令后服务端断开，投递线程还在继续
+    char buf[65536];
+    size_t got = 0;
+    while (got < 1000 * strlen("*2\r\n$3\r\nGET\r\n$1\r\nk\r\n")) {
+        eventloop_once(r, 1);
+        ssize_t n;
+        while ((n = read(sv[1], buf, sizeof(buf))) > 0) {
+            got += n;
+        }
+    }
+    close(sv[1]);
+    while (atomic_load(&g_posted) < DROP_POSTS) {
+        eventloop_once(r, 1);
+    }
+    pthread_join(tid, NULL);
+    for (int i = 0; i < 1000 && res.nulls < DROP_POSTS; i++) {
+        eventloop_once(r, 1);
+    }
+    // 没有回复，所有投递都以 NULL 回调；最后一个引用放掉时连接被释放（ASan 检查泄漏和越界访问）
+    assert(res.calls == 0 && res.nulls == DROP_POSTS);
+    assert(r->nused == 0);
+
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    printf("Starting redis client tests...\n\n");
+
+    test_encode_and_fifo();
+    test_deep_pipeline();
+    test_writable_only_when_pending();
+    test_disconnect();
+    test_free_in_callback();
+    test_protocol_error();
+    test_pipelining();
+    test_post_command();
+    test_stream_reply();
+    test_post_while_dropped();
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,436 @@
+#include "redis_cluster.h"
+
+// CRC16-CCITT（XMODEM），和 redis 的 crc16.c 相同
+static const uint16_t _redis_crc16_table[256] = {
+	0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50a5, 0x60c6, 0x70e7,
+	0x8108, 0x9129, 0xa14a, 0xb16b, 0xc18c, 0xd1ad, 0xe1ce, 0xf1ef,
+	0x1231, 0x0210, 0x3273, 0x2252, 0x52b5, 0x4294, 0x72f7, 0x62d6,
+	0x9339, 0x8318, 0xb37b, 0xa35a, 0xd3bd, 0xc39c, 0xf3ff, 0xe3de,
+	0x2462, 0x3443, 0x0420, 0x1401, 0x64e6, 0x74c7, 0x44a4, 0x5485,
+	0xa56a, 0xb54b, 0x8528, 0x9509, 0xe5ee, 0xf5cf, 0xc5ac, 0xd58d,
+	0x3653, 0x2672, 0x1611, 0x0630, 0x76d7, 0x66f6, 0x5695, 0x46b4,
+	0xb75b, 0xa77a, 0x9719, 0x8738, 0xf7df, 0xe7fe, 0xd79d, 0xc7bc,
+	0x48c4, 0x58e5, 0x6886, 0x78a7, 0x0840, 0x1861, 0x2802, 0x3823,
+	0xc9cc, 0xd9ed, 0xe98e, 0xf9af, 0x8948, 0x9969, 0xa90a, 0xb92b,
+	0x5af5, 0x4ad4, 0x7ab7, 0x6a96, 0x1a71, 0x0a50, 0x3a33, 0x2a12,
+	0xdbfd, 0xcbdc, 0xfbbf, 0xeb9e, 0x9b79, 0x8b58, 0xbb3b, 0xab1a,
+	0x6ca6, 0x7c87, 0x4ce4, 0x5cc5, 0x2c22, 0x3c03, 0x0c60, 0x1c41,
+	0xedae, 0xfd8f, 0xcdec, 0xddcd, 0xad2a, 0xbd0b, 0x8d68, 0x9d49,
+	0x7e97, 0x6eb6, 0x5ed5, 0x4ef4, 0x3e13, 0x2e32, 0x1e51, 0x0e70,
+	0xff9f, 0xefbe, 0xdfdd, 0xcffc, 0xbf1b, 0xaf3a, 0x9f59, 0x8f78,
+	0x9188, 0x81a9, 0xb1ca, 0xa1eb, 0xd10c, 0xc12d, 0xf14e, 0xe16f,
+	0x1080, 0x00a1, 0x30c2, 0x20e3, 0x5004, 0x4025, 0x7046, 0x6067,
+	0x83b9, 0x9398, 0xa3fb, 0xb3da, 0xc33d, 0xd31c, 0xe37f, 0xf35e,
+	0x02b1, 0x1290, 0x22f3, 0x32d2, 0x4235, 0x5214, 0x6277, 0x7256,
+	0xb5ea, 0xa5cb, 0x95a8, 0x8589, 0xf56e, 0xe54f, 0xd52c, 0xc50d,
+	0x34e2, 0x24c3, 0x14a0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+	0xa7db, 0xb7fa, 0x8799, 0x97b8, 0xe75f, 0xf77e, 0xc71d, 0xd73c,
+	0x26d3, 0x36f2, 0x0691, 0x16b0, 0x6657, 0x7676, 0x4615, 0x5634,
+	0xd94c, 0xc96d, 0xf90e, 0xe92f, 0x99c8, 0x89e9, 0xb98a, 0xa9ab,
+	0x5844, 0x4865, 0x7806, 0x6827, 0x18c0, 0x08e1, 0x3882, 0x28a3,
+	0xcb7d, 0xdb5c, 0xeb3f, 0xfb1e, 0x8bf9, 0x9bd8, 0xabbb, 0xbb9a,
+	0x4a75, 0x5a54, 0x6a37, 0x7a16, 0x0af1, 0x1ad0, 0x2ab3, 0x3a92,
+	0xfd2e, 0xed0f, 0xdd6c, 0xcd4d, 0xbdaa, 0xad8b, 0x9de8, 0x8dc9,
+	0x7c26, 0x6c07, 0x5c64, 0x4c45, 0x3ca2, 0x2c83, 0x1ce0, 0x0cc1,
+	0xef1f, 0xff3e, 0xcf5d, 0xdf7c, 0xaf9b, 0xbfba, 0x8fd9, 0x9ff8,
+	0x6e17, 0x7e36, 0x4e55, 0x5e74, 0x2e93, 0x3eb2, 0x0ed1, 0x1ef0,
+};
+
+// 发出去的命令：参数留一份拷贝，重定向时重发
+typedef struct {
+	redis_cluster_t* cl;
+	redis_reply_fn fn;
+	void* privdata;
+	int redirects;
+	int argc;
+	size_t lens[]; //argc 个参数长度，后面紧跟所有参数的内容
+} redis_cluster_req_t;
+
+static void _redis_cluster_reply_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata);
+static void _redis_cluster_refresh(redis_cluster_t* cl);
+
+static uint16_t _redis_crc16(const char* buf, size_t len)
+{
+	uint16_t crc = 0;
+	for (size_t i = 0; i < len; i++) {
+		crc = (crc << 8) ^ _redis_crc16_table[((crc >> 8) ^ (uint8_t)buf[i]) & 0xff];
+	}
+	return crc;
+}
+
+uint16_t redis_cluster_keyslot(const char* key, size_t len)
+{
+	size_t s, e;
+	for (s = 0; s < len && key[s] != '{'; s++);
+	if (s < len) {
+		for (e = s + 1; e < len && key[e] != '}'; e++);
+		// "{}" 不算 tag，整个 key 参与计算
+		if (e < len && e != s + 1) {
+			key += s + 1;
+			len = e - s - 1;
+		}
+	}
+	return _redis_crc16(key, len) & (REDIS_CLUSTER_SLOTS - 1);
+}
+
+static inline int _redis_conn_usable(redis_conn_t* c)
+{
+	return c && !c->err && !(c->flags & REDIS_CONN_FREEING);
+}
+
+static void _redis_cluster_conn_cb(redis_conn_t* c, int status)
+{
+	redis_cluster_node_t* n = (redis_cluster_node_t*)c->data;
+	// 连不上时不立即刷新拓扑：整个集群都不可用时会变成每轮 eventloop 重连一次
+	if (status != 0 && n->c == c) {
+		n->c = NULL;
+	}
+}
+
+static void _redis_cluster_disconnect_cb(redis_conn_t* c, int status)
+{
+	redis_cluster_node_t* n = (redis_cluster_node_t*)c->data;
+	if (n->c == c) {
+		n->c = NULL;
+	}
+	// 节点挂掉后它的槽可能已经被从节点接管
+	_redis_cluster_refresh(n->cl);
+}
+
+// 节点的连接，断开过的节点在这里重连
+static redis_conn_t* _redis_cluster_node_conn(redis_cluster_node_t* n)
+{
+	if (_redis_conn_usable(n->c)) {
+		return n->c;
+	}
+	redis_conn_t* c = redis_connect(n->cl->r, n->host, n->port);
+	if (!c) {
+		return NULL;
+	}
+	c->data = n;
+	c->connect_fn = _redis_cluster_conn_cb;
+	c->disconnect_fn = _redis_cluster_disconnect_cb;
+	redis_conn_set_pipelining(c, n->cl->pipelining);
+	n->c = c;
+	return c;
+}
+
+// 按地址找节点，没有时新建（还不连接）
+static redis_cluster_node_t* _redis_cluster_node(redis_cluster_t* cl, const char* host, int port)
+{
+	for (int i = 0; i < cl->nnodes; i++) {
+		redis_cluster_node_t* n = cl->nodes[i];
+		if (n->port == port && strcmp(n->host, host) == 0) {
+			return n;
+		}
+	}
+	if (strlen(host) >= REDIS_CLUSTER_MAX_HOST || cl->nnodes >= INT16_MAX) {
+		return NULL;
+	}
+	if (cl->nnodes == cl->cap) {
+		int cap = cl->cap ? cl->cap * 2 : 8;
+		redis_cluster_node_t** nodes = (redis_cluster_node_t**)realloc(cl->nodes, sizeof(redis_cluster_node_t*) * cap);
+		if (!nodes) {
+			return NULL;
+		}
+		cl->nodes = nodes;
+		cl->cap = cap;
+	}
+	redis_cluster_node_t* n = (redis_cluster_node_t*)calloc(1, sizeof(redis_cluster_node_t));
+	if (!n) {
+		return NULL;
+	}
+	n->cl = cl;
+	n->index = cl->nnodes;
+	strcpy(n->host, host);
+	n->port = port;
+	cl->nodes[cl->nnodes++] = n;
+	return n;
+}
+
+// 槽还不知道归属时用的节点：优先已经连上的
+static redis_cluster_node_t* _redis_cluster_any(redis_cluster_t* cl)
+{
+	for (int i = 0; i < cl->nnodes; i++) {
+		if (_redis_conn_usable(cl->nodes[i]->c)) {
+			return cl->nodes[i];
+		}
+	}
+	return cl->nnodes > 0 ? cl->nodes[0] : NULL;
+}
+
+static void _redis_cluster_destroy(redis_cluster_t* cl)
+{
+	for (int i = 0; i < cl->nnodes; i++) {
+		free(cl->nodes[i]);
+	}
+	free(cl->nodes);
+	free(cl);
+}
+
+// 一条命令或 CLUSTER SLOTS 结束，redis_cluster_free 之后最后一个结束的负责释放
+static void _redis_cluster_done(redis_cluster_t* cl)
+{
+	cl->inflight--;
+	if (cl->closing && cl->inflight == 0) {
+		_redis_cluster_destroy(cl);
+	}
+}
+
+// CLUSTER SLOTS 的回复：[[start, end, [host, port, id], 从节点...], ...]
+static void _redis_cluster_load_slots(redis_cluster_t* cl, redis_cluster_node_t* from, resp_reply_t* reply)
+{
+	if (reply->type != RESP_ARRAY) {
+		char err[128];
+		uint32_t n = resp_view_copy(&reply->str, err, sizeof(err) - 1);
+		err[n] = '\0';
+		printf("redis cluster %s:%d CLUSTER SLOTS error: %s\n", from->host, from->port, err);
+		return;
+	}
+	int16_t slots[REDIS_CLUSTER_SLOTS];
+	memset(slots, 0xff, sizeof(slots));
+	for (int64_t i = 0; i < reply->elements; i++) {
+		resp_reply_t* range = &reply->element[i];
+		if (range->type != RESP_ARRAY || range->elements < 3 || range->element[0].type != RESP_INTEGER
+			|| range->element[1].type != RESP_INTEGER || range->element[2].type != RESP_ARRAY
+			|| range->element[2].elements < 2 || range->element[2].element[1].type != RESP_INTEGER) {
+			continue;
+		}
+		long long start = range->element[0].integer;
+		long long end = range->element[1].integer;
+		resp_reply_t* master = &range->element[2];
+		char host[REDIS_CLUSTER_MAX_HOST];
+		if (master->element[0].str.len == 0 || master->element[0].str.len >= sizeof(host)) {
+			// 空地址表示和回复 CLUSTER SLOTS 的节点相同
+			strcpy(host, from->host);
+		}
+		else {
+			uint32_t n = resp_view_copy(&master->element[0].str, host, sizeof(host) - 1);
+			host[n] = '\0';
+		}
+		redis_cluster_node_t* n = _redis_cluster_node(cl, host, (int)master->element[1].integer);
+		if (!n || start < 0 || end >= REDIS_CLUSTER_SLOTS) {
+			continue;
+		}
+		for (long long s = start; s <= end; s++) {
+			slots[s] = (int16_t)n->index;
+		}
+	}
+	memcpy(cl->slots, slots, sizeof(slots));
+	cl->refreshes++;
+}
+
+static void _redis_cluster_slots_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+	redis_cluster_t* cl = (redis_cluster_t*)privdata;
+	cl->refreshing = 0;
+	if (reply && !cl->closing) {
+		_redis_cluster_load_slots(cl, (redis_cluster_node_t*)c->data, reply);
+	}
+	_redis_cluster_done(cl);
+}
+
+static void _redis_cluster_refresh(redis_cluster_t* cl)
+{
+	if (cl->refreshing || cl->closing) {
+		return;
+	}
+	redis_cluster_node_t* n = _redis_cluster_any(cl);
+	redis_conn_t* c = n ? _redis_cluster_node_conn(n) : NULL;
+	if (c && redis_conn_command(c, _redis_cluster_slots_cb, cl, "CLUSTER SLOTS") == 0) {
+		cl->refreshing = 1;
+		cl->inflight++;
+	}
+}
+
+void redis_cluster_refresh(redis_cluster_t* cl)
+{
+	_redis_cluster_refresh(cl);
+}
+
+static int _redis_cluster_send(redis_cluster_node_t* n, redis_cluster_req_t* req, int asking)
+{
+	redis_conn_t* c = _redis_cluster_node_conn(n);
+	if (!c) {
+		return -1;
+	}
+	const char* stack[16];
+	const char** argv = req->argc <= 16 ? stack : (const char**)malloc(sizeof(char*) * req->argc);
+	if (!argv) {
+		return -1;
+	}
+	const char* p = (const char*)(req->lens + req->argc);
+	for (int i = 0; i < req->argc; i++) {
+		argv[i] = p;
+		p += req->lens[i];
+	}
+	int ret = 0;
+	// ASKING 只对同一条连接上紧跟着的下一条命令有效
+	if (asking) {
+		ret = redis_conn_command(c, NULL, NULL, "ASKING");
+	}
+	if (ret == 0) {
+		ret = redis_conn_command_argv(c, _redis_cluster_reply_cb, req, req->argc, argv, req->lens);
+	}
+	if (argv != stack) {
+		free(argv);
+	}
+	return ret;
+}
+
+// "MOVED 3999 127.0.0.1:6381" 或 "ASK 3999 127.0.0.1:6381"，不是重定向时返回 NULL
+static redis_cluster_node_t* _redis_cluster_redirect(redis_cluster_t* cl, redis_conn_t* c, resp_reply_t* reply, int* ask, int* slot)
+{
+	char err[128];
+	uint32_t len = resp_view_copy(&reply->str, err, sizeof(err) - 1);
+	err[len] = '\0';
+	char* p;
+	if (strncmp(err, "MOVED ", 6) == 0) {
+		*ask = 0;
+		p = err + 6;
+	}
+	else if (strncmp(err, "ASK ", 4) == 0) {
+		*ask = 1;
+		p = err + 4;
+	}
+	else {
+		return NULL;
+	}
+	char* end;
+	long s = strtol(p, &end, 10);
+	char* colon = strrchr(end, ':');
+	if (end == p || *end != ' ' || s < 0 || s >= REDIS_CLUSTER_SLOTS || !colon) {
+		return NULL;
+	}
+	*colon = '\0';
+	*slot = (int)s;
+	const char* host = end + 1;
+	if (host[0] == '\0') {
+		host = ((redis_cluster_node_t*)c->data)->host;
+	}
+	return _redis_cluster_node(cl, host, atoi(colon + 1));
+}
+
+static void _redis_cluster_reply_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+	redis_cluster_req_t* req = (redis_cluster_req_t*)privdata;
+	redis_cluster_t* cl = req->cl;
+	if (reply && reply->type == RESP_ERROR && !cl->closing && req->redirects < REDIS_CLUSTER_MAX_REDIRECTS) {
+		int ask, slot;
+		redis_cluster_node_t* n = _redis_cluster_redirect(cl, c, reply, &ask, &slot);
+		if (n) {
+			req->redirects++;
+			if (ask) {
+				cl->asks++;
+			}
+			else {
+				// 先改这一个槽，其他迁走的槽等拓扑刷新
+				cl->moved++;
+				cl->slots[slot] = (int16_t)n->index;
+				_redis_cluster_refresh(cl);
+			}
+			if (_redis_cluster_send(n, req, ask) == 0) {
+				return;
+			}
+		}
+	}
+	if (req->fn) {
+		req->fn(c, reply, req->privdata);
+	}
+	free(req);
+	_redis_cluster_done(cl);
+}
+
+redis_cluster_t* redis_cluster_create(reactor_t* r, const char* host, int port)
+{
+	redis_cluster_t* cl = (redis_cluster_t*)calloc(1, sizeof(redis_cluster_t));
+	if (!cl) {
+		return NULL;
+	}
+	cl->r = r;
+	cl->pipelining = 1;
+	memset(cl->slots, 0xff, sizeof(cl->slots));
+	redis_cluster_node_t* seed = _redis_cluster_node(cl, host, port);
+	if (!seed || !_redis_cluster_node_conn(seed)) {
+		redis_cluster_free(cl);
+		return NULL;
+	}
+	_redis_cluster_refresh(cl);
+	return cl;
+}
+
+void redis_cluster_free(redis_cluster_t* cl)
+{
+	cl->closing = 1;
+	// 不在回调里时未完成的命令在 redis_conn_free 中就回调完了，先占住一个 inflight 防止中途释放
+	cl->inflight++;
+	for (int i = 0; i < cl->nnodes; i++) {
+		redis_cluster_node_t* n = cl->nodes[i];
+		if (n->c) {
+			n->c->connect_fn = NULL;
+			n->c->disconnect_fn = NULL;
+			redis_conn_free(n->c);
+			n->c = NULL;
+		}
+	}
+	_redis_cluster_done(cl);
+}
+
+void redis_cluster_set_pipelining(redis_cluster_t* cl, int on)
+{
+	cl->pipelining = on;
+	for (int i = 0; i < cl->nnodes; i++) {
+		if (cl->nodes[i]->c) {
+			redis_conn_set_pipelining(cl->nodes[i]->c, on);
+		}
+	}
+}
+
+int redis_cluster_command_key(redis_cluster_t* cl, const char* key, size_t keylen, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen)
+{
+	if (cl->closing || argc <= 0) {
+		return -1;
+	}
+	size_t total = 0;
+	for (int i = 0; i < argc; i++) {
+		total += argvlen ? argvlen[i] : strlen(argv[i]);
+	}
+	redis_cluster_req_t* req = (redis_cluster_req_t*)malloc(sizeof(redis_cluster_req_t) + sizeof(size_t) * argc + total);
+	if (!req) {
+		return -1;
+	}
+	req->cl = cl;
+	req->fn = fn;
+	req->privdata = privdata;
+	req->redirects = 0;
+	req->argc = argc;
+	char* p = (char*)(req->lens + argc);
+	for (int i = 0; i < argc; i++) {
+		req->lens[i] = argvlen ? argvlen[i] : strlen(argv[i]);
+		memcpy(p, argv[i], req->lens[i]);
+		p += req->lens[i];
+	}
+
+	redis_cluster_node_t* n = NULL;
+	if (key) {
+		int16_t idx = cl->slots[redis_cluster_keyslot(key, keylen)];
+		n = idx >= 0 ? cl->nodes[idx] : NULL;
+	}
+	if (!n) {
+		n = _redis_cluster_any(cl);
+	}
+	if (!n || _redis_cluster_send(n, req, 0) < 0) {
+		free(req);
+		return -1;
+	}
+	cl->inflight++;
+	return 0;
+}
+
+int redis_cluster_command_argv(redis_cluster_t* cl, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen)
+{
+	if (argc < 2) {
+		return redis_cluster_command_key(cl, NULL, 0, fn, privdata, argc, argv, argvlen);
+	}
+	return redis_cluster_command_key(cl, argv[1], argvlen ? argvlen[1] : strlen(argv[1]), fn, privdata, argc, argv, argvlen);
+}
@@ -0,0 +1,64 @@
+#ifndef __REDIS_CLUSTER_H__
+#define __REDIS_CLUSTER_H__
+
+#include "redis_client.h"
+
+// 同一个 reactor 内的 redis cluster 客户端：
+// 从任意一个种子节点加载 CLUSTER SLOTS，维护 16384 个槽到节点的映射，命令按 key 的槽发给所属节点；
+// 每个节点一条连接，默认打开自动 pipeline，同一轮 eventloop 中发给同一节点的命令合并成一次写出。
+// 收到 MOVED 时更新这个槽并重发，同时在后台重新加载一次拓扑（同一时间最多一个 CLUSTER SLOTS 在途）；
+// 收到 ASK 时只对这一条命令先发 ASKING 再重发到目标节点，不改映射。
+
+#define REDIS_CLUSTER_SLOTS			16384
+#define REDIS_CLUSTER_MAX_HOST		64
+#define REDIS_CLUSTER_MAX_REDIRECTS	5 //一条命令最多跟随几次重定向，超过后把最后的错误交给调用方
+
+typedef struct redis_cluster_s redis_cluster_t;
+typedef struct redis_cluster_node_s redis_cluster_node_t;
+
+struct redis_cluster_node_s
+{
+	redis_cluster_t* cl;
+	int index;
+	char host[REDIS_CLUSTER_MAX_HOST];
+	int port;
+	redis_conn_t* c; //断开期间为 NULL，下次有命令路由过来时重连
+};
+
+struct redis_cluster_s
+{
+	reactor_t* r;
+	int pipelining;
+	int refreshing; //CLUSTER SLOTS 在途
+	int closing; //redis_cluster_free 已调用，等未完成的回调都结束后释放
+	uint32_t inflight; //未完成的命令和 CLUSTER SLOTS
+	redis_cluster_node_t** nodes; //节点只增不删，下标在 slots 中引用
+	int nnodes;
+	int cap;
+	int16_t slots[REDIS_CLUSTER_SLOTS]; //槽 -> nodes 下标，-1 表示还不知道，发给任意节点等 MOVED
+	uint64_t moved;
+	uint64_t asks;
+	uint64_t refreshes; //成功加载拓扑的次数
+};
+
+// 连接种子节点并加载拓扑；拓扑到达之前发出的命令先发给种子节点
+redis_cluster_t* redis_cluster_create(reactor_t* r, const char* host, int port);
+
+// 释放所有节点连接，未完成的回调以 reply == NULL 调用；可以在回调中调用，cl 在所有回调结束后才真正释放
+void redis_cluster_free(redis_cluster_t* cl);
+
+void redis_cluster_set_pipelining(redis_cluster_t* cl, int on);
+
+// key 所属的槽，key 中有非空的 {tag} 时只对第一个 tag 计算
+uint16_t redis_cluster_keyslot(const char* key, size_t len);
+
+// 以 argv[1] 作为 key 路由（没有参数的命令发给任意节点），成功返回 0
+int redis_cluster_command_argv(redis_cluster_t* cl, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen);
+
+// key 不在 argv[1] 的命令（EVAL 等）显式指定路由用的 key
+int redis_cluster_command_key(redis_cluster_t* cl, const char* key, size_t keylen, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen);
+
+// 后台重新加载一次拓扑，已有 CLUSTER SLOTS 在途时什么也不做
+void redis_cluster_refresh(redis_cluster_t* cl);
+
+#endif
@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "redis_cluster.h"
+#include "redis_test_server.h"
+
+// 编译: gcc reactor.c reactor_uring.c ringbuffer/ringbuffer.c ringbuffer/mpmc_ring.c chainbuffer/chainbuffer.c memsearch/memsearch.c timewheel/timewheel.c resp/resp_parser.c redis_client.c redis_cluster.c redis_test_server.c redis_cluster_test.c -o redis_cluster_test -lpthread
+// 同一个进程里用两个监听 socket 扮演两个集群节点，槽的归属由测试直接改 owner 表
+
+#define TEST_PORT_A 16391
+#define TEST_PORT_B 16392
+#define NODES 2
+
+static test_server_t nodes[NODES];
+static int cmds[NODES]; //每个节点处理过的命令数，重连后不清零
+static int owner[REDIS_CLUSTER_SLOTS]; //槽 -> nodes 下标
+static int migrating_slot = -1; //正在从 owner 迁往另一个节点的槽，源节点对它回 ASK
+static int pingpong_slot = -1; //两个节点对这个槽互相回 MOVED
+
+static void reply_slots(test_client_t* cl)
+{
+    char buf[4096];
+    int len = 0, ranges = 0;
+    for (int s = 0; s < REDIS_CLUSTER_SLOTS; ) {
+        int e = s;
+        while (e + 1 < REDIS_CLUSTER_SLOTS && owner[e + 1] == owner[s]) {
+            e++;
+        }
+        len += snprintf(buf + len, sizeof(buf) - len, "*3\r\n:%d\r\n:%d\r\n*3\r\n$9\r\n127.0.0.1\r\n:%d\r\n$2\r\nid\r\n",
+            s, e, nodes[owner[s]].port);
+        ranges++;
+        s = e + 1;
+    }
+    test_reply(cl, "*%d\r\n", ranges);
+    test_write(cl, buf, len);
+}
+
+// cl->state 记这条连接上一条命令是不是 ASKING
+static void handle(test_server_t* n, test_client_t* cl, int argc, char** argv, size_t* lens)
+{
+    int self = n - nodes;
+    cmds[self]++;
+    int asking = cl->state;
+    cl->state = 0;
+    if (strcmp(argv[0], "CLUSTER") == 0) {
+        reply_slots(cl);
+        return;
+    }
+    if (strcmp(argv[0], "ASKING") == 0) {
+        cl->state = 1;
+        test_reply(cl, "+OK\r\n");
+        return;
+    }
+    int slot = redis_cluster_keyslot(argv[1], lens[1]);
+    int other = nodes[1 - self].port;
+    if (slot == pingpong_slot) {
+        test_reply(cl, "-MOVED %d 127.0.0.1:%d\r\n", slot, other);
+    }
+    else if (slot == migrating_slot && owner[slot] == self) {
+        test_reply(cl, "-ASK %d 127.0.0.1:%d\r\n", slot, other);
+    }
+    else if (owner[slot] != self && !(slot == migrating_slot && asking)) {
+        test_reply(cl, "-MOVED %d 127.0.0.1:%d\r\n", slot, nodes[owner[slot]].port);
+    }
+    else if (strcmp(argv[0], "GET") == 0) {
+        test_reply(cl, "$%d\r\n%c:%s\r\n", (int)lens[1] + 2, 'A' + self, argv[1]);
+    }
+    else {
+        test_reply(cl, "+OK\r\n");
+    }
+}
+
+static void pump(reactor_t* r)
+{
+    eventloop_once(r, 1);
+    for (int i = 0; i < NODES; i++) {
+        test_server_poll(&nodes[i]);
+    }
+}
+
+typedef struct {
+    int calls;
+    int nulls;
+    int type;
+    char last_str[64];
+} result_t;
+
+static void record_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    result_t* res = (result_t*)privdata;
+    if (!reply) {
+        res->nulls++;
+        return;
+    }
+    res->calls++;
+    res->type = reply->type;
+    uint32_t n = resp_view_copy(&reply->str, res->last_str, sizeof(res->last_str) - 1);
+    res->last_str[n] = '\0';
+}
+
+static void pump_until(reactor_t* r, int* counter, int expect)
+{
+    for (int i = 0; i < 1000 && *counter < expect; i++) {
+        pump(r);
+    }
+    assert(*counter == expect);
+}
+
+static void get(reactor_t* r, redis_cluster_t* cl, result_t* res, const char* key)
+{
+    const char* argv[] = { "GET", key };
+    int before = res->calls;
+    assert(redis_cluster_command_argv(cl, record_cb, res, 2, argv, NULL) == 0);
+    pump_until(r, &res->calls, before + 1);
+}
+
+static redis_cluster_t* setup(reactor_t* r)
+{
+    for (int s = 0; s < REDIS_CLUSTER_SLOTS; s++) {
+        owner[s] = s < REDIS_CLUSTER_SLOTS / 2 ? 0 : 1;
+    }
+    migrating_slot = -1;
+    pingpong_slot = -1;
+    redis_cluster_t* cl = redis_cluster_create(r, "127.0.0.1", TEST_PORT_A);
+    assert(cl);
+    for (int i = 0; i < 1000 && cl->refreshes == 0; i++) {
+        pump(r);
+    }
+    assert(cl->refreshes == 1 && cl->nnodes == NODES);
+    return cl;
+}
+
+static void teardown(reactor_t* r, redis_cluster_t* cl)
+{
+    redis_cluster_free(cl);
+    for (int i = 0; i < 10; i++) {
+        pump(r);
+    }
+    for (int i = 0; i < NODES; i++) {
+        assert(test_server_clients(&nodes[i]) == 0);
+    }
+}
+
+// 测试用例1：CRC16 与 hash tag
+void test_keyslot() {
+    printf("Test 1: Key slot\n");
+    assert(redis_cluster_keyslot("123456789", 9) == (0x31C3 & 16383));
+    assert(redis_cluster_keyslot("foo", 3) == 12182);
+    assert(redis_cluster_keyslot("bar", 3) == 5061);
+    assert(redis_cluster_keyslot("", 0) == 0);
+    // 只对第一个非空 tag 计算
+    assert(redis_cluster_keyslot("{user1000}.following", 20) == redis_cluster_keyslot("{user1000}.followers", 20));
+    assert(redis_cluster_keyslot("{user1000}.following", 20) == redis_cluster_keyslot("user1000", 8));
+    assert(redis_cluster_keyslot("foo{bar}{zap}", 13) == redis_cluster_keyslot("bar", 3));
+    assert(redis_cluster_keyslot("foo{{bar}}zap", 13) == redis_cluster_keyslot("{bar", 4));
+    assert(redis_cluster_keyslot("foo{}{bar}", 10) != redis_cluster_keyslot("bar", 3));
+    assert(redis_cluster_keyslot("{bar", 4) != redis_cluster_keyslot("bar", 3));
+    printf("Passed\n\n");
+}
+
+// 测试用例2：拓扑加载后命令直接发给所属节点
+void test_routing() {
+    printf("Test 2: Slot routing\n");
+    reactor_t* r = create_reactor();
+    redis_cluster_t* cl = setup(r);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+
+    int cmds_a = cmds[0], cmds_b = cmds[1];
+    get(r, cl, &res, "bar"); //5061 -> A
+    assert(strcmp(res.last_str, "A:bar") == 0);
+    get(r, cl, &res, "foo"); //12182 -> B
+    assert(strcmp(res.last_str, "B:foo") == 0);
+    get(r, cl, &res, "{foo}.x");
+    assert(strcmp(res.last_str, "B:{foo}.x") == 0);
+    assert(cmds[0] == cmds_a + 1 && cmds[1] == cmds_b + 2);
+    assert(cl->moved == 0 && cl->asks == 0);
+
+    // 同一轮发给同一节点的命令一次写出
+    const char* argv[] = { "GET", "foo" };
+    for (int i = 0; i < 100; i++) {
+        assert(redis_cluster_command_argv(cl, record_cb, &res, 2, argv, NULL) == 0);
+    }
+    redis_conn_t* b = cl->nodes[1]->c;
+    uint64_t flushes = b->flushes;
+    pump_until(r, &res.calls, 103);
+    assert(b->flushes == flushes + 1);
+
+    teardown(r, cl);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例3：MOVED 更新槽并刷新拓扑，ASK 只重发这一条命令
+void test_redirect() {
+    printf("Test 3: MOVED and ASK\n");
+    reactor_t* r = create_reactor();
+    redis_cluster_t* cl = setup(r);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+
+    // foo 的槽迁到了 A，客户端还以为在 B
+    owner[12182] = 0;
+    get(r, cl, &res, "foo");
+    assert(res.type == RESP_BULK && strcmp(res.last_str, "A:foo") == 0);
+    assert(cl->moved == 1 && cl->slots[12182] == 0);
+    for (int i = 0; i < 100 && cl->refreshes < 2; i++) {
+        pump(r);
+    }
+    assert(cl->refreshes == 2 && cl->slots[12182] == 0 && cl->slots[12183] == 1);
+    int cmds_b = cmds[1];
+    get(r, cl, &res, "foo");
+    assert(strcmp(res.last_str, "A:foo") == 0 && cmds[1] == cmds_b && cl->moved == 1);
+
+    // bar 的槽正在从 A 迁往 B：每次都先被 A 回 ASK，映射保持不变
+    migrating_slot = 5061;
+    get(r, cl, &res, "bar");
+    assert(strcmp(res.last_str, "B:bar") == 0 && cl->asks == 1);
+    get(r, cl, &res, "bar");
+    assert(strcmp(res.last_str, "B:bar") == 0 && cl->asks == 2);
+    assert(cl->slots[5061] == 0 && cl->refreshes == 2 && cl->moved == 1);
+
+    // 重定向次数有上限，最后的 MOVED 交给调用方
+    pingpong_slot = redis_cluster_keyslot("loop", 4);
+    get(r, cl, &res, "loop");
+    assert(res.type == RESP_ERROR && strncmp(res.last_str, "MOVED", 5) == 0);
+    assert(cl->moved == 1 + REDIS_CLUSTER_MAX_REDIRECTS);
+
+    teardown(r, cl);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例4：节点断开后未完成的命令以 NULL 回调，刷新拓扑，下次路由过去时重连
+void test_reconnect() {
+    printf("Test 4: Node reconnect\n");
+    reactor_t* r = create_reactor();
+    redis_cluster_t* cl = setup(r);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+
+    get(r, cl, &res, "foo");
+    // 服务端先断开再处理命令
+    const char* argv[] = { "GET", "foo" };
+    assert(redis_cluster_command_argv(cl, record_cb, &res, 2, argv, NULL) == 0);
+    eventloop_once(r, 0);
+    assert(test_server_clients(&nodes[1]) == 1);
+    for (int i = 0; i < TEST_SERVER_MAX_CLIENTS; i++) {
+        if (nodes[1].clients[i].fd >= 0) {
+            test_server_drop(&nodes[1], &nodes[1].clients[i]);
+        }
+    }
+    pump_until(r, &res.nulls, 1);
+    assert(cl->nodes[1]->c == NULL);
+    for (int i = 0; i < 100 && cl->refreshes < 2; i++) {
+        pump(r);
+    }
+    assert(cl->refreshes == 2);
+
+    get(r, cl, &res, "foo");
+    assert(strcmp(res.last_str, "B:foo") == 0 && cl->nodes[1]->c != NULL);
+
+    teardown(r, cl);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+static redis_cluster_t* free_in_cb;
+
+static void free_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    record_cb(c, reply, privdata);
+    if (free_in_cb) {
+        redis_cluster_t* cl = free_in_cb;
+        free_in_cb = NULL;
+        redis_cluster_free(cl);
+    }
+}
+
+// 测试用例5：在回调里释放 cluster，同一连接和其他节点上未完成的命令以 NULL 回调
+void test_free_in_callback() {
+    printf("Test 5: Free inside a reply callback\n");
+    reactor_t* r = create_reactor();
+    redis_cluster_t* cl = setup(r);
+    result_t first, rest;
+    memset(&first, 0, sizeof(first));
+    memset(&rest, 0, sizeof(rest));
+
+    const char* bar[] = { "GET", "bar" }; //A
+    const char* foo[] = { "GET", "foo" }; //B
+    assert(redis_cluster_command_argv(cl, free_cb, &first, 2, bar, NULL) == 0);
+    assert(redis_cluster_command_argv(cl, record_cb, &rest, 2, bar, NULL) == 0);
+    assert(redis_cluster_command_argv(cl, record_cb, &rest, 2, foo, NULL) == 0);
+    redis_cluster_refresh(cl);
+    assert(cl->refreshing && cl->inflight == 4);
+    free_in_cb = cl;
+    pump_until(r, &first.calls, 1);
+    assert(free_in_cb == NULL);
+    for (int i = 0; i < 100 && rest.calls + rest.nulls < 2; i++) {
+        pump(r);
+    }
+    // A 上排在后面的那条一定拿不到回复，B 上的可能在释放之前已经回来了
+    assert(rest.calls + rest.nulls == 2 && rest.nulls >= 1);
+    for (int i = 0; i < 10; i++) {
+        pump(r);
+    }
+    for (int i = 0; i < NODES; i++) {
+        assert(test_server_clients(&nodes[i]) == 0);
+    }
+    assert(r->nused == 0);
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    printf("Starting redis cluster tests...\n\n");
+    test_server_open(&nodes[0], TEST_PORT_A, handle, NULL);
+    test_server_open(&nodes[1], TEST_PORT_B, handle, NULL);
+
+    test_keyslot();
+    test_routing();
+    test_redirect();
+    test_reconnect();
+    test_free_in_callback();
+
+    for (int i = 0; i < NODES; i++) {
+        test_server_close(&nodes[i]);
+    }
+    printf("All tests passed!\n");
+    return 0;
+}
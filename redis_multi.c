@@ -0,0 +1,218 @@
+#include "redis_multi.h"
+
+// 一条 MGET/MSET 带的 key 在传入数组中的下标
+typedef struct {
+	redis_multi_t* m;
+	int n;
+	int idx[];
+} redis_multi_chunk_t;
+
+typedef struct {
+	uint16_t slot;
+	int idx;
+} redis_multi_key_t;
+
+static void _redis_multi_release(redis_multi_t* m)
+{
+	if (--m->pending > 0) {
+		return;
+	}
+	if (m->fn) {
+		m->fn(m, m->privdata);
+	}
+	for (int i = 0; i < m->nblocks; i++) {
+		free(m->blocks[i]);
+	}
+	free(m->blocks);
+	free(m->values);
+	free(m);
+}
+
+static void _redis_multi_get_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+	redis_multi_chunk_t* chunk = (redis_multi_chunk_t*)privdata;
+	redis_multi_t* m = chunk->m;
+	if (!reply || reply->type != RESP_ARRAY || reply->elements != chunk->n) {
+		m->failed += chunk->n;
+	}
+	else {
+		// 这条回复里所有的值拷进同一块内存
+		size_t total = 0;
+		for (int i = 0; i < chunk->n; i++) {
+			if (reply->element[i].type == RESP_BULK) {
+				total += reply->element[i].str.len;
+			}
+		}
+		char* block = total ? (char*)malloc(total) : NULL;
+		if (total && !block) {
+			m->failed += chunk->n;
+		}
+		else {
+			if (block) {
+				m->blocks[m->nblocks++] = block;
+			}
+			char* p = block;
+			for (int i = 0; i < chunk->n; i++) {
+				resp_reply_t* e = &reply->element[i];
+				if (e->type != RESP_BULK) {
+					continue;
+				}
+				redis_multi_value_t* v = &m->values[chunk->idx[i]];
+				v->len = resp_view_copy(&e->str, p, e->str.len);
+				v->str = v->len ? p : "";
+				p += v->len;
+			}
+		}
+	}
+	free(chunk);
+	_redis_multi_release(m);
+}
+
+static void _redis_multi_set_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+	redis_multi_chunk_t* chunk = (redis_multi_chunk_t*)privdata;
+	redis_multi_t* m = chunk->m;
+	if (!reply || reply->type == RESP_ERROR) {
+		m->failed += chunk->n;
+	}
+	free(chunk);
+	_redis_multi_release(m);
+}
+
+static int _redis_multi_key_cmp(const void* a, const void* b)
+{
+	const redis_multi_key_t* x = (const redis_multi_key_t*)a;
+	const redis_multi_key_t* y = (const redis_multi_key_t*)b;
+	if (x->slot != y->slot) {
+		return (int)x->slot - (int)y->slot;
+	}
+	return x->idx - y->idx;
+}
+
+// 从 keys[i] 开始的一条命令能带多少个 key：不超过 REDIS_MULTI_BATCH，cluster 上不跨槽
+static int _redis_multi_chunk_len(redis_multi_t* m, const redis_multi_key_t* keys, int i)
+{
+	int j = i + 1;
+	while (j < m->nkeys && j - i < REDIS_MULTI_BATCH && (!m->cluster || keys[j].slot == keys[i].slot)) {
+		j++;
+	}
+	return j - i;
+}
+
+static void _redis_multi_send(redis_multi_t* m, const redis_multi_key_t* order, int n, const char** keys, const size_t* keylens,
+	const char** values, const size_t* valuelens, const char** argv, size_t* lens)
+{
+	redis_multi_chunk_t* chunk = (redis_multi_chunk_t*)malloc(sizeof(redis_multi_chunk_t) + sizeof(int) * n);
+	if (!chunk) {
+		m->failed += n;
+		return;
+	}
+	chunk->m = m;
+	chunk->n = n;
+	int argc = 1;
+	argv[0] = values ? "MSET" : "MGET";
+	lens[0] = 4;
+	for (int i = 0; i < n; i++) {
+		int k = order[i].idx;
+		chunk->idx[i] = k;
+		argv[argc] = keys[k];
+		lens[argc++] = keylens ? keylens[k] : strlen(keys[k]);
+		if (values) {
+			argv[argc] = values[k];
+			lens[argc++] = valuelens ? valuelens[k] : strlen(values[k]);
+		}
+	}
+	redis_reply_fn cb = values ? _redis_multi_set_cb : _redis_multi_get_cb;
+	int ret = m->cluster ? redis_cluster_command_argv(m->cluster, cb, chunk, argc, argv, lens)
+		: redis_pool_command_argv(m->pool, cb, chunk, argc, argv, lens);
+	if (ret < 0) {
+		m->failed += n;
+		free(chunk);
+		return;
+	}
+	m->pending++;
+}
+
+static int _redis_multi(redis_pool_t* p, redis_cluster_t* cl, int nkeys, const char** keys, const size_t* keylens,
+	const char** values, const size_t* valuelens, redis_multi_fn fn, void* privdata)
+{
+	if (nkeys < 0) {
+		return -1;
+	}
+	redis_multi_t* m = (redis_multi_t*)calloc(1, sizeof(redis_multi_t));
+	redis_multi_key_t* order = (redis_multi_key_t*)malloc(sizeof(redis_multi_key_t) * (nkeys + 1));
+	const char** argv = (const char**)malloc(sizeof(char*) * (REDIS_MULTI_BATCH * 2 + 1));
+	size_t* lens = (size_t*)malloc(sizeof(size_t) * (REDIS_MULTI_BATCH * 2 + 1));
+	if (!m || !order || !argv || !lens) {
+		goto fail;
+	}
+	m->pool = p;
+	m->cluster = cl;
+	m->nkeys = nkeys;
+	m->fn = fn;
+	m->privdata = privdata;
+	m->pending = 1; //发送期间占住，所有命令都同步失败时在最后回调
+	if (!values && (m->values = (redis_multi_value_t*)calloc(nkeys + 1, sizeof(redis_multi_value_t))) == NULL) {
+		goto fail;
+	}
+	for (int i = 0; i < nkeys; i++) {
+		order[i].idx = i;
+		order[i].slot = cl ? redis_cluster_keyslot(keys[i], keylens ? keylens[i] : strlen(keys[i])) : 0;
+	}
+	if (cl) {
+		qsort(order, nkeys, sizeof(redis_multi_key_t), _redis_multi_key_cmp);
+	}
+	for (int i = 0; i < nkeys; i += _redis_multi_chunk_len(m, order, i)) {
+		m->nchunks++;
+	}
+	if ((m->blocks = (void**)malloc(sizeof(void*) * (m->nchunks + 1))) == NULL) {
+		goto fail;
+	}
+	for (int i = 0; i < nkeys; ) {
+		int n = _redis_multi_chunk_len(m, order, i);
+		_redis_multi_send(m, order + i, n, keys, keylens, values, valuelens, argv, lens);
+		i += n;
+	}
+	free(order);
+	free(argv);
+	free(lens);
+	_redis_multi_release(m);
+	return 0;
+
+fail:
+	if (m) {
+		free(m->values);
+		free(m->blocks);
+	}
+	free(m);
+	free(order);
+	free(argv);
+	free(lens);
+	return -1;
+}
+
+int redis_multi_get(redis_pool_t* p, int nkeys, const char** keys, const size_t* keylens, redis_multi_fn fn, void* privdata)
+{
+	return _redis_multi(p, NULL, nkeys, keys, keylens, NULL, NULL, fn, privdata);
+}
+
+int redis_multi_set(redis_pool_t* p, int nkeys, const char** keys, const size_t* keylens, const char** values, const size_t* valuelens, redis_multi_fn fn, void* privdata)
+{
+	if (!values) {
+		return -1;
+	}
+	return _redis_multi(p, NULL, nkeys, keys, keylens, values, valuelens, fn, privdata);
+}
+
+int redis_multi_cluster_get(redis_cluster_t* cl, int nkeys, const char** keys, const size_t* keylens, redis_multi_fn fn, void* privdata)
+{
+	return _redis_multi(NULL, cl, nkeys, keys, keylens, NULL, NULL, fn, privdata);
+}
+
+int redis_multi_cluster_set(redis_cluster_t* cl, int nkeys, const char** keys, const size_t* keylens, const char** values, const size_t* valuelens, redis_multi_fn fn, void* privdata)
+{
+	if (!values) {
+		return -1;
+	}
+	return _redis_multi(NULL, cl, nkeys, keys, keylens, values, valuelens, fn, privdata);
+}
@@ -0,0 +1,50 @@
+#ifndef __REDIS_MULTI_H__
+#define __REDIS_MULTI_H__
+
+#include "redis_pool.h"
+#include "redis_cluster.h"
+
+// 多 key 读写：成千上万个 key 拆成若干条 MGET/MSET，分散到连接池的各条连接上并行发出
+// （cluster 上先按槽分组，每条命令只含同一个槽的 key），全部回来后只回调一次，结果按传入顺序排列。
+// 每条 MGET 的回复一次性拷贝进一块内存，不为每个 key 单独分配。
+
+#define REDIS_MULTI_BATCH	256 //每条 MGET/MSET 最多带多少个 key
+
+typedef struct redis_multi_s redis_multi_t;
+typedef struct redis_multi_value_s redis_multi_value_t;
+
+// 回调返回后 m 和其中的 values 都被释放
+typedef void (*redis_multi_fn)(redis_multi_t* m, void* privdata);
+
+struct redis_multi_value_s
+{
+	const char* str; //key 不存在、不是字符串或所在的命令失败时为 NULL
+	uint32_t len;
+};
+
+struct redis_multi_s
+{
+	redis_pool_t* pool;
+	redis_cluster_t* cluster;
+	int nkeys;
+	int nchunks; //拆成的命令数
+	int pending; //还没回来的命令数
+	int failed; //没有拿到结果的 key 数（连接断开、错误回复、发送失败）
+	redis_multi_value_t* values; //mget 时 nkeys 个，与传入的 key 一一对应；mset 时为 NULL
+	void** blocks; //每条 MGET 回复的数据块
+	int nblocks;
+	redis_multi_fn fn;
+	void* privdata;
+};
+
+// keylens 为 NULL 时按 strlen 计算。返回 0 时 fn 一定会被调用一次（所有命令都发送失败时在返回前调用），
+// 返回 -1 时 fn 不会被调用
+int redis_multi_get(redis_pool_t* p, int nkeys, const char** keys, const size_t* keylens, redis_multi_fn fn, void* privdata);
+
+int redis_multi_set(redis_pool_t* p, int nkeys, const char** keys, const size_t* keylens, const char** values, const size_t* valuelens, redis_multi_fn fn, void* privdata);
+
+int redis_multi_cluster_get(redis_cluster_t* cl, int nkeys, const char** keys, const size_t* keylens, redis_multi_fn fn, void* privdata);
+
+int redis_multi_cluster_set(redis_cluster_t* cl, int nkeys, const char** keys, const size_t* keylens, const char** values, const size_t* valuelens, redis_multi_fn fn, void* privdata);
+
+#endif
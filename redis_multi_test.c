@@ -0,0 +1,246 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "redis_multi.h"
+#include "redis_test_server.h"
+
+// 编译: gcc reactor.c reactor_uring.c ringbuffer/ringbuffer.c ringbuffer/mpmc_ring.c chainbuffer/chainbuffer.c memsearch/memsearch.c timewheel/timewheel.c resp/resp_parser.c redis_client.c redis_pool.c redis_cluster.c redis_multi.c redis_test_server.c redis_multi_test.c -o redis_multi_test -lpthread
+// 同一个进程里的假服务器：MGET 对每个 key 回 "v:<key>"（key 含 missing 时回 nil），MSET 检查 value 是否为 "x:<key>"
+
+#define TEST_PORT 16393
+#define POOL_SIZE 3
+
+static test_server_t srv;
+static int mset_pairs;
+
+static void handle(test_server_t* s, test_client_t* cl, int argc, char** argv, size_t* lens)
+{
+    static char out[1 << 20];
+    size_t len = 0;
+    if (strcmp(argv[0], "MGET") == 0) {
+        len += sprintf(out + len, "*%d\r\n", argc - 1);
+        for (int i = 1; i < argc; i++) {
+            if (strstr(argv[i], "missing")) {
+                len += sprintf(out + len, "$-1\r\n");
+            }
+            else {
+                len += sprintf(out + len, "$%d\r\nv:%s\r\n", (int)lens[i] + 2, argv[i]);
+            }
+        }
+    }
+    else if (strcmp(argv[0], "MSET") == 0) {
+        for (int i = 1; i + 1 < argc; i += 2) {
+            assert(lens[i + 1] == lens[i] + 2 && memcmp(argv[i + 1], "x:", 2) == 0 && strcmp(argv[i + 1] + 2, argv[i]) == 0);
+            mset_pairs++;
+        }
+        len += sprintf(out + len, "+OK\r\n");
+    }
+    else {
+        len += sprintf(out + len, "-ERR unknown command\r\n");
+    }
+    test_write(cl, out, len);
+}
+
+static void pump(reactor_t* r)
+{
+    eventloop_once(r, 1);
+    test_server_poll(&srv);
+}
+
+typedef struct {
+    int calls;
+    int nkeys;
+    int nchunks;
+    int failed;
+    int errors; //值和 key 对不上的个数
+} result_t;
+
+static const char** test_keys;
+
+static void check_cb(redis_multi_t* m, void* privdata)
+{
+    result_t* res = (result_t*)privdata;
+    res->calls++;
+    res->nkeys = m->nkeys;
+    res->nchunks = m->nchunks;
+    res->failed = m->failed;
+    for (int i = 0; m->values && i < m->nkeys; i++) {
+        redis_multi_value_t* v = &m->values[i];
+        if (strstr(test_keys[i], "missing") || !v->str) {
+            res->errors += (v->str != NULL) != (strstr(test_keys[i], "missing") == NULL);
+            continue;
+        }
+        res->errors += !(v->len == strlen(test_keys[i]) + 2 && memcmp(v->str, "v:", 2) == 0
+            && memcmp(v->str + 2, test_keys[i], v->len - 2) == 0);
+    }
+}
+
+static void pump_until(reactor_t* r, int* counter, int expect)
+{
+    for (int i = 0; i < 1000 && *counter < expect; i++) {
+        pump(r);
+    }
+    assert(*counter == expect);
+}
+
+static int connected_members(redis_pool_t* p)
+{
+    int n = 0;
+    for (int i = 0; i < p->size; i++) {
+        redis_conn_t* c = p->members[i].c;
+        n += c && (c->flags & REDIS_CONN_CONNECTED);
+    }
+    return n;
+}
+
+static redis_pool_t* setup(reactor_t* r)
+{
+    redis_pool_t* p = redis_pool_create(r, "127.0.0.1", TEST_PORT, POOL_SIZE);
+    assert(p);
+    for (int i = 0; i < 500 && connected_members(p) < POOL_SIZE; i++) {
+        pump(r);
+    }
+    assert(connected_members(p) == POOL_SIZE);
+    return p;
+}
+
+static const char** make_keys(int n, int missing_every)
+{
+    const char** keys = malloc(sizeof(char*) * n);
+    for (int i = 0; i < n; i++) {
+        char* k = malloc(32);
+        snprintf(k, 32, missing_every && i % missing_every == 0 ? "missing:%d" : "key:%d", i);
+        keys[i] = k;
+    }
+    return keys;
+}
+
+static void free_keys(const char** keys, int n)
+{
+    for (int i = 0; i < n; i++) {
+        free((char*)keys[i]);
+    }
+    free(keys);
+}
+
+// 测试用例1：拆成多条 MGET 分散到各条连接，结果按原顺序排列
+void test_mget() {
+    printf("Test 1: Scatter/gather MGET\n");
+    reactor_t* r = create_reactor();
+    redis_pool_t* p = setup(r);
+    int n = 1000;
+    test_keys = make_keys(n, 7);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+
+    assert(redis_multi_get(p, n, test_keys, NULL, check_cb, &res) == 0);
+    assert(res.calls == 0);
+    pump_until(r, &res.calls, 1);
+    assert(res.nkeys == n && res.failed == 0 && res.errors == 0);
+    assert(res.nchunks == (n + REDIS_MULTI_BATCH - 1) / REDIS_MULTI_BATCH);
+    int busy = 0, total = 0;
+    for (int i = 0; i < TEST_SERVER_MAX_CLIENTS; i++) {
+        test_client_t* cl = &srv.clients[i];
+        busy += cl->fd >= 0 && cl->cmds > 0;
+        total += cl->fd >= 0 ? cl->cmds : 0;
+    }
+    assert(total == res.nchunks && busy == POOL_SIZE);
+
+    // 空 key 列表时在返回前回调
+    assert(redis_multi_get(p, 0, test_keys, NULL, check_cb, &res) == 0);
+    assert(res.calls == 2 && res.nkeys == 0 && res.nchunks == 0);
+
+    free_keys(test_keys, n);
+    redis_pool_free(p);
+    for (int i = 0; i < 10; i++) {
+        pump(r);
+    }
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例2：MSET 按批次发出，key 和 value 一一对应
+void test_mset() {
+    printf("Test 2: Scatter MSET\n");
+    reactor_t* r = create_reactor();
+    redis_pool_t* p = setup(r);
+    int n = 600;
+    test_keys = make_keys(n, 0);
+    const char** values = malloc(sizeof(char*) * n);
+    for (int i = 0; i < n; i++) {
+        char* v = malloc(40);
+        snprintf(v, 40, "x:%s", test_keys[i]);
+        values[i] = v;
+    }
+    result_t res;
+    memset(&res, 0, sizeof(res));
+    mset_pairs = 0;
+
+    assert(redis_multi_set(p, n, test_keys, NULL, values, NULL, check_cb, &res) == 0);
+    pump_until(r, &res.calls, 1);
+    assert(res.failed == 0 && res.nchunks == 3 && mset_pairs == n);
+    assert(redis_multi_set(p, n, test_keys, NULL, NULL, NULL, check_cb, &res) == -1);
+
+    for (int i = 0; i < n; i++) {
+        free((char*)values[i]);
+    }
+    free(values);
+    free_keys(test_keys, n);
+    redis_pool_free(p);
+    for (int i = 0; i < 10; i++) {
+        pump(r);
+    }
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例3：一条连接断开，只有它上面那批 key 没有结果，回调仍然只调一次
+void test_partial_failure() {
+    printf("Test 3: Partial failure\n");
+    reactor_t* r = create_reactor();
+    redis_pool_t* p = setup(r);
+    int n = REDIS_MULTI_BATCH * 3;
+    test_keys = make_keys(n, 0);
+    result_t res;
+    memset(&res, 0, sizeof(res));
+
+    assert(redis_multi_get(p, n, test_keys, NULL, check_cb, &res) == 0);
+    eventloop_once(r, 0);
+    // 服务端在处理命令之前断开一条连接
+    for (int i = 0; i < TEST_SERVER_MAX_CLIENTS; i++) {
+        if (srv.clients[i].fd >= 0) {
+            test_server_drop(&srv, &srv.clients[i]);
+            break;
+        }
+    }
+    pump_until(r, &res.calls, 1);
+    assert(res.failed == REDIS_MULTI_BATCH && res.errors == REDIS_MULTI_BATCH);
+    for (int i = 0; i < 10; i++) {
+        pump(r);
+    }
+    assert(res.calls == 1);
+
+    free_keys(test_keys, n);
+    redis_pool_free(p);
+    for (int i = 0; i < 10; i++) {
+        pump(r);
+    }
+    release_reactor(r);
+    printf("Passed\n\n");
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    printf("Starting redis multi tests...\n\n");
+    test_server_open(&srv, TEST_PORT, handle, NULL);
+
+    test_mget();
+    test_mset();
+    test_partial_failure();
+
+    test_server_close(&srv);
+    printf("All tests passed!\n");
+    return 0;
+}
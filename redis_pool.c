@@ -0,0 +1,168 @@
+#include "redis_pool.h"
+
+static void _redis_member_connect(redis_member_t* m);
+
+static void _redis_member_retry_cb(timer_node_t* t, void* privdata)
+{
+	redis_member_t* m = (redis_member_t*)privdata;
+	m->retry = NULL;
+	m->pool->reconnects++;
+	_redis_member_connect(m);
+}
+
+// 连接已经（或即将）被释放，登记一次重连，等待时间逐次翻倍
+static void _redis_member_schedule(redis_member_t* m)
+{
+	m->c = NULL;
+	m->retry = add_timer(m->pool->r, m->retry_ms, _redis_member_retry_cb, m);
+	m->retry_ms *= 2;
+	if (m->retry_ms > REDIS_POOL_RETRY_MAX_MS) {
+		m->retry_ms = REDIS_POOL_RETRY_MAX_MS;
+	}
+}
+
+static void _redis_member_connect_cb(redis_conn_t* c, int status)
+{
+	redis_member_t* m = (redis_member_t*)c->data;
+	if (status == 0) {
+		m->retry_ms = REDIS_POOL_RETRY_MIN_MS;
+		return;
+	}
+	_redis_member_schedule(m);
+}
+
+static void _redis_member_disconnect_cb(redis_conn_t* c, int status)
+{
+	_redis_member_schedule((redis_member_t*)c->data);
+}
+
+static void _redis_member_connect(redis_member_t* m)
+{
+	redis_pool_t* p = m->pool;
+	redis_conn_t* c = redis_connect(p->r, p->host, p->port);
+	if (!c) {
+		_redis_member_schedule(m);
+		return;
+	}
+	c->data = m;
+	c->connect_fn = _redis_member_connect_cb;
+	c->disconnect_fn = _redis_member_disconnect_cb;
+	redis_conn_set_pipelining(c, p->pipelining);
+	m->c = c;
+}
+
+redis_pool_t* redis_pool_create(reactor_t* r, const char* host, int port, int size)
+{
+	if (size <= 0 || strlen(host) >= REDIS_POOL_MAX_HOST) {
+		return NULL;
+	}
+	redis_pool_t* p = (redis_pool_t*)calloc(1, sizeof(redis_pool_t));
+	if (!p) {
+		return NULL;
+	}
+	p->members = (redis_member_t*)calloc(size, sizeof(redis_member_t));
+	if (!p->members) {
+		free(p);
+		return NULL;
+	}
+	p->r = r;
+	strcpy(p->host, host);
+	p->port = port;
+	p->size = size;
+	for (int i = 0; i < size; i++) {
+		redis_member_t* m = &p->members[i];
+		m->pool = p;
+		m->index = i;
+		m->retry_ms = REDIS_POOL_RETRY_MIN_MS;
+		_redis_member_connect(m);
+	}
+	return p;
+}
+
+void redis_pool_free(redis_pool_t* p)
+{
+	for (int i = 0; i < p->size; i++) {
+		redis_member_t* m = &p->members[i];
+		if (m->retry) {
+			del_timer(p->r, m->retry);
+		}
+		if (m->c) {
+			// 主动释放，不再触发重连
+			m->c->connect_fn = NULL;
+			m->c->disconnect_fn = NULL;
+			redis_conn_free(m->c);
+		}
+	}
+	free(p->members);
+	free(p);
+}
+
+void redis_pool_set_pipelining(redis_pool_t* p, int on)
+{
+	p->pipelining = on;
+	for (int i = 0; i < p->size; i++) {
+		if (p->members[i].c) {
+			redis_conn_set_pipelining(p->members[i].c, on);
+		}
+	}
+}
+
+static inline int _redis_conn_usable(redis_conn_t* c)
+{
+	return c && !c->err && !(c->flags & REDIS_CONN_FREEING);
+}
+
+static uint32_t _redis_pin_hash(const char* key, size_t len)
+{
+	uint32_t h = 2166136261u; //FNV-1a
+	for (size_t i = 0; i < len; i++) {
+		h ^= (uint8_t)key[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+redis_conn_t* redis_pool_get(redis_pool_t* p, const char* pin, size_t pinlen)
+{
+	if (pin) {
+		redis_conn_t* c = p->members[_redis_pin_hash(pin, pinlen) % p->size].c;
+		return _redis_conn_usable(c) ? c : NULL;
+	}
+	redis_conn_t* best = NULL;
+	uint64_t best_load = UINT64_MAX;
+	for (int i = 0; i < p->size; i++) {
+		redis_conn_t* c = p->members[(p->rr + i) % p->size].c;
+		if (!_redis_conn_usable(c)) {
+			continue;
+		}
+		// 还在连接中的成员也能先攒命令，但排在所有已连接成员之后
+		uint64_t load = c->cb_count;
+		if (!(c->flags & REDIS_CONN_CONNECTED)) {
+			load += (uint64_t)1 << 32;
+		}
+		if (load < best_load) {
+			best = c;
+			best_load = load;
+		}
+	}
+	p->rr++;
+	return best;
+}
+
+int redis_pool_command_argv(redis_pool_t* p, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen)
+{
+	redis_conn_t* c = redis_pool_get(p, NULL, 0);
+	if (!c) {
+		return -1;
+	}
+	return redis_conn_command_argv(c, fn, privdata, argc, argv, argvlen);
+}
+
+int redis_pool_command_pinned(redis_pool_t* p, const char* key, size_t keylen, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen)
+{
+	redis_conn_t* c = redis_pool_get(p, key, keylen);
+	if (!c) {
+		return -1;
+	}
+	return redis_conn_command_argv(c, fn, privdata, argc, argv, argvlen);
+}
@@ -0,0 +1,55 @@
+#ifndef __REDIS_POOL_H__
+#define __REDIS_POOL_H__
+
+#include "redis_client.h"
+
+// 同一个 reactor 内到同一个 redis 的 N 条连接：
+// 普通命令路由到未完成回复最少的连接，避免小命令排在大回复后面（队头阻塞）；
+// 需要保证顺序的命令可以按 key 固定到某一条连接；
+// 断开的连接由定时器在后台按指数退避重连。
+
+#define REDIS_POOL_RETRY_MIN_MS	100
+#define REDIS_POOL_RETRY_MAX_MS	5000
+#define REDIS_POOL_MAX_HOST		64
+
+typedef struct redis_pool_s redis_pool_t;
+typedef struct redis_member_s redis_member_t;
+
+struct redis_member_s
+{
+	redis_pool_t* pool;
+	int index;
+	redis_conn_t* c; //断开期间为 NULL
+	uint32_t retry_ms; //下一次重连的等待时间
+	timer_node_t* retry;
+};
+
+struct redis_pool_s
+{
+	reactor_t* r;
+	char host[REDIS_POOL_MAX_HOST];
+	int port;
+	int size;
+	int pipelining;
+	uint32_t rr; //未完成回复数相同时轮流选择的起点
+	redis_member_t* members;
+	uint64_t reconnects;
+};
+
+redis_pool_t* redis_pool_create(reactor_t* r, const char* host, int port, int size);
+
+// 释放所有连接，未完成的回调以 reply == NULL 调用
+void redis_pool_free(redis_pool_t* p);
+
+void redis_pool_set_pipelining(redis_pool_t* p, int on);
+
+// pin 为 NULL 时返回未完成回复最少的连接；
+// 否则按 pin 的哈希固定返回同一条连接，该连接断开时返回 NULL（不会换到别的连接上打乱顺序）
+redis_conn_t* redis_pool_get(redis_pool_t* p, const char* pin, size_t pinlen);
+
+int redis_pool_command_argv(redis_pool_t* p, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen);
+
+// 按 key 固定连接的版本，同一个 key 的命令按发送顺序执行
+int redis_pool_command_pinned(redis_pool_t* p, const char* key, size_t keylen, redis_reply_fn fn, void* privdata, int argc, const char** argv, const size_t* argvlen);
+
+#endif
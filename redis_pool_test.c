@@ -0,0 +1,175 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <signal.h>
+#include "redis_pool.h"
+#include "redis_test_server.h"
+
+// 编译: gcc reactor.c reactor_uring.c ringbuffer/ringbuffer.c ringbuffer/mpmc_ring.c chainbuffer/chainbuffer.c memsearch/memsearch.c timewheel/timewheel.c resp/resp_parser.c redis_client.c redis_pool.c redis_test_server.c redis_pool_test.c -o redis_pool_test -lpthread
+// 服务端只是一个监听 socket：握手由内核完成，测试按需 accept 再关闭来模拟断线
+
+#define TEST_PORT 16390
+#define POOL_SIZE 4
+
+static int connected_members(redis_pool_t* p)
+{
+    int n = 0;
+    for (int i = 0; i < p->size; i++) {
+        redis_conn_t* c = p->members[i].c;
+        if (c && (c->flags & REDIS_CONN_CONNECTED)) {
+            n++;
+        }
+    }
+    return n;
+}
+
+static void wait_connected(reactor_t* r, redis_pool_t* p, int expect)
+{
+    for (int i = 0; i < 500 && connected_members(p) < expect; i++) {
+        eventloop_once(r, 10);
+    }
+    assert(connected_members(p) == expect);
+}
+
+// 关掉所有已经建立的服务端连接
+static int drop_all(int lfd)
+{
+    int n = 0, fd;
+    while ((fd = accept(lfd, NULL, NULL)) >= 0) {
+        close(fd);
+        n++;
+    }
+    return n;
+}
+
+static int g_nulls = 0;
+
+static void count_null_cb(redis_conn_t* c, resp_reply_t* reply, void* privdata)
+{
+    if (!reply) {
+        g_nulls++;
+    }
+}
+
+// 测试用例1：按未完成回复数路由
+void test_least_outstanding() {
+    printf("Test 1: Least-outstanding routing\n");
+    int lfd = test_listen_local(TEST_PORT);
+    reactor_t* r = create_reactor();
+    redis_pool_t* p = redis_pool_create(r, "127.0.0.1", TEST_PORT, POOL_SIZE);
+    assert(p);
+    wait_connected(r, p, POOL_SIZE);
+
+    const char* argv[] = { "GET", "k" };
+    for (int i = 0; i < 2 * POOL_SIZE; i++) {
+        assert(redis_pool_command_argv(p, NULL, NULL, 2, argv, NULL) == 0);
+    }
+    for (int i = 0; i < POOL_SIZE; i++) {
+        assert(p->members[i].c->cb_count == 2);
+    }
+
+    // 第 0 条连接上堆积了大量回复，后续命令绕开它
+    redis_conn_t* busy = p->members[0].c;
+    for (int i = 0; i < 5; i++) {
+        assert(redis_conn_command_argv(busy, NULL, NULL, 2, argv, NULL) == 0);
+    }
+    for (int i = 0; i < 2 * (POOL_SIZE - 1); i++) {
+        assert(redis_pool_command_argv(p, NULL, NULL, 2, argv, NULL) == 0);
+    }
+    assert(busy->cb_count == 7);
+    for (int i = 1; i < POOL_SIZE; i++) {
+        assert(p->members[i].c->cb_count == 4);
+    }
+
+    redis_pool_free(p);
+    assert(r->nused == 0);
+    release_reactor(r);
+    drop_all(lfd);
+    close(lfd);
+    printf("Passed\n\n");
+}
+
+// 测试用例2：key 固定连接，断线期间不换连接
+void test_pinning() {
+    printf("Test 2: Key pinning\n");
+    int lfd = test_listen_local(TEST_PORT);
+    reactor_t* r = create_reactor();
+    redis_pool_t* p = redis_pool_create(r, "127.0.0.1", TEST_PORT, POOL_SIZE);
+    wait_connected(r, p, POOL_SIZE);
+
+    redis_conn_t* c = redis_pool_get(p, "user:42", 7);
+    assert(c);
+    for (int i = 0; i < 10; i++) {
+        assert(redis_pool_get(p, "user:42", 7) == c);
+    }
+    int spread = 0;
+    char key[32];
+    for (int i = 0; i < 64; i++) {
+        int len = snprintf(key, sizeof(key), "user:%d", i);
+        spread |= 1 << redis_pool_get(p, key, len)->fd % 32;
+    }
+    assert(__builtin_popcount(spread) > 1);
+
+    // 服务端断开后 pin 拿不到连接，直到重连成功
+    g_nulls = 0;
+    const char* argv[] = { "INCR", "user:42" };
+    assert(redis_pool_command_pinned(p, "user:42", 7, count_null_cb, NULL, 2, argv, NULL) == 0);
+    assert(drop_all(lfd) == POOL_SIZE);
+    for (int i = 0; i < 100 && connected_members(p) > 0; i++) {
+        eventloop_once(r, 10);
+    }
+    assert(g_nulls == 1);
+    assert(redis_pool_get(p, "user:42", 7) == NULL);
+    assert(redis_pool_command_pinned(p, "user:42", 7, NULL, NULL, 2, argv, NULL) == -1);
+
+    wait_connected(r, p, POOL_SIZE);
+    assert(p->reconnects == POOL_SIZE);
+    assert(redis_pool_get(p, "user:42", 7) != NULL);
+
+    redis_pool_free(p);
+    release_reactor(r);
+    drop_all(lfd);
+    close(lfd);
+    printf("Passed\n\n");
+}
+
+// 测试用例3：服务端不可用时指数退避重连
+void test_backoff() {
+    printf("Test 3: Reconnect backoff\n");
+    reactor_t* r = create_reactor();
+    redis_pool_t* p = redis_pool_create(r, "127.0.0.1", TEST_PORT, 1);
+    assert(redis_pool_get(p, NULL, 0) != NULL); //连接中的成员也可以先攒命令
+
+    uint64_t start = timewheel_now();
+    while (p->reconnects < 3 && timewheel_now() - start < 5000) {
+        eventloop_once(r, 50);
+    }
+    // 100 + 200 + 400 ms
+    assert(p->reconnects == 3);
+    assert(timewheel_now() - start >= 700);
+
+    // 服务端恢复后连上，退避时间复位
+    int lfd = test_listen_local(TEST_PORT);
+    wait_connected(r, p, 1);
+    assert(p->members[0].retry_ms == REDIS_POOL_RETRY_MIN_MS);
+
+    redis_pool_free(p);
+    assert(r->nused == 0);
+    release_reactor(r);
+    drop_all(lfd);
+    close(lfd);
+    printf("Passed\n\n");
+}
+
+int main() {
+    signal(SIGPIPE, SIG_IGN);
+    printf("Starting redis pool tests...\n\n");
+
+    test_least_outstanding();
+    test_pinning();
+    test_backoff();
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "redis_test_server.h"
+
+int test_listen_local(int port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+    assert(listen(fd, 64) == 0);
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    return fd;
+}
+
+void test_server_open(test_server_t* s, int port, test_server_fn fn, void* data)
+{
+    memset(s, 0, sizeof(*s));
+    s->lfd = test_listen_local(port);
+    s->port = port;
+    s->fn = fn;
+    s->data = data;
+    for (int i = 0; i < TEST_SERVER_MAX_CLIENTS; i++) {
+        s->clients[i].fd = -1;
+        s->clients[i].in = malloc(TEST_SERVER_BUF_SIZE);
+        assert(s->clients[i].in);
+    }
+}
+
+void test_server_close(test_server_t* s)
+{
+    for (int i = 0; i < TEST_SERVER_MAX_CLIENTS; i++) {
+        if (s->clients[i].fd >= 0) {
+            close(s->clients[i].fd);
+        }
+        free(s->clients[i].in);
+    }
+    close(s->lfd);
+}
+
+void test_server_drop(test_server_t* s, test_client_t* cl)
+{
+    assert(cl >= s->clients && cl < s->clients + TEST_SERVER_MAX_CLIENTS && cl->fd >= 0);
+    close(cl->fd);
+    cl->fd = -1;
+}
+
+int test_server_clients(test_server_t* s)
+{
+    int n = 0;
+    for (int i = 0; i < TEST_SERVER_MAX_CLIENTS; i++) {
+        n += s->clients[i].fd >= 0;
+    }
+    return n;
+}
+
+void test_write(test_client_t* cl, const char* p, size_t len)
+{
+    while (len > 0) {
+        ssize_t n = write(cl->fd, p, len);
+        assert(n > 0);
+        p += n;
+        len -= n;
+    }
+}
+
+void test_reply(test_client_t* cl, const char* fmt, ...)
+{
+    char buf[4096];
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(buf, sizeof(buf), fmt, ap);
+    va_end(ap);
+    assert(len >= 0 && len < (int)sizeof(buf));
+    test_write(cl, buf, len);
+}
+
+// 解析并处理 in 中所有完整的命令，不完整的留到下次
+static void _test_server_serve(test_server_t* s, test_client_t* cl)
+{
+    size_t pos = 0;
+    while (pos < cl->inlen) {
+        char* p = cl->in + pos;
+        char* end = cl->in + cl->inlen;
+        char* nl = memchr(p, '\n', end - p);
+        if (!nl) {
+            break;
+        }
+        assert(*p == '*');
+        int argc = atoi(p + 1);
+        assert(argc > 0 && argc <= TEST_SERVER_MAX_ARGS);
+        p = nl + 1;
+        int i;
+        for (i = 0; i < argc; i++) {
+            nl = memchr(p, '\n', end - p);
+            if (!nl) {
+                break;
+            }
+            size_t len = atoi(p + 1);
+            if ((size_t)(end - nl - 1) < len + 2) {
+                break;
+            }
+            s->lens[i] = len;
+            s->argv[i] = nl + 1;
+            s->argv[i][len] = '\0';
+            p = nl + 1 + len + 2;
+        }
+        if (i < argc) {
+            break;
+        }
+        cl->cmds++;
+        s->fn(s, cl, argc, s->argv, s->lens);
+        pos = p - cl->in;
+        if (cl->fd < 0) {
+            //回调里断开了连接
+            return;
+        }
+    }
+    memmove(cl->in, cl->in + pos, cl->inlen - pos);
+    cl->inlen -= pos;
+}
+
+void test_server_poll(test_server_t* s)
+{
+    int fd;
+    while ((fd = accept(s->lfd, NULL, NULL)) >= 0) {
+        int i;
+        for (i = 0; i < TEST_SERVER_MAX_CLIENTS && s->clients[i].fd >= 0; i++);
+        assert(i < TEST_SERVER_MAX_CLIENTS);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        test_client_t* cl = &s->clients[i];
+        cl->fd = fd;
+        cl->inlen = 0;
+        cl->cmds = 0;
+        cl->state = 0;
+    }
+    for (int i = 0; i < TEST_SERVER_MAX_CLIENTS; i++) {
+        test_client_t* cl = &s->clients[i];
+        if (cl->fd < 0) {
+            continue;
+        }
+        ssize_t got = -1;
+        while (cl->inlen < TEST_SERVER_BUF_SIZE && (got = read(cl->fd, cl->in + cl->inlen, TEST_SERVER_BUF_SIZE - cl->inlen)) > 0) {
+            cl->inlen += got;
+        }
+        if (got == 0) {
+            test_server_drop(s, cl);
+            continue;
+        }
+        _test_server_serve(s, cl);
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef __REDIS_TEST_SERVER_H__
+#define __REDIS_TEST_SERVER_H__
+
+#include <stddef.h>
+
+// 测试用的假 RESP 服务器，和被测的 reactor 跑在同一个线程里：
+// 测试每轮 eventloop_once 之后调用 test_server_poll，accept 新连接、读出所有完整的命令交给回调处理。
+// 编译测试时一起带上 redis_test_server.c
+
+#define TEST_SERVER_MAX_CLIENTS	8
+#define TEST_SERVER_MAX_ARGS	1024
+#define TEST_SERVER_BUF_SIZE	(1 << 20)
+
+typedef struct test_server_s test_server_t;
+typedef struct test_client_s test_client_t;
+
+// argv[i] 以 '\0' 结尾，回调返回后失效
+typedef void (*test_server_fn)(test_server_t* s, test_client_t* cl, int argc, char** argv, size_t* lens);
+
+struct test_client_s
+{
+    int fd; //空闲时为 -1
+    char* in;
+    size_t inlen;
+    int cmds; //这条连接上处理过的命令数
+    int state; //给测试自己记连接状态（如 ASKING），accept 时清零
+};
+
+struct test_server_s
+{
+    int lfd;
+    int port;
+    test_server_fn fn;
+    void* data;
+    test_client_t clients[TEST_SERVER_MAX_CLIENTS];
+    char* argv[TEST_SERVER_MAX_ARGS];
+    size_t lens[TEST_SERVER_MAX_ARGS];
+};
+
+// 监听 127.0.0.1:port 的非阻塞 socket
+int test_listen_local(int port);
+
+void test_server_open(test_server_t* s, int port, test_server_fn fn, void* data);
+
+void test_server_close(test_server_t* s);
+
+void test_server_poll(test_server_t* s);
+
+// 服务端主动断开一条连接
+void test_server_drop(test_server_t* s, test_client_t* cl);
+
+// 当前建立着的连接数
+int test_server_clients(test_server_t* s);
+
+void test_write(test_client_t* cl, const char* p, size_t len);
+
+void test_reply(test_client_t* cl, const char* fmt, ...);
+
+#endif
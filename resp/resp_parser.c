@@ -0,0 +1,479 @@
+#include "resp_parser.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+void resp_parser_init(resp_parser_t* p)
+{
+	memset(p, 0, sizeof(resp_parser_t));
+}
+
+// 在 chain 链上定位绝对偏移 pos，pos 超出已有数据时返回 -1
+static int resp_seek(buffer_t* buf, uint32_t pos, resp_view_t* v)
+{
+	buf_chain_t* chain = buf->first;
+	while (chain && pos >= chain->off) {
+		pos -= chain->off;
+		chain = chain->next;
+	}
+	if (!chain) {
+		return -1;
+	}
+	v->chain = chain;
+	v->off = pos;
+	return 0;
+}
+
+static int resp_byte_at(buffer_t* buf, uint32_t pos)
+{
+	resp_view_t v;
+	if (resp_seek(buf, pos, &v) < 0) {
+		return -1;
+	}
+	return v.chain->buffer[v.chain->misalign + v.off];
+}
+
+static void resp_make_view(buffer_t* buf, uint32_t pos, uint32_t len, resp_view_t* v)
+{
+	if (resp_seek(buf, pos, v) < 0) {
+		v->chain = NULL;
+		v->off = 0;
+	}
+	v->len = len;
+}
+
+// 从绝对偏移 start 开始找 "\r\n"，返回 '\r' 的位置，找不到返回 -1
+static int64_t resp_find_crlf(buffer_t* buf, uint32_t start)
+{
+	resp_view_t c;
+	if (resp_seek(buf, start, &c) < 0) {
+		return -1;
+	}
+	buf_chain_t* ch = c.chain;
+	uint32_t off = c.off;
+	int64_t base = (int64_t)start - off; //当前 chain 有效数据起点的绝对偏移
+	int prev_cr = 0; //上一个 chain 以 '\r' 结尾
+
+	for (; ch; ch = ch->next, off = 0) {
+		if (ch->off == 0) {
+			continue;
+		}
+		uint8_t* data = ch->buffer + ch->misalign;
+		uint8_t* end = data + ch->off;
+		uint8_t* p = data + off;
+		if (prev_cr) {
+			if (data[0] == '\n') {
+				return base - 1;
+			}
+			prev_cr = 0;
+		}
+		while (p < end && (p = memchr(p, '\r', end - p)) != NULL) {
+			if (p + 1 < end) {
+				if (p[1] == '\n') {
+					return base + (p - data);
+				}
+				p++;
+			}
+			else {
+				prev_cr = 1;
+				break;
+			}
+		}
+		base += ch->off;
+	}
+	return -1;
+}
+
+static int resp_parse_number(buffer_t* buf, uint32_t pos, uint32_t len, long long* out)
+{
+	char tmp[RESP_MAX_LINE + 1];
+	resp_view_t v;
+	if (len == 0 || len > RESP_MAX_LINE) {
+		return -1;
+	}
+	resp_make_view(buf, pos, len, &v);
+	resp_view_copy(&v, tmp, len);
+	tmp[len] = '\0';
+
+	char* end;
+	errno = 0;
+	long long x = strtoll(tmp, &end, 10);
+	if (end != tmp + len || errno) {
+		return -1;
+	}
+	*out = x;
+	return 0;
+}
+
+// 一个值解析完毕：逐层扣减所在聚合的剩余元素数
+static void resp_complete_value(resp_parser_t* p)
+{
+	while (p->depth > 0) {
+		if (--p->remain[p->depth - 1] > 0) {
+			break;
+		}
+		p->depth--;
+		// 属性本身不算所在聚合的元素
+		if (p->attrs & (1u << p->depth)) {
+			p->attrs &= ~(1u << p->depth);
+			break;
+		}
+	}
+}
+
+static int resp_parse_bulk(resp_parser_t* p, buffer_t* buf, resp_value_t* v)
+{
+	uint32_t len = (uint32_t)p->bulk_len;
+	if (buffer_len(buf) - p->pos < (uint64_t)len + 2) {
+		return RESP_AGAIN;
+	}
+	if (resp_byte_at(buf, p->pos + len) != '\r' || resp_byte_at(buf, p->pos + len + 1) != '\n') {
+		p->err = 1;
+		return RESP_ERR;
+	}
+	memset(v, 0, sizeof(resp_value_t));
+	v->type = p->bulk_type;
+	v->depth = p->depth;
+	resp_make_view(buf, p->pos, len, &v->str);
+	p->pos += len + 2;
+	p->state = RESP_STATE_TYPE;
+	resp_complete_value(p);
+	return RESP_VALUE;
+}
+
+// 分块输出：每次输出当前 chain 里已有的数据。最后一个字节等 CRLF 到齐后随最后一块一起输出，
+// 这样最后一块一定带 RESP_CHUNK_LAST，调用方不会收到空块
+static int resp_parse_chunk(resp_parser_t* p, buffer_t* buf, resp_value_t* v)
+{
+	resp_view_t at;
+	if (resp_seek(buf, p->pos, &at) < 0) {
+		return RESP_AGAIN;
+	}
+	uint64_t left = p->bulk_len - p->bulk_off;
+	uint64_t n = at.chain->off - at.off;
+	int last = 0;
+	if (n >= left) {
+		n = left;
+		if (buffer_len(buf) - p->pos >= left + 2) {
+			if (resp_byte_at(buf, p->pos + left) != '\r' || resp_byte_at(buf, p->pos + left + 1) != '\n') {
+				p->err = 1;
+				return RESP_ERR;
+			}
+			last = 1;
+		}
+		else if (--n == 0) {
+			return RESP_AGAIN;
+		}
+	}
+	memset(v, 0, sizeof(resp_value_t));
+	v->type = p->bulk_type;
+	v->depth = p->depth;
+	v->str = at;
+	v->str.len = (uint32_t)n;
+	v->chunk = last ? RESP_CHUNK_LAST : RESP_CHUNK_MORE;
+	v->offset = p->bulk_off;
+	v->total = p->bulk_len;
+	p->pos += (uint32_t)n;
+	p->bulk_off += n;
+	if (last) {
+		p->pos += 2;
+		p->state = RESP_STATE_TYPE;
+		resp_complete_value(p);
+	}
+	return RESP_VALUE;
+}
+
+static int resp_parse_value(resp_parser_t* p, buffer_t* buf, resp_value_t* v)
+{
+	if (p->err) {
+		return RESP_ERR;
+	}
+	if (p->state == RESP_STATE_BULK) {
+		return resp_parse_bulk(p, buf, v);
+	}
+	if (p->state == RESP_STATE_STREAM) {
+		return resp_parse_chunk(p, buf, v);
+	}
+	if (p->pos >= buffer_len(buf)) {
+		return RESP_AGAIN;
+	}
+
+	int type = resp_byte_at(buf, p->pos);
+	uint32_t line = p->pos + 1;
+	int64_t cr = resp_find_crlf(buf, p->scan > line ? p->scan : line);
+	if (cr < 0) {
+		// 行还没收全，记下已经扫描过的位置（末尾可能是半个 CRLF，留一个字节）
+		p->scan = buffer_len(buf) - 1;
+		return RESP_AGAIN;
+	}
+	uint32_t linelen = (uint32_t)(cr - line);
+	long long n;
+
+	memset(v, 0, sizeof(resp_value_t));
+	v->type = type;
+	v->depth = p->depth;
+	p->scan = 0;
+
+	switch (type) {
+	case RESP_STRING:
+	case RESP_ERROR:
+	case RESP_DOUBLE:
+	case RESP_BIGNUM:
+		resp_make_view(buf, line, linelen, &v->str);
+		break;
+	case RESP_INTEGER:
+		if (resp_parse_number(buf, line, linelen, &v->integer) < 0) {
+			goto proto_err;
+		}
+		break;
+	case RESP_BOOL:
+		n = resp_byte_at(buf, line);
+		if (linelen != 1 || (n != 't' && n != 'f')) {
+			goto proto_err;
+		}
+		v->integer = (n == 't');
+		break;
+	case RESP_NULL:
+		if (linelen != 0) {
+			goto proto_err;
+		}
+		break;
+	case RESP_BULK:
+	case RESP_BLOB_ERROR:
+	case RESP_VERBATIM:
+		if (resp_parse_number(buf, line, linelen, &n) < 0) {
+			goto proto_err;
+		}
+		if (n == -1 && type == RESP_BULK) {
+			v->type = RESP_NULL;
+			break;
+		}
+		if (p->stream_min && n >= p->stream_min) {
+			if (n > RESP_MAX_STREAM_BULK) {
+				goto proto_err;
+			}
+			p->state = RESP_STATE_STREAM;
+			p->bulk_type = type;
+			p->bulk_len = (uint64_t)n;
+			p->bulk_off = 0;
+			p->pos = (uint32_t)cr + 2;
+			return resp_parse_chunk(p, buf, v);
+		}
+		if (n < 0 || n > BUFFER_CHAIN_MAX - 2) {
+			goto proto_err;
+		}
+		p->state = RESP_STATE_BULK;
+		p->bulk_type = type;
+		p->bulk_len = (uint32_t)n;
+		p->pos = (uint32_t)cr + 2;
+		return resp_parse_bulk(p, buf, v);
+	case RESP_ARRAY:
+	case RESP_MAP:
+	case RESP_SET:
+	case RESP_ATTR:
+	case RESP_PUSH:
+		if (resp_parse_number(buf, line, linelen, &n) < 0) {
+			goto proto_err;
+		}
+		if (n == -1 && type == RESP_ARRAY) {
+			v->type = RESP_NULL;
+			break;
+		}
+		// 先按上限检查再乘 2，个数来自网络，不能直接拿去分配
+		int64_t max = p->max_elements > 0 ? p->max_elements : RESP_MAX_ELEMENTS;
+		if (type == RESP_MAP || type == RESP_ATTR) {
+			max /= 2;
+		}
+		if (n < 0 || n > max) {
+			goto proto_err;
+		}
+		v->elements = (type == RESP_MAP || type == RESP_ATTR) ? n * 2 : n;
+		p->pos = (uint32_t)cr + 2;
+		if (v->elements > 0) {
+			if (p->depth >= RESP_MAX_DEPTH) {
+				goto proto_err;
+			}
+			if (type == RESP_ATTR) {
+				p->attrs |= 1u << p->depth;
+			}
+			p->remain[p->depth++] = v->elements;
+		}
+		else if (type != RESP_ATTR) {
+			resp_complete_value(p);
+		}
+		return RESP_VALUE;
+	default:
+		goto proto_err;
+	}
+
+	p->pos = (uint32_t)cr + 2;
+	resp_complete_value(p);
+	return RESP_VALUE;
+
+proto_err:
+	p->err = 1;
+	return RESP_ERR;
+}
+
+int resp_parser_next(resp_parser_t* p, buffer_t* buf, resp_value_t* v)
+{
+	while (1) {
+		// 属性开着的时候，下一个值一定在属性里面
+		int skip = p->attrs != 0;
+		int ret = resp_parse_value(p, buf, v);
+		if (ret != RESP_VALUE || !(skip || v->type == RESP_ATTR)) {
+			return ret;
+		}
+	}
+}
+
+void resp_parser_consume(resp_parser_t* p, buffer_t* buf)
+{
+	buffer_drain(buf, p->pos);
+	p->pos = 0;
+	p->scan = 0;
+}
+
+int resp_parser_peek_type(resp_parser_t* p, buffer_t* buf)
+{
+	if (p->state != RESP_STATE_TYPE || p->pos >= buffer_len(buf)) {
+		return -1;
+	}
+	return resp_byte_at(buf, p->pos);
+}
+
+uint32_t resp_view_copy(const resp_view_t* v, void* dst, uint32_t len)
+{
+	buf_chain_t* ch = v->chain;
+	uint32_t off = v->off;
+	uint8_t* d = (uint8_t*)dst;
+	if (len > v->len) {
+		len = v->len;
+	}
+	uint32_t left = len;
+	while (left && ch) {
+		uint32_t n = ch->off - off;
+		if (n > left) {
+			n = left;
+		}
+		memcpy(d, ch->buffer + ch->misalign + off, n);
+		d += n;
+		left -= n;
+		ch = ch->next;
+		off = 0;
+	}
+	return len - left;
+}
+
+char* resp_view_dup(const resp_view_t* v)
+{
+	char* s = (char*)malloc(v->len + 1);
+	if (!s) {
+		return NULL;
+	}
+	resp_view_copy(v, s, v->len);
+	s[v->len] = '\0';
+	return s;
+}
+
+int resp_view_eq(const resp_view_t* v, const char* s, uint32_t len)
+{
+	if (v->len != len) {
+		return 0;
+	}
+	buf_chain_t* ch = v->chain;
+	uint32_t off = v->off;
+	while (len && ch) {
+		uint32_t n = ch->off - off;
+		if (n > len) {
+			n = len;
+		}
+		if (memcmp(ch->buffer + ch->misalign + off, s, n) != 0) {
+			return 0;
+		}
+		s += n;
+		len -= n;
+		ch = ch->next;
+		off = 0;
+	}
+	return len == 0;
+}
+
+const uint8_t* resp_view_ptr(const resp_view_t* v)
+{
+	if (!v->chain) {
+		return NULL;
+	}
+	if (v->off + v->len > v->chain->off) {
+		return NULL;
+	}
+	return v->chain->buffer + v->chain->misalign + v->off;
+}
+
+void resp_reader_init(resp_reader_t* rd)
+{
+	memset(rd, 0, sizeof(resp_reader_t));
+}
+
+static void resp_reply_free_children(resp_reply_t* r)
+{
+	if (!r->element) {
+		return;
+	}
+	for (int64_t i = 0; i < r->elements; i++) {
+		resp_reply_free_children(&r->element[i]);
+	}
+	free(r->element);
+	r->element = NULL;
+}
+
+int resp_reader_next(resp_reader_t* rd, buffer_t* buf, resp_reply_t** reply)
+{
+	resp_value_t v;
+	if (rd->ready) {
+		*reply = &rd->root;
+		return RESP_VALUE;
+	}
+	while (1) {
+		int ret = resp_parser_next(&rd->parser, buf, &v);
+		if (ret != RESP_VALUE) {
+			return ret;
+		}
+		resp_reply_t* node = &rd->root;
+		if (v.depth > 0) {
+			node = &rd->stack[v.depth - 1]->element[rd->filled[v.depth - 1]++];
+		}
+		node->type = v.type;
+		node->integer = v.integer;
+		node->elements = v.elements;
+		node->element = NULL;
+		node->str = v.str;
+		if (v.elements > 0) {
+			node->element = (resp_reply_t*)calloc(v.elements, sizeof(resp_reply_t));
+			if (!node->element) {
+				rd->parser.err = 1;
+				return RESP_ERR;
+			}
+			rd->stack[v.depth] = node;
+			rd->filled[v.depth] = 0;
+		}
+		if (resp_parser_reply_done(&rd->parser)) {
+			rd->ready = 1;
+			*reply = &rd->root;
+			return RESP_VALUE;
+		}
+	}
+}
+
+void resp_reader_consume(resp_reader_t* rd, buffer_t* buf)
+{
+	resp_reply_free_children(&rd->root);
+	rd->ready = 0;
+	resp_parser_consume(&rd->parser, buf);
+}
+
+void resp_reader_reset(resp_reader_t* rd)
+{
+	resp_reply_free_children(&rd->root);
+	resp_reader_init(rd);
+}
@@ -0,0 +1,152 @@
+#ifndef __RESP_PARSER_H__
+#define __RESP_PARSER_H__
+
+#include <stdint.h>
+#include "../chainbuffer/chainbuffer.h"
+
+// RESP2/RESP3 增量解析器，直接在 chainbuffer 上工作：
+// 每次 resp_parser_next 吐出一个值（标量或聚合类型的头部），字符串类数据以 view
+// （chain + 偏移 + 长度）的形式指向 buffer 内部，不做拷贝；数据不完整时返回 RESP_AGAIN，
+// 下次带着更多数据再调用即可从断点继续。
+// view 在调用 resp_parser_consume（drain 掉已解析的数据）之前有效，期间只允许往 buffer 追加数据。
+// 设置了 stream_min 时，长度达到 stream_min 的 bulk 不等收全，按到达的数据分块输出，
+// 每块只落在一个 chain 内，调用方每块 consume 一次，整个值不需要同时驻留在内存里。
+// RESP3 的属性（|）描述的是紧随其后的那个值，解析器直接跳过，不输出，也不计入所在聚合的元素数。
+
+#define RESP_MAX_DEPTH		32
+#define RESP_MAX_LINE		64 //数字行（长度、整数）的最大长度
+#define RESP_MAX_STREAM_BULK	(512LL * 1024 * 1024) //分块输出的 bulk 最大长度，和 redis 的 proto-max-bulk-len 默认值一致
+#define RESP_MAX_ELEMENTS	(1LL << 22) //聚合类型默认的子元素个数上限，reader 为一个聚合最多分配约 200MB
+
+#define RESP_AGAIN			0
+#define RESP_VALUE			1
+#define RESP_ERR			-1
+
+#define RESP_CHUNK_MORE		1 //分块输出的 bulk，后面还有
+#define RESP_CHUNK_LAST		2 //分块输出的 bulk 的最后一块
+
+typedef enum {
+	RESP_STRING = '+',
+	RESP_ERROR = '-',
+	RESP_INTEGER = ':',
+	RESP_BULK = '$',
+	RESP_ARRAY = '*',
+	// RESP3
+	RESP_NULL = '_', //RESP2 的 $-1 / *-1 也统一报告为 RESP_NULL
+	RESP_DOUBLE = ',',
+	RESP_BOOL = '#',
+	RESP_BLOB_ERROR = '!',
+	RESP_VERBATIM = '=',
+	RESP_BIGNUM = '(',
+	RESP_MAP = '%',
+	RESP_SET = '~',
+	RESP_ATTR = '|',
+	RESP_PUSH = '>',
+} resp_type_t;
+
+typedef struct resp_view_s resp_view_t;
+typedef struct resp_value_s resp_value_t;
+typedef struct resp_parser_s resp_parser_t;
+typedef struct resp_reply_s resp_reply_t;
+typedef struct resp_reader_s resp_reader_t;
+
+struct resp_view_s
+{
+	buf_chain_t* chain;
+	uint32_t off; //相对 chain 有效数据起点（misalign 之后）的偏移
+	uint32_t len;
+};
+
+struct resp_value_s
+{
+	int type;
+	int depth; //嵌套层数，顶层为 0
+	long long integer; //INTEGER 的值，BOOL 为 0/1
+	int64_t elements; //聚合类型的子元素个数（MAP 为键值对数 * 2）
+	resp_view_t str; //STRING/ERROR/BULK/DOUBLE/BIGNUM/VERBATIM/BLOB_ERROR 的内容
+	int chunk; //0 为完整的值，分块输出时为 RESP_CHUNK_MORE / RESP_CHUNK_LAST，str 为本块数据
+	uint64_t offset; //本块在整个 bulk 中的偏移
+	uint64_t total; //分块输出的 bulk 的总长度
+};
+
+enum {
+	RESP_STATE_TYPE = 0,
+	RESP_STATE_BULK,
+	RESP_STATE_STREAM, //分块输出大 bulk
+};
+
+struct resp_parser_s
+{
+	int state;
+	int err;
+	uint32_t pos; //已解析到的位置（相对 buffer 起点）
+	uint32_t scan; //当前行已确认没有 CRLF 的位置，数据不完整时下次从这里继续找
+	int bulk_type;
+	uint64_t bulk_len;
+	uint64_t bulk_off; //分块输出时已经输出的字节数
+	uint32_t stream_min; //bulk 长度达到这个值时分块输出，0 表示不分块
+	int64_t max_elements; //聚合的子元素个数超过它时按协议错误处理，0 表示 RESP_MAX_ELEMENTS
+	int depth;
+	int64_t remain[RESP_MAX_DEPTH]; //每层聚合还剩多少个子元素
+	uint32_t attrs; //第 i 位表示第 i 层是正在跳过的属性
+};
+
+void resp_parser_init(resp_parser_t* p);
+
+int resp_parser_next(resp_parser_t* p, buffer_t* buf, resp_value_t* v);
+
+// 紧接在 resp_parser_next 返回 RESP_VALUE 之后调用：整条顶层回复是否已经解析完
+static inline int resp_parser_reply_done(resp_parser_t* p)
+{
+	return p->depth == 0 && p->state == RESP_STATE_TYPE;
+}
+
+void resp_parser_consume(resp_parser_t* p, buffer_t* buf);
+
+// 下一个值的类型字节，还没有数据时返回 -1
+int resp_parser_peek_type(resp_parser_t* p, buffer_t* buf);
+
+uint32_t resp_view_copy(const resp_view_t* v, void* dst, uint32_t len);
+
+char* resp_view_dup(const resp_view_t* v);
+
+int resp_view_eq(const resp_view_t* v, const char* s, uint32_t len);
+
+// view 落在单个 chain 内时返回其起始地址，跨 chain 时返回 NULL
+const uint8_t* resp_view_ptr(const resp_view_t* v);
+
+// -------------------------- 整条回复 --------------------------
+// 在 parser 之上把一条顶层回复组装成树，字符串仍然是指向 buffer 的 view。
+// 顶层节点内嵌在 reader 中，标量回复（GET/SET/INCR 等）不做任何内存分配；
+// 每个非空聚合只分配一次（子节点连续存放）。
+
+struct resp_reply_s
+{
+	int type;
+	long long integer;
+	int64_t elements;
+	resp_reply_t* element; //elements 个子节点组成的数组
+	resp_view_t str;
+};
+
+struct resp_reader_s
+{
+	resp_parser_t parser;
+	resp_reply_t root;
+	resp_reply_t* stack[RESP_MAX_DEPTH]; //每层正在填充的聚合节点
+	int64_t filled[RESP_MAX_DEPTH]; //每层已经填了几个子节点
+	int ready; //root 是一条完整的回复，等待 resp_reader_consume
+};
+
+void resp_reader_init(resp_reader_t* rd);
+
+// 返回 RESP_VALUE 时 *reply 指向一条完整的顶层回复，在 resp_reader_consume 之前有效
+int resp_reader_next(resp_reader_t* rd, buffer_t* buf, resp_reply_t** reply);
+
+// 释放回复树并 drain 掉对应的数据
+void resp_reader_consume(resp_reader_t* rd, buffer_t* buf);
+
+// 释放未完成的回复树（连接关闭时调用）
+void resp_reader_reset(resp_reader_t* rd);
+
+#endif
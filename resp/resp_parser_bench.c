@@ -0,0 +1,148 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <hiredis/hiredis.h>
+#include "resp_parser.h"
+
+// 编译: gcc -O2 resp_parser.c ../chainbuffer/chainbuffer.c ../memsearch/memsearch.c resp_parser_bench.c -o resp_parser_bench -lhiredis
+// 用法: ./resp_parser_bench [元素个数] [元素大小] [轮数]
+
+#define FEED_CHUNK (16 * 1024) //模拟每次从 socket 读到的数据量
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// LRANGE 回复: *n 后跟 n 个 bulk string
+static char* build_lrange(int n, int size, size_t* len)
+{
+    char* out = malloc((size_t)n * (size + 32) + 32);
+    char* p = out + sprintf(out, "*%d\r\n", n);
+    for (int i = 0; i < n; i++) {
+        p += sprintf(p, "$%d\r\n", size);
+        memset(p, 'a' + i % 26, size);
+        p += size;
+        *p++ = '\r';
+        *p++ = '\n';
+    }
+    *len = p - out;
+    return out;
+}
+
+// HGETALL 回复（RESP2）: *2n，field 是短字符串，value 是 bulk string
+static char* build_hgetall(int n, int size, size_t* len)
+{
+    char* out = malloc((size_t)n * (size + 64) + 32);
+    char* p = out + sprintf(out, "*%d\r\n", n * 2);
+    for (int i = 0; i < n; i++) {
+        char field[32];
+        int flen = sprintf(field, "field:%d", i);
+        p += sprintf(p, "$%d\r\n%s\r\n$%d\r\n", flen, field, size);
+        memset(p, 'v', size);
+        p += size;
+        *p++ = '\r';
+        *p++ = '\n';
+    }
+    *len = p - out;
+    return out;
+}
+
+static double run_native(const char* data, size_t len, int rounds, long* values)
+{
+    buffer_t* buf = buffer_new(0);
+    resp_parser_t p;
+    resp_value_t v;
+    resp_parser_init(&p);
+    long count = 0;
+    uint64_t sum = 0;
+
+    double t0 = now_sec();
+    for (int k = 0; k < rounds; k++) {
+        size_t fed = 0;
+        int done = 0;
+        while (!done) {
+            size_t n = len - fed < FEED_CHUNK ? len - fed : FEED_CHUNK;
+            buffer_add(buf, data + fed, n);
+            fed += n;
+            int ret;
+            while ((ret = resp_parser_next(&p, buf, &v)) == RESP_VALUE) {
+                count++;
+                sum += v.str.len; //只取长度，不拷贝数据
+                if (resp_parser_reply_done(&p)) {
+                    done = 1;
+                    break;
+                }
+            }
+            if (ret == RESP_ERR) {
+                printf("native parser error\n");
+                exit(1);
+            }
+        }
+        resp_parser_consume(&p, buf);
+    }
+    double elapsed = now_sec() - t0;
+
+    buffer_free(buf);
+    *values = count + (sum == 0); //防止 sum 被优化掉
+    return elapsed;
+}
+
+static double run_hiredis(const char* data, size_t len, int rounds, long* values)
+{
+    redisReader* reader = redisReaderCreate();
+    long count = 0;
+
+    double t0 = now_sec();
+    for (int k = 0; k < rounds; k++) {
+        size_t fed = 0;
+        void* reply = NULL;
+        while (reply == NULL) {
+            size_t n = len - fed < FEED_CHUNK ? len - fed : FEED_CHUNK;
+            redisReaderFeed(reader, data + fed, n);
+            fed += n;
+            if (redisReaderGetReply(reader, &reply) != REDIS_OK) {
+                printf("hiredis reader error: %s\n", reader->errstr);
+                exit(1);
+            }
+        }
+        count += ((redisReply*)reply)->elements + 1;
+        freeReplyObject(reply);
+    }
+    double elapsed = now_sec() - t0;
+
+    redisReaderFree(reader);
+    *values = count;
+    return elapsed;
+}
+
+static void bench(const char* name, const char* data, size_t len, int rounds)
+{
+    long nv = 0, hv = 0;
+    double native = run_native(data, len, rounds, &nv);
+    double hiredis = run_hiredis(data, len, rounds, &hv);
+    double mb = (double)len * rounds / (1024 * 1024);
+    printf("%-8s reply=%zu B  native=%8.1f MB/s %6.1f ns/value  hiredis=%8.1f MB/s %6.1f ns/value  (x%.2f)\n",
+        name, len, mb / native, native * 1e9 / nv, mb / hiredis, hiredis * 1e9 / hv, hiredis / native);
+}
+
+int main(int argc, char* argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 10000;
+    int size = argc > 2 ? atoi(argv[2]) : 64;
+    int rounds = argc > 3 ? atoi(argv[3]) : 200;
+    size_t len;
+
+    printf("resp parser bench: %d elements, %d bytes/element, %d rounds, %d B feeds\n", n, size, rounds, FEED_CHUNK);
+    char* lrange = build_lrange(n, size, &len);
+    bench("LRANGE", lrange, len, rounds);
+    free(lrange);
+
+    char* hgetall = build_hgetall(n, size, &len);
+    bench("HGETALL", hgetall, len, rounds);
+    free(hgetall);
+    return 0;
+}
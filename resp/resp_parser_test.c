@@ -0,0 +1,370 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdlib.h>
+#include "resp_parser.h"
+
+// 测试用例1：RESP2 标量
+void test_scalars() {
+    printf("Test 1: RESP2 scalars\n");
+    buffer_t* buf = buffer_new(0);
+    resp_parser_t p;
+    resp_value_t v;
+    resp_parser_init(&p);
+
+    const char* data = "+OK\r\n-ERR bad\r\n:-42\r\n$5\r\nhello\r\n$-1\r\n$0\r\n\r\n";
+    buffer_add(buf, data, strlen(data));
+
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_STRING && resp_view_eq(&v.str, "OK", 2));
+    assert(resp_parser_reply_done(&p));
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_ERROR && resp_view_eq(&v.str, "ERR bad", 7));
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_INTEGER && v.integer == -42);
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_BULK && v.str.len == 5);
+    assert(memcmp(resp_view_ptr(&v.str), "hello", 5) == 0);
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_NULL);
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_BULK && v.str.len == 0);
+    assert(resp_parser_next(&p, buf, &v) == RESP_AGAIN);
+
+    resp_parser_consume(&p, buf);
+    assert(buffer_len(buf) == 0);
+
+    buffer_free(buf);
+    printf("Passed\n\n");
+}
+
+// 测试用例2：嵌套数组与回复边界
+void test_nested_array() {
+    printf("Test 2: Nested array\n");
+    buffer_t* buf = buffer_new(0);
+    resp_parser_t p;
+    resp_value_t v;
+    resp_parser_init(&p);
+
+    const char* data = "*3\r\n:1\r\n*2\r\n$1\r\na\r\n$1\r\nb\r\n*0\r\n+next\r\n";
+    buffer_add(buf, data, strlen(data));
+
+    int types[] = { '*', ':', '*', '$', '$', '*' };
+    int depths[] = { 0, 1, 1, 2, 2, 1 };
+    for (int i = 0; i < 6; i++) {
+        assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+        assert(v.type == types[i] && v.depth == depths[i]);
+        assert(resp_parser_reply_done(&p) == (i == 5));
+    }
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_STRING && v.depth == 0 && resp_parser_reply_done(&p));
+
+    buffer_free(buf);
+    printf("Passed\n\n");
+}
+
+// 测试用例3：逐字节喂数据，验证断点续解析
+void test_byte_by_byte() {
+    printf("Test 3: Byte-by-byte feed\n");
+    buffer_t* buf = buffer_new(0);
+    resp_parser_t p;
+    resp_value_t v;
+    resp_parser_init(&p);
+
+    const char* data = "*2\r\n$12\r\nhello\r\nworld\r\n+a\rb\r\n";
+    int values = 0;
+    for (size_t i = 0; i < strlen(data); i++) {
+        buffer_add(buf, data + i, 1);
+        int ret;
+        while ((ret = resp_parser_next(&p, buf, &v)) == RESP_VALUE) {
+            values++;
+            if (v.type == RESP_BULK) {
+                char* s = resp_view_dup(&v.str);
+                assert(strcmp(s, "hello\r\nworld") == 0);
+                free(s);
+            }
+            if (v.type == RESP_STRING) {
+                assert(resp_view_eq(&v.str, "a\rb", 3));
+            }
+        }
+        assert(ret == RESP_AGAIN);
+    }
+    assert(values == 3);
+
+    buffer_free(buf);
+    printf("Passed\n\n");
+}
+
+// 测试用例4：bulk string 跨多个 chain，view 零拷贝
+void test_bulk_across_chains() {
+    printf("Test 4: Bulk string across chains\n");
+    buffer_t* buf = buffer_new(0);
+    resp_parser_t p;
+    resp_value_t v;
+    resp_parser_init(&p);
+
+    char body[5000];
+    for (int i = 0; i < (int)sizeof(body); i++) {
+        body[i] = 'A' + i % 26;
+    }
+    const char* hdr = "$5000\r\n";
+    buffer_add(buf, hdr, strlen(hdr));
+    buffer_add(buf, body, 1000);
+    assert(resp_parser_next(&p, buf, &v) == RESP_AGAIN);
+    buffer_add(buf, body + 1000, 4000);
+    assert(resp_parser_next(&p, buf, &v) == RESP_AGAIN);
+    buffer_add(buf, "\r", 1);
+    assert(resp_parser_next(&p, buf, &v) == RESP_AGAIN);
+    buffer_add(buf, "\n", 1);
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_BULK && v.str.len == 5000);
+    assert(buf->first != buf->last);
+    assert(resp_view_ptr(&v.str) == NULL);
+
+    char copy[5000];
+    assert(resp_view_copy(&v.str, copy, sizeof(copy)) == 5000);
+    assert(memcmp(copy, body, 5000) == 0);
+
+    resp_parser_consume(&p, buf);
+    assert(buffer_len(buf) == 0);
+
+    buffer_free(buf);
+    printf("Passed\n\n");
+}
+
+// 测试用例5：RESP3 类型
+void test_resp3() {
+    printf("Test 5: RESP3 types\n");
+    buffer_t* buf = buffer_new(0);
+    resp_parser_t p;
+    resp_value_t v;
+    resp_parser_init(&p);
+
+    const char* data = "%1\r\n+k\r\n#t\r\n_\r\n,3.14\r\n>2\r\n$10\r\ninvalidate\r\n*1\r\n$3\r\nfoo\r\n";
+    buffer_add(buf, data, strlen(data));
+
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_MAP && v.elements == 2);
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE && v.type == RESP_STRING);
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_BOOL && v.integer == 1 && resp_parser_reply_done(&p));
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE && v.type == RESP_NULL);
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_DOUBLE && resp_view_eq(&v.str, "3.14", 4));
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE);
+    assert(v.type == RESP_PUSH && v.elements == 2);
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE && resp_view_eq(&v.str, "invalidate", 10));
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE && v.type == RESP_ARRAY);
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE && resp_view_eq(&v.str, "foo", 3));
+    assert(resp_parser_reply_done(&p));
+
+    buffer_free(buf);
+    printf("Passed\n\n");
+}
+
+// 测试用例6：协议错误
+void test_protocol_error() {
+    printf("Test 6: Protocol errors\n");
+    const char* bad[] = { "?x\r\n", ":12a\r\n", "$3\r\nabcd\r\n", "*-2\r\n", "#x\r\n" };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        buffer_t* buf = buffer_new(0);
+        resp_parser_t p;
+        resp_value_t v;
+        resp_parser_init(&p);
+        buffer_add(buf, bad[i], strlen(bad[i]));
+        assert(resp_parser_next(&p, buf, &v) == RESP_ERR);
+        assert(resp_parser_next(&p, buf, &v) == RESP_ERR);
+        buffer_free(buf);
+    }
+    printf("Passed\n\n");
+}
+
+// 测试用例7：reader 组装整条回复
+void test_reader() {
+    printf("Test 7: Reply reader\n");
+    buffer_t* buf = buffer_new(0);
+    resp_reader_t rd;
+    resp_reply_t* r;
+    resp_reader_init(&rd);
+
+    const char* data = "*3\r\n$3\r\nfoo\r\n*2\r\n:1\r\n$-1\r\n*0\r\n:7\r\n";
+    int replies = 0;
+    for (size_t i = 0; i < strlen(data); i++) {
+        buffer_add(buf, data + i, 1);
+        int ret;
+        while ((ret = resp_reader_next(&rd, buf, &r)) == RESP_VALUE) {
+            if (replies == 0) {
+                assert(r->type == RESP_ARRAY && r->elements == 3);
+                assert(resp_view_eq(&r->element[0].str, "foo", 3));
+                assert(r->element[1].type == RESP_ARRAY && r->element[1].elements == 2);
+                assert(r->element[1].element[0].integer == 1);
+                assert(r->element[1].element[1].type == RESP_NULL);
+                assert(r->element[2].type == RESP_ARRAY && r->element[2].elements == 0);
+            }
+            else {
+                assert(r->type == RESP_INTEGER && r->integer == 7 && r->element == NULL);
+            }
+            replies++;
+            resp_reader_consume(&rd, buf);
+        }
+        assert(ret == RESP_AGAIN);
+    }
+    assert(replies == 2 && buffer_len(buf) == 0);
+
+    // 未完成的回复树由 reset 释放
+    const char* partial = "*2\r\n*2\r\n:1\r\n";
+    buffer_add(buf, partial, strlen(partial));
+    assert(resp_reader_next(&rd, buf, &r) == RESP_AGAIN);
+    resp_reader_reset(&rd);
+
+    buffer_free(buf);
+    printf("Passed\n\n");
+}
+
+// 测试用例8：大 bulk 分块输出，每块 consume 之后内存即释放
+void test_stream_bulk() {
+    printf("Test 8: Streamed bulk chunks\n");
+    buffer_t* buf = buffer_new(0);
+    resp_parser_t p;
+    resp_value_t v;
+    resp_parser_init(&p);
+    p.stream_min = 1000;
+
+    char body[5000];
+    for (int i = 0; i < (int)sizeof(body); i++) {
+        body[i] = 'a' + i % 26;
+    }
+    char got[5000];
+    uint64_t off = 0;
+    int chunks = 0;
+    const char* hdr = "*2\r\n$3\r\nkey\r\n$5000\r\n";
+    buffer_add(buf, hdr, strlen(hdr));
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE && v.type == RESP_ARRAY && v.elements == 2);
+    // 小于 stream_min 的 bulk 照常整块输出
+    assert(resp_parser_next(&p, buf, &v) == RESP_VALUE && v.chunk == 0 && resp_view_eq(&v.str, "key", 3));
+    // 只有头部、还没有数据时不输出空块
+    assert(resp_parser_next(&p, buf, &v) == RESP_AGAIN);
+    resp_parser_consume(&p, buf);
+
+    // 数据和结尾的 CRLF 分几次到达
+    size_t steps[] = { 700, 1800, 2499, 1, 1, 1 };
+    size_t sent = 0;
+    const char* tail = "\r\n";
+    for (int i = 0; i < 6; i++) {
+        for (size_t k = 0; k < steps[i]; k++, sent++) {
+            buffer_add(buf, sent < 5000 ? body + sent : tail + sent - 5000, 1);
+        }
+        int ret;
+        while ((ret = resp_parser_next(&p, buf, &v)) == RESP_VALUE) {
+            assert(v.type == RESP_BULK && v.depth == 1 && v.total == 5000 && v.offset == off);
+            assert(v.str.len > 0 && resp_view_ptr(&v.str) != NULL);
+            memcpy(got + off, resp_view_ptr(&v.str), v.str.len);
+            off += v.str.len;
+            chunks++;
+            assert((v.chunk == RESP_CHUNK_LAST) == (off == 5000));
+            assert(resp_parser_reply_done(&p) == (off == 5000));
+            resp_parser_consume(&p, buf);
+        }
+        assert(ret == RESP_AGAIN);
+        // CRLF 收全之前最后一个字节不输出
+        assert(off == (sent >= 5002 ? 5000 : (sent >= 5000 ? 4999 : sent)));
+    }
+    assert(chunks >= 4 && memcmp(got, body, 5000) == 0 && buffer_len(buf) == 0);
+
+    // 结尾不是 CRLF
+    buffer_add(buf, "$1000\r\n", 7);
+    for (int i = 0; i < 1000; i++) {
+        buffer_add(buf, "x", 1);
+    }
+    buffer_add(buf, "xx", 2);
+    int ret;
+    while ((ret = resp_parser_next(&p, buf, &v)) == RESP_VALUE) {
+        assert(v.chunk == RESP_CHUNK_MORE);
+    }
+    assert(ret == RESP_ERR);
+
+    buffer_free(buf);
+    printf("Passed\n\n");
+}
+
+// 测试用例9：聚合的元素个数超过上限时报协议错误，不做分配
+void test_element_limit() {
+    printf("Test 9: Aggregate element limit\n");
+    const char* bad[] = { "*9223372036854775807\r\n", "%4611686018427387904\r\n", "*4194305\r\n", "%2097153\r\n", "~5000000\r\n" };
+    for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++) {
+        buffer_t* buf = buffer_new(0);
+        resp_reader_t rd;
+        resp_reply_t* r;
+        resp_reader_init(&rd);
+        buffer_add(buf, bad[i], strlen(bad[i]));
+        assert(resp_reader_next(&rd, buf, &r) == RESP_ERR);
+        resp_reader_reset(&rd);
+        buffer_free(buf);
+    }
+
+    // 上限可以按 parser 调整，MAP 按键值对数 * 2 比较
+    const char* data[] = { "*4\r\n", "%2\r\n", "*5\r\n", "%3\r\n" };
+    for (int i = 0; i < 4; i++) {
+        buffer_t* buf = buffer_new(0);
+        resp_parser_t p;
+        resp_value_t v;
+        resp_parser_init(&p);
+        p.max_elements = 4;
+        buffer_add(buf, data[i], strlen(data[i]));
+        assert(resp_parser_next(&p, buf, &v) == (i < 2 ? RESP_VALUE : RESP_ERR));
+        buffer_free(buf);
+    }
+    printf("Passed\n\n");
+}
+
+// 测试用例10：属性被跳过，不占所在聚合的元素，也不会被当成一条回复
+void test_attribute() {
+    printf("Test 10: Attributes are skipped\n");
+    buffer_t* buf = buffer_new(0);
+    resp_reader_t rd;
+    resp_reply_t* r;
+    resp_reader_init(&rd);
+
+    const char* data = "|1\r\n+key-popularity\r\n%1\r\n$1\r\na\r\n,0.19\r\n*2\r\n:2039123\r\n|1\r\n+ttl\r\n:3600\r\n:9543892\r\n"
+        "|0\r\n+OK\r\n";
+    int replies = 0;
+    for (size_t i = 0; i < strlen(data); i++) {
+        buffer_add(buf, data + i, 1);
+        int ret;
+        while ((ret = resp_reader_next(&rd, buf, &r)) == RESP_VALUE) {
+            if (replies == 0) {
+                assert(r->type == RESP_ARRAY && r->elements == 2);
+                assert(r->element[0].integer == 2039123 && r->element[1].integer == 9543892);
+            }
+            else {
+                assert(r->type == RESP_STRING && resp_view_eq(&r->str, "OK", 2));
+            }
+            replies++;
+            resp_reader_consume(&rd, buf);
+        }
+        assert(ret == RESP_AGAIN);
+    }
+    assert(replies == 2 && buffer_len(buf) == 0);
+
+    resp_reader_reset(&rd);
+    buffer_free(buf);
+    printf("Passed\n\n");
+}
+
+int main() {
+    printf("Starting resp parser tests...\n\n");
+
+    test_scalars();
+    test_nested_array();
+    test_byte_by_byte();
+    test_bulk_across_chains();
+    test_resp3();
+    test_protocol_error();
+    test_reader();
+    test_stream_bulk();
+    test_element_limit();
+    test_attribute();
+
+    printf("All tests passed!\n");
+    return 0;
+}
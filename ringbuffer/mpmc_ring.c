@@ -0,0 +1,192 @@
+#include "mpmc_ring.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+typedef struct mpmc_cell_s
+{
+	_Atomic size_t seq;
+	uint8_t data[];
+} mpmc_cell_t;
+
+static inline mpmc_cell_t* _mpmc_cell(mpmc_ring_t* r, size_t pos)
+{
+	return (mpmc_cell_t*)(r->cells + (size_t)(pos & r->mask) * r->stride);
+}
+
+mpmc_ring_t* mpmc_ring_create(uint32_t size, uint32_t msg_size)
+{
+	if (msg_size == 0 || size > RINGBUFFER_MAX_SIZE) {
+		return NULL;
+	}
+	uint32_t slots = 2;
+	while (slots < size) {
+		slots <<= 1;
+	}
+	void* mem = NULL;
+	if (posix_memalign(&mem, RINGBUFFER_CACHELINE, sizeof(mpmc_ring_t)) != 0) {
+		return NULL;
+	}
+	mpmc_ring_t* r = (mpmc_ring_t*)mem;
+	r->size = slots;
+	r->mask = slots - 1;
+	r->msg_size = msg_size;
+	r->stride = (sizeof(mpmc_cell_t) + msg_size + 7) & ~7u;
+	if (posix_memalign(&mem, RINGBUFFER_CACHELINE, (size_t)slots * r->stride) != 0) {
+		free(r);
+		return NULL;
+	}
+	r->cells = (uint8_t*)mem;
+	for (uint32_t i = 0; i < slots; i++) {
+		atomic_init(&_mpmc_cell(r, i)->seq, i);
+	}
+	atomic_init(&r->enqueue_pos, 0);
+	atomic_init(&r->dequeue_pos, 0);
+	atomic_init(&r->futex, 0);
+	atomic_init(&r->waiters, 0);
+	return r;
+}
+
+void mpmc_ring_destroy(mpmc_ring_t* r)
+{
+	if (r) {
+		free(r->cells);
+		free(r);
+	}
+}
+
+static inline long _futex(_Atomic uint32_t* addr, int op, uint32_t val, const struct timespec* ts)
+{
+	return syscall(SYS_futex, (uint32_t*)addr, op | FUTEX_PRIVATE_FLAG, val, ts, NULL, 0);
+}
+
+// 生产者发布完槽序号后调用：和 mpmc_ring_wait 里先登记 waiters 再检查队列配对，避免丢失唤醒
+static inline void _mpmc_notify(mpmc_ring_t* r, uint32_t n)
+{
+	atomic_thread_fence(memory_order_seq_cst);
+	if (atomic_load_explicit(&r->waiters, memory_order_relaxed) == 0) {
+		return;
+	}
+	atomic_fetch_add_explicit(&r->futex, 1, memory_order_release);
+	_futex(&r->futex, FUTEX_WAKE, n > INT_MAX ? INT_MAX : n, NULL);
+}
+
+// 从 pos 开始数最多 n 个连续就绪的槽：生产者要求 seq == pos + i，消费者要求 seq == pos + i + 1
+static inline uint32_t _mpmc_ready(mpmc_ring_t* r, size_t pos, uint32_t n, size_t lag)
+{
+	uint32_t k = 0;
+	while (k < n) {
+		size_t seq = atomic_load_explicit(&_mpmc_cell(r, pos + k)->seq, memory_order_acquire);
+		if (seq != pos + k + lag) {
+			break;
+		}
+		k++;
+	}
+	return k;
+}
+
+// 抢占 [pos, pos + k) 这段位置。已经就绪的槽在 CAS 成功之前不会被别人改动：
+// 只有抢到这些位置的线程才会写它们的序号
+static uint32_t _mpmc_claim(mpmc_ring_t* r, _Atomic size_t* cursor, uint32_t n, size_t lag, size_t* start)
+{
+	size_t pos = atomic_load_explicit(cursor, memory_order_relaxed);
+	for (;;) {
+		uint32_t k = _mpmc_ready(r, pos, n, lag);
+		if (k == 0) {
+			// 第一个槽没就绪：要么队列满/空，要么别的线程已经抢走了 pos
+			size_t now = atomic_load_explicit(cursor, memory_order_relaxed);
+			if (now == pos) {
+				return 0;
+			}
+			pos = now;
+			continue;
+		}
+		if (atomic_compare_exchange_weak_explicit(cursor, &pos, pos + k, memory_order_relaxed, memory_order_relaxed)) {
+			*start = pos;
+			return k;
+		}
+	}
+}
+
+uint32_t mpmc_ring_push_batch(mpmc_ring_t* r, const void* msgs, uint32_t n)
+{
+	size_t pos;
+	uint32_t k = n > r->size ? r->size : n;
+	k = _mpmc_claim(r, &r->enqueue_pos, k, 0, &pos);
+	const uint8_t* src = (const uint8_t*)msgs;
+	for (uint32_t i = 0; i < k; i++) {
+		mpmc_cell_t* cell = _mpmc_cell(r, pos + i);
+		memcpy(cell->data, src + (size_t)i * r->msg_size, r->msg_size);
+		atomic_store_explicit(&cell->seq, pos + i + 1, memory_order_release);
+	}
+	if (k > 0) {
+		_mpmc_notify(r, k);
+	}
+	return k;
+}
+
+uint32_t mpmc_ring_pop_batch(mpmc_ring_t* r, void* msgs, uint32_t n)
+{
+	size_t pos;
+	uint32_t k = n > r->size ? r->size : n;
+	k = _mpmc_claim(r, &r->dequeue_pos, k, 1, &pos);
+	uint8_t* dst = (uint8_t*)msgs;
+	for (uint32_t i = 0; i < k; i++) {
+		mpmc_cell_t* cell = _mpmc_cell(r, pos + i);
+		memcpy(dst + (size_t)i * r->msg_size, cell->data, r->msg_size);
+		// 槽留给下一圈的生产者
+		atomic_store_explicit(&cell->seq, pos + i + r->size, memory_order_release);
+	}
+	return k;
+}
+
+int mpmc_ring_push(mpmc_ring_t* r, const void* msg)
+{
+	return mpmc_ring_push_batch(r, msg, 1) == 1 ? 0 : -1;
+}
+
+int mpmc_ring_pop(mpmc_ring_t* r, void* msg)
+{
+	return mpmc_ring_pop_batch(r, msg, 1) == 1 ? 0 : -1;
+}
+
+static inline int _mpmc_nonempty(mpmc_ring_t* r)
+{
+	size_t pos = atomic_load_explicit(&r->dequeue_pos, memory_order_relaxed);
+	return _mpmc_ready(r, pos, 1, 1) == 1;
+}
+
+int mpmc_ring_wait(mpmc_ring_t* r, int timeout_ms)
+{
+	if (_mpmc_nonempty(r)) {
+		return 0;
+	}
+	uint32_t seq = atomic_load_explicit(&r->futex, memory_order_acquire);
+	atomic_fetch_add_explicit(&r->waiters, 1, memory_order_seq_cst);
+	if (_mpmc_nonempty(r)) {
+		atomic_fetch_sub_explicit(&r->waiters, 1, memory_order_relaxed);
+		return 0;
+	}
+	struct timespec ts, *tsp = NULL;
+	if (timeout_ms >= 0) {
+		ts.tv_sec = timeout_ms / 1000;
+		ts.tv_nsec = (long)(timeout_ms % 1000) * 1000000;
+		tsp = &ts;
+	}
+	// futex 值已经变了说明检查之后有人入队，内核直接返回 EAGAIN
+	long ret = _futex(&r->futex, FUTEX_WAIT, seq, tsp);
+	int timeout = ret == -1 && errno == ETIMEDOUT;
+	atomic_fetch_sub_explicit(&r->waiters, 1, memory_order_relaxed);
+	return timeout ? -1 : 0;
+}
+
+void mpmc_ring_wake_all(mpmc_ring_t* r)
+{
+	atomic_fetch_add_explicit(&r->futex, 1, memory_order_release);
+	_futex(&r->futex, FUTEX_WAKE, INT_MAX, NULL);
+}
@@ -0,0 +1,54 @@
+#ifndef __MPMC_RING_H__
+#define __MPMC_RING_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include "ringbuffer.h"
+
+// 多生产者多消费者的有界队列，消息定长（Vyukov 算法）：
+// 每个槽带一个序号，槽序号 == pos 表示可写，== pos + 1 表示可读；
+// 生产者/消费者只在 enqueue_pos/dequeue_pos 上 CAS 抢位置，拿到位置后各自读写自己的槽。
+// 空闲的消费者可以用 mpmc_ring_wait 在 futex 上睡眠，生产者只在有人睡眠时才做 wake 系统调用。
+
+typedef struct mpmc_ring_s mpmc_ring_t;
+
+struct mpmc_ring_s
+{
+	uint32_t size; //槽数，2 的幂
+	uint32_t mask;
+	uint32_t msg_size;
+	uint32_t stride; //每个槽的字节数：序号 + 消息，按 8 字节对齐
+	uint8_t* cells;
+
+	_Alignas(RINGBUFFER_CACHELINE) _Atomic size_t enqueue_pos;
+	_Alignas(RINGBUFFER_CACHELINE) _Atomic size_t dequeue_pos;
+	_Alignas(RINGBUFFER_CACHELINE) _Atomic uint32_t futex; //每次唤醒前加一
+	_Atomic uint32_t waiters;
+};
+
+// size 向上取整到 2 的幂（至少 2），msg_size 为每条消息的字节数
+mpmc_ring_t* mpmc_ring_create(uint32_t size, uint32_t msg_size);
+
+void mpmc_ring_destroy(mpmc_ring_t* r);
+
+// 成功返回 0，队列满返回 -1
+int mpmc_ring_push(mpmc_ring_t* r, const void* msg);
+
+// 成功返回 0，队列空返回 -1
+int mpmc_ring_pop(mpmc_ring_t* r, void* msg);
+
+// msgs 为 n 条连续存放的消息，一次 CAS 抢占尽可能多的连续槽，返回实际入队条数
+uint32_t mpmc_ring_push_batch(mpmc_ring_t* r, const void* msgs, uint32_t n);
+
+// 最多出队 n 条到 msgs，返回实际条数
+uint32_t mpmc_ring_pop_batch(mpmc_ring_t* r, void* msgs, uint32_t n);
+
+// 队列为空时睡眠，直到有消息入队、mpmc_ring_wake_all 或超时（timeout_ms < 0 不超时）；
+// 超时返回 -1，否则返回 0（可能是伪唤醒，调用方需要重新 pop）
+int mpmc_ring_wait(mpmc_ring_t* r, int timeout_ms);
+
+// 唤醒所有睡眠的消费者，用于退出
+void mpmc_ring_wake_all(mpmc_ring_t* r);
+
+#endif
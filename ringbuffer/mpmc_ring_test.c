@@ -0,0 +1,181 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <time.h>
+#include "mpmc_ring.h"
+
+// 编译: gcc ringbuffer.c ../memsearch/memsearch.c mpmc_ring.c mpmc_ring_test.c -o mpmc_ring_test -lpthread
+
+// 测试用例1：单线程先进先出、满和空
+void test_basic() {
+    printf("Test 1: Basic push and pop\n");
+    mpmc_ring_t* r = mpmc_ring_create(3, sizeof(uint64_t));
+    assert(r != NULL);
+    assert(r->size == 4);
+
+    uint64_t v;
+    assert(mpmc_ring_pop(r, &v) == -1);
+    for (uint64_t i = 0; i < 4; i++) {
+        assert(mpmc_ring_push(r, &i) == 0);
+    }
+    v = 99;
+    assert(mpmc_ring_push(r, &v) == -1);
+    for (uint64_t i = 0; i < 4; i++) {
+        assert(mpmc_ring_pop(r, &v) == 0);
+        assert(v == i);
+    }
+    assert(mpmc_ring_pop(r, &v) == -1);
+
+    mpmc_ring_destroy(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例2：批量入队出队，跨越槽数组末尾
+void test_batch() {
+    printf("Test 2: Batch push and pop\n");
+    mpmc_ring_t* r = mpmc_ring_create(8, 12);
+    assert(r != NULL);
+    assert(r->stride % 8 == 0);
+
+    char in[16][12], out[16][12];
+    for (int i = 0; i < 16; i++) {
+        snprintf(in[i], sizeof(in[i]), "msg-%d", i);
+    }
+    assert(mpmc_ring_push_batch(r, in, 5) == 5);
+    assert(mpmc_ring_pop_batch(r, out, 3) == 3);
+    assert(memcmp(out, in, 3 * 12) == 0);
+
+    // 只剩 6 个空槽
+    assert(mpmc_ring_push_batch(r, in[5], 7) == 6);
+    assert(mpmc_ring_pop_batch(r, out, 10) == 8);
+    assert(memcmp(out, in[3], 8 * 12) == 0);
+    assert(mpmc_ring_pop_batch(r, out, 10) == 0);
+
+    mpmc_ring_destroy(r);
+    printf("Passed\n\n");
+}
+
+// 测试用例3：空队列上等待超时
+void test_wait_timeout() {
+    printf("Test 3: Wait timeout\n");
+    mpmc_ring_t* r = mpmc_ring_create(4, sizeof(int));
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    assert(mpmc_ring_wait(r, 50) == -1);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    assert((t1.tv_sec - t0.tv_sec) * 1000 + (t1.tv_nsec - t0.tv_nsec) / 1000000 >= 40);
+
+    int v = 1;
+    mpmc_ring_push(r, &v);
+    assert(mpmc_ring_wait(r, 50) == 0);
+    assert(r->waiters == 0);
+
+    mpmc_ring_destroy(r);
+    printf("Passed\n\n");
+}
+
+#define MT_PRODUCERS 4
+#define MT_CONSUMERS 4
+#define MT_PER_PRODUCER 200000
+
+typedef struct {
+    mpmc_ring_t* r;
+    int id;
+    uint64_t sum;
+    long count;
+    _Atomic int* done;
+} mt_arg_t;
+
+static void* mt_producer(void* arg) {
+    mt_arg_t* a = (mt_arg_t*)arg;
+    uint64_t batch[16];
+    uint64_t next = 0;
+    while (next < MT_PER_PRODUCER) {
+        uint32_t n = 0;
+        while (n < 16 && next + n < MT_PER_PRODUCER) {
+            batch[n] = ((uint64_t)a->id << 32) | (next + n);
+            n++;
+        }
+        next += mpmc_ring_push_batch(a->r, batch, n);
+    }
+    return NULL;
+}
+
+static void* mt_consumer(void* arg) {
+    mt_arg_t* a = (mt_arg_t*)arg;
+    uint64_t batch[16];
+    uint64_t last[MT_PRODUCERS];
+    memset(last, 0xff, sizeof(last));
+    for (;;) {
+        uint32_t n = mpmc_ring_pop_batch(a->r, batch, 16);
+        if (n == 0) {
+            if (*a->done) {
+                break;
+            }
+            mpmc_ring_wait(a->r, 10);
+            continue;
+        }
+        for (uint32_t i = 0; i < n; i++) {
+            int id = batch[i] >> 32;
+            uint64_t seq = batch[i] & 0xffffffff;
+            // 同一个生产者的消息在每个消费者看来都是递增的
+            assert(last[id] == UINT64_MAX || seq > last[id]);
+            last[id] = seq;
+            a->sum += seq;
+        }
+        a->count += n;
+    }
+    return NULL;
+}
+
+// 测试用例4：多生产者多消费者，不丢不重
+void test_threads() {
+    printf("Test 4: Multiple producers and consumers\n");
+    mpmc_ring_t* r = mpmc_ring_create(256, sizeof(uint64_t));
+    _Atomic int done = 0;
+    pthread_t pt[MT_PRODUCERS], ct[MT_CONSUMERS];
+    mt_arg_t pa[MT_PRODUCERS], ca[MT_CONSUMERS];
+    memset(pa, 0, sizeof(pa));
+    memset(ca, 0, sizeof(ca));
+    for (int i = 0; i < MT_CONSUMERS; i++) {
+        ca[i].r = r;
+        ca[i].done = &done;
+        pthread_create(&ct[i], NULL, mt_consumer, &ca[i]);
+    }
+    for (int i = 0; i < MT_PRODUCERS; i++) {
+        pa[i].r = r;
+        pa[i].id = i;
+        pthread_create(&pt[i], NULL, mt_producer, &pa[i]);
+    }
+    for (int i = 0; i < MT_PRODUCERS; i++) {
+        pthread_join(pt[i], NULL);
+    }
+    done = 1;
+    mpmc_ring_wake_all(r);
+
+    uint64_t sum = 0;
+    long count = 0;
+    for (int i = 0; i < MT_CONSUMERS; i++) {
+        pthread_join(ct[i], NULL);
+        sum += ca[i].sum;
+        count += ca[i].count;
+    }
+    assert(count == (long)MT_PRODUCERS * MT_PER_PRODUCER);
+    assert(sum == (uint64_t)MT_PRODUCERS * MT_PER_PRODUCER * (MT_PER_PRODUCER - 1) / 2);
+
+    mpmc_ring_destroy(r);
+    printf("Passed\n\n");
+}
+
+int main() {
+    printf("Starting mpmc ring tests...\n\n");
+
+    test_basic();
+    test_batch();
+    test_wait_timeout();
+    test_threads();
+
+    printf("All tests passed!\n");
+    return 0;
+}
@@ -1,8 +1,14 @@
+#define _GNU_SOURCE
 #include "ringbuffer.h"
+#include "../memsearch/memsearch.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <errno.h>
 #include <stdatomic.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
 
 static inline bool is_power_of_two(uint32_t num)
 {
@@ -12,10 +18,10 @@ static inline bool is_power_of_two(uint32_t num)
 static inline uint32_t roundup_power_of_two(uint32_t num)
 {
 	if (num == 0) return 1;
+	if (num > RINGBUFFER_MAX_SIZE) return 0;
 	uint32_t result = 1;
 	while (result < num) {
 		result <<= 1;
-		if (result == 0) return 1 << 31;
 	}
 	return result;
 }
@@ -24,13 +30,62 @@ ringbuffer_t* ringbuffer_create(uint32_t sz)
 {
 	uint32_t size = roundup_power_of_two(sz);
 	if (size == 0) return NULL;
-	ringbuffer_t* rb = (ringbuffer_t*)malloc(sizeof(ringbuffer_t) + size);
-	if (!rb) return NULL;
+	// head / tail 各占一条 cache line，结构体本身要按 cache line 对齐
+	void* mem = NULL;
+	if (posix_memalign(&mem, RINGBUFFER_CACHELINE, sizeof(ringbuffer_t) + size) != 0) return NULL;
+	ringbuffer_t* rb = (ringbuffer_t*)mem;
 
 	rb->size = size;
+	rb->mask = size - 1;
+	rb->mirrored = 0;
+	rb->buf = (uint8_t*)(rb + 1);
+	atomic_init(&rb->tail, 0);
+	rb->head_cache = 0;
 	atomic_init(&rb->head, 0);
+	rb->tail_cache = 0;
+
+	return rb;
+}
+
+ringbuffer_t* ringbuffer_create_mirrored(uint32_t sz)
+{
+	uint32_t page = (uint32_t)sysconf(_SC_PAGESIZE);
+	uint32_t size = roundup_power_of_two(sz < page ? page : sz);
+	if (size == 0) return NULL;
+	void* mem = NULL;
+	if (posix_memalign(&mem, RINGBUFFER_CACHELINE, sizeof(ringbuffer_t)) != 0) return NULL;
+	ringbuffer_t* rb = (ringbuffer_t*)mem;
+
+	int fd = memfd_create("ringbuffer", MFD_CLOEXEC);
+	if (fd < 0) {
+		free(rb);
+		return NULL;
+	}
+	// 先占一段 2 * size 的地址空间，再把同一个 memfd 分别固定映射到前后两半
+	uint8_t* addr = NULL;
+	if (ftruncate(fd, size) == 0) {
+		addr = (uint8_t*)mmap(NULL, (size_t)size * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	}
+	if (addr == NULL || addr == MAP_FAILED
+		|| mmap(addr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+		|| mmap(addr + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED) {
+		if (addr && addr != MAP_FAILED) {
+			munmap(addr, (size_t)size * 2);
+		}
+		close(fd);
+		free(rb);
+		return NULL;
+	}
+	close(fd); //映射会持有 memfd
+
+	rb->size = size;
+	rb->mask = size - 1;
+	rb->mirrored = 1;
+	rb->buf = addr;
 	atomic_init(&rb->tail, 0);
-	rb->buf = (uint8_t*)(rb + 1);
+	rb->head_cache = 0;
+	atomic_init(&rb->head, 0);
+	rb->tail_cache = 0;
 
 	return rb;
 }
@@ -38,16 +93,43 @@ ringbuffer_t* ringbuffer_create(uint32_t sz)
 void ringbuffer_destroy(ringbuffer_t* rb)
 {
 	if (rb) {
+		if (rb->mirrored) {
+			munmap(rb->buf, (size_t)rb->size * 2);
+		}
 		free(rb);
 	}
 }
 
+// 生产者看到的空闲字节数：缓存的 head 够用就不去碰消费者的 cache line
+static inline uint32_t _ringbuffer_free(ringbuffer_t* rb, uint32_t tail, size_t want)
+{
+	uint32_t avail = rb->size - (tail - rb->head_cache);
+	if (avail < want) {
+		rb->head_cache = atomic_load_explicit(&rb->head, memory_order_acquire);
+		avail = rb->size - (tail - rb->head_cache);
+	}
+	return avail;
+}
+
+// 消费者看到的可读字节数
+static inline uint32_t _ringbuffer_filled(ringbuffer_t* rb, uint32_t head, size_t want)
+{
+	uint32_t used = rb->tail_cache - head;
+	if (used < want) {
+		rb->tail_cache = atomic_load_explicit(&rb->tail, memory_order_acquire);
+		used = rb->tail_cache - head;
+	}
+	return used;
+}
+
 size_t ringbuffer_used(ringbuffer_t* rb)
 {
 	assert(rb != NULL);
-	uint32_t head = atomic_load(&rb->head);
-	uint32_t tail = atomic_load(&rb->tail);
-	return tail - head;
+	// 先读 head 再读 tail，两次读之间对端可能前进，结果只是快照
+	uint32_t head = atomic_load_explicit(&rb->head, memory_order_acquire);
+	uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_acquire);
+	uint32_t used = tail - head;
+	return used > rb->size ? rb->size : used;
 }
 
 size_t ringbuffer_available(ringbuffer_t* rb)
@@ -61,18 +143,17 @@ size_t ringbuffer_write(ringbuffer_t* rb, const void* data, size_t len)
 	if (!rb || !data || len == 0) return 0;
 
 	const uint8_t* src = (const uint8_t*)data;
-	uint32_t head = atomic_load(&rb->head);
-	uint32_t tail = atomic_load(&rb->tail);
-	size_t available = rb->size - (tail - head);
+	uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+	size_t available = _ringbuffer_free(rb, tail, len);
 	if (len > available) {
 		len = available;
 		if (len == 0) return 0;
 	}
 
-	uint32_t pos = tail & (rb->size - 1);
+	uint32_t pos = tail & rb->mask;
 	size_t to_end = rb->size - pos;
 
-	if (len <= to_end) {
+	if (rb->mirrored || len <= to_end) {
 		memcpy(rb->buf + pos, src, len);
 	}
 	else {
@@ -80,7 +161,7 @@ size_t ringbuffer_write(ringbuffer_t* rb, const void* data, size_t len)
 		memcpy(rb->buf, src + to_end, len - to_end);
 	}
 
-	atomic_store(&rb->tail, tail + len);
+	atomic_store_explicit(&rb->tail, tail + (uint32_t)len, memory_order_release);
 	return len;
 }
 
@@ -89,19 +170,18 @@ size_t ringbuffer_read(ringbuffer_t* rb, void* data, size_t len)
 	if (!rb || !data || len == 0) return 0;
 	
 	uint8_t* dst = (uint8_t*)data;
-	uint32_t head = atomic_load(&rb->head);
-	uint32_t tail = atomic_load(&rb->tail);
-	size_t used = tail - head;
+	uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+	size_t used = _ringbuffer_filled(rb, head, len);
 
 	if (len > used) {
 		len = used;
 		if (len == 0) return 0;
 	}
 
-	uint32_t pos = head & (rb->size - 1); //index % size
+	uint32_t pos = head & rb->mask; //index % size
 	size_t to_end = rb->size - pos;
 
-	if (len <= to_end) {
+	if (rb->mirrored || len <= to_end) {
 		memcpy(dst, rb->buf + pos, len);
 	}
 	else {
@@ -109,65 +189,152 @@ size_t ringbuffer_read(ringbuffer_t* rb, void* data, size_t len)
 		memcpy(dst + to_end, rb->buf, len - to_end);
 	}
 
-	atomic_store(&rb->head, head + len);
+	atomic_store_explicit(&rb->head, head + (uint32_t)len, memory_order_release);
 	return len;
 }
 
 void ringbuffer_clear(ringbuffer_t* r)
 {
 	if (!r) return;
-	uint32_t tail = atomic_load(&r->tail);
-	atomic_store(&r->head, tail);
+	uint32_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+	r->tail_cache = tail;
+	atomic_store_explicit(&r->head, tail, memory_order_release);
 }
 
 size_t ringbuffer_find(ringbuffer_t* rb, const char* sep, size_t seplen)
 {
 	if (!rb || !sep || seplen == 0) return 0;
 
-	size_t used = ringbuffer_used(rb);
+	uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+	size_t used = _ringbuffer_filled(rb, head, rb->size);
 	if (used < seplen) return 0;
 
-	uint32_t head = atomic_load(&rb->head);
-	uint32_t head_pos = head & (rb->size - 1);
+	uint32_t head_pos = head & rb->mask;
 
-	for (size_t i = 0; i <= used - seplen; i++) {
-		uint32_t pos = (head_pos + i) & (rb->size - 1);
-		if (pos + seplen <= rb->size) {
-			if (memcmp(rb->buf + pos, sep, seplen) == 0) {
-				return i + seplen;
-			}
-		}
-		else {
-			size_t first_part = rb->size - pos;
-			if (memcmp(rb->buf + pos, sep, first_part) != 0) {
-				continue;
-			}
-			if (memcmp(rb->buf, sep + first_part, seplen - first_part) == 0) {
-				return i + seplen;
-			}
+	if (rb->mirrored) {
+		size_t k = memsearch(rb->buf + head_pos, used, sep, seplen);
+		return k < used ? k + seplen : 0;
+	}
+
+	// 第一段：head 到缓冲区末尾
+	size_t first = rb->size - head_pos < used ? rb->size - head_pos : used;
+	size_t k = memsearch(rb->buf + head_pos, first, sep, seplen);
+	if (k < first) {
+		return k + seplen;
+	}
+	if (first == used) {
+		return 0;
+	}
+	// 跨过末尾的起点最多 seplen - 1 个
+	size_t i = first >= seplen ? first - seplen + 1 : 0;
+	for (; i < first && i + seplen <= used; i++) {
+		size_t first_part = first - i;
+		if (memcmp(rb->buf + head_pos + i, sep, first_part) == 0
+			&& memcmp(rb->buf, sep + first_part, seplen - first_part) == 0) {
+			return i + seplen;
 		}
 	}
-	return 0;
+	// 第二段：从缓冲区开头到 tail
+	k = memsearch(rb->buf, used - first, sep, seplen);
+	return k < used - first ? first + k + seplen : 0;
 }
 
-size_t ringbuffer_get_contiguous(ringbuffer_t* rb, uint8_t** data_ptr)
+int ringbuffer_read_fd(ringbuffer_t* rb, int fd, uint32_t howmuch)
 {
-	if (!rb || !data_ptr) return 0;
+	uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+	uint32_t available = _ringbuffer_free(rb, tail, rb->size);
+	if (howmuch == 0 || howmuch > available) {
+		howmuch = available;
+	}
+	if (howmuch == 0) {
+		errno = ENOBUFS;
+		return -1;
+	}
 
-	uint32_t head = atomic_load(&rb->head);
-	uint32_t tail = atomic_load(&rb->tail);
-	uint32_t head_pos = head & (rb->size - 1);
-	uint32_t tail_pos = tail & (rb->size - 1);
+	uint32_t pos = tail & rb->mask;
+	uint32_t to_end = rb->size - pos;
+	ssize_t n;
+	if (rb->mirrored || howmuch <= to_end) {
+		n = read(fd, rb->buf + pos, howmuch);
+	}
+	else {
+		struct iovec iov[2] = { { rb->buf + pos, to_end }, { rb->buf, howmuch - to_end } };
+		n = readv(fd, iov, 2);
+	}
+	if (n > 0) {
+		atomic_store_explicit(&rb->tail, tail + (uint32_t)n, memory_order_release);
+	}
+	return (int)n;
+}
 
-	size_t contiguous_len;
-	if (tail >= head) {
-		// 数据未跨边界
-		contiguous_len = tail_pos - head_pos;
+int ringbuffer_write_fd(ringbuffer_t* rb, int fd, uint32_t howmuch)
+{
+	uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+	uint32_t used = _ringbuffer_filled(rb, head, rb->size);
+	if (howmuch == 0 || howmuch > used) {
+		howmuch = used;
+	}
+	if (howmuch == 0) {
+		return 0;
+	}
+
+	uint32_t pos = head & rb->mask;
+	uint32_t to_end = rb->size - pos;
+	ssize_t n;
+	if (rb->mirrored || howmuch <= to_end) {
+		n = write(fd, rb->buf + pos, howmuch);
 	}
 	else {
-		contiguous_len = rb->size - head_pos;
+		struct iovec iov[2] = { { rb->buf + pos, to_end }, { rb->buf, howmuch - to_end } };
+		n = writev(fd, iov, 2);
 	}
+	if (n > 0) {
+		atomic_store_explicit(&rb->head, head + (uint32_t)n, memory_order_release);
+	}
+	return (int)n;
+}
+
+size_t ringbuffer_reserve(ringbuffer_t* rb, uint8_t** data_ptr)
+{
+	if (!rb || !data_ptr) return 0;
+
+	uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+	uint32_t pos = tail & rb->mask;
+	size_t to_end = rb->mirrored ? rb->size : rb->size - pos;
+	size_t available = _ringbuffer_free(rb, tail, to_end);
 
-	*data_ptr = rb->buf + head_pos;
-	return contiguous_len;
-}
\ No newline at end of file
+	*data_ptr = rb->buf + pos;
+	return available < to_end ? available : to_end;
+}
+
+void ringbuffer_commit(ringbuffer_t* rb, size_t len)
+{
+	uint32_t tail = atomic_load_explicit(&rb->tail, memory_order_relaxed);
+	assert(len <= rb->size - (tail - rb->head_cache));
+	atomic_store_explicit(&rb->tail, tail + (uint32_t)len, memory_order_release);
+}
+
+size_t ringbuffer_peek(ringbuffer_t* rb, uint8_t** data_ptr)
+{
+	if (!rb || !data_ptr) return 0;
+
+	uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+	uint32_t pos = head & rb->mask;
+	size_t to_end = rb->mirrored ? rb->size : rb->size - pos;
+	size_t used = _ringbuffer_filled(rb, head, to_end);
+
+	*data_ptr = rb->buf + pos;
+	return used < to_end ? used : to_end;
+}
+
+void ringbuffer_consume(ringbuffer_t* rb, size_t len)
+{
+	uint32_t head = atomic_load_explicit(&rb->head, memory_order_relaxed);
+	assert(len <= (uint32_t)(rb->tail_cache - head));
+	atomic_store_explicit(&rb->head, head + (uint32_t)len, memory_order_release);
+}
+
+size_t ringbuffer_get_contiguous(ringbuffer_t* rb, uint8_t** data_ptr)
+{
+	return ringbuffer_peek(rb, data_ptr);
+}
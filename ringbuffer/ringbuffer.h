@@ -6,32 +6,77 @@
 #include <stddef.h>
 #include <stdatomic.h>
 
+// 单生产者单消费者（SPSC）字节环，用于 reactor 线程和 worker 线程之间交接数据。
+// 生产者线程只调用 write / reserve / commit，消费者线程只调用 read / peek / consume / find / clear，
+// used / available 在任意线程调用都只是一个快照。
+// tail 由生产者以 release 发布、消费者以 acquire 读取，保证读到 tail 时对应的数据已经可见；head 反之。
+// 两端各自缓存一份对端的下标，只有缓存的值不够用时才去读对端的 cache line。
+// mirrored 模式把同一段 memfd 页面连续映射两次，buf[i] 和 buf[i + size] 是同一个字节，
+// 任何可读/可写区间都是连续的：peek/reserve 能拿到全部数据，可以直接在环上解析或 write()。
+
+#define RINGBUFFER_CACHELINE	64
+#define RINGBUFFER_MAX_SIZE		(1u << 31) //下标按 uint32_t 回绕，容量不能超过 2^31
+
 typedef struct ringbuffer_s ringbuffer_t;
 
 struct ringbuffer_s
 {
 	uint32_t size;
-	atomic_uint_fast32_t head;
-	atomic_uint_fast32_t tail;
+	uint32_t mask;
+	int mirrored;
 	uint8_t* buf;
+
+	// 生产者独占的 cache line
+	_Alignas(RINGBUFFER_CACHELINE) _Atomic uint32_t tail;
+	uint32_t head_cache;
+
+	// 消费者独占的 cache line
+	_Alignas(RINGBUFFER_CACHELINE) _Atomic uint32_t head;
+	uint32_t tail_cache;
 };
 
+// size 向上取整到 2 的幂，超过 RINGBUFFER_MAX_SIZE 返回 NULL
 ringbuffer_t* ringbuffer_create(uint32_t size);
 
+// 双映射模式，size 还会向上取整到页大小；不支持 memfd 时返回 NULL
+ringbuffer_t* ringbuffer_create_mirrored(uint32_t size);
+
 void ringbuffer_destroy(ringbuffer_t* rb);
 
+// 生产者：拷贝写入，返回实际写入的字节数
 size_t ringbuffer_write(ringbuffer_t* rb, const void* data, size_t len);
 
+// 消费者：拷贝读出，返回实际读出的字节数
 size_t ringbuffer_read(ringbuffer_t* rb, void* data, size_t len);
 
+// 消费者：丢弃所有已写入的数据
 void ringbuffer_clear(ringbuffer_t* rb);
 
 size_t ringbuffer_used(ringbuffer_t* rb);
 
 size_t ringbuffer_available(ringbuffer_t* rb);
 
+// 消费者：返回 sep 结尾位置到 head 的长度（包含 sep），找不到返回 0
 size_t ringbuffer_find(ringbuffer_t* rb, const char* sep, size_t seplen);
 
+// 生产者：从 fd 读入最多 howmuch 字节（0 表示填满空闲空间），返回值同 read
+int ringbuffer_read_fd(ringbuffer_t* rb, int fd, uint32_t howmuch);
+
+// 消费者：把已有数据写到 fd（howmuch 为 0 时尽量全部写出），返回值同 write
+int ringbuffer_write_fd(ringbuffer_t* rb, int fd, uint32_t howmuch);
+
+// 生产者零拷贝写：返回 tail 处连续可写的字节数，数据直接写到 *data_ptr，
+// 再调用 commit 发布（commit 的长度不能超过 reserve 返回值）
+size_t ringbuffer_reserve(ringbuffer_t* rb, uint8_t** data_ptr);
+
+void ringbuffer_commit(ringbuffer_t* rb, size_t len);
+
+// 消费者零拷贝读：返回 head 处连续可读的字节数，处理完后用 consume 释放
+size_t ringbuffer_peek(ringbuffer_t* rb, uint8_t** data_ptr);
+
+void ringbuffer_consume(ringbuffer_t* rb, size_t len);
+
+// 同 ringbuffer_peek
 size_t ringbuffer_get_contiguous(ringbuffer_t* rb, uint8_t** data_ptr);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include "ringbuffer.h"
+#include "mpmc_ring.h"
+
+// 编译: gcc -O2 ringbuffer.c ../memsearch/memsearch.c mpmc_ring.c ringbuffer_bench.c -o ringbuffer_bench -lpthread
+// 用法: ./ringbuffer_bench spsc [每种消息大小传输的 MB] [环大小 KB]
+//       ./ringbuffer_bench mpmc [每轮消息数] [槽数]
+//       ./ringbuffer_bench mirror [每轮消息数] [环大小 KB]
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// -------------------------- spsc：一个生产者线程、一个消费者线程 --------------------------
+typedef struct {
+    ringbuffer_t* rb;
+    size_t msg;
+    long count;
+    int zerocopy;
+} spsc_arg_t;
+
+// 拷贝模式逐条 write，环满时一条消息可能分几次写完；
+// 零拷贝模式把 reserve 到的连续空间一次填满整数条消息
+static void* spsc_producer(void* arg)
+{
+    spsc_arg_t* a = (spsc_arg_t*)arg;
+    uint8_t* msg = malloc(a->msg);
+    memset(msg, 'm', a->msg);
+    long sent = 0;
+    while (sent < a->count) {
+        if (!a->zerocopy) {
+            size_t off = 0;
+            while (off < a->msg) {
+                size_t n = ringbuffer_write(a->rb, msg + off, a->msg - off);
+                if (n == 0) {
+                    sched_yield();
+                }
+                off += n;
+            }
+            sent++;
+            continue;
+        }
+        uint8_t* p;
+        long n = ringbuffer_reserve(a->rb, &p) / a->msg;
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        if (n > a->count - sent) {
+            n = a->count - sent;
+        }
+        for (long i = 0; i < n; i++) {
+            memcpy(p + i * a->msg, msg, a->msg);
+        }
+        ringbuffer_commit(a->rb, n * a->msg);
+        sent += n;
+    }
+    free(msg);
+    return NULL;
+}
+
+static long spsc_consume(spsc_arg_t* a)
+{
+    uint8_t* msg = malloc(a->msg);
+    long received = 0, sum = 0;
+    while (received < a->count) {
+        if (!a->zerocopy) {
+            size_t off = 0;
+            while (off < a->msg) {
+                size_t n = ringbuffer_read(a->rb, msg + off, a->msg - off);
+                if (n == 0) {
+                    sched_yield();
+                }
+                off += n;
+            }
+            sum += msg[0];
+            received++;
+            continue;
+        }
+        uint8_t* p;
+        long n = ringbuffer_peek(a->rb, &p) / a->msg;
+        if (n == 0) {
+            sched_yield();
+            continue;
+        }
+        for (long i = 0; i < n; i++) {
+            sum += p[i * a->msg];
+        }
+        ringbuffer_consume(a->rb, n * a->msg);
+        received += n;
+    }
+    free(msg);
+    return sum;
+}
+
+static void bench_spsc(long mb, uint32_t ring_kb)
+{
+    size_t sizes[] = { 16, 64, 256, 1024, 4096 };
+    printf("spsc bench: %ld MB per run, %u KB ring\n", mb, ring_kb);
+    for (int zerocopy = 0; zerocopy <= 1; zerocopy++) {
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            spsc_arg_t a;
+            a.rb = ringbuffer_create(ring_kb * 1024);
+            a.msg = sizes[i];
+            a.count = (mb << 20) / sizes[i];
+            a.zerocopy = zerocopy;
+
+            pthread_t tid;
+            double start = now_sec();
+            pthread_create(&tid, NULL, spsc_producer, &a);
+            long sum = spsc_consume(&a);
+            pthread_join(tid, NULL);
+            double elapsed = now_sec() - start;
+
+            printf("%-9s msg=%-5zu %8.2f GB/s %12.0f msgs/s%s\n", zerocopy ? "zerocopy" : "copy", a.msg,
+                a.count * a.msg / elapsed / 1e9, a.count / elapsed, sum == (long)'m' * a.count ? "" : "  (corrupt)");
+            ringbuffer_destroy(a.rb);
+        }
+    }
+}
+
+// -------------------------- mpmc：1~16 个生产者 x 1~16 个消费者 --------------------------
+#define MPMC_MSG 64
+#define MPMC_BATCH 32
+
+typedef struct {
+    mpmc_ring_t* r;
+    long count; //生产者要发的条数
+    _Atomic long* received; //所有消费者收到的总数
+    long total;
+} mpmc_arg_t;
+
+static void* mpmc_producer(void* arg)
+{
+    mpmc_arg_t* a = (mpmc_arg_t*)arg;
+    uint8_t batch[MPMC_BATCH][MPMC_MSG];
+    memset(batch, 'm', sizeof(batch));
+    long sent = 0;
+    while (sent < a->count) {
+        uint32_t n = a->count - sent < MPMC_BATCH ? a->count - sent : MPMC_BATCH;
+        uint32_t k = mpmc_ring_push_batch(a->r, batch, n);
+        if (k == 0) {
+            sched_yield();
+        }
+        sent += k;
+    }
+    return NULL;
+}
+
+static void* mpmc_consumer(void* arg)
+{
+    mpmc_arg_t* a = (mpmc_arg_t*)arg;
+    uint8_t batch[MPMC_BATCH][MPMC_MSG];
+    while (atomic_load(a->received) < a->total) {
+        uint32_t n = mpmc_ring_pop_batch(a->r, batch, MPMC_BATCH);
+        if (n == 0) {
+            mpmc_ring_wait(a->r, 1);
+            continue;
+        }
+        if (atomic_fetch_add(a->received, n) + n == a->total) {
+            mpmc_ring_wake_all(a->r);
+        }
+    }
+    return NULL;
+}
+
+static double mpmc_run(int producers, int consumers, long total, uint32_t slots)
+{
+    mpmc_ring_t* r = mpmc_ring_create(slots, MPMC_MSG);
+    _Atomic long received = 0;
+    pthread_t tids[32];
+    mpmc_arg_t args[32];
+    total -= total % producers;
+
+    double start = now_sec();
+    for (int i = 0; i < producers + consumers; i++) {
+        args[i].r = r;
+        args[i].count = total / producers;
+        args[i].received = &received;
+        args[i].total = total;
+        pthread_create(&tids[i], NULL, i < producers ? mpmc_producer : mpmc_consumer, &args[i]);
+    }
+    for (int i = 0; i < producers + consumers; i++) {
+        pthread_join(tids[i], NULL);
+    }
+    double elapsed = now_sec() - start;
+    mpmc_ring_destroy(r);
+    return total / elapsed;
+}
+
+static void bench_mpmc(long total, uint32_t slots)
+{
+    int counts[] = { 1, 2, 4, 8, 16 };
+    int n = sizeof(counts) / sizeof(counts[0]);
+    printf("mpmc bench: %ld msgs of %d bytes per run, %u slots, batch %d, Mmsgs/s\n", total, MPMC_MSG, slots, MPMC_BATCH);
+    printf("prod\\cons");
+    for (int c = 0; c < n; c++) {
+        printf("%8d", counts[c]);
+    }
+    printf("\n");
+    for (int p = 0; p < n; p++) {
+        printf("%9d", counts[p]);
+        for (int c = 0; c < n; c++) {
+            printf("%8.2f", mpmc_run(counts[p], counts[c], total, slots) / 1e6);
+            fflush(stdout);
+        }
+        printf("\n");
+    }
+}
+
+// -------------------------- mirror：双映射 vs 分两段拷贝，消息大小不整除环大小，经常跨边界 --------------------------
+// copy：write + read 一整条消息；
+// frame：找到 \r\n 分帧后就地处理，普通模式下跨边界的帧只能先拷到临时缓冲
+static double mirror_run(ringbuffer_t* rb, int frame, size_t msg_len, long count, long* straddled)
+{
+    uint8_t* msg = malloc(msg_len);
+    uint8_t* scratch = malloc(msg_len);
+    memset(msg, 'm', msg_len);
+    memcpy(msg + msg_len - 2, "\r\n", 2);
+    long sum = 0;
+    *straddled = 0;
+
+    double start = now_sec();
+    for (long i = 0; i < count; i++) {
+        if ((rb->tail & rb->mask) + msg_len > rb->size) {
+            (*straddled)++;
+        }
+        ringbuffer_write(rb, msg, msg_len);
+        if (!frame) {
+            ringbuffer_read(rb, scratch, msg_len);
+            sum += scratch[0];
+            continue;
+        }
+        size_t len = ringbuffer_find(rb, "\r\n", 2);
+        uint8_t* p;
+        if (ringbuffer_peek(rb, &p) >= len) {
+            sum += p[0] + p[len - 3];
+            ringbuffer_consume(rb, len);
+        }
+        else {
+            ringbuffer_read(rb, scratch, len);
+            sum += scratch[0] + scratch[len - 3];
+        }
+    }
+    double elapsed = now_sec() - start;
+    free(msg);
+    free(scratch);
+    return sum ? count / elapsed : 0;
+}
+
+static void bench_mirror(long count, uint32_t ring_kb)
+{
+    size_t sizes[] = { 100, 1000, 3000, 20000 };
+    printf("mirror bench: %ld msgs per run, %u KB ring\n", count, ring_kb);
+    for (int frame = 0; frame <= 1; frame++) {
+        for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            ringbuffer_t* split = ringbuffer_create(ring_kb * 1024);
+            ringbuffer_t* mirror = ringbuffer_create_mirrored(ring_kb * 1024);
+            if (!mirror) {
+                printf("memfd mirror not supported\n");
+                ringbuffer_destroy(split);
+                return;
+            }
+            long straddled, unused;
+            double s = mirror_run(split, frame, sizes[i], count, &straddled);
+            double m = mirror_run(mirror, frame, sizes[i], count, &unused);
+            printf("%-5s msg=%-6zu split=%10.0f msgs/s  mirrored=%10.0f msgs/s  (x%.2f, %.1f%% straddle)\n",
+                frame ? "frame" : "copy", sizes[i], s, m, m / s, 100.0 * straddled / count);
+            ringbuffer_destroy(split);
+            ringbuffer_destroy(mirror);
+        }
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        printf("usage: %s spsc [mb] [ring_kb]\n", argv[0]);
+        printf("       %s mpmc [msgs] [slots]\n", argv[0]);
+        printf("       %s mirror [msgs] [ring_kb]\n", argv[0]);
+        return 1;
+    }
+    if (strcmp(argv[1], "spsc") == 0) {
+        bench_spsc(argc > 2 ? atol(argv[2]) : 1024, argc > 3 ? atoi(argv[3]) : 256);
+        return 0;
+    }
+    if (strcmp(argv[1], "mpmc") == 0) {
+        bench_mpmc(argc > 2 ? atol(argv[2]) : 4000000, argc > 3 ? atoi(argv[3]) : 4096);
+        return 0;
+    }
+    if (strcmp(argv[1], "mirror") == 0) {
+        bench_mirror(argc > 2 ? atol(argv[2]) : 200000, argc > 3 ? atoi(argv[3]) : 64);
+        return 0;
+    }
+    printf("unknown bench: %s\n", argv[1]);
+    return 1;
+}
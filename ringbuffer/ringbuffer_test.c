@@ -1,8 +1,12 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "ringbuffer.h"
 
+// 编译: gcc ringbuffer.c ../memsearch/memsearch.c ringbuffer_test.c -o ringbuffer_test -lpthread
+
 // 测试用例1：基本写入和读取
 void test_basic_write_read() {
     printf("Test 1: Basic write and read\n");
@@ -176,6 +180,195 @@ void test_edge_cases() {
     printf("Passed\n\n");
 }
 
+// 测试用例9：零拷贝 reserve/commit 和 peek/consume
+void test_reserve_peek() {
+    printf("Test 9: Reserve/commit and peek/consume\n");
+    ringbuffer_t* rb = ringbuffer_create(8);
+    assert(rb != NULL);
+
+    uint8_t* p;
+    assert(ringbuffer_reserve(rb, &p) == 8);
+    memcpy(p, "ABCDEF", 6);
+    ringbuffer_commit(rb, 6);
+    assert(ringbuffer_used(rb) == 6);
+
+    assert(ringbuffer_peek(rb, &p) == 6);
+    assert(memcmp(p, "ABCD", 4) == 0);
+    ringbuffer_consume(rb, 4);
+
+    // tail 在 6，连续可写只到末尾
+    assert(ringbuffer_reserve(rb, &p) == 2);
+    memcpy(p, "GH", 2);
+    ringbuffer_commit(rb, 2);
+    assert(ringbuffer_reserve(rb, &p) == 4);
+    memcpy(p, "IJ", 2);
+    ringbuffer_commit(rb, 2);
+
+    // 跨边界时 peek 先返回到末尾的那一段
+    assert(ringbuffer_peek(rb, &p) == 4);
+    assert(memcmp(p, "EFGH", 4) == 0);
+    assert(ringbuffer_get_contiguous(rb, &p) == 4);
+    ringbuffer_consume(rb, 4);
+    assert(ringbuffer_peek(rb, &p) == 2);
+    assert(memcmp(p, "IJ", 2) == 0);
+    ringbuffer_consume(rb, 2);
+    assert(ringbuffer_peek(rb, &p) == 0);
+    assert(ringbuffer_available(rb) == 8);
+
+    ringbuffer_destroy(rb);
+    printf("Passed\n\n");
+}
+
+// 测试用例10：容量上限
+void test_size_limit() {
+    printf("Test 10: Size limit\n");
+    assert(ringbuffer_create(RINGBUFFER_MAX_SIZE + 1) == NULL);
+    ringbuffer_t* rb = ringbuffer_create(100);
+    assert(rb != NULL);
+    assert(rb->size == 128);
+    assert(((uintptr_t)&rb->head - (uintptr_t)&rb->tail) >= RINGBUFFER_CACHELINE);
+    ringbuffer_destroy(rb);
+    printf("Passed\n\n");
+}
+
+#define SPSC_TOTAL (4u << 20)
+
+static void* spsc_producer(void* arg) {
+    ringbuffer_t* rb = (ringbuffer_t*)arg;
+    uint32_t next = 0;
+    while (next < SPSC_TOTAL) {
+        uint8_t* p;
+        size_t n = ringbuffer_reserve(rb, &p);
+        if (n > SPSC_TOTAL - next) {
+            n = SPSC_TOTAL - next;
+        }
+        for (size_t i = 0; i < n; i++) {
+            p[i] = (uint8_t)(next + i);
+        }
+        ringbuffer_commit(rb, n);
+        next += n;
+    }
+    return NULL;
+}
+
+// 测试用例11：两个线程交接数据，内容和顺序不乱
+void test_spsc_threads() {
+    printf("Test 11: SPSC across threads\n");
+    ringbuffer_t* rb = ringbuffer_create(4096);
+    assert(rb != NULL);
+
+    pthread_t tid;
+    pthread_create(&tid, NULL, spsc_producer, rb);
+    uint32_t expect = 0;
+    uint8_t buf[777];
+    while (expect < SPSC_TOTAL) {
+        size_t n = ringbuffer_read(rb, buf, sizeof(buf));
+        for (size_t i = 0; i < n; i++) {
+            assert(buf[i] == (uint8_t)(expect + i));
+        }
+        expect += n;
+    }
+    pthread_join(tid, NULL);
+    assert(ringbuffer_used(rb) == 0);
+
+    ringbuffer_destroy(rb);
+    printf("Passed\n\n");
+}
+
+// 测试用例12：双映射模式下跨边界的数据也是连续的
+void test_mirrored() {
+    printf("Test 12: Mirrored mode\n");
+    ringbuffer_t* rb = ringbuffer_create_mirrored(100);
+    assert(rb != NULL);
+    assert(rb->mirrored);
+    assert(rb->size == (uint32_t)sysconf(_SC_PAGESIZE));
+
+    // 把 tail 推到离末尾 4 字节的位置
+    char junk[4096];
+    memset(junk, 'x', sizeof(junk));
+    size_t skip = rb->size - 4;
+    assert(ringbuffer_write(rb, junk, skip) == skip);
+    assert(ringbuffer_read(rb, junk, skip) == skip);
+
+    const char* msg = "*1\r\n$4\r\nPING\r\n";
+    assert(ringbuffer_write(rb, msg, strlen(msg)) == strlen(msg));
+    assert(memcmp(rb->buf, msg + 4, 4) == 0); //后半段确实写在了开头
+    uint8_t* p;
+    assert(ringbuffer_peek(rb, &p) == strlen(msg));
+    assert(memcmp(p, msg, strlen(msg)) == 0);
+    assert(ringbuffer_find(rb, "PING\r\n", 6) == strlen(msg));
+
+    // reserve 也能拿到跨边界的整段空闲空间
+    ringbuffer_consume(rb, strlen(msg));
+    assert(ringbuffer_reserve(rb, &p) == rb->size);
+
+    char out[32];
+    assert(ringbuffer_write(rb, msg, strlen(msg)) == strlen(msg));
+    assert(ringbuffer_read(rb, out, sizeof(out)) == strlen(msg));
+    assert(memcmp(out, msg, strlen(msg)) == 0);
+
+    ringbuffer_destroy(rb);
+    printf("Passed\n\n");
+}
+
+// 测试用例13：fd 读写在两种模式下跨边界
+void test_fd_io() {
+    printf("Test 13: fd read/write\n");
+    for (int mirrored = 0; mirrored <= 1; mirrored++) {
+        ringbuffer_t* rb = mirrored ? ringbuffer_create_mirrored(4096) : ringbuffer_create(4096);
+        int in[2], out[2];
+        assert(pipe(in) == 0 && pipe(out) == 0);
+
+        char data[6000];
+        for (size_t i = 0; i < sizeof(data); i++) {
+            data[i] = (char)(i * 7);
+        }
+        char back[6000];
+        size_t sent = 0, got = 0;
+        while (got < sizeof(data)) {
+            if (sent < sizeof(data)) {
+                size_t n = sizeof(data) - sent < 1500 ? sizeof(data) - sent : 1500;
+                assert(write(in[1], data + sent, n) == (ssize_t)n);
+                sent += n;
+                assert(ringbuffer_read_fd(rb, in[0], 0) == (int)n);
+            }
+            int n = ringbuffer_write_fd(rb, out[1], 1000);
+            assert(n > 0);
+            assert(read(out[0], back + got, n) == n);
+            got += n;
+        }
+        assert(memcmp(back, data, sizeof(data)) == 0);
+        assert(ringbuffer_write_fd(rb, out[1], 0) == 0);
+
+        close(in[0]); close(in[1]); close(out[0]); close(out[1]);
+        ringbuffer_destroy(rb);
+    }
+    printf("Passed\n\n");
+}
+
+// 测试用例14：查找分隔符，分别落在第一段、跨越末尾、第二段
+void test_find_wrap() {
+    printf("Test 14: Find across the wrap point\n");
+    ringbuffer_t* rb = ringbuffer_create(64);
+    char junk[64];
+    char out[64];
+    memset(junk, 'x', sizeof(junk));
+    for (int shift = 0; shift < 64; shift++) {
+        // head 移到 shift 处，写入的 "...\r\n..." 从 shift 开始
+        ringbuffer_clear(rb);
+        ringbuffer_write(rb, junk, shift);
+        ringbuffer_read(rb, out, shift);
+        const char* msg = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa\r\nbb";
+        ringbuffer_write(rb, msg, strlen(msg));
+        assert(ringbuffer_find(rb, "\r\n", 2) == 43);
+        assert(ringbuffer_find(rb, "a\r\nb", 4) == 44);
+        assert(ringbuffer_find(rb, "\n\r", 2) == 0);
+        ringbuffer_read(rb, out, strlen(msg));
+    }
+    ringbuffer_destroy(rb);
+    printf("Passed\n\n");
+}
+
 int main() {
     printf("Starting ringbuffer tests...\n\n");
 
@@ -187,6 +380,12 @@ int main() {
     test_find_pattern();
     test_contiguous_block();
     test_edge_cases();
+    test_reserve_peek();
+    test_size_limit();
+    test_spsc_threads();
+    test_mirrored();
+    test_fd_io();
+    test_find_wrap();
 
     printf("All tests passed!\n");
     return 0;
@@ -0,0 +1,270 @@
+#include "timewheel.h"
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+uint64_t timewheel_now(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static inline void list_init(timer_node_t* head)
+{
+	head->prev = head;
+	head->next = head;
+}
+
+static inline void list_add_tail(timer_node_t* head, timer_node_t* t)
+{
+	t->prev = head->prev;
+	t->next = head;
+	head->prev->next = t;
+	head->prev = t;
+}
+
+static inline void list_del(timer_node_t* t)
+{
+	t->prev->next = t->next;
+	t->next->prev = t->prev;
+	t->prev = NULL;
+	t->next = NULL;
+}
+
+// 把 from 链表整体搬到 to（to 原本为空）
+static inline void list_splice(timer_node_t* from, timer_node_t* to)
+{
+	if (from->next == from) {
+		list_init(to);
+		return;
+	}
+	to->next = from->next;
+	to->prev = from->prev;
+	to->next->prev = to;
+	to->prev->next = to;
+	list_init(from);
+}
+
+timewheel_t* timewheel_create(uint64_t now)
+{
+	timewheel_t* tw = (timewheel_t*)malloc(sizeof(timewheel_t));
+	if (!tw) {
+		return NULL;
+	}
+	memset(tw, 0, sizeof(timewheel_t));
+	tw->jiffies = now;
+	for (int i = 0; i < TVR_SIZE; i++) {
+		list_init(&tw->tv1[i]);
+	}
+	for (int level = 0; level < TVN_LEVELS; level++) {
+		for (int i = 0; i < TVN_SIZE; i++) {
+			list_init(&tw->tvn[level][i]);
+		}
+	}
+	return tw;
+}
+
+static void free_slot(timer_node_t* head)
+{
+	timer_node_t *t, *next;
+	for (t = head->next; t != head; t = next) {
+		next = t->next;
+		free(t);
+	}
+}
+
+void timewheel_destroy(timewheel_t* tw)
+{
+	if (!tw) {
+		return;
+	}
+	for (int i = 0; i < TVR_SIZE; i++) {
+		free_slot(&tw->tv1[i]);
+	}
+	for (int level = 0; level < TVN_LEVELS; level++) {
+		for (int i = 0; i < TVN_SIZE; i++) {
+			free_slot(&tw->tvn[level][i]);
+		}
+	}
+	timer_node_t* t = tw->free_list;
+	while (t) {
+		timer_node_t* prev = t->prev;
+		free(t);
+		t = prev;
+	}
+	free(tw);
+}
+
+static void internal_add(timewheel_t* tw, timer_node_t* t)
+{
+	uint64_t expire = t->expire;
+	uint64_t idx = expire - tw->jiffies;
+	timer_node_t* head;
+
+	if (idx < TVR_SIZE) {
+		int i = expire & TVR_MASK;
+		tw->tv1_map[i >> 6] |= 1ULL << (i & 63);
+		head = &tw->tv1[i];
+	}
+	else {
+		if (idx > 0xffffffffULL) {
+			idx = 0xffffffffULL;
+			expire = tw->jiffies + idx;
+			t->expire = expire;
+		}
+		int level = 0;
+		while (level < TVN_LEVELS - 1 && idx >= (1ULL << (TVR_BITS + (level + 1) * TVN_BITS))) {
+			level++;
+		}
+		int i = (expire >> (TVR_BITS + level * TVN_BITS)) & TVN_MASK;
+		head = &tw->tvn[level][i];
+	}
+	list_add_tail(head, t);
+}
+
+// 摘下节点；若第 0 层的槽因此变空，同步清掉位图
+static void detach_timer(timewheel_t* tw, timer_node_t* t)
+{
+	timer_node_t* next = t->next;
+	list_del(t);
+	if (next->next == next && next >= tw->tv1 && next < tw->tv1 + TVR_SIZE) {
+		int i = (int)(next - tw->tv1);
+		tw->tv1_map[i >> 6] &= ~(1ULL << (i & 63));
+	}
+}
+
+static void recycle_timer(timewheel_t* tw, timer_node_t* t)
+{
+	t->next = NULL;
+	t->cb = NULL;
+	if (tw->nfree < TIMEWHEEL_MAX_FREE) {
+		t->prev = tw->free_list;
+		tw->free_list = t;
+		tw->nfree++;
+	}
+	else {
+		free(t);
+	}
+}
+
+timer_node_t* timewheel_add(timewheel_t* tw, uint64_t expire, timer_callback_fn cb, void* priv)
+{
+	timer_node_t* t;
+	if (tw->free_list) {
+		t = tw->free_list;
+		tw->free_list = t->prev;
+		tw->nfree--;
+	}
+	else {
+		t = (timer_node_t*)malloc(sizeof(timer_node_t));
+		if (!t) {
+			return NULL;
+		}
+	}
+	t->expire = expire < tw->jiffies ? tw->jiffies : expire;
+	t->cb = cb;
+	t->priv = priv;
+	internal_add(tw, t);
+	tw->count++;
+	return t;
+}
+
+void timewheel_del(timewheel_t* tw, timer_node_t* t)
+{
+	if (!t || !t->next) {
+		return;
+	}
+	detach_timer(tw, t);
+	tw->count--;
+	recycle_timer(tw, t);
+}
+
+static void cascade(timewheel_t* tw, int level, int index)
+{
+	timer_node_t head;
+	list_splice(&tw->tvn[level][index], &head);
+	while (head.next != &head) {
+		timer_node_t* t = head.next;
+		list_del(t);
+		internal_add(tw, t);
+	}
+}
+
+// 从第 0 层的 from 槽开始，距离下一个非空槽还有多少 tick；没有则返回到本轮结束的距离
+static uint32_t find_pending(timewheel_t* tw, int from)
+{
+	for (int w = from >> 6; w < TVR_SIZE / 64; w++) {
+		uint64_t bits = tw->tv1_map[w];
+		if (w == from >> 6) {
+			bits &= ~0ULL << (from & 63);
+		}
+		if (bits) {
+			return (w << 6) + __builtin_ctzll(bits) - from;
+		}
+	}
+	return TVR_SIZE - from;
+}
+
+int timewheel_expire(timewheel_t* tw, uint64_t now)
+{
+	int fired = 0;
+	while (tw->jiffies <= now) {
+		if (tw->count == 0) {
+			tw->jiffies = now + 1;
+			break;
+		}
+		int idx = tw->jiffies & TVR_MASK;
+		if (idx == 0) {
+			for (int level = 0; level < TVN_LEVELS; level++) {
+				int i = (tw->jiffies >> (TVR_BITS + level * TVN_BITS)) & TVN_MASK;
+				cascade(tw, level, i);
+				if (i != 0) {
+					break;
+				}
+			}
+		}
+
+		timer_node_t* slot = &tw->tv1[idx];
+		if (slot->next == slot) {
+			// 空槽直接跳到下一个非空槽（或下一次 cascade），不逐 tick 空转
+			uint64_t step = find_pending(tw, idx);
+			if (step > now + 1 - tw->jiffies) {
+				step = now + 1 - tw->jiffies;
+			}
+			tw->jiffies += step;
+			continue;
+		}
+
+		timer_node_t head;
+		list_splice(slot, &head);
+		tw->tv1_map[idx >> 6] &= ~(1ULL << (idx & 63));
+		tw->jiffies++;
+		while (head.next != &head) {
+			timer_node_t* t = head.next;
+			list_del(t);
+			tw->count--;
+			t->cb(t, t->priv);
+			recycle_timer(tw, t);
+			fired++;
+		}
+	}
+	return fired;
+}
+
+int timewheel_next_timeout(timewheel_t* tw, uint64_t now)
+{
+	if (tw->count == 0) {
+		return -1;
+	}
+	// 第 0 层之后的定时器只会更晚，返回到下一次 cascade 的距离即可（可能提前醒来，但不会迟到）
+	uint64_t expire = tw->jiffies + find_pending(tw, tw->jiffies & TVR_MASK);
+	if (expire <= now) {
+		return 0;
+	}
+	if (expire - now > INT_MAX) {
+		return INT_MAX;
+	}
+	return (int)(expire - now);
+}
@@ -0,0 +1,58 @@
+#ifndef __TIMEWHEEL_H__
+#define __TIMEWHEEL_H__
+
+#include <stdint.h>
+
+typedef struct timer_node_s timer_node_t;
+typedef struct timewheel_s timewheel_t;
+
+typedef void (*timer_callback_fn)(timer_node_t* t, void* privdata);
+
+// 分层时间轮（同 Linux 早期 tvec 结构），tick 为 1ms：
+// 第 0 层 256 个槽，其余 4 层各 64 个槽，可覆盖 2^32 ms。
+// 插入/删除都是 O(1) 的双向链表操作，到期时高层槽位逐级下放（cascade）。
+#define TVR_BITS	8
+#define TVN_BITS	6
+#define TVR_SIZE	(1 << TVR_BITS)
+#define TVN_SIZE	(1 << TVN_BITS)
+#define TVR_MASK	(TVR_SIZE - 1)
+#define TVN_MASK	(TVN_SIZE - 1)
+#define TVN_LEVELS	4
+#define TIMEWHEEL_MAX_FREE	4096 //回收链表最多缓存的节点数
+
+struct timer_node_s
+{
+	struct timer_node_s* prev;
+	struct timer_node_s* next; //为 NULL 表示不在轮上
+	uint64_t expire;
+	timer_callback_fn cb;
+	void* priv;
+};
+
+struct timewheel_s
+{
+	uint64_t jiffies; //下一个待处理的 tick
+	uint32_t count;
+	uint32_t nfree;
+	timer_node_t* free_list;
+	uint64_t tv1_map[TVR_SIZE / 64]; //第 0 层非空槽位图，用于快速计算最近的到期时间
+	timer_node_t tv1[TVR_SIZE];
+	timer_node_t tvn[TVN_LEVELS][TVN_SIZE];
+};
+
+uint64_t timewheel_now(void);
+
+timewheel_t* timewheel_create(uint64_t now);
+
+void timewheel_destroy(timewheel_t* tw);
+
+// expire 为绝对时间（ms），回调执行后节点即被回收，调用方不能再对其 del
+timer_node_t* timewheel_add(timewheel_t* tw, uint64_t expire, timer_callback_fn cb, void* priv);
+
+void timewheel_del(timewheel_t* tw, timer_node_t* t);
+
+int timewheel_expire(timewheel_t* tw, uint64_t now);
+
+int timewheel_next_timeout(timewheel_t* tw, uint64_t now);
+
+#endif
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "timewheel.h"
+
+// 编译: gcc -O2 timewheel.c timewheel_bench.c -o timewheel_bench
+// 用法: ./timewheel_bench [定时器数量]
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void noop_cb(timer_node_t* t, void* privdata)
+{
+    (*(long*)privdata)++;
+}
+
+int main(int argc, char* argv[])
+{
+    int n = argc > 1 ? atoi(argv[1]) : 1000000;
+    timer_node_t** nodes = malloc(sizeof(timer_node_t*) * n);
+    long fired = 0;
+    srand(1);
+
+    timewheel_t* tw = timewheel_create(0);
+
+    // 插入：超时时间分布在 1ms ~ 60s，模拟每条在途命令一个超时定时器
+    double t0 = now_sec();
+    for (int i = 0; i < n; i++) {
+        nodes[i] = timewheel_add(tw, 1 + rand() % 60000, noop_cb, &fired);
+    }
+    double t1 = now_sec();
+
+    // 取消一半：大部分命令在超时前就已收到回复
+    for (int i = 0; i < n; i += 2) {
+        timewheel_del(tw, nodes[i]);
+    }
+    double t2 = now_sec();
+
+    // 到期：模拟时间按 1ms 推进直到全部触发
+    uint64_t now = 0;
+    while (tw->count > 0) {
+        now++;
+        timewheel_expire(tw, now);
+    }
+    double t3 = now_sec();
+
+    int inserted = n, canceled = (n + 1) / 2;
+    printf("timers=%d\n", n);
+    printf("insert : %.2f Mops/s\n", inserted / (t1 - t0) / 1e6);
+    printf("cancel : %.2f Mops/s\n", canceled / (t2 - t1) / 1e6);
+    printf("expire : %.2f Mops/s (%ld fired, %llu ticks)\n",
+        fired / (t3 - t2) / 1e6, fired, (unsigned long long)now);
+
+    // 插入后立即取消：命中回收链表的快速路径
+    double t4 = now_sec();
+    for (int i = 0; i < n; i++) {
+        timer_node_t* t = timewheel_add(tw, now + 1 + rand() % 60000, noop_cb, &fired);
+        timewheel_del(tw, t);
+    }
+    double t5 = now_sec();
+    printf("insert+cancel : %.2f Mops/s\n", n / (t5 - t4) / 1e6);
+
+    timewheel_destroy(tw);
+    free(nodes);
+    return 0;
+}
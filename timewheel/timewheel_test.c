@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "timewheel.h"
+
+static int fired_order[16];
+static int fired_num = 0;
+
+static void record_cb(timer_node_t* t, void* privdata)
+{
+    fired_order[fired_num++] = (int)(long)privdata;
+}
+
+// 测试用例1：按到期时间顺序触发
+void test_expire_order() {
+    printf("Test 1: Expire order\n");
+    timewheel_t* tw = timewheel_create(1000);
+    assert(tw != NULL);
+    fired_num = 0;
+
+    timewheel_add(tw, 1030, record_cb, (void*)3);
+    timewheel_add(tw, 1010, record_cb, (void*)1);
+    timewheel_add(tw, 1020, record_cb, (void*)2);
+    assert(tw->count == 3);
+
+    assert(timewheel_expire(tw, 1009) == 0);
+    assert(timewheel_expire(tw, 1020) == 2);
+    assert(fired_order[0] == 1 && fired_order[1] == 2);
+    assert(timewheel_expire(tw, 1100) == 1);
+    assert(fired_order[2] == 3);
+    assert(tw->count == 0);
+
+    timewheel_destroy(tw);
+    printf("Passed\n\n");
+}
+
+// 测试用例2：取消定时器
+void test_cancel() {
+    printf("Test 2: Cancel timer\n");
+    timewheel_t* tw = timewheel_create(0);
+    fired_num = 0;
+
+    timer_node_t* t1 = timewheel_add(tw, 5, record_cb, (void*)1);
+    timer_node_t* t2 = timewheel_add(tw, 5, record_cb, (void*)2);
+    timewheel_del(tw, t1);
+    assert(tw->count == 1);
+    assert(timewheel_expire(tw, 10) == 1);
+    assert(fired_num == 1 && fired_order[0] == 2);
+    (void)t2;
+
+    // 同一槽位全部取消后，最近到期时间不再指向该槽
+    t1 = timewheel_add(tw, 20, record_cb, (void*)1);
+    timewheel_add(tw, 200, record_cb, (void*)2);
+    assert(timewheel_next_timeout(tw, 11) == 9);
+    timewheel_del(tw, t1);
+    assert(timewheel_next_timeout(tw, 11) == 189);
+
+    timewheel_destroy(tw);
+    printf("Passed\n\n");
+}
+
+// 测试用例3：高层槽位 cascade
+void test_cascade() {
+    printf("Test 3: Cascade from upper levels\n");
+    timewheel_t* tw = timewheel_create(0);
+    fired_num = 0;
+
+    timewheel_add(tw, 300, record_cb, (void*)1);         // 第 1 层
+    timewheel_add(tw, 70000, record_cb, (void*)2);       // 第 2 层
+    timewheel_add(tw, 20000000, record_cb, (void*)3);    // 第 3 层
+
+    assert(timewheel_expire(tw, 299) == 0);
+    assert(timewheel_expire(tw, 300) == 1);
+    assert(timewheel_expire(tw, 69999) == 0);
+    assert(timewheel_expire(tw, 70000) == 1);
+    assert(timewheel_expire(tw, 19999999) == 0);
+    assert(timewheel_expire(tw, 20000000) == 1);
+    assert(fired_order[0] == 1 && fired_order[1] == 2 && fired_order[2] == 3);
+
+    timewheel_destroy(tw);
+    printf("Passed\n\n");
+}
+
+// 测试用例4：最近到期时间
+void test_next_timeout() {
+    printf("Test 4: Next timeout\n");
+    timewheel_t* tw = timewheel_create(100);
+    assert(timewheel_next_timeout(tw, 100) == -1);
+
+    timewheel_add(tw, 150, record_cb, (void*)1);
+    assert(timewheel_next_timeout(tw, 100) == 50);
+    assert(timewheel_next_timeout(tw, 160) == 0);
+
+    // 过期的时间点会被放到下一个 tick
+    timewheel_add(tw, 10, record_cb, (void*)2);
+    assert(timewheel_next_timeout(tw, 100) == 0);
+
+    timewheel_destroy(tw);
+    printf("Passed\n\n");
+}
+
+static timewheel_t* g_tw = NULL;
+
+static void rearm_cb(timer_node_t* t, void* privdata)
+{
+    int* n = (int*)privdata;
+    if (++(*n) < 3) {
+        timewheel_add(g_tw, t->expire + 10, rearm_cb, privdata);
+    }
+}
+
+// 测试用例5：回调中重新添加定时器
+void test_rearm_in_callback() {
+    printf("Test 5: Re-arm in callback\n");
+    g_tw = timewheel_create(0);
+    int n = 0;
+    timewheel_add(g_tw, 10, rearm_cb, &n);
+    assert(timewheel_expire(g_tw, 100) == 3);
+    assert(n == 3);
+    assert(g_tw->count == 0);
+    timewheel_destroy(g_tw);
+    printf("Passed\n\n");
+}
+
+int main() {
+    printf("Starting timewheel tests...\n\n");
+
+    test_expire_order();
+    test_cancel();
+    test_cascade();
+    test_next_timeout();
+    test_rearm_in_callback();
+
+    printf("All tests passed!\n");
+    return 0;
+}